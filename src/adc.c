@@ -11,6 +11,8 @@
 
 #include "dma.h"
 
+#include <stdlib.h>
+
 #define ADC_IRQ_PRIORITY    3
 
 #define ADC_DMA_PRIORITY    0
@@ -20,30 +22,62 @@
 
 
 static void adc_dma_callback (uint8_t chan, void *state);
+static void adc_init_temp_cal (void);
+static void adc_init_vcc_cal (void);
 
 
 #define ADC_RANGE_A_FIRST       ADC_INPUTCTRL_MUXPOS_PIN0_Val
 #define ADC_RANGE_A_LAST        ADC_INPUTCTRL_MUXPOS_PIN9_Val
 #define ADC_RANGE_A_MASK        0x3FF
-#define ADC_RANGE_A_BIT         29
 
 #define ADC_RANGE_B_FIRST       ADC_INPUTCTRL_MUXPOS_PIN10_Val
 #define ADC_RANGE_B_LAST        ADC_INPUTCTRL_MUXPOS_PIN19_Val
 #define ADC_RANGE_B_MASK        0xFFC00
-#define ADC_RANGE_B_BIT         30
 
 #define ADC_RANGE_INT_FIRST     ADC_INPUTCTRL_MUXPOS_TEMP_Val
 #define ADC_RANGE_INT_LAST      ADC_INPUTCTRL_MUXPOS_DAC_Val
 #define ADC_RANGE_INT_MASK      0x1F000000
-#define ADC_RANGE_INT_BIT       31
-
-enum adc_scan_range {
-    /* Scan from channels 1 to 10 */
-    ADC_RANGE_A,
-    /* Scan from channel 11 to 19 */
-    ADC_RANGE_B,
-    /* Scan of internal channels */
-    ADC_RANGE_INTERNAL
+
+#define ADC_NUM_CHANNELS        (ADC_RANGE_INT_LAST + 1)
+
+/** Maximum number of channels for which statistics can be kept */
+#define ADC_STATS_NUM_SLOTS     6
+/** Marks a channel for which no statistics are kept */
+#define ADC_STATS_NO_SLOT       0xFF
+
+/**
+ *  Configuration for a single ADC channel.
+ */
+struct adc_chan_conf_t {
+    /** Oversampling mode (enum adc_oversample) */
+    uint8_t oversample:3;
+    /** Gain setting (enum adc_gain) */
+    uint8_t gain:4;
+};
+
+/**
+ *  AVGCTRL register values for each oversampling mode, see table 33-3 in the
+ *  SAMD21 datasheet. Results with more than 16 bits of accumulation are
+ *  automatically shifted right by the ADC, ADJRES provides the rest of the
+ *  decimation.
+ */
+static const uint8_t adc_avgctrl_values[] = {
+    [ADC_OVERSAMPLE_NONE] = ADC_AVGCTRL_SAMPLENUM_1 | ADC_AVGCTRL_ADJRES(0),
+    [ADC_OVERSAMPLE_4X] = ADC_AVGCTRL_SAMPLENUM_4 | ADC_AVGCTRL_ADJRES(1),
+    [ADC_OVERSAMPLE_16X] = ADC_AVGCTRL_SAMPLENUM_16 | ADC_AVGCTRL_ADJRES(2),
+    [ADC_OVERSAMPLE_64X] = ADC_AVGCTRL_SAMPLENUM_64 | ADC_AVGCTRL_ADJRES(1),
+    [ADC_OVERSAMPLE_256X] = ADC_AVGCTRL_SAMPLENUM_256 | ADC_AVGCTRL_ADJRES(0)
+};
+
+/**
+ *  Result resolution in bits for each oversampling mode.
+ */
+static const uint8_t adc_result_bits[] = {
+    [ADC_OVERSAMPLE_NONE] = 12,
+    [ADC_OVERSAMPLE_4X] = 13,
+    [ADC_OVERSAMPLE_16X] = 14,
+    [ADC_OVERSAMPLE_64X] = 15,
+    [ADC_OVERSAMPLE_256X] = 16
 };
 
 struct {
@@ -54,6 +88,8 @@ struct {
     uint16_t adc_in_buffer_pins[20];
     uint16_t adc_in_buffer_internal[5];
     
+    struct adc_chan_conf_t chan_conf[ADC_NUM_CHANNELS];
+    
     union {
         uint8_t dma_chan;
         struct {
@@ -62,9 +98,103 @@ struct {
         };
     };
     
+    /* First and last channels in the currently configured scan */
+    uint8_t scan_first;
+    uint8_t scan_last;
+    
     uint8_t use_dma:1;
 } adc_state_g;
 
+/**
+ *  Accumulated statistics for a channel.
+ */
+struct adc_stats_accum_t {
+    /** Sum of the squares of the samples */
+    uint64_t sum_sq;
+    /** Sum of the samples */
+    uint32_t sum;
+    /** Smallest sample */
+    uint16_t min;
+    /** Largest sample */
+    uint16_t max;
+    /** Number of samples */
+    uint16_t count;
+};
+
+/**
+ *  Statistics state for a channel.
+ */
+static struct {
+    /** Statistics for the window which is currently being accumulated */
+    struct adc_stats_accum_t accum;
+    /** Statistics for the last completed window */
+    volatile struct adc_stats_accum_t window;
+    /** Number of samples in each window */
+    uint16_t window_len;
+    /** Incremented every time a window is completed */
+    volatile uint8_t seq;
+} adc_stats_g[ADC_STATS_NUM_SLOTS];
+
+/** Index in adc_stats_g for each channel, or ADC_STATS_NO_SLOT */
+static uint8_t adc_stats_slots_g[ADC_NUM_CHANNELS];
+
+/** ADC value to voltage coefficient for course temperature calculation, the
+    voltage of a full scale reading at an ideal 1 V reference */
+#define ADC_TEMP_COURSE_CO  (((100000 * (uint32_t)1000) + 32768) / 65535)
+
+/**
+ *  Calibration constants for the internal temperature sensor, computed once
+ *  from the NVM Temperature Log Row.
+ */
+static struct {
+    /** Room temperature (in hundred nanodegrees celsius) */
+    int64_t temp_r;
+    /** Difference between hot and room temperatures */
+    int64_t delta_t;
+    /** Voltage measured at room temperature (in nanovolts) */
+    uint32_t v_adc_r;
+    /** Difference between voltages measured at hot and room temperatures */
+    int32_t denominator;
+    /** delta_t scaled down by 100000 */
+    int32_t delta_t_s;
+    /** Actual voltage of 1 V reference at room temperature, scaled */
+    int32_t int1v_r_s;
+    /** Difference between 1 V reference voltages at hot and room
+        temperatures */
+    int16_t delta_int1v;
+    /** Integer part of delta_t / denominator */
+    int32_t slope_int;
+    /** Fractional part of delta_t / denominator (Q0.32) */
+    uint32_t slope_frac;
+    /** 2^32 / delta_t_s, or 0 if the reciprocal can not be used */
+    int32_t delta_t_s_recip;
+    /** Set if the calibration values are usable */
+    uint8_t valid:1;
+} adc_temp_cal_g;
+
+/**
+ *  Calibration constants for the scaled VCC channels.
+ */
+enum adc_vcc_cal {
+    ADC_VCC_CAL_CORE,
+    ADC_VCC_CAL_IO,
+    ADC_NUM_VCC_CAL
+};
+
+static const uint8_t adc_vcc_cal_chans[] = {
+    [ADC_VCC_CAL_CORE] = ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val,
+    [ADC_VCC_CAL_IO] = ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC_Val
+};
+
+static struct {
+    /** Millivolts at full scale multiplied by any gain less than 1x */
+    uint16_t scale;
+    /** 2^32 / divisor */
+    uint32_t recip;
+    /** 65535 multiplied by any gain greater than 1x */
+    uint32_t divisor;
+} adc_vcc_cal_g[ADC_NUM_VCC_CAL];
+
 struct pin_t {
     uint8_t num:5;
     uint8_t port:1;
@@ -106,85 +236,97 @@ static void adc_set_pmux (uint8_t channel)
 }
 
 /**
- *  Configure the ADC and supporting peripherals to be ready for the next scan.
+ *  Get the mask of channels which are in the same scan range as a channel.
  *
- *  @param range The scan range to configure
+ *  @param channel The channel for which the range mask should be found
  *
- *  @return The next range which will be scanned
+ *  @return The mask for the scan range which contains the channel
  */
-static enum adc_scan_range adc_conf_scan (void)
-{
-    uint32_t scan_mask;
-    enum adc_scan_range range;
-    
-    /* Find the next range */
-    if (ADC->INPUTCTRL.bit.MUXPOS <= ADC_RANGE_A_LAST) {
-        // Last scan was over range A
-        if (adc_state_g.channel_mask & ADC_RANGE_B_MASK) {
-            // Next scan over B
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_B_MASK;
-            range = ADC_RANGE_B;
-        } else if (adc_state_g.channel_mask & ADC_RANGE_INT_MASK) {
-            // Next scan over Internal
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_INT_MASK;
-            range = ADC_RANGE_INTERNAL;
-        } else {
-            // Next scan over A
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_A_MASK;
-            range = ADC_RANGE_A;
-        }
-    } else if (ADC->INPUTCTRL.bit.MUXPOS <= ADC_RANGE_B_LAST) {
-        // Last scan was over range B
-        if (adc_state_g.channel_mask & ADC_RANGE_INT_MASK) {
-            // Next scan over Internal
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_INT_MASK;
-            range = ADC_RANGE_INTERNAL;
-        } else if (adc_state_g.channel_mask & ADC_RANGE_A_MASK) {
-            // Next scan over A
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_A_MASK;
-            range = ADC_RANGE_A;
-        } else {
-            // Next scan over B
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_B_MASK;
-            range = ADC_RANGE_B;
-        }
+static inline uint32_t adc_range_mask (uint8_t channel)
+{
+    if (channel <= ADC_RANGE_A_LAST) {
+        return ADC_RANGE_A_MASK;
+    } else if (channel <= ADC_RANGE_B_LAST) {
+        return ADC_RANGE_B_MASK;
     } else {
-        // Last scan was over internal inputs
-        if (adc_state_g.channel_mask & ADC_RANGE_A_MASK) {
-            // Next scan over A
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_A_MASK;
-            range = ADC_RANGE_A;
-        } else if (adc_state_g.channel_mask & ADC_RANGE_B_MASK) {
-            // Next scan over B
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_B_MASK;
-            range = ADC_RANGE_B;
-        } else {
-            // Next scan over Internal
-            scan_mask = adc_state_g.channel_mask & ADC_RANGE_INT_MASK;
-            range = ADC_RANGE_INTERNAL;
-        }
+        return ADC_RANGE_INT_MASK;
+    }
+}
+
+/**
+ *  Configure the ADC and supporting peripherals to be ready for the next scan.
+ *
+ *  Each scan covers a group of consecutive enabled channels within one of the
+ *  scan ranges (A, B or internal) which all share the same oversampling and
+ *  gain configuration.
+ *
+ *  @return 1 if the next scan is the first scan of a new sweep, 0 otherwise
+ */
+static uint8_t adc_conf_scan (void)
+{
+    uint32_t scan_mask = 0;
+    uint8_t new_sweep = 0;
+    
+    /* Find the enabled channels after the end of the last scan */
+    if (adc_state_g.scan_last < 31) {
+        scan_mask = (adc_state_g.channel_mask &
+                     ~((2UL << adc_state_g.scan_last) - 1));
+    }
+    
+    if (!scan_mask) {
+        // Last scan was the end of a sweep, wrap around to the first channel
+        scan_mask = adc_state_g.channel_mask;
+        new_sweep = 1;
     }
     
     /* Find first and last chan for scan */
     uint8_t first = __builtin_ctz(scan_mask);
-    uint8_t last = 31 - __builtin_clz(scan_mask);
+    uint8_t last = first;
+    
+    struct adc_chan_conf_t conf = adc_state_g.chan_conf[first];
+    
+    // Extend the scan over following channels in the same range which have
+    // the same configuration
+    scan_mask &= adc_range_mask(first) & ~(1UL << first);
+    while (scan_mask) {
+        uint8_t chan = __builtin_ctz(scan_mask);
+        struct adc_chan_conf_t c = adc_state_g.chan_conf[chan];
+        
+        if ((c.oversample != conf.oversample) || (c.gain != conf.gain)) {
+            break;
+        }
+        
+        last = chan;
+        scan_mask &= scan_mask - 1;
+    }
+    
+    adc_state_g.scan_first = first;
+    adc_state_g.scan_last = last;
+    
+    /* Configure resolution and averaging */
+    ADC->AVGCTRL.reg = adc_avgctrl_values[conf.oversample];
+    ADC->CTRLB.bit.RESSEL = ((conf.oversample == ADC_OVERSAMPLE_NONE) ?
+                             ADC_CTRLB_RESSEL_12BIT_Val :
+                             ADC_CTRLB_RESSEL_16BIT_Val);
+    // Wait for synchronization
+    while (ADC->STATUS.bit.SYNCBUSY);
     
     /* Configure scan */
     ADC->INPUTCTRL.reg = (ADC_INPUTCTRL_MUXPOS(first) |
                           ADC_INPUTCTRL_MUXNEG_GND |
                           ADC_INPUTCTRL_INPUTSCAN(last - first) |
                           ADC_INPUTCTRL_INPUTOFFSET(0) |
-                          ADC_INPUTCTRL_GAIN_1X);
+                          ADC_INPUTCTRL_GAIN(conf.gain));
     // Wait for synchronization
     while (ADC->STATUS.bit.SYNCBUSY);
     
     /* Configure DMA or interrupts */
     if (adc_state_g.use_dma) {
-        uint16_t *buffer = ((scan_mask & ADC_RANGE_INT_MASK) ?
+        uint16_t *buffer = ((first >= ADC_RANGE_INT_FIRST) ?
                             (adc_state_g.adc_in_buffer_internal +
                              (first - ADC_RANGE_INT_FIRST)) :
                             (adc_state_g.adc_in_buffer_pins + first));
-    
+        
         dma_start_static_to_buffer_hword(adc_state_g.dma_chan, buffer,
                                          (1 + last - first),
                                          ((volatile const uint16_t*)
@@ -195,7 +337,7 @@ static enum adc_scan_range adc_conf_scan (void)
         adc_state_g.last_chan = last;
     }
     
-    return range;
+    return new_sweep;
 }
 
 /**
@@ -240,8 +382,16 @@ uint8_t init_adc (uint32_t clock_mask, uint32_t clock_freq,
     ADC->REFCTRL.reg = ADC_REFCTRL_REFSEL_INT1V;
     
     /* 256x oversampling and decimation for 16 bit effective resolution */
-    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_256 | ADC_AVGCTRL_ADJRES(0);
-
+    ADC->AVGCTRL.reg = adc_avgctrl_values[ADC_OVERSAMPLE_256X];
+    
+    for (uint8_t i = 0; i < ADC_NUM_CHANNELS; i++) {
+        adc_state_g.chan_conf[i] = (struct adc_chan_conf_t) {
+            .oversample = ADC_OVERSAMPLE_256X,
+            .gain = ADC_GAIN_1X
+        };
+        adc_stats_slots_g[i] = ADC_STATS_NO_SLOT;
+    }
+    
     /* Configure Control B register */
     // Calculate prescaler value
     // Division factor (rounded up to ensure maximum frequency is not exceeded)
@@ -287,12 +437,12 @@ uint8_t init_adc (uint32_t clock_mask, uint32_t clock_freq,
     /* Configure initial state */
     adc_state_g.channel_mask = channel_mask;
     adc_state_g.sweep_period = sweep_period;
+    // Make sure that the first scan starts from the first enabled channel
+    adc_state_g.scan_last = 31;
     
-    // Set bits in mask to indicate which ranges are used
-    channel_mask |= ((!!(channel_mask & ADC_RANGE_A_MASK) << ADC_RANGE_A_BIT) |
-                     (!!(channel_mask & ADC_RANGE_B_MASK) << ADC_RANGE_B_BIT) |
-                     (!!(channel_mask & ADC_RANGE_INT_MASK) << ADC_RANGE_INT_BIT)
-                    );
+    /* Precompute calibration constants for internal channels */
+    adc_init_temp_cal();
+    adc_init_vcc_cal();
     
     /* Configure DMA or interrupts */
     if ((dma_chan >= 0) && (dma_chan < DMAC_CH_NUM)) {
@@ -318,6 +468,151 @@ uint8_t init_adc (uint32_t clock_mask, uint32_t clock_freq,
     return 0;
 }
 
+/**
+ *  Mask the interrupt from which the end of each scan is handled, so that the
+ *  channel configuration and statistics slots can be changed without a scan
+ *  completing part way through.
+ */
+static inline void adc_mask_irq (void)
+{
+    NVIC_DisableIRQ(adc_state_g.use_dma ? DMAC_IRQn : ADC_IRQn);
+    __DSB();
+    __ISB();
+}
+
+/**
+ *  Unmask the interrupt masked by adc_mask_irq.
+ */
+static inline void adc_unmask_irq (void)
+{
+    NVIC_EnableIRQ(adc_state_g.use_dma ? DMAC_IRQn : ADC_IRQn);
+}
+
+uint8_t adc_configure_channels (uint32_t channel_mask,
+                                enum adc_oversample oversample,
+                                enum adc_gain gain)
+{
+    if ((oversample > ADC_OVERSAMPLE_256X) ||
+        ((gain > ADC_GAIN_16X) && (gain != ADC_GAIN_DIV2))) {
+        return 1;
+    }
+    
+    channel_mask &= (1UL << ADC_NUM_CHANNELS) - 1;
+    
+    adc_mask_irq();
+    
+    while (channel_mask != 0) {
+        uint8_t chan = __builtin_ctz(channel_mask);
+        adc_state_g.chan_conf[chan] = (struct adc_chan_conf_t) {
+            .oversample = oversample,
+            .gain = gain
+        };
+        channel_mask &= channel_mask - 1;
+    }
+    
+    // The VCC conversions depend on the gain of the VCC channels
+    adc_init_vcc_cal();
+    
+    if (!ADC->CTRLA.bit.ENABLE) {
+        // No sweep is in progress, reconfigure the first scan of the next
+        // sweep so that it uses the new configuration
+        adc_state_g.scan_last = 31;
+        adc_conf_scan();
+    }
+    
+    adc_unmask_irq();
+    
+    return 0;
+}
+
+/**
+ *  Clear the statistics being accumulated for a channel.
+ */
+static inline void adc_stats_clear (struct adc_stats_accum_t *accum)
+{
+    *accum = (struct adc_stats_accum_t) {
+        .sum_sq = 0,
+        .sum = 0,
+        .min = UINT16_MAX,
+        .max = 0,
+        .count = 0
+    };
+}
+
+uint8_t adc_stats_configure (uint32_t channel_mask, uint16_t window)
+{
+    channel_mask &= adc_state_g.channel_mask;
+    
+    if ((window == 0) && (channel_mask != 0)) {
+        return 1;
+    } else if (__builtin_popcount(channel_mask) > ADC_STATS_NUM_SLOTS) {
+        return 1;
+    }
+    
+    adc_mask_irq();
+    
+    // Stop keeping statistics for all channels before reassigning the slots
+    for (uint8_t i = 0; i < ADC_NUM_CHANNELS; i++) {
+        adc_stats_slots_g[i] = ADC_STATS_NO_SLOT;
+    }
+    
+    uint8_t slot = 0;
+    while (channel_mask != 0) {
+        uint8_t chan = __builtin_ctz(channel_mask);
+        
+        adc_stats_clear(&adc_stats_g[slot].accum);
+        adc_stats_g[slot].window.count = 0;
+        adc_stats_g[slot].window_len = window;
+        adc_stats_g[slot].seq++;
+        adc_stats_slots_g[chan] = slot;
+        
+        slot++;
+        channel_mask &= channel_mask - 1;
+    }
+    
+    adc_unmask_irq();
+    
+    return 0;
+}
+
+/**
+ *  Add the results of a completed scan to the statistics for the scanned
+ *  channels.
+ *
+ *  @param first The first channel in the scan
+ *  @param last The last channel in the scan
+ */
+static void adc_stats_update_scan (uint8_t first, uint8_t last)
+{
+    for (uint8_t chan = first; chan <= last; chan++) {
+        uint8_t slot = adc_stats_slots_g[chan];
+        
+        if (slot == ADC_STATS_NO_SLOT) {
+            continue;
+        }
+        
+        struct adc_stats_accum_t *accum = &adc_stats_g[slot].accum;
+        uint16_t value = adc_get_value(chan);
+        
+        accum->sum_sq += (uint32_t)value * value;
+        accum->sum += value;
+        if (value < accum->min) {
+            accum->min = value;
+        }
+        if (value > accum->max) {
+            accum->max = value;
+        }
+        accum->count++;
+        
+        if (accum->count >= adc_stats_g[slot].window_len) {
+            // Window is complete, make it available and start the next one
+            adc_stats_g[slot].window = *accum;
+            adc_stats_g[slot].seq++;
+            adc_stats_clear(accum);
+        }
+    }
+}
+
 void adc_service (void)
 {
     if ((millis - adc_state_g.last_sweep_time) > adc_state_g.sweep_period) {
@@ -332,7 +627,7 @@ void adc_service (void)
     }
 }
 
-uint16_t adc_get_value (uint8_t channel)
+uint16_t adc_get_value_raw (uint8_t channel)
 {
     if (channel >= ADC_RANGE_INT_FIRST) {
         return adc_state_g.adc_in_buffer_internal[channel - ADC_RANGE_INT_FIRST];
@@ -341,25 +636,155 @@ uint16_t adc_get_value (uint8_t channel)
     }
 }
 
+/**
+ *  Find the integer square root of a number, rounded down.
+ */
+static uint16_t adc_isqrt (uint32_t n)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    
+    while (bit > n) {
+        bit >>= 2;
+    }
+    
+    while (bit != 0) {
+        if (n >= (root + bit)) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return (uint16_t)root;
+}
+
+uint8_t adc_get_stats (uint8_t channel, struct adc_stats_t *stats)
+{
+    if ((channel >= ADC_NUM_CHANNELS) ||
+        (adc_stats_slots_g[channel] == ADC_STATS_NO_SLOT)) {
+        return 1;
+    }
+    
+    uint8_t slot = adc_stats_slots_g[channel];
+    struct adc_stats_accum_t window;
+    uint8_t seq;
+    
+    // Copy the last completed window, trying again if a new window was
+    // completed while copying
+    do {
+        seq = adc_stats_g[slot].seq;
+        window = adc_stats_g[slot].window;
+    } while (seq != adc_stats_g[slot].seq);
+    
+    if (window.count == 0) {
+        // No window has been completed yet
+        return 1;
+    }
+    
+    stats->min = window.min;
+    stats->max = window.max;
+    stats->mean = (uint16_t)(window.sum / window.count);
+    stats->rms = adc_isqrt((uint32_t)(window.sum_sq / window.count));
+    stats->count = window.count;
+    
+    return 0;
+}
+
+uint8_t adc_get_resolution (uint8_t channel)
+{
+    return adc_result_bits[adc_state_g.chan_conf[channel].oversample];
+}
+
+uint16_t adc_get_value (uint8_t channel)
+{
+    return adc_get_value_raw(channel) << (16 - adc_get_resolution(channel));
+}
+
+/**
+ *  Scale the value of a channel to a given full scale value, taking into
+ *  account the gain with which the channel is sampled.
+ *
+ *  @param channel The channel number
+ *  @param full_scale The value which corresponds to an input at the reference
+ *                    voltage with a gain of 1x, must be at most 32767
+ *
+ *  @return The scaled value
+ */
+static uint32_t adc_scale_value (uint8_t channel, uint32_t full_scale)
+{
+    uint8_t gain = adc_state_g.chan_conf[channel].gain;
+    uint32_t num = full_scale * adc_get_value(channel);
+    
+    if (gain == ADC_GAIN_DIV2) {
+        return (2 * num) / 65535;
+    } else {
+        return num / (65535UL << gain);
+    }
+}
+
 uint16_t adc_get_value_millivolts (uint8_t channel)
 {
-    uint16_t adc_m = adc_get_value(channel);
-    return (1000 * (uint32_t)adc_m) / 65535;
+    return (uint16_t)adc_scale_value(channel, 1000);
 }
 
 uint32_t adc_get_value_nanovolts (uint8_t channel)
 {
-    uint16_t adc_m = adc_get_value(channel);
-    return (uint32_t)((1000000000 * (uint64_t)adc_m) / 65535);
+    uint8_t gain = adc_state_g.chan_conf[channel].gain;
+    uint64_t num = 1000000000 * (uint64_t)adc_get_value(channel);
+    
+    if (gain == ADC_GAIN_DIV2) {
+        return (uint32_t)((2 * num) / 65535);
+    } else {
+        return (uint32_t)(num / (65535UL << gain));
+    }
 }
 
-static int16_t adc_get_temp (uint8_t fine)
+/**
+ *  Find the quotient of n / d rounded towards zero, as it would be calculated
+ *  by the C division operator, from an estimate of the quotient. This allows
+ *  divisions by calibration constants to be replaced by a multiplication with
+ *  a precomputed reciprocal without changing the result.
+ *
+ *  @param n The dividend
+ *  @param d The divisor, must not be 0
+ *  @param q An estimate of the quotient, should be within one or two of the
+ *           actual quotient
+ *
+ *  @return The exact quotient
+ */
+static int64_t adc_cal_correct_quotient (int64_t n, int64_t d, int64_t q)
 {
-    /* Check that temperature sensor is enabled */
-    if (!(adc_state_g.channel_mask & ADC_INPUTCTRL_MUXPOS_TEMP)) {
-        return INT16_MIN;
+    if (d < 0) {
+        // n / d has the same value as -n / -d
+        n = -n;
+        d = -d;
+    }
+    
+    // Find floor(n / d)
+    while ((q * d) > n) {
+        q--;
+    }
+    while (((q + 1) * d) <= n) {
+        q++;
+    }
+    
+    // Round towards zero
+    if ((n < 0) && ((q * d) != n)) {
+        q++;
     }
     
+    return q;
+}
+
+/**
+ *  Load the temperature sensor calibration values from the NVM Temperature Log
+ *  Row and compute the constants used to convert temperature sensor readings.
+ */
+static void adc_init_temp_cal (void)
+{
     /* Read values from Temperature Log Row */
     // Room temperature (in hundred nanodegrees celsius)
     uint8_t room_temp_val_int = (uint8_t)(((*((uint32_t*)
@@ -409,52 +834,131 @@ static int16_t adc_get_temp (uint8_t fine)
                                        NVMCTRL_FUSES_HOT_ADC_VAL_Msk) >>
                                       NVMCTRL_FUSES_HOT_ADC_VAL_Pos);
     
-    /* Get measured ADC value */
-    uint16_t adc_m_val = adc_state_g.adc_in_buffer_internal[
-                        ADC_INPUTCTRL_MUXPOS_TEMP_Val - ADC_RANGE_INT_FIRST];
-    
     /* Compute coefficients to convert ADC values to nanovolts */
     uint32_t adc_r_co = ((100000 * (uint32_t)int1v_r) + 2048) / 4095;
     uint32_t adc_h_co = ((100000 * (uint32_t)int1v_h) + 2048) / 4095;
-    uint32_t adc_m_course_co = ((100000 * (uint32_t)1000) + 32768) / 65535;
     
     /* Compute voltages (in nanovolts) */
     uint32_t v_adc_r = adc_r_val * adc_r_co;
     uint32_t v_adc_h = adc_h_val * adc_h_co;
-    uint32_t v_adc_m_course = adc_m_val * adc_m_course_co;
     
-    /* Compute course temp (in nanodegrees celsius) */
     int32_t denominator = v_adc_h - v_adc_r;
-    int32_t delta_v_course = v_adc_m_course - v_adc_r;
     int64_t delta_t = temp_h - temp_r;
+    int32_t delta_t_s = delta_t / 100000;
     
-    int64_t numerator_course = (int64_t)delta_v_course * delta_t;
-    int64_t temp_c = temp_r + (numerator_course / denominator);
+    adc_temp_cal_g.valid = ((denominator != 0) && (delta_t_s != 0));
+    if (!adc_temp_cal_g.valid) {
+        return;
+    }
+    
+    adc_temp_cal_g.temp_r = temp_r;
+    adc_temp_cal_g.delta_t = delta_t;
+    adc_temp_cal_g.v_adc_r = v_adc_r;
+    adc_temp_cal_g.denominator = denominator;
+    adc_temp_cal_g.delta_t_s = delta_t_s;
+    adc_temp_cal_g.int1v_r_s = 100000 * int1v_r;
+    adc_temp_cal_g.delta_int1v = int1v_h - int1v_r;
+    
+    /* Compute fixed point reciprocals */
+    // Split delta_t / denominator into an integer part rounded down and a
+    // positive fractional part
+    int64_t slope_int = delta_t / denominator;
+    int64_t slope_rem = delta_t % denominator;
+    if ((slope_rem != 0) && ((slope_rem < 0) != (denominator < 0))) {
+        slope_int--;
+        slope_rem += denominator;
+    }
+    adc_temp_cal_g.slope_int = (int32_t)slope_int;
+    adc_temp_cal_g.slope_frac = (uint32_t)((slope_rem << 32) / denominator);
+    adc_temp_cal_g.delta_t_s_recip = (int32_t)(((int64_t)1 << 32) /
+                                               delta_t_s);
+    
+    // Make sure that estimating the 1 V reference correction with the
+    // reciprocal can not overflow for any ADC value, this is only a concern
+    // for implausible calibration values
+    uint64_t max_delta_v = (((uint64_t)UINT16_MAX * ADC_TEMP_COURSE_CO) +
+                            v_adc_r);
+    uint64_t max_delta_temp = max_delta_v * (uint64_t)(llabs(slope_int) + 1);
+    uint64_t max_n = ((uint64_t)abs(adc_temp_cal_g.delta_int1v) *
+                      max_delta_temp);
+    uint64_t max_factor = (uint64_t)abs(adc_temp_cal_g.delta_t_s_recip);
+    if ((max_factor == 0) || (max_delta_temp > (INT64_MAX / 256)) ||
+        (max_n > (INT64_MAX / max_factor))) {
+        // Fall back to division
+        adc_temp_cal_g.delta_t_s_recip = 0;
+    }
+}
+
+/**
+ *  Calculate the difference between the temperature for a measured voltage and
+ *  the room temperature calibration point.
+ *
+ *  @param v_adc_m The measured voltage in the same units as the calibration
+ *                 voltages
+ *
+ *  @return The temperature difference in hundred nanodegrees celsius
+ */
+static int64_t adc_temp_delta (uint32_t v_adc_m)
+{
+    int32_t delta_v = v_adc_m - adc_temp_cal_g.v_adc_r;
+    
+    int64_t q = ((delta_v * (int64_t)adc_temp_cal_g.slope_int) +
+                 ((delta_v * (int64_t)adc_temp_cal_g.slope_frac) >> 32));
+    
+    return adc_cal_correct_quotient(delta_v * adc_temp_cal_g.delta_t,
+                                    adc_temp_cal_g.denominator, q);
+}
+
+/**
+ *  Convert a temperature in hundred nanodegrees celsius to hundredths of a
+ *  degree.
+ */
+static inline int16_t adc_temp_to_centidegrees (int64_t temp)
+{
+    // 4295 = ceil(2^32 / 1000000)
+    int64_t q = (temp * 4295) >> 32;
+    return (int16_t)adc_cal_correct_quotient(temp, 1000000, q);
+}
+
+static int16_t adc_get_temp (uint8_t fine)
+{
+    /* Check that temperature sensor is enabled */
+    if (!(adc_state_g.channel_mask & (1 << ADC_INPUTCTRL_MUXPOS_TEMP_Val)) ||
+        !adc_temp_cal_g.valid) {
+        return INT16_MIN;
+    }
+    
+    /* Get measured ADC value */
+    uint16_t adc_m_val = adc_get_value(ADC_INPUTCTRL_MUXPOS_TEMP_Val);
+    
+    /* Compute course temp (in nanodegrees celsius) */
+    int64_t delta_temp_c = adc_temp_delta(adc_m_val * ADC_TEMP_COURSE_CO);
     
     if (!fine) {
         // Return course value
-        return (int16_t)(temp_c / 1000000);
+        return adc_temp_to_centidegrees(adc_temp_cal_g.temp_r + delta_temp_c);
     }
     
     /* Estimate 1 V reference actual voltage (in nanovolts) */
-    int16_t delta_int1v = int1v_h - int1v_r;
-    int32_t delta_t_s = delta_t / 100000;
-    int32_t int1v_r_s = 100000 * int1v_r;
-    int32_t int1v_m = int1v_r_s + (delta_int1v * (temp_c - temp_r) / delta_t_s);
-
-    /* Compute new coefficient for measured temp ADC value */
-    uint32_t adc_m_fine_co = (int1v_m + 32768) / 65535;
+    int64_t n = adc_temp_cal_g.delta_int1v * delta_temp_c;
+    int64_t q = ((adc_temp_cal_g.delta_t_s_recip != 0) ?
+                 ((n * adc_temp_cal_g.delta_t_s_recip) >> 32) :
+                 (n / adc_temp_cal_g.delta_t_s));
+    int32_t int1v_m = (adc_temp_cal_g.int1v_r_s +
+                       adc_cal_correct_quotient(n, adc_temp_cal_g.delta_t_s,
+                                                q));
     
-    /* Compute new measured ACD voltage (in nanovolts) */
-    uint32_t v_adc_m_fine = adc_m_val * adc_m_fine_co;
+    /* Compute new coefficient for measured temp ADC value */
+    int32_t co_n = int1v_m + 32768;
+    // 65537 = ceil(2^32 / 65535)
+    uint32_t adc_m_fine_co = adc_cal_correct_quotient(co_n, 65535,
+                                                      ((int64_t)co_n * 65537) >> 32);
     
     /* Compute fine temp (in nanodegrees celsius) */
-    int32_t delta_v_fine = v_adc_m_fine - v_adc_r;
-    int64_t numerator_fine = (int64_t)delta_v_fine * delta_t;
-    int64_t temp_f = temp_r + (numerator_fine / denominator);
+    int64_t delta_temp_f = adc_temp_delta(adc_m_val * adc_m_fine_co);
     
     // Return fine value
-    return (int16_t)(temp_f / 1000000);
+    return adc_temp_to_centidegrees(adc_temp_cal_g.temp_r + delta_temp_f);
 }
 
 int16_t adc_get_temp_course (void)
@@ -467,26 +971,61 @@ int16_t adc_get_temp_fine (void)
     return adc_get_temp(1);
 }
 
+/**
+ *  Compute the constants used to convert the scaled VCC channels to
+ *  millivolts for the current channel configurations.
+ */
+static void adc_init_vcc_cal (void)
+{
+    for (uint8_t i = 0; i < ADC_NUM_VCC_CAL; i++) {
+        uint8_t gain = adc_state_g.chan_conf[adc_vcc_cal_chans[i]].gain;
+        
+        if (gain == ADC_GAIN_DIV2) {
+            adc_vcc_cal_g[i].scale = 2 * 4000;
+            adc_vcc_cal_g[i].divisor = 65535;
+        } else {
+            adc_vcc_cal_g[i].scale = 4000;
+            adc_vcc_cal_g[i].divisor = 65535UL << gain;
+        }
+        adc_vcc_cal_g[i].recip = (((uint64_t)1 << 32) /
+                                  adc_vcc_cal_g[i].divisor);
+    }
+}
+
+/**
+ *  Get the value of a scaled VCC channel in millivolts.
+ *
+ *  @param cal Index of the channel in the VCC calibration table
+ *
+ *  @return The voltage in millivolts
+ */
+static int16_t adc_get_vcc (uint8_t cal)
+{
+    uint32_t n = (adc_vcc_cal_g[cal].scale *
+                  adc_get_value(adc_vcc_cal_chans[cal]));
+    uint32_t q = ((uint64_t)n * adc_vcc_cal_g[cal].recip) >> 32;
+    
+    return (int16_t)adc_cal_correct_quotient(n, adc_vcc_cal_g[cal].divisor, q);
+}
+
 int16_t adc_get_core_vcc (void)
 {
-    if (!(adc_state_g.channel_mask & ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val)) {
+    if (!(adc_state_g.channel_mask &
+          (1 << ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val))) {
         return INT16_MIN;
     }
     
-    uint16_t adc_m = adc_state_g.adc_in_buffer_internal[
-                ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val - ADC_RANGE_INT_FIRST];
-    return (uint16_t)((4000 * (uint32_t)adc_m) / 65535);
+    return adc_get_vcc(ADC_VCC_CAL_CORE);
 }
 
 int16_t adc_get_io_vcc (void)
 {
-    if (!(adc_state_g.channel_mask & ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC_Val)) {
+    if (!(adc_state_g.channel_mask &
+          (1 << ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC_Val))) {
         return INT16_MIN;
     }
     
-    uint16_t adc_m = adc_state_g.adc_in_buffer_internal[
-                    ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC_Val - ADC_RANGE_INT_FIRST];
-    return (uint16_t)((4000 * (uint32_t)adc_m) / 65535);
+    return adc_get_vcc(ADC_VCC_CAL_IO);
 }
 
 uint32_t adc_get_last_sweep_time (void)
@@ -511,7 +1050,7 @@ void ADC_Handler (void)
         uint8_t index = adc_state_g.chan_num++;
         adc_state_g.adc_in_buffer_pins[index] = ADC->RESULT.reg;
     }
-
+    
     // If we have reached the end of a sweep, run the DMA callback function
     if (adc_state_g.chan_num > adc_state_g.last_chan) {
         adc_dma_callback(255, NULL);
@@ -526,13 +1065,14 @@ static void adc_dma_callback (uint8_t chan, void *state)
     ADC->CTRLB.bit.FREERUN = 0;
     ADC->SWTRIG.bit.FLUSH = 1;
     
-    // Configure the next sweep
-    enum adc_scan_range next_range = adc_conf_scan();
-
-    if (((next_range == ADC_RANGE_B) && (adc_state_g.channel_mask & ADC_RANGE_A_MASK)) ||
-        ((next_range == ADC_RANGE_INTERNAL) && (adc_state_g.channel_mask & (~ADC_RANGE_INT_MASK)))) {
-        // The next range is B and range A is selected or the next scan range is
-        // internal and A or B is selected
+    // Update statistics for the channels in the scan that just finished
+    adc_stats_update_scan(adc_state_g.scan_first, adc_state_g.scan_last);
+    
+    // Configure the next scan
+    uint8_t new_sweep = adc_conf_scan();
+    
+    if (!new_sweep) {
+        // There are more scans left in this sweep
         adc_start_scan();
     } else {
         // Full set of sweeps is complete
@@ -12,6 +12,52 @@
 
 #include "global.h"
 
+/**
+ *  ADC hardware oversampling modes. Each mode accumulates a number of samples
+ *  in hardware and decimates the result to provide extra bits of resolution.
+ */
+enum adc_oversample {
+    /** Single sample, 12 bit result */
+    ADC_OVERSAMPLE_NONE,
+    /** 4 samples, 13 bit result */
+    ADC_OVERSAMPLE_4X,
+    /** 16 samples, 14 bit result */
+    ADC_OVERSAMPLE_16X,
+    /** 64 samples, 15 bit result */
+    ADC_OVERSAMPLE_64X,
+    /** 256 samples, 16 bit result */
+    ADC_OVERSAMPLE_256X
+};
+
+/**
+ *  ADC input gain settings.
+ */
+enum adc_gain {
+    ADC_GAIN_1X = ADC_INPUTCTRL_GAIN_1X_Val,
+    ADC_GAIN_2X = ADC_INPUTCTRL_GAIN_2X_Val,
+    ADC_GAIN_4X = ADC_INPUTCTRL_GAIN_4X_Val,
+    ADC_GAIN_8X = ADC_INPUTCTRL_GAIN_8X_Val,
+    ADC_GAIN_16X = ADC_INPUTCTRL_GAIN_16X_Val,
+    ADC_GAIN_DIV2 = ADC_INPUTCTRL_GAIN_DIV2_Val
+};
+
+/**
+ *  Statistics for an ADC channel over a window of samples. All values are
+ *  scaled to 16 bits, as returned by adc_get_value.
+ */
+struct adc_stats_t {
+    /** Smallest value in the window */
+    uint16_t min;
+    /** Largest value in the window */
+    uint16_t max;
+    /** Mean of the values in the window */
+    uint16_t mean;
+    /** Root mean square of the values in the window */
+    uint16_t rms;
+    /** Number of samples in the window */
+    uint16_t count;
+};
+
 /**
  *  Initilize and start automatic ADC sampling at a fixed period.
  *
@@ -26,19 +72,54 @@
  *  @param max_source_impedance Maximum impedence of source, see figure 37-5
  *                              in SAMD21 datasheet
  *
+ *  All channels are initially configured for 256x oversampling with a gain of
+ *  1x, adc_configure_channels can be used to change this.
+ *
  *  @return 0 if ADC initilized successfully
  */
 extern uint8_t init_adc (uint32_t clock_mask, uint32_t clock_freq,
                          uint32_t channel_mask, uint32_t sweep_period,
                          uint32_t max_source_impedance, int8_t dma_chan);
 
+/**
+ *  Set the oversampling mode and gain for a set of ADC channels. Adjacent
+ *  channels which share a configuration are sampled together in a single scan.
+ *  The new configuration takes effect from the next scan of each channel.
+ *
+ *  @param channel_mask Mask of channels to be configured
+ *  @param oversample Hardware oversampling mode for the channels
+ *  @param gain Input gain for the channels
+ *
+ *  @return 0 if the channels were configured successfully
+ */
+extern uint8_t adc_configure_channels (uint32_t channel_mask,
+                                       enum adc_oversample oversample,
+                                       enum adc_gain gain);
+
+/**
+ *  Start keeping statistics for a set of ADC channels. The minimum, maximum,
+ *  sum and sum of squares of each channel are accumulated as each sample is
+ *  taken and made available when a window of samples has been completed.
+ *  Statistics are no longer kept for any channels not in the mask.
+ *
+ *  @param channel_mask Mask of channels for which statistics should be kept,
+ *                      channels which are not enabled are ignored
+ *  @param window The number of samples in each window, one sample is taken per
+ *                sweep
+ *
+ *  @return 0 if statistics were configured successfully, 1 if the window is 0
+ *          or too many channels are selected
+ */
+extern uint8_t adc_stats_configure (uint32_t channel_mask, uint16_t window);
+
 /**
  *  Function to be called in each iteration of the main loop.
  */
 extern void adc_service (void);
 
 /**
- *  Get the measured value for an ADC channel.
+ *  Get the measured value for an ADC channel. The value is scaled to 16 bits
+ *  regardless of the resolution at which the channel is sampled.
  *
  *  @param channel The channel number of which the value should be retrieved
  *
@@ -46,12 +127,45 @@ extern void adc_service (void);
  */
 extern uint16_t adc_get_value (uint8_t channel);
 
+/**
+ *  Get the measured value for an ADC channel at the resolution at which it was
+ *  sampled.
+ *
+ *  @param channel The channel number of which the value should be retrieved
+ *
+ *  @return The measured value of the channel, ranging from 0 to
+ *          2^adc_get_resolution(channel) - 1
+ */
+extern uint16_t adc_get_value_raw (uint8_t channel);
+
+/**
+ *  Get the statistics for the last completed window of an ADC channel.
+ *
+ *  @param channel The channel number of which the statistics should be
+ *                 retrieved
+ *  @param stats Structure in which the statistics will be stored
+ *
+ *  @return 0 if statistics are available, 1 if statistics are not kept for
+ *          the channel or no window has been completed yet
+ */
+extern uint8_t adc_get_stats (uint8_t channel, struct adc_stats_t *stats);
+
+/**
+ *  Get the resolution at which an ADC channel is sampled.
+ *
+ *  @param channel The channel number
+ *
+ *  @return The number of bits in the result for the channel, from 12 to 16
+ */
+extern uint8_t adc_get_resolution (uint8_t channel);
+
 /**
  *  Get the measured value for an ADC channel in millivolts.
  *
  *  @param channel The channel number of which the value should be retrieved
  *
- *  @return The measured value of the channel in millivolts, from 0 to 1000
+ *  @return The measured value of the channel in millivolts, from 0 to 1000 at
+ *          a gain of 1x
  */
 extern uint16_t adc_get_value_millivolts (uint8_t channel);
 
@@ -61,6 +175,7 @@ extern uint16_t adc_get_value_millivolts (uint8_t channel);
  *  @param channel The channel number of which the value should be retrieved
  *
  *  @return The measured value of the channel in nanovolts, from 0 to 1000000000
+ *          at a gain of 1x
  */
 extern uint32_t adc_get_value_nanovolts (uint8_t channel);
 
@@ -190,6 +190,39 @@ static inline uint16_t circular_buffer_get_head(struct circular_buffer_t *buffer
     }
 }
 
+/**
+ *  Get a pointer to the byte a certain distance after the head of the buffer
+ *  and the number of contiguous bytes in the buffer following the pointer.
+ *  This allows data after the head to be accessed while the data at the head
+ *  is still in use, for example by a DMA transaction.
+ *
+ *  @param buffer The circular buffer.
+ *  @param offset The distance from the head of the buffer.
+ *  @param start Pointer to where a pointer to the byte will be placed.
+ *
+ *  @return The number of contiguous bytes in the buffer after the pointer, 0
+ *          if there are no bytes in the buffer past the offset.
+ */
+static inline uint16_t circular_buffer_get_after_head(
+                                            struct circular_buffer_t *buffer,
+                                            uint16_t offset, uint8_t **start)
+{
+    if (offset >= buffer->length) {
+        *start = buffer->buffer + buffer->tail;
+        return 0;
+    }
+    
+    uint16_t index = buffer->head + offset;
+    if (index >= buffer->capacity) {
+        index -= buffer->capacity;
+    }
+    *start = buffer->buffer + index;
+    
+    uint16_t remaining = buffer->length - offset;
+    uint16_t contiguous = buffer->capacity - index;
+    return (remaining < contiguous) ? remaining : contiguous;
+}
+
 /**
  *  Move the head of the buffer forwards by a certain number of bytes. This has
  *  the effect of removing `length` bytes from the buffer. If the head of the
@@ -231,6 +264,54 @@ static inline void circular_buffer_move_head(struct circular_buffer_t *buffer,
     __enable_irq();
 }
 
+/**
+ *  Get a pointer to the tail of the buffer and the number of contiguous free
+ *  bytes in the buffer following the pointer.
+ *
+ *  @param buffer The circular buffer for which the tail should be found.
+ *  @param tail Pointer where a pointer to the tail will be placed.
+ *
+ *  @return The number of contiguous bytes which can be written after the tail.
+ */
+static inline uint16_t circular_buffer_get_tail(struct circular_buffer_t *buffer,
+                                                uint8_t **tail)
+{
+    *tail = buffer->buffer + buffer->tail;
+    
+    if (circular_buffer_is_full(buffer)) {
+        return 0;
+    } else if (buffer->tail >= buffer->head) {
+        return buffer->capacity - buffer->tail;
+    } else {
+        return buffer->head - buffer->tail;
+    }
+}
+
+/**
+ *  Move the tail of the buffer forwards by a certain number of bytes. This has
+ *  the effect of adding `length` bytes, which must already have been written
+ *  after the tail, to the buffer. If the tail of the buffer would be moved past
+ *  the head, the tail will only be moved up to the head.
+ *
+ *  @param buffer The circular buffer for which the tail should be moved.
+ *  @param length The distance which the tail should be moved.
+ */
+static inline void circular_buffer_move_tail(struct circular_buffer_t *buffer,
+                                             uint16_t length)
+{
+    __disable_irq();
+    
+    uint16_t unused = circular_buffer_unused(buffer);
+    if (length > unused) {
+        length = unused;
+    }
+    
+    buffer->tail = (buffer->tail + length) % buffer->capacity;
+    buffer->length += length;
+    
+    __enable_irq();
+}
+
 /**
  *  Get the item from the head of a circular buffer, if available, without
  *  removing it from the buffer.
@@ -264,7 +345,7 @@ static inline int circular_buffer_unpush(struct circular_buffer_t *buffer)
         return 1;
     } else {
         __disable_irq();
-
+        
         if (buffer->tail == 0) {
             buffer->tail = buffer->capacity;
         }
@@ -145,6 +145,8 @@ extern struct sercom_uart_desc_t uart3_g;
 /* Define to enable echo on USB CDC port 2 */
 //#define USB_CDC_PORT_2_ECHO
 // Note: USB CDC ports should be enabled in order to minimize memory usage
+/* Define to enable the vendor specific bulk interface */
+//#define ENABLE_USB_VENDOR
 
 //
 //
@@ -187,6 +189,16 @@ extern struct mcp23s17_desc_t io_expander_g;
 #define ADC_DMA_CHAN 11
 /* Maximum impedance of source in ohms, see figure 37-5 in SAMD21 datasheet */
 #define ADC_SOURCE_IMPEDANCE 100000
+/* Mask of channels which should be sampled once per sweep without oversampling,
+ all channels use 256x oversampling if not otherwise configured */
+//#define ADC_SINGLE_SHOT_MASK 0
+/* Mask of channels which should be sampled with 16x oversampling */
+//#define ADC_16X_OVERSAMPLE_MASK 0
+/* Mask of channels for which min, max, mean and RMS statistics should be kept,
+ at most 6 channels */
+//#define ADC_STATS_MASK 0
+/* Number of sweeps in each statistics window */
+//#define ADC_STATS_WINDOW 16
 
 //
 //
@@ -228,6 +240,18 @@ extern struct mcp23s17_desc_t io_expander_g;
 extern struct rn2483_desc_t rn2483_g;
 #endif
 
+/* Second RN2483 enabled if defined, frames received by both radios are merged
+   by the ground service. The other settings are the same as for the first
+   radio. */
+//#define ENABLE_LORA_RADIO_2
+/*  The uart instance used to communicate with the second radio */
+#define LORA_2_UART uart0_g
+/*  Centre frequency in hertz for the second radio */
+#define LORA_2_FREQ LORA_FREQ
+#ifdef ENABLE_LORA_RADIO_2
+extern struct rn2483_desc_t rn2483_2_g;
+#endif
+
 
 
 //
@@ -244,6 +268,12 @@ extern struct rn2483_desc_t rn2483_g;
 /* USB CDC port to be used for ground service, this is ignored if
    GROUND_UART is defined */
 #define GROUND_CDC_PORT 1
+/* Number of Reed-Solomon parity bytes for each codeword in a telemetry frame,
+   0 if frames are sent without forward error correction. Must match the
+   rocket. */
+#define GROUND_FEC_ROOTS 8
+/* Number of interleaved codewords in each telemetry frame */
+#define GROUND_FEC_DEPTH 2
 #endif
 
 #endif /* config_ground_h */
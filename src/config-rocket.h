@@ -143,6 +143,8 @@ extern struct sercom_uart_desc_t uart3_g;
 /* Define to enable echo on USB CDC port 2 */
 //#define USB_CDC_PORT_2_ECHO
 // Note: USB CDC ports should be enabled in order to minimize memory usage
+/* Define to enable the vendor specific bulk interface */
+//#define ENABLE_USB_VENDOR
 
 //
 //
@@ -185,6 +187,16 @@ extern struct mcp23s17_desc_t io_expander_g;
 #define ADC_DMA_CHAN 11
 /* Maximum impedance of source in ohms, see figure 37-5 in SAMD21 datasheet */
 #define ADC_SOURCE_IMPEDANCE 100000
+/* Mask of channels which should be sampled once per sweep without oversampling,
+ all channels use 256x oversampling if not otherwise configured */
+//#define ADC_SINGLE_SHOT_MASK 0
+/* Mask of channels which should be sampled with 16x oversampling */
+//#define ADC_16X_OVERSAMPLE_MASK 0
+/* Mask of channels for which min, max, mean and RMS statistics should be kept,
+ at most 6 channels */
+//#define ADC_STATS_MASK 0
+/* Number of sweeps in each statistics window */
+//#define ADC_STATS_WINDOW 16
 
 //
 //
@@ -238,8 +250,46 @@ extern struct rn2483_desc_t rn2483_g;
 #define ALTIMETER_CSB 0
 /* Altimeter sample period in milliseconds */
 #define ALTIMETER_PERIOD 1000
+/* Oversampling ratios for pressure and temperature (256, 512, 1024, 2048 or
+ 4096) */
+#define ALTIMETER_PRES_OSR 4096
+#define ALTIMETER_TEMP_OSR 4096
+/* Number of pressure measurements for each temperature measurement */
+#define ALTIMETER_TEMP_PERIOD 1
+/* Timer Counter used to time conversions, millis is used if not defined */
+//#define ALTIMETER_TC TC4
 extern struct ms5611_desc_t altimeter_g;
 
+//
+//
+//  Estimator
+//
+//
+
+/* Vertical state estimator enabled if defined, requires the altimeter */
+#define ENABLE_ESTIMATOR
+/* Gain for altitude correction (Q0.16) */
+#define ESTIMATOR_ALPHA 13107
+/* Gain for velocity correction (Q0.16) */
+#define ESTIMATOR_BETA 1456
+extern struct estimator_t estimator_g;
+
+//
+//
+//  Flight State
+//
+//
+
+/* Flight state machine enabled if defined, requires the estimator */
+#define ENABLE_FLIGHT_STATE
+/* ADC channel of an analog accelerometer on the vertical axis, if present */
+//#define FLIGHT_STATE_ACCEL_CHAN 0
+/* Accelerometer output in millivolts at 0 g, must be below 2000 mV */
+#define FLIGHT_STATE_ACCEL_ZERO 1650
+/* Accelerometer scale in millimetres per second squared per millivolt */
+#define FLIGHT_STATE_ACCEL_SCALE 1509
+extern struct flight_state_desc_t flight_state_g;
+
 //
 //
 // GNSS
@@ -250,6 +300,13 @@ extern struct ms5611_desc_t altimeter_g;
 #define ENABLE_GNSS
 /* UART used to communicate with GNSS */
 #define GNSS_UART uart2_g
+/* Timer Counter used to timestamp the GNSS pulse per second output, must be
+ TC4 or TC6 (the following TC is also used), disabled if not defined */
+//#define GNSS_PPS_TC TC6
+/* Pin connected to the GNSS pulse per second output */
+#define GNSS_PPS_PIN GPIO_2
+/* Event channel used to route the pulse per second output to the TC */
+#define GNSS_PPS_EVENT_CHAN 0
 
 
 
@@ -263,6 +320,16 @@ extern struct ms5611_desc_t altimeter_g;
 /* Ground service enabled if defined */
 #define ENABLE_TELEMETRY_SERVICE
 #define TELEMETRY_RATE 5000
+/* Maximum fraction of the time for which the radio may transmit, in tenths of
+ a percent */
+#define TELEMETRY_MAX_DUTY_CYCLE 100
+/* Number of telemetry samples between keyframes */
+#define TELEMETRY_KEYFRAME_INTERVAL 10
+/* Number of Reed-Solomon parity bytes for each codeword in a telemetry frame,
+   0 to disable forward error correction. Must match the ground station. */
+#define TELEMETRY_FEC_ROOTS 8
+/* Number of interleaved codewords in each telemetry frame */
+#define TELEMETRY_FEC_DEPTH 2
 #endif
 
 
@@ -28,6 +28,8 @@
 #include "mcp23s17-registers.h"
 #include "gnss-xa1110.h"
 #include "ms5611.h"
+#include "estimator.h"
+#include "flight-state.h"
 
 #include "telemetry-format.h"
 #include "telemetry.h"
@@ -563,10 +565,27 @@ static void debug_analog_print_channel (struct console_desc_t *console,
         
         console_send_str(console, " ");
         console_send_str(console, unit);
-        console_send_str(console, ")\n");
-    } else {
-        console_send_str(console, "\n");
+        console_send_str(console, ")");
     }
+    
+    struct adc_stats_t stats;
+    if (!adc_get_stats(channel, &stats)) {
+        console_send_str(console, " [min: 0x");
+        utoa(stats.min, str, 16);
+        console_send_str(console, str);
+        console_send_str(console, ", max: 0x");
+        utoa(stats.max, str, 16);
+        console_send_str(console, str);
+        console_send_str(console, ", mean: 0x");
+        utoa(stats.mean, str, 16);
+        console_send_str(console, str);
+        console_send_str(console, ", rms: 0x");
+        utoa(stats.rms, str, 16);
+        console_send_str(console, str);
+        console_send_str(console, "]");
+    }
+    
+    console_send_str(console, "\n");
 }
 
 static void debug_analog (uint8_t argc, char **argv,
@@ -725,7 +744,7 @@ static void debug_alt (uint8_t argc, char **argv,
     utoa(altimeter_g.d1, str, 10);
     console_send_str(console, str);
     console_send_str(console, ", p0 = ");
-    print_fixed_point(console, (int32_t)(altimeter_g.p0 * 100), 2);
+    print_fixed_point(console, altimeter_g.p0, 2);
     
     wdt_pat();
     
@@ -737,10 +756,35 @@ static void debug_alt (uint8_t argc, char **argv,
     console_send_str(console, str);
     
     // Altitude
-    int32_t altitude = (int32_t)(altimeter_g.altitude * 100);
     console_send_str(console, ")\nAltitude: ");
-    print_fixed_point(console, altitude, 2);
+    print_fixed_point(console, altimeter_g.altitude, 3);
     console_send_str(console, " m\n");
+    
+#ifdef ENABLE_ESTIMATOR
+    wdt_pat();
+    
+    // Estimated state
+    console_send_str(console, "\nEstimated altitude: ");
+    print_fixed_point(console, estimator_get_altitude(&estimator_g), 3);
+    console_send_str(console, " m\nEstimated velocity: ");
+    print_fixed_point(console, estimator_get_velocity(&estimator_g), 3);
+    console_send_str(console, " m/s\nPredicted apogee: ");
+    print_fixed_point(console, estimator_get_apogee(&estimator_g), 3);
+    console_send_str(console, " m (in ");
+    utoa(estimator_get_time_to_apogee(&estimator_g), str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " milliseconds)\n");
+#endif
+    
+#ifdef ENABLE_FLIGHT_STATE
+    console_send_str(console, "Flight state: ");
+    console_send_str(console, flight_state_name(flight_state_get_state(
+                                                            &flight_state_g)));
+    if (flight_state_parachute_deployed(&flight_state_g)) {
+        console_send_str(console, " (parachute deployed)");
+    }
+    console_send_str(console, "\n");
+#endif
 #endif
 }
 
@@ -1397,6 +1441,53 @@ static void debug_telem_resume (uint8_t argc, char **argv,
     telemetry_paused = 0;
 }
 
+#define DEBUG_TELEM_STATS_NAME  "telem-stats"
+#define DEBUG_TELEM_STATS_HELP  "Print the telemetry schedule and link utilisation"
+
+static void debug_telem_stats (uint8_t argc, char **argv,
+                               struct console_desc_t *console)
+{
+    const struct telemetry_schedule_t *schedule = telemetry_get_schedule();
+    char str[11];
+    
+    console_send_str(console, "Samples per frame: ");
+    utoa(schedule->samples_per_frame, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, "\nSample length: ");
+    utoa(schedule->sample_length, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " bytes");
+    
+    console_send_str(console, "\nRequested period: ");
+    utoa(schedule->requested_period, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, " ms\nSample period: ");
+    utoa(schedule->sample_period, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, " ms\nFrame period: ");
+    utoa(schedule->frame_period, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, " ms\nFrame airtime: ");
+    utoa(schedule->frame_airtime, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, " us\nUtilisation: ");
+    utoa(schedule->utilisation / 10, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, ".");
+    utoa(schedule->utilisation % 10, str, 10);
+    console_send_str(console, str);
+    
+    console_send_str(console, "%\nSamples dropped: ");
+    utoa(schedule->samples_dropped, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, "\n");
+}
+
 #define DEBUG_ADC_INIT_NAME  "adc-init"
 #define DEBUG_ADC_INIT_HELP  "Initialize ADC"
 
@@ -2082,7 +2173,7 @@ static void debug_radio_version (uint8_t argc, char **argv,
 }
 
 
-const uint8_t debug_commands_num_funcs = 24;
+const uint8_t debug_commands_num_funcs = 25;
 const struct cli_func_desc_t debug_commands_funcs[] = {
     {.func = debug_version, .name = DEBUG_VERSION_NAME, .help_string = DEBUG_VERSION_HELP},
     {.func = debug_did, .name = DEBUG_DID_NAME, .help_string = DEBUG_DID_HELP},
@@ -2103,6 +2194,7 @@ const struct cli_func_desc_t debug_commands_funcs[] = {
     {.func = debug_telem_test, .name = DEBUG_TELEM_TEST_NAME, .help_string = DEBUG_TELEM_TEST_HELP},
     {.func = debug_telem_pause, .name = DEBUG_TELEM_PAUSE_NAME, .help_string = DEBUG_TELEM_PAUSE_HELP},
     {.func = debug_telem_resume, .name = DEBUG_TELEM_RESUME_NAME, .help_string = DEBUG_TELEM_RESUME_HELP},
+    {.func = debug_telem_stats, .name = DEBUG_TELEM_STATS_NAME, .help_string = DEBUG_TELEM_STATS_HELP},
     {.func = debug_adc_init, .name = DEBUG_ADC_INIT_NAME, .help_string = DEBUG_ADC_INIT_HELP},
     {.func = debug_adc_read, .name = DEBUG_ADC_READ_NAME, .help_string = DEBUG_ADC_READ_HELP},
     {.func = debug_dac, .name = DEBUG_DAC_NAME, .help_string = DEBUG_DAC_HELP},
@@ -42,7 +42,7 @@ void init_dmac(void)
     /* Enable DMAC interupts */
     NVIC_SetPriority (DMAC_IRQn, DMA_IRQ_PRIORITY);
     NVIC_EnableIRQ(DMAC_IRQn);
-
+    
     /* Enable DMA module */
     DMAC->CTRL.bit.DMAENABLE = 0b1;
 }
@@ -228,7 +228,7 @@ void dma_start_double_buffer_to_static(uint8_t chan,
                                           DMAC_BTCTRL_SRCINC |
                                           DMAC_BTCTRL_BEATSIZE_BYTE |
                                           DMAC_BTCTRL_VALID);
-
+    
     // Set source and destination addresses
     dmacDescriptors_g[chan].SRCADDR.reg = (uint32_t)buffer1 + length1;
     dmacDescriptors_g[chan].DSTADDR.reg = (uint32_t)dest;
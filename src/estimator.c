@@ -0,0 +1,167 @@
+/**
+ * @file estimator.c
+ * @desc Vertical state estimator
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "estimator.h"
+
+/** 2^40 / (2 * ESTIMATOR_GRAVITY), converts a squared velocity (divided by
+    2^8) to the height gained while decelerating at 1 g */
+#define ESTIMATOR_APOGEE_CO     56057491
+/** 1000 * 2^32 / ESTIMATOR_GRAVITY, converts a velocity to the time taken to
+    decelerate to zero at 1 g in milliseconds */
+#define ESTIMATOR_TIME_CO       437949148
+
+
+void init_estimator (struct estimator_t *est, struct ms5611_desc_t *altimeter,
+                     uint16_t alpha, uint16_t beta)
+{
+    est->altimeter = altimeter;
+    est->alpha = alpha;
+    est->beta = beta;
+    
+    est->altitude = 0;
+    est->velocity = 0;
+    est->accel = 0;
+    est->dt = 0;
+    est->last_sample = 0;
+    
+    est->initialized = 0;
+    est->accel_valid = 0;
+}
+
+void estimator_service (struct estimator_t *est)
+{
+    if (est->altimeter == NULL) {
+        return;
+    }
+    
+    uint32_t sample = ms5611_get_sample_count(est->altimeter);
+    
+    if (sample != est->last_sample) {
+        est->last_sample = sample;
+        estimator_update_altitude(est, ms5611_get_altitude(est->altimeter),
+                                  ms5611_get_last_reading_time(est->altimeter));
+    }
+}
+
+/**
+ *  Update the cached values which depend on the interval between samples.
+ *
+ *  @param est The estimator instance
+ *  @param dt The interval in milliseconds, must not be 0
+ */
+static void estimator_set_dt (struct estimator_t *est, uint32_t dt)
+{
+    // The interval is usually the same for every sample, so the divisions only
+    // need to be done occasionally
+    est->dt = dt;
+    est->dt_s = (uint32_t)(((uint64_t)dt << 24) / 1000);
+    est->dt_recip = (1000UL << 16) / dt;
+}
+
+void estimator_update_altitude (struct estimator_t *est, int32_t altitude,
+                                uint32_t time)
+{
+    if (!est->initialized) {
+        // Start from the first sample at rest
+        est->altitude = (int64_t)altitude << 16;
+        est->velocity = 0;
+        est->last_time = time;
+        est->initialized = 1;
+        return;
+    }
+    
+    uint32_t dt = time - est->last_time;
+    if (dt == 0) {
+        // Can't do anything useful with two samples at the same time
+        return;
+    } else if (dt > 65535) {
+        // Too long since last sample, start again
+        est->initialized = 0;
+        estimator_update_altitude(est, altitude, time);
+        return;
+    }
+    est->last_time = time;
+    
+    if (dt != est->dt) {
+        estimator_set_dt(est, dt);
+    }
+    
+    /* Predict */
+    est->altitude += ((int64_t)est->velocity * est->dt_s) >> 16;
+    
+    if (est->accel_valid &&
+        ((time - est->accel_time) <= ESTIMATOR_ACCEL_TIMEOUT)) {
+        // Change in velocity (Q23.8)
+        int32_t dv = (int32_t)(((int64_t)est->accel * est->dt_s) >> 16);
+        
+        est->altitude += ((int64_t)dv * est->dt_s) >> 17;
+        est->velocity += dv;
+    }
+    
+    /* Correct */
+    int32_t residual = altitude - (int32_t)(est->altitude >> 16);
+    
+    est->altitude += (int64_t)est->alpha * residual;
+    
+    // beta * residual / dt
+    int64_t r = ((int64_t)est->beta * residual) >> 8;
+    est->velocity += (int32_t)((r * est->dt_recip) >> 16);
+}
+
+void estimator_update_accel (struct estimator_t *est, int32_t accel,
+                             uint32_t time)
+{
+    est->accel = accel;
+    est->accel_time = time;
+    est->accel_valid = 1;
+}
+
+/**
+ *  Check whether a recent acceleration measurement shows a greater
+ *  deceleration than gravity alone.
+ */
+static inline uint8_t estimator_use_accel (struct estimator_t *est)
+{
+    return (est->accel_valid &&
+            ((est->last_time - est->accel_time) <= ESTIMATOR_ACCEL_TIMEOUT) &&
+            (est->accel < -ESTIMATOR_GRAVITY));
+}
+
+int32_t estimator_get_apogee (struct estimator_t *est)
+{
+    int32_t altitude = estimator_get_altitude(est);
+    int32_t velocity = estimator_get_velocity(est);
+    
+    if (velocity <= 0) {
+        return altitude;
+    }
+    
+    int64_t v_sq = (int64_t)velocity * velocity;
+    
+    if (estimator_use_accel(est)) {
+        return altitude + (int32_t)(v_sq / (2 * (int64_t)-est->accel));
+    }
+    
+    return altitude + (int32_t)(((v_sq >> 8) * ESTIMATOR_APOGEE_CO) >> 32);
+}
+
+uint32_t estimator_get_time_to_apogee (struct estimator_t *est)
+{
+    int32_t velocity = estimator_get_velocity(est);
+    
+    if (velocity <= 0) {
+        return 0;
+    }
+    
+    if (estimator_use_accel(est)) {
+        return (uint32_t)(((int64_t)velocity * 1000) / -est->accel);
+    }
+    
+    return (uint32_t)(((uint64_t)velocity * ESTIMATOR_TIME_CO) >> 32);
+}
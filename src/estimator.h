@@ -0,0 +1,156 @@
+/**
+ * @file estimator.h
+ * @desc Vertical state estimator
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef estimator_h
+#define estimator_h
+
+#include "global.h"
+
+#include "ms5611.h"
+
+/** Standard gravity in millimetres per second squared */
+#define ESTIMATOR_GRAVITY   9807
+
+/** Time in milliseconds after which an acceleration measurement is no longer
+    used */
+#define ESTIMATOR_ACCEL_TIMEOUT 100
+
+struct estimator_t {
+    /** Altimeter from which samples are taken, may be NULL */
+    struct ms5611_desc_t *altimeter;
+    
+    /** Estimated altitude in millimetres (Q47.16) */
+    int64_t altitude;
+    /** Estimated vertical velocity in millimetres per second (Q23.8) */
+    int32_t velocity;
+    /** Most recently measured vertical acceleration in millimetres per second
+        squared */
+    int32_t accel;
+    
+    /** Time of the last altitude sample */
+    uint32_t last_time;
+    /** Time of the last acceleration sample */
+    uint32_t accel_time;
+    /** Number of the last sample taken from the altimeter */
+    uint32_t last_sample;
+    
+    /** Interval between the last two altitude samples in milliseconds */
+    uint32_t dt;
+    /** Interval in seconds (Q8.24) */
+    uint32_t dt_s;
+    /** Reciprocal of interval in seconds (Q15.16) */
+    uint32_t dt_recip;
+    
+    /** Gain for altitude correction (Q0.16) */
+    uint16_t alpha;
+    /** Gain for velocity correction (Q0.16) */
+    uint16_t beta;
+    
+    /** Set once the first altitude sample has been received */
+    uint8_t initialized:1;
+    /** Set if an acceleration measurement has been received */
+    uint8_t accel_valid:1;
+};
+
+/**
+ *  Initialize a vertical state estimator.
+ *
+ *  The estimator is an alpha-beta filter, which is equivalent to a steady
+ *  state Kalman filter with a constant velocity model. Acceleration
+ *  measurements, when they are available, are used as a control input.
+ *
+ *  @param est The estimator instance to be initialized
+ *  @param altimeter The altimeter from which samples should be taken by
+ *                   estimator_service, may be NULL if samples are provided
+ *                   with estimator_update_altitude
+ *  @param alpha Gain for altitude correction (Q0.16)
+ *  @param beta Gain for velocity correction (Q0.16)
+ */
+extern void init_estimator (struct estimator_t *est,
+                            struct ms5611_desc_t *altimeter, uint16_t alpha,
+                            uint16_t beta);
+
+/**
+ *  Service to be run in each iteration of the main loop. Passes any new
+ *  samples from the altimeter to the estimator.
+ *
+ *  @param est The estimator instance
+ */
+extern void estimator_service (struct estimator_t *est);
+
+/**
+ *  Update the estimate with an altitude sample.
+ *
+ *  @param est The estimator instance
+ *  @param altitude The measured altitude in millimetres
+ *  @param time The time at which the sample was taken in milliseconds
+ */
+extern void estimator_update_altitude (struct estimator_t *est,
+                                       int32_t altitude, uint32_t time);
+
+/**
+ *  Provide a vertical acceleration measurement to the estimator. The
+ *  acceleration is used when predicting the state at the next altitude
+ *  sample.
+ *
+ *  @param est The estimator instance
+ *  @param accel The vertical acceleration in millimetres per second squared,
+ *               with gravity removed so that it is zero at rest
+ *  @param time The time at which the sample was taken in milliseconds
+ */
+extern void estimator_update_accel (struct estimator_t *est, int32_t accel,
+                                    uint32_t time);
+
+/**
+ *  Get the estimated altitude.
+ *
+ *  @param est The estimator instance
+ *
+ *  @return The estimated altitude in millimetres
+ */
+static inline int32_t estimator_get_altitude (struct estimator_t *est)
+{
+    return (int32_t)(est->altitude >> 16);
+}
+
+/**
+ *  Get the estimated vertical velocity.
+ *
+ *  @param est The estimator instance
+ *
+ *  @return The estimated vertical velocity in millimetres per second
+ */
+static inline int32_t estimator_get_velocity (struct estimator_t *est)
+{
+    return est->velocity >> 8;
+}
+
+/**
+ *  Get the predicted altitude at apogee. The prediction assumes that the only
+ *  force acting on the vehicle is gravity, unless a greater deceleration has
+ *  been measured.
+ *
+ *  @param est The estimator instance
+ *
+ *  @return The predicted apogee altitude in millimetres, or the current
+ *          altitude if the vehicle is not ascending
+ */
+extern int32_t estimator_get_apogee (struct estimator_t *est);
+
+/**
+ *  Get the predicted time until apogee.
+ *
+ *  @param est The estimator instance
+ *
+ *  @return The predicted time until apogee in milliseconds, or 0 if the
+ *          vehicle is not ascending
+ */
+extern uint32_t estimator_get_time_to_apogee (struct estimator_t *est);
+
+#endif /* estimator_h */
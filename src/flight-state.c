@@ -0,0 +1,327 @@
+/**
+ * @file flight-state.c
+ * @desc Flight phase state machine
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "flight-state.h"
+
+#include "adc.h"
+
+/** The ADC measures against a 1 V reference, a gain of 1/2 lets accelerometer
+    outputs up to 2 V, such as a 3.3 V part at rest, be measured */
+#define FLIGHT_STATE_ACCEL_GAIN         ADC_GAIN_DIV2
+/** Oversampling for the accelerometer's channel, the ADC's default */
+#define FLIGHT_STATE_ACCEL_OVERSAMPLE   ADC_OVERSAMPLE_256X
+
+/*
+ *  The estimator's gains are per sample, so changing the altimeter period
+ *  while accelerating causes a transient in the velocity estimate. Pre-flight
+ *  uses the same period as ascent so that nothing changes at launch.
+ *
+ *  At an OSR of 4096 a reading takes about 20 ms for the pressure and
+ *  temperature conversions, periods which the altimeter can not meet are
+ *  raised to its minimum period when they are applied.
+ */
+const struct flight_state_rates_t flight_state_default_rates[] = {
+    [FLIGHT_STATE_STANDBY] =            { .altimeter_period = 100,
+                                          .telemetry_period = 5000 },
+    [FLIGHT_STATE_PRE_FLIGHT] =         { .altimeter_period = 20,
+                                          .telemetry_period = 2000 },
+    [FLIGHT_STATE_POWERED_ASCENT] =     { .altimeter_period = 20,
+                                          .telemetry_period = 500 },
+    [FLIGHT_STATE_COASTING_ASCENT] =    { .altimeter_period = 20,
+                                          .telemetry_period = 500 },
+    [FLIGHT_STATE_DESCENT] =            { .altimeter_period = 20,
+                                          .telemetry_period = 1000 },
+    [FLIGHT_STATE_RECOVERY] =           { .altimeter_period = 1000,
+                                          .telemetry_period = 5000 }
+};
+
+static const char *const flight_state_names[] = {
+    [FLIGHT_STATE_STANDBY] = "standby",
+    [FLIGHT_STATE_PRE_FLIGHT] = "pre-flight",
+    [FLIGHT_STATE_POWERED_ASCENT] = "powered ascent",
+    [FLIGHT_STATE_COASTING_ASCENT] = "coasting ascent",
+    [FLIGHT_STATE_DESCENT] = "descent",
+    [FLIGHT_STATE_RECOVERY] = "recovery"
+};
+
+
+/**
+ *  Change to a new state.
+ *
+ *  @param fs The flight state instance
+ *  @param state The new state
+ *  @param time The time of the sample which caused the transition
+ */
+static void flight_state_transition (struct flight_state_desc_t *fs,
+                                     enum flight_state state, uint32_t time)
+{
+    fs->state = state;
+    fs->transition_time[state] = time;
+    fs->debounce_active = 0;
+    
+    struct ms5611_desc_t *altimeter = fs->estimator->altimeter;
+    if (altimeter != NULL) {
+        uint32_t period = fs->rates[state].altimeter_period;
+        if (period < ms5611_get_min_period(altimeter)) {
+            period = ms5611_get_min_period(altimeter);
+        }
+        ms5611_set_period(altimeter, period);
+    }
+}
+
+/**
+ *  Check whether a condition has been met continuously for long enough.
+ *
+ *  @param fs The flight state instance
+ *  @param condition Whether the condition is met by the current sample
+ *  @param time The time of the current sample
+ *  @param duration The time in milliseconds for which the condition must be
+ *                  met
+ *
+ *  @return 1 if the condition has been met for at least the given duration
+ */
+static uint8_t flight_state_debounce (struct flight_state_desc_t *fs,
+                                      uint8_t condition, uint32_t time,
+                                      uint32_t duration)
+{
+    if (!condition) {
+        fs->debounce_active = 0;
+        return 0;
+    } else if (!fs->debounce_active) {
+        fs->debounce_active = 1;
+        fs->debounce_start = time;
+    }
+    
+    return (time - fs->debounce_start) >= duration;
+}
+
+/**
+ *  Check whether a velocity is slow enough that the vehicle could be on the
+ *  ground.
+ */
+static inline uint8_t flight_state_at_rest (int32_t velocity)
+{
+    return ((velocity < FLIGHT_STATE_LANDING_VELOCITY) &&
+            (velocity > -FLIGHT_STATE_LANDING_VELOCITY));
+}
+
+void init_flight_state (struct flight_state_desc_t *fs,
+                        struct estimator_t *estimator,
+                        const struct flight_state_rates_t *rates)
+{
+    fs->estimator = estimator;
+    fs->rates = rates;
+    
+    for (int i = 0; i < FLIGHT_STATE_NUM_STATES; i++) {
+        fs->transition_time[i] = 0;
+    }
+    
+    fs->last_update = 0;
+    fs->ground_altitude = 0;
+    fs->max_altitude = INT32_MIN;
+    fs->max_velocity = INT32_MIN;
+    fs->accel_channel = FLIGHT_STATE_NO_ACCEL;
+    fs->parachute_deployed = 0;
+    fs->accel_valid = 0;
+    
+    flight_state_transition(fs, FLIGHT_STATE_STANDBY, 0);
+}
+
+void flight_state_use_accel (struct flight_state_desc_t *fs, uint8_t channel,
+                             uint16_t zero, int16_t scale)
+{
+    fs->accel_channel = channel;
+    fs->accel_zero = zero;
+    fs->accel_scale = scale;
+    fs->accel_valid = 0;
+    
+    adc_configure_channels((1UL << channel), FLIGHT_STATE_ACCEL_OVERSAMPLE,
+                           FLIGHT_STATE_ACCEL_GAIN);
+}
+
+/**
+ *  Take a new acceleration measurement if the ADC has completed a sweep.
+ *
+ *  @param fs The flight state instance
+ */
+static void flight_state_update_accel (struct flight_state_desc_t *fs)
+{
+    uint32_t sweep_time = adc_get_last_sweep_time();
+    
+    if (fs->accel_valid && (sweep_time == fs->accel_time)) {
+        return;
+    }
+    
+    int32_t mv = (int32_t)adc_get_value_millivolts(fs->accel_channel);
+    
+    // The accelerometer measures 1 g at rest, remove gravity so that the
+    // acceleration is relative to the ground
+    fs->accel = (((mv - (int32_t)fs->accel_zero) * fs->accel_scale) -
+                 ESTIMATOR_GRAVITY);
+    fs->accel_time = sweep_time;
+    fs->accel_valid = 1;
+    
+    estimator_update_accel(fs->estimator, fs->accel, sweep_time);
+}
+
+/*
+ *  State handlers, each is called once for each new estimate while in the
+ *  corresponding state.
+ */
+
+static void flight_state_standby (struct flight_state_desc_t *fs,
+                                  uint32_t time, int32_t altitude,
+                                  int32_t velocity)
+{
+    // Wait for the estimator to settle on the ground altitude
+    if (flight_state_debounce(fs, flight_state_at_rest(velocity), time,
+                              FLIGHT_STATE_STANDBY_TIME)) {
+        fs->ground_altitude = altitude;
+        flight_state_transition(fs, FLIGHT_STATE_PRE_FLIGHT, time);
+    }
+}
+
+static void flight_state_pre_flight (struct flight_state_desc_t *fs,
+                                     uint32_t time, int32_t altitude,
+                                     int32_t velocity)
+{
+    if (flight_state_at_rest(velocity)) {
+        // Follow slow changes in ground pressure
+        fs->ground_altitude += (altitude - fs->ground_altitude) >> 6;
+        fs->max_altitude = altitude;
+        fs->max_velocity = velocity;
+    }
+    
+    uint8_t launch = ((velocity > FLIGHT_STATE_LAUNCH_VELOCITY) &&
+                      ((altitude - fs->ground_altitude) >
+                       FLIGHT_STATE_LAUNCH_HEIGHT));
+    
+    if (fs->accel_valid && (fs->accel > FLIGHT_STATE_LAUNCH_ACCEL)) {
+        launch = 1;
+    }
+    
+    if (flight_state_debounce(fs, launch, time,
+                              FLIGHT_STATE_LAUNCH_DEBOUNCE)) {
+        flight_state_transition(fs, FLIGHT_STATE_POWERED_ASCENT,
+                                fs->debounce_start);
+    }
+}
+
+static void flight_state_powered_ascent (struct flight_state_desc_t *fs,
+                                         uint32_t time, int32_t altitude,
+                                         int32_t velocity)
+{
+    uint8_t burnout;
+    
+    if (fs->accel_valid) {
+        // Thrust no longer exceeds drag
+        burnout = fs->accel < 0;
+    } else {
+        // Vehicle has started slowing down
+        burnout = velocity < (fs->max_velocity -
+                              FLIGHT_STATE_BURNOUT_VELOCITY_DROP);
+    }
+    
+    if (flight_state_debounce(fs, burnout, time,
+                              FLIGHT_STATE_BURNOUT_DEBOUNCE)) {
+        flight_state_transition(fs, FLIGHT_STATE_COASTING_ASCENT,
+                                fs->debounce_start);
+    }
+}
+
+static void flight_state_coasting_ascent (struct flight_state_desc_t *fs,
+                                          uint32_t time, int32_t altitude,
+                                          int32_t velocity)
+{
+    uint8_t apogee = ((velocity < 0) ||
+                      (altitude < (fs->max_altitude -
+                                   FLIGHT_STATE_APOGEE_ALTITUDE_DROP)));
+    
+    if (flight_state_debounce(fs, apogee, time,
+                              FLIGHT_STATE_APOGEE_DEBOUNCE)) {
+        flight_state_transition(fs, FLIGHT_STATE_DESCENT, fs->debounce_start);
+    }
+}
+
+static void flight_state_descent (struct flight_state_desc_t *fs,
+                                  uint32_t time, int32_t altitude,
+                                  int32_t velocity)
+{
+    if (!fs->parachute_deployed) {
+        // Look for a slow descent once the vehicle has had time to accelerate
+        // after apogee
+        uint32_t since_apogee = time - fs->transition_time[FLIGHT_STATE_DESCENT];
+        uint8_t slow = ((since_apogee >= FLIGHT_STATE_PARACHUTE_DELAY) &&
+                        (velocity > -FLIGHT_STATE_PARACHUTE_VELOCITY));
+        
+        if (flight_state_debounce(fs, slow, time,
+                                  FLIGHT_STATE_PARACHUTE_DEBOUNCE)) {
+            fs->parachute_deployed = 1;
+            fs->debounce_active = 0;
+        }
+    } else if (flight_state_debounce(fs, flight_state_at_rest(velocity), time,
+                                     FLIGHT_STATE_LANDING_DEBOUNCE)) {
+        flight_state_transition(fs, FLIGHT_STATE_RECOVERY, fs->debounce_start);
+    }
+}
+
+static void flight_state_recovery (struct flight_state_desc_t *fs,
+                                   uint32_t time, int32_t altitude,
+                                   int32_t velocity)
+{
+    // Nothing left to detect
+}
+
+typedef void (*flight_state_handler_t)(struct flight_state_desc_t *fs,
+                                       uint32_t time, int32_t altitude,
+                                       int32_t velocity);
+
+static const flight_state_handler_t flight_state_handlers[] = {
+    [FLIGHT_STATE_STANDBY] = flight_state_standby,
+    [FLIGHT_STATE_PRE_FLIGHT] = flight_state_pre_flight,
+    [FLIGHT_STATE_POWERED_ASCENT] = flight_state_powered_ascent,
+    [FLIGHT_STATE_COASTING_ASCENT] = flight_state_coasting_ascent,
+    [FLIGHT_STATE_DESCENT] = flight_state_descent,
+    [FLIGHT_STATE_RECOVERY] = flight_state_recovery
+};
+
+void flight_state_service (struct flight_state_desc_t *fs)
+{
+    if (fs->accel_channel != FLIGHT_STATE_NO_ACCEL) {
+        flight_state_update_accel(fs);
+    }
+    
+    struct estimator_t *est = fs->estimator;
+    
+    if (!est->initialized || (est->last_time == fs->last_update)) {
+        // No new estimate
+        return;
+    }
+    fs->last_update = est->last_time;
+    
+    int32_t altitude = estimator_get_altitude(est);
+    int32_t velocity = estimator_get_velocity(est);
+    
+    if (altitude > fs->max_altitude) {
+        fs->max_altitude = altitude;
+    }
+    if (velocity > fs->max_velocity) {
+        fs->max_velocity = velocity;
+    }
+    
+    flight_state_handlers[fs->state](fs, est->last_time, altitude, velocity);
+}
+
+const char *flight_state_name (enum flight_state state)
+{
+    if (state >= FLIGHT_STATE_NUM_STATES) {
+        return "unknown";
+    }
+    return flight_state_names[state];
+}
@@ -0,0 +1,228 @@
+/**
+ * @file flight-state.h
+ * @desc Flight phase state machine
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef flight_state_h
+#define flight_state_h
+
+#include "global.h"
+
+#include "estimator.h"
+
+/** Time in milliseconds for which the estimator must have been running before
+    leaving standby */
+#define FLIGHT_STATE_STANDBY_TIME           5000
+
+/** Velocity in millimetres per second above which launch is detected */
+#define FLIGHT_STATE_LAUNCH_VELOCITY        10000
+/** Height above the ground in millimetres above which launch is detected */
+#define FLIGHT_STATE_LAUNCH_HEIGHT          5000
+/** Acceleration in millimetres per second squared above which launch is
+    detected */
+#define FLIGHT_STATE_LAUNCH_ACCEL           29421
+/** Time in milliseconds for which launch conditions must be met */
+#define FLIGHT_STATE_LAUNCH_DEBOUNCE        50
+
+/** Drop from the peak velocity in millimetres per second at which burnout is
+    detected when no accelerometer is available */
+#define FLIGHT_STATE_BURNOUT_VELOCITY_DROP  2000
+/** Time in milliseconds for which burnout conditions must be met */
+#define FLIGHT_STATE_BURNOUT_DEBOUNCE       100
+
+/** Drop from the peak altitude in millimetres at which apogee is detected
+    regardless of the estimated velocity */
+#define FLIGHT_STATE_APOGEE_ALTITUDE_DROP   10000
+/** Time in milliseconds for which apogee conditions must be met */
+#define FLIGHT_STATE_APOGEE_DEBOUNCE        200
+
+/** Time in milliseconds after apogee before a parachute can be detected */
+#define FLIGHT_STATE_PARACHUTE_DELAY        3000
+/** Descent rate in millimetres per second below which a parachute is
+    considered to be deployed */
+#define FLIGHT_STATE_PARACHUTE_VELOCITY     25000
+/** Time in milliseconds for which the parachute conditions must be met */
+#define FLIGHT_STATE_PARACHUTE_DEBOUNCE     1000
+
+/** Speed in millimetres per second below which the vehicle could have
+    landed */
+#define FLIGHT_STATE_LANDING_VELOCITY       1000
+/** Time in milliseconds for which landing conditions must be met */
+#define FLIGHT_STATE_LANDING_DEBOUNCE       5000
+
+/** Value for accel_channel when no accelerometer is used */
+#define FLIGHT_STATE_NO_ACCEL               0xFF
+
+enum flight_state {
+    /** On the ground, waiting for the estimator to settle */
+    FLIGHT_STATE_STANDBY,
+    /** On the ground, ready for launch */
+    FLIGHT_STATE_PRE_FLIGHT,
+    /** Ascending with the motor burning */
+    FLIGHT_STATE_POWERED_ASCENT,
+    /** Ascending after motor burnout */
+    FLIGHT_STATE_COASTING_ASCENT,
+    /** Descending after apogee */
+    FLIGHT_STATE_DESCENT,
+    /** Landed */
+    FLIGHT_STATE_RECOVERY,
+    
+    FLIGHT_STATE_NUM_STATES
+};
+
+struct flight_state_rates_t {
+    /** Period at which the altimeter is sampled in milliseconds */
+    uint16_t altimeter_period;
+    /** Period at which telemetry is sent in milliseconds */
+    uint16_t telemetry_period;
+};
+
+struct flight_state_desc_t {
+    /** Estimator from which the vehicle state is taken */
+    struct estimator_t *estimator;
+    /** Sampling and telemetry rates for each state */
+    const struct flight_state_rates_t *rates;
+    
+    /** Time at which each state was entered, 0 if it has not been entered */
+    uint32_t transition_time[FLIGHT_STATE_NUM_STATES];
+    
+    /** Time of the last estimator update which was processed */
+    uint32_t last_update;
+    /** Time at which the conditions for the next transition were first met */
+    uint32_t debounce_start;
+    
+    /** Estimated altitude of the ground in millimetres */
+    int32_t ground_altitude;
+    /** Highest estimated altitude in millimetres */
+    int32_t max_altitude;
+    /** Highest estimated velocity in millimetres per second */
+    int32_t max_velocity;
+    
+    /** Last measured vertical acceleration in millimetres per second squared,
+        with gravity removed */
+    int32_t accel;
+    /** Time of the ADC sweep from which accel was measured */
+    uint32_t accel_time;
+    /** Accelerometer output in millivolts at 0 g */
+    uint16_t accel_zero;
+    /** Accelerometer scale in millimetres per second squared per millivolt */
+    int16_t accel_scale;
+    /** ADC channel for accelerometer, FLIGHT_STATE_NO_ACCEL if not used */
+    uint8_t accel_channel;
+    
+    /** Current state */
+    uint8_t state:3;
+    /** Set when the conditions for the next transition are being met */
+    uint8_t debounce_active:1;
+    /** Set when a parachute is believed to be deployed */
+    uint8_t parachute_deployed:1;
+    /** Set when an acceleration measurement has been taken */
+    uint8_t accel_valid:1;
+};
+
+/** Default sampling and telemetry rates for each state */
+extern const struct flight_state_rates_t flight_state_default_rates[];
+
+/**
+ *  Initialize the flight state machine.
+ *
+ *  @param fs The flight state instance to be initialized
+ *  @param estimator The estimator from which the vehicle state is taken
+ *  @param rates Table of sampling and telemetry rates indexed by state
+ */
+extern void init_flight_state (struct flight_state_desc_t *fs,
+                               struct estimator_t *estimator,
+                               const struct flight_state_rates_t *rates);
+
+/**
+ *  Use an analog accelerometer aligned with the vehicle's vertical axis for
+ *  launch and burnout detection. Acceleration measurements are also provided
+ *  to the estimator. The channel is sampled with a gain of 1/2, so outputs of
+ *  up to 2 V can be measured.
+ *
+ *  @param fs The flight state instance
+ *  @param channel The ADC channel to which the accelerometer is connected
+ *  @param zero The accelerometer output in millivolts at 0 g
+ *  @param scale The accelerometer scale in millimetres per second squared per
+ *               millivolt, negative if the accelerometer is inverted
+ */
+extern void flight_state_use_accel (struct flight_state_desc_t *fs,
+                                    uint8_t channel, uint16_t zero,
+                                    int16_t scale);
+
+/**
+ *  Service to be run in each iteration of the main loop. Checks for state
+ *  transitions once for each estimator update, the execution time does not
+ *  depend on the state.
+ *
+ *  @param fs The flight state instance
+ */
+extern void flight_state_service (struct flight_state_desc_t *fs);
+
+/**
+ *  Get the current flight state.
+ *
+ *  @param fs The flight state instance
+ *
+ *  @return The current state
+ */
+static inline enum flight_state flight_state_get_state (
+                                                struct flight_state_desc_t *fs)
+{
+    return (enum flight_state)fs->state;
+}
+
+/**
+ *  Get the time at which a state was entered.
+ *
+ *  @param fs The flight state instance
+ *  @param state The state
+ *
+ *  @return The value of millis when the state was entered, or 0 if it has not
+ *          been entered
+ */
+static inline uint32_t flight_state_get_transition_time (
+                                                struct flight_state_desc_t *fs,
+                                                enum flight_state state)
+{
+    return fs->transition_time[state];
+}
+
+/**
+ *  Get whether a parachute is believed to be deployed.
+ *
+ *  @param fs The flight state instance
+ */
+static inline uint8_t flight_state_parachute_deployed (
+                                                struct flight_state_desc_t *fs)
+{
+    return fs->parachute_deployed;
+}
+
+/**
+ *  Get the period at which telemetry should be sent in the current state.
+ *
+ *  @param fs The flight state instance
+ *
+ *  @return The telemetry period in milliseconds
+ */
+static inline uint32_t flight_state_get_telemetry_period (
+                                                struct flight_state_desc_t *fs)
+{
+    return fs->rates[fs->state].telemetry_period;
+}
+
+/**
+ *  Get a string describing a flight state.
+ *
+ *  @param state The state
+ *
+ *  @return A string with the name of the state
+ */
+extern const char *flight_state_name (enum flight_state state);
+
+#endif /* flight_state_h */
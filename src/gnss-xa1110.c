@@ -6,67 +6,47 @@
  * @last-edit 2019-07-25
  */
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "gnss-xa1110.h"
 
-
-#define I(x) ((x) - '0')
+#include "evsys.h"
+#include "tc.h"
 
 
 struct gnss gnss_xa1110_descriptor;
 
+/** Allowed error in the measured PPS timer frequency, as a right shift of the
+    nominal frequency */
+#define GNSS_PPS_TOLERANCE_SHIFT    5
 
 /**
- *  Parse the latitude and longitude from a NMEA sentence.
- *
- *  @param lat The latitude string
- *  @param north_south North-South indicator string
- *  @param lon The longitude string
- *  @param east_west East-West indicator string
- *  @param desc GNSS descriptor in which coordinates should be stored
+ *  State for pulse per second timestamping.
  */
-static void gnss_parse_coordinates (char *lat, char *north_south, char *lon,
-                                    char *east_west, struct gnss *desc)
-{
-    /* Latitude */
-    // Whole degrees
-    desc->latitude =  I(lat[0]) * 6000000;
-    desc->latitude += I(lat[1]) * 600000;
-    // Whole minutes
-    desc->latitude += I(lat[2]) * 100000;
-    desc->latitude += I(lat[3]) * 10000;
-    // Fractional minutes
-    desc->latitude += I(lat[5]) * 1000;
-    desc->latitude += I(lat[6]) * 100;
-    desc->latitude += I(lat[7]) * 10;
-    desc->latitude += I(lat[8]) * 1;
-    
-    // North/South
-    if (north_south[0] == 'S') {
-        desc->latitude *= -1;
-    }
-    
-    /* Longitude */
-    // Whole degrees
-    desc->longitude =  I(lon[0]) * 60000000;
-    desc->longitude += I(lon[1]) * 6000000;
-    desc->longitude += I(lon[2]) * 600000;
-    // Whole minutes
-    desc->longitude += I(lon[3]) * 100000;
-    desc->longitude += I(lon[4]) * 10000;
-    // Fractional minutes
-    desc->longitude += I(lon[6]) * 1000;
-    desc->longitude += I(lon[7]) * 100;
-    desc->longitude += I(lon[8]) * 10;
-    desc->longitude += I(lon[9]) * 1;
-    
-    // East/West
-    if (east_west[0] == 'W') {
-        desc->longitude *= -1;
-    }
-}
+static struct {
+    /** Timer Counter used to capture the pulse per second output */
+    Tc *tc;
+    /** Nominal timer frequency in Hz */
+    uint32_t nominal_ticks_per_second;
+    /** Timer ticks between the last two pulses that were one second apart */
+    uint32_t ticks_per_second;
+    /** Timer count captured at the most recent pulse */
+    volatile uint32_t capture;
+    /** Value of millis when the most recent pulse was captured */
+    volatile uint32_t capture_millis;
+    /** Most recent pulse which was matched with a UTC time */
+    struct gnss_time_sync_t sync;
+    /** Incremented before and after sync is updated, odd while the update is
+        in progress */
+    volatile uint8_t sync_sequence;
+    /** Set once a pulse has been captured */
+    uint8_t have_capture:1;
+    /** Set once a pulse has been matched with a UTC time */
+    uint8_t synced:1;
+} gnss_pps_g;
+
 
 /**
  *  Determine if a year is a leap year.
@@ -108,28 +88,32 @@ static const uint16_t month_add[] = {0, 31, 31 + 28, 2*31 + 28, 2*31 + 30 + 28,
     3*31 + 30 + 28, 3*31 + 2*30 + 28, 4*31 + 2*30 + 28, 5*31 + 2*30 + 28,
     5*31 + 3*30 + 28, 6*31 + 3*30 + 28, 6*31 + 4*30 + 28};
 
+
 /**
- *  Parse the time from a NMEA sentence.
+ *  Convert a date and time from a NMEA sentence to Unix time.
  *
- *  @param date The date string
- *  @param time The time string
+ *  @param date The date as the integer ddmmyy
+ *  @param time The time as the integer hhmmss
  *
- *  @return Unix time representation of string time
+ *  @return Unix time representation of the date and time
  */
-static uint32_t gnss_parse_time (char *date, char *time)
+static uint32_t gnss_make_time (uint32_t date, uint32_t time)
 {
     /* Start at January 1st 2000 */
     uint32_t unix_time = 946684800;
     
     /* Date */
     // Convert date to days since January 1st 2000
+    uint32_t years_since_2000 = date % 100;
+    date /= 100;
+    uint8_t month = date % 100;
+    // Treat an invalid month as January
+    month = ((month >= 1) && (month <= 12)) ? (month - 1) : 0;
     // Days
-    uint32_t days = (I(date[0]) * 10) + I(date[1]) - 1;
+    uint32_t days = (date / 100) - 1;
     // Months
-    uint8_t month = (I(date[2]) * 10) + I(date[3]) - 1;
     days += month_add[month];
     // Years since 2000
-    uint32_t years_since_2000 = (I(date[4]) * 10) + I(date[5]);
     days += years_since_2000 * 365;
     // Leap years since 2000 (including 2000 its self, not including the current
     // year)
@@ -141,360 +125,852 @@ static uint32_t gnss_parse_time (char *date, char *time)
     unix_time += days * 24 * 60 * 60;
     
     /* Time */
-    // Hours
-    unix_time += I(time[0]) * 60 * 60 * 10;
-    unix_time += I(time[1]) * 60 * 60;
+    // Seconds
+    unix_time += time % 100;
+    time /= 100;
     // Minutes
-    unix_time += I(time[2]) * 60 * 10;
-    unix_time += I(time[3]) * 60;
-    // Whole Seconds
-    unix_time += I(time[4]) * 10;
-    unix_time += I(time[5]);
+    unix_time += (time % 100) * 60;
+    // Hours
+    unix_time += (time / 100) * 60 * 60;
     
     return unix_time;
 }
 
 /**
- *  Parse a floating point number an integer with a given scaling factor.
- *  The number will be parsed up to log(scale) decimal places. The returned
- *  value is scale times the value in the string.
+ *  Convert a latitude or longitude from a NMEA sentence to 100 microminutes
+ *  per least significant bit.
  *
- *  @param str The string containing the floating point number
- *  @param scale The scaling factor, must be a power of 10
+ *  @param value The coordinate as an integer in the form dddmmmmmm (degrees
+ *               and ten-thousandths of a minute)
  *
- *  @return The parsed integer
+ *  @return The coordinate in 100 microminutes per least significant bit
  */
-static int32_t gnss_parse_fp (char *str, uint32_t scale)
+static inline int32_t gnss_make_coordinate (int32_t value)
 {
-    int32_t out = 0;
-    
-    /* Find decimal place */
-    char *decimal = str;
-    for (; (*decimal != '.') && (*decimal != '\0'); decimal++);
-    
-    /* Whole part */
-    int32_t weight = scale;
-    char *c = decimal - 1;
-    
-    for (; (*c != '\0') && (*c != '-'); c--) {
-        out += I(*c) * weight;
-        weight *= 10;
-    }
-    
-    int8_t negation = (*c == '-' ? -1 : 1);
-    
-    /* Fractional part */
-    if (*decimal == '\0') {
-        // No fractional part
-        return out * negation;
-    }
-    
-    weight = scale;
-    c = decimal + 1;
-    
-    for (; (*c != '\0') && (weight != 1); c++) {
-        weight /= 10;
-        out += I(*c) * weight;
-    }
-    
-    return out * negation;
+    return ((value / 1000000) * 600000) + (value % 1000000);
 }
 
 
+/*
+ *  Incremental NMEA parser
+ *
+ *  Sentences are parsed one byte at a time as they are received. Numeric fields
+ *  are accumulated directly in to integers and each sentence's data is stored
+ *  in a pending structure. Once the checksum has been verified the pending
+ *  data is queued, and gnss_xa1110_service copies it in to the GNSS
+ *  descriptor from the main loop. The descriptor is never written from the
+ *  UART interrupt, so readers in the main loop always see the fields of a
+ *  single fix together.
+ */
+
+/** Maximum number of digits accumulated for a numeric field */
+#define GNSS_FIELD_MAX_DIGITS   9
+/** Length of a NMEA address field (talker and sentence type) */
+#define GNSS_ADDRESS_LEN        5
+/** Number of bits used for each character of a packed address */
+#define GNSS_ADDRESS_CHAR_BITS  5
+
+/**
+ *  Pack the five characters of a NMEA address field in to an integer which can
+ *  be compared with a single instruction. Only the low five bits of each
+ *  character are kept, which is enough to distinguish upper and lower case
+ *  letters without regard to case.
+ */
+#define GNSS_ADDRESS(a, b, c, d, e) ((((uint32_t)(a) & 0x1F) << 20) | \
+                                     (((uint32_t)(b) & 0x1F) << 15) | \
+                                     (((uint32_t)(c) & 0x1F) << 10) | \
+                                     (((uint32_t)(d) & 0x1F) << 5) | \
+                                     ((uint32_t)(e) & 0x1F))
+
+/** Bit mask of field numbers from first to last (inclusive) */
+#define GNSS_FIELDS(first, last) ((0xFFFFFFFFUL >> (31 - (last))) & \
+                                  (0xFFFFFFFFUL << (first)))
+/** Number of satellites described by a GSV sentence */
+#define GNSS_GSV_SATS           4
+/** Number of verified sentences which can wait for gnss_xa1110_service */
+#define GNSS_READY_LEN          4
+
+enum gnss_parse_state {
+    /** Waiting for the start of a sentence */
+    GNSS_PARSE_IDLE,
+    /** Receiving the address field */
+    GNSS_PARSE_ADDRESS,
+    /** Receiving a data field */
+    GNSS_PARSE_FIELD,
+    /** Receiving the first checksum digit */
+    GNSS_PARSE_CHECKSUM_HIGH,
+    /** Receiving the second checksum digit */
+    GNSS_PARSE_CHECKSUM_LOW
+};
 
+/**
+ *  A field as it is received.
+ */
+struct gnss_field_t {
+    /** All of the digits in the field as an integer, ignoring the decimal
+        point */
+    int32_t value;
+    /** Number of characters in field */
+    uint8_t length;
+    /** Number of digits in value */
+    uint8_t digits;
+    /** Number of digits in value after the decimal point */
+    uint8_t frac_digits;
+    /** First character of field */
+    char first;
+    /** Bit mask of keywords which the field could match */
+    uint8_t keywords;
+    /** Set if the field started with a minus sign */
+    uint8_t negative:1;
+    /** Set once a decimal point has been received */
+    uint8_t point:1;
+};
+
+/**
+ *  Data from a sentence which has not yet been verified.
+ */
+union gnss_pending_t {
+    struct {
+        uint32_t time;
+        uint32_t date;
+        int32_t latitude;
+        int32_t longitude;
+        int16_t speed;
+        int16_t course;
+        uint8_t has_time:1;
+        uint8_t has_date:1;
+        uint8_t valid:1;
+    } rmc;
+    struct {
+        int32_t altitude;
+        uint8_t fix_quality;
+        uint8_t num_sats_in_use;
+    } gga;
+    struct {
+        uint32_t sats_in_use;
+        uint16_t pdop;
+        uint16_t hdop;
+        uint16_t vdop;
+        enum gnss_fix_type fix_type;
+    } gsa;
+#ifdef GNSS_STORE_IN_VIEW_SAT_INFO
+    struct {
+        struct {
+            uint16_t id;
+            uint16_t azimuth;
+            uint8_t elevation;
+            uint8_t snr;
+        } sats[GNSS_GSV_SATS];
+        uint8_t message_num;
+        uint8_t num_in_view;
+        uint8_t num_sats;
+    } gsv;
+#endif
+    struct {
+        enum gnss_antenna antenna;
+    } pgack;
+};
 
-static void gnss_parse_gga (uint8_t argc, char **argv, struct gnss *desc)
+struct gnss_parser_state_t;
+struct gnss_sentence_t;
+
+/**
+ *  Descriptor for a NMEA sentence parser
+ */
+struct gps_parser_t {
+    /** Function called with each field of the sentence */
+    void (*field)(struct gnss_parser_state_t*, uint8_t);
+    /** Function called from gnss_xa1110_service once the sentence has been
+        verified */
+    void (*commit)(const struct gnss_sentence_t*, struct gnss*);
+    /** Bit mask of the fields which are passed to the field function */
+    uint32_t fields;
+    /** Packed address field of the sentence */
+    uint32_t address;
+    /** Set if the sentence contains GPS data, cleared for GLONASS */
+    uint8_t gps:1;
+};
+
+/**
+ *  A sentence which has been received with a valid checksum and is waiting to
+ *  be copied in to the GNSS descriptor.
+ */
+struct gnss_sentence_t {
+    /** Parser for the sentence */
+    const struct gps_parser_t *parser;
+    /** Data from the sentence */
+    union gnss_pending_t pending;
+    /** Value of millis when the sentence was received */
+    uint32_t time;
+};
+
+/**
+ *  State of the NMEA parser.
+ */
+struct gnss_parser_state_t {
+    /** Parser for the current sentence, NULL if the sentence is ignored */
+    const struct gps_parser_t *parser;
+    /** The field currently being received */
+    struct gnss_field_t field;
+    /** Data from the current sentence */
+    union gnss_pending_t pending;
+    /** Packed address field of the current sentence */
+    uint32_t address;
+    /** Number of the current field, the address field is field 0 */
+    uint8_t field_num;
+    /** Set if the current field is used by the parser for the sentence */
+    uint8_t field_wanted;
+    /** Checksum calculated from the received sentence */
+    uint8_t checksum;
+    /** Checksum received with the sentence */
+    uint8_t received_checksum;
+    /** Current parser state */
+    enum gnss_parse_state state;
+};
+
+static struct gnss_parser_state_t gnss_parser_g;
+
+/**
+ *  Sentences passed from the UART interrupt to gnss_xa1110_service.
+ */
+static struct {
+    /** Verified sentences which have not been committed */
+    struct gnss_sentence_t sentences[GNSS_READY_LEN];
+    /** Value of millis when the most recent valid sentence was received */
+    volatile uint32_t last_sentence;
+    /** Index of the next sentence to be queued, only written by the
+        interrupt */
+    volatile uint8_t head;
+    /** Index of the next sentence to be committed, only written by the
+        service */
+    volatile uint8_t tail;
+} gnss_ready_g;
+
+
+/**
+ *  Keywords which can be matched in fields. Each keyword corresponds to a bit
+ *  in the keywords field of struct gnss_field_t.
+ */
+enum gnss_keyword {
+    GNSS_KEYWORD_ANT_INTERNAL,
+    GNSS_KEYWORD_ANT_EXTERNAL,
+    GNSS_NUM_KEYWORDS
+};
+
+static const char *const gnss_keywords[] = {
+    [GNSS_KEYWORD_ANT_INTERNAL] = "SW_ANT_Internal",
+    [GNSS_KEYWORD_ANT_EXTERNAL] = "SW_ANT_External"
+};
+
+/**
+ *  Check whether a field starts with a keyword.
+ *
+ *  @param field The field
+ *  @param keyword The keyword
+ *
+ *  @return 1 if the field starts with the keyword, 0 otherwise
+ */
+static uint8_t gnss_field_is (const struct gnss_field_t *field,
+                              enum gnss_keyword keyword)
 {
-    // 1: UTC Time (ignored)
-    
-    // 2: Latitude
-    // 3: North/South
-    // 4: Longitude
-    // 5: East/West
-    //gnss_parse_coordinates(argv[2], argv[3], argv[4], argv[5], desc);
-    
-    // 6: Position Fix Indicator
-    desc->fix_quality = strtoul(argv[6], NULL, 10);
-    
-    // 7: Number of satellites used
-    desc->num_sats_in_use = strtoul(argv[7], NULL, 10);
-    
-    // 8: Horizontal Dilution of Precision
-    //desc->hdop = (uint16_t)gnss_parse_fp(argv[8], 100);
-    
-    // 9: Altitude
-    desc->altitude = gnss_parse_fp(argv[9], 1000);
-    
-    // 10: Altitude Units (ignored)
-    
-    // 11/12: Geoidal Separation (ignored)
+    return (field->keywords & (1 << keyword)) &&
+            (field->length >= strlen(gnss_keywords[keyword]));
+}
+
+/**
+ *  Get the value of a numeric field with a given number of decimal places.
+ *
+ *  @param field The field
+ *  @param frac_digits The number of decimal places
+ *
+ *  @return The value of the field times 10^frac_digits
+ */
+static int32_t gnss_field_fixed (const struct gnss_field_t *field,
+                                 uint8_t frac_digits)
+{
+    int32_t value = field->value;
     
-    // 13: Age of Differential Correction (ignored)
+    for (uint8_t f = field->frac_digits; f < frac_digits; f++) {
+        value *= 10;
+    }
+    for (uint8_t f = field->frac_digits; f > frac_digits; f--) {
+        value /= 10;
+    }
     
-    // All done!
+    return field->negative ? -value : value;
 }
 
-#ifdef GNSS_STORE_IN_USE_SAT_SVS
 /**
- *  Parse a comma separated list of satellite PRNs into a bit field.
+ *  Get the value of a numeric field as an unsigned integer.
+ *
+ *  @param field The field
  *
- *  @param num_chans The number of channels to parse
- *  @param offset Lowest possible satellite number
- *  @param str Array of strings for each channel
- *  @param field Bit field in which present channels should be stored
+ *  @return The integer part of the field
  */
-static void gnss_parse_sat_list (uint8_t num_chans, uint8_t offset,
-                                 char **str, uint32_t *field)
+static inline uint32_t gnss_field_uint (const struct gnss_field_t *field)
 {
-    *field = 0;
-    for (uint8_t i = 0; i < num_chans; i++) {
-        if (str[i][0] != '\0') {
-            *field |= (1 << (strtoul(str[i], NULL, 10) - offset));
-        }
-    }
+    return (uint32_t)gnss_field_fixed(field, 0);
 }
-#endif
 
-static void gnss_parse_gsa (uint8_t argc, char **argv, struct gnss *desc)
+
+/* Field handlers */
+
+static void gnss_field_rmc (struct gnss_parser_state_t *p, uint8_t n)
 {
-#ifdef GNSS_STORE_IN_USE_SAT_SVS
-    // Determine if this sentence contains info on GPS or GLONASS satellites
-    uint8_t gps = !strcmp(argv[0] + 1, "GPGSA");
-#endif
+    struct gnss_field_t *f = &p->field;
     
-    // 1: Mode 1 (ignored)
-    
-    // 2: Mode 2
-    switch (argv[2][0]) {
-        case '1':
-            desc->fix_type = GNSS_FIX_NOT_AVAILABLE;
+    switch (n) {
+        case 1:
+            // UTC Time
+            p->pending.rmc.time = gnss_field_uint(f);
+            p->pending.rmc.has_time = f->digits >= 6;
+            break;
+        case 2:
+            // Status
+            p->pending.rmc.valid = f->first == 'A';
+            break;
+        case 3:
+            // Latitude
+            p->pending.rmc.latitude = gnss_make_coordinate(
+                                                    gnss_field_fixed(f, 4));
+            break;
+        case 4:
+            // North/South
+            if (f->first == 'S') {
+                p->pending.rmc.latitude *= -1;
+            }
+            break;
+        case 5:
+            // Longitude
+            p->pending.rmc.longitude = gnss_make_coordinate(
+                                                    gnss_field_fixed(f, 4));
             break;
-        case '2':
-            desc->fix_type = GNSS_FIX_2D;
+        case 6:
+            // East/West
+            if (f->first == 'W') {
+                p->pending.rmc.longitude *= -1;
+            }
             break;
-        case '3':
-            desc->fix_type = GNSS_FIX_3D;
+        case 7:
+            // Speed over ground
+            p->pending.rmc.speed = (int16_t)gnss_field_fixed(f, 2);
+            break;
+        case 8:
+            // Course over ground
+            p->pending.rmc.course = (int16_t)gnss_field_fixed(f, 2);
+            break;
+        case 9:
+            // Date
+            p->pending.rmc.date = gnss_field_uint(f);
+            p->pending.rmc.has_date = f->digits == 6;
             break;
         default:
-            desc->fix_type = GNSS_FIX_UNKOWN;
+            // 10/11: Magnetic Variation (ignored)
+            // 12: Mode (ignored)
             break;
     }
+}
+
+/**
+ *  Match the most recent pulse per second with a UTC time. The NMEA sentences
+ *  for each fix follow the pulse which marks the start of the second.
+ *
+ *  @param utc_time The time from an RMC sentence
+ *  @param time The value of millis when the RMC sentence was received
+ */
+static void gnss_pps_match (uint32_t utc_time, uint32_t time)
+{
+    uint32_t capture, capture_millis;
     
-    // 3: Satellite on channel 1
-    // 4: Satellite on channel 2
-    // 5: Satellite on channel 3
-    // 6: Satellite on channel 4
-    // 7: Satellite on channel 5
-    // 8: Satellite on channel 6
-    // 9: Satellite on channel 7
-    // 10: Satellite on channel 8
-    // 11: Satellite on channel 9
-    // 12: Satellite on channel 10
-    // 13: Satellite on channel 11
-    // 14: Satellite on channel 12
-#ifdef GNSS_STORE_IN_USE_SAT_SVS
-    gnss_parse_sat_list(12, gps ? GPS_SV_OFFSET : GLONASS_SV_OFFSET, argv + 3,
-                        gps ? &desc->gps_sats_in_use :
-                        &desc->glonass_sats_in_use);
-#endif
-    
-    // 15: Position Dilution of Precision
-    desc->pdop = (uint16_t)gnss_parse_fp(argv[15], 100);
+    if (!gnss_pps_g.have_capture) {
+        return;
+    }
     
-    // 16: Horizontal Dilution of Precision
-    desc->hdop = (uint16_t)gnss_parse_fp(argv[16], 100);
+    // The capture interrupt could preempt us, make sure that the capture and
+    // its time are from the same pulse
+    do {
+        capture_millis = gnss_pps_g.capture_millis;
+        capture = gnss_pps_g.capture;
+    } while (capture_millis != gnss_pps_g.capture_millis);
     
-    // 17: Vertical Dilution of Precision
-    desc->vdop = (uint16_t)gnss_parse_fp(argv[17], 100);
+    if ((time - capture_millis) > GNSS_PPS_MAX_DELAY) {
+        // No pulse for this second
+        return;
+    }
     
-    // All done!
-    desc->last_meta = millis;
+    gnss_pps_g.sync_sequence++;
+    gnss_pps_g.sync.utc_time = utc_time;
+    gnss_pps_g.sync.ticks = capture;
+    gnss_pps_g.sync.millis = capture_millis;
+    gnss_pps_g.sync.ticks_per_second = gnss_pps_g.ticks_per_second;
+    gnss_pps_g.sync_sequence++;
+    gnss_pps_g.synced = 1;
 }
 
-static void gnss_parse_rmc (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_commit_rmc (const struct gnss_sentence_t *s,
+                             struct gnss *desc)
 {
-    // 9: Date
-    // 1: UTC Time
-    desc->utc_time = gnss_parse_time(argv[9], argv[1]);
+    if (s->pending.rmc.has_time && s->pending.rmc.has_date) {
+        desc->utc_time = gnss_make_time(s->pending.rmc.date,
+                                        s->pending.rmc.time);
+        gnss_pps_match(desc->utc_time, s->time);
+    }
     
-    // 2: Status
-    if (argv[2][0] == 'V') {
-        //desc->status = 0;
+    if (!s->pending.rmc.valid) {
         return;
     }
     
-    // 3: Latitude
-    // 4: North/South
-    // 5: Longitude
-    // 6: East/West
-    gnss_parse_coordinates(argv[3], argv[4], argv[5], argv[6], desc);
-    
-    // 7: Speed over ground
-    desc->speed = (uint16_t)gnss_parse_fp(argv[7], 100);
-    
-    // 8: Course over ground
-    desc->course = (uint16_t)gnss_parse_fp(argv[8], 100);
-    
-    // 10/11: Magnetic Variation (ignored)
+    desc->latitude = s->pending.rmc.latitude;
+    desc->longitude = s->pending.rmc.longitude;
+    desc->speed = s->pending.rmc.speed;
+    desc->course = s->pending.rmc.course;
+    desc->last_fix = s->time;
+}
+
+static void gnss_field_gga (struct gnss_parser_state_t *p, uint8_t n)
+{
+    struct gnss_field_t *f = &p->field;
     
-    // 12: Mode (ignored)
+    switch (n) {
+        case 6:
+            // Position Fix Indicator
+            p->pending.gga.fix_quality = (uint8_t)gnss_field_uint(f);
+            break;
+        case 7:
+            // Number of satellites used
+            p->pending.gga.num_sats_in_use = (uint8_t)gnss_field_uint(f);
+            break;
+        case 9:
+            // Altitude
+            p->pending.gga.altitude = gnss_field_fixed(f, 3);
+            break;
+        default:
+            // 1: UTC Time (ignored)
+            // 2-5: Position (ignored, taken from RMC)
+            // 8: Horizontal Dilution of Precision (ignored, taken from GSA)
+            // 10: Altitude Units (ignored)
+            // 11/12: Geoidal Separation (ignored)
+            // 13: Age of Differential Correction (ignored)
+            break;
+    }
+}
+
+static void gnss_commit_gga (const struct gnss_sentence_t *s,
+                             struct gnss *desc)
+{
+    desc->fix_quality = s->pending.gga.fix_quality;
+    desc->num_sats_in_use = s->pending.gga.num_sats_in_use;
+    desc->altitude = s->pending.gga.altitude;
+}
+
+static void gnss_field_gsa (struct gnss_parser_state_t *p, uint8_t n)
+{
+    struct gnss_field_t *f = &p->field;
     
-    // All done!
-    //desc->status = 1;
-    desc->last_fix = millis;
+    if (n == 1) {
+        // Mode 1 (ignored)
+        p->pending.gsa.sats_in_use = 0;
+    } else if (n == 2) {
+        // Mode 2
+        switch (f->first) {
+            case '1':
+                p->pending.gsa.fix_type = GNSS_FIX_NOT_AVAILABLE;
+                break;
+            case '2':
+                p->pending.gsa.fix_type = GNSS_FIX_2D;
+                break;
+            case '3':
+                p->pending.gsa.fix_type = GNSS_FIX_3D;
+                break;
+            default:
+                p->pending.gsa.fix_type = GNSS_FIX_UNKOWN;
+                break;
+        }
+    } else if (n <= 14) {
+        // Satellites on channels 1 through 12
+#ifdef GNSS_STORE_IN_USE_SAT_SVS
+        uint8_t offset = (p->parser->gps ? GPS_SV_OFFSET :
+                          GLONASS_SV_OFFSET);
+        uint32_t sv = gnss_field_uint(f) - offset;
+        
+        if ((f->length != 0) && (sv < 32)) {
+            p->pending.gsa.sats_in_use |= (1UL << sv);
+        }
+#endif
+    } else if (n == 15) {
+        // Position Dilution of Precision
+        p->pending.gsa.pdop = (uint16_t)gnss_field_fixed(f, 2);
+    } else if (n == 16) {
+        // Horizontal Dilution of Precision
+        p->pending.gsa.hdop = (uint16_t)gnss_field_fixed(f, 2);
+    } else if (n == 17) {
+        // Vertical Dilution of Precision
+        p->pending.gsa.vdop = (uint16_t)gnss_field_fixed(f, 2);
+    }
+}
+
+static void gnss_commit_gsa (const struct gnss_sentence_t *s,
+                             struct gnss *desc)
+{
+    desc->fix_type = s->pending.gsa.fix_type;
+#ifdef GNSS_STORE_IN_USE_SAT_SVS
+    if (s->parser->gps) {
+        desc->gps_sats_in_use = s->pending.gsa.sats_in_use;
+    } else {
+        desc->glonass_sats_in_use = s->pending.gsa.sats_in_use;
+    }
+#endif
+    desc->pdop = s->pending.gsa.pdop;
+    desc->hdop = s->pending.gsa.hdop;
+    desc->vdop = s->pending.gsa.vdop;
+    desc->last_meta = s->time;
 }
 
 #ifdef GNSS_STORE_IN_VIEW_SAT_INFO
-static void gnss_parse_gsv (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_field_gsv (struct gnss_parser_state_t *p, uint8_t n)
 {
-    // Determine if this sentence contains info on GPS or GLONASS satellites
-    uint8_t gps = !strcmp(argv[0] + 1, "GPGSV");
+    struct gnss_field_t *f = &p->field;
     
-    // 1: Number of Messages (ignored)
-    
-    // 2: Message Number
-    uint8_t message_num = strtoul(argv[2], NULL, 10) - 1;
+    if (n == 1) {
+        // Number of Messages (ignored)
+        p->pending.gsv.num_sats = 0;
+    } else if (n == 2) {
+        // Message Number
+        p->pending.gsv.message_num = (uint8_t)gnss_field_uint(f) - 1;
+    } else if (n == 3) {
+        // Satellites in View
+        p->pending.gsv.num_in_view = (uint8_t)gnss_field_uint(f);
+    } else {
+        // In view satellite info, four fields for each satellite
+        uint8_t sat = (n - 4) / 4;
+        
+        if (sat >= GNSS_GSV_SATS) {
+            return;
+        }
+        
+        switch ((n - 4) % 4) {
+            case 0:
+                p->pending.gsv.sats[sat].id = (uint16_t)gnss_field_uint(f);
+                break;
+            case 1:
+                p->pending.gsv.sats[sat].elevation =
+                                                (uint8_t)gnss_field_uint(f);
+                break;
+            case 2:
+                p->pending.gsv.sats[sat].azimuth =
+                                                (uint16_t)gnss_field_uint(f);
+                break;
+            case 3:
+                p->pending.gsv.sats[sat].snr = (uint8_t)gnss_field_uint(f);
+                p->pending.gsv.num_sats = sat + 1;
+                break;
+        }
+    }
+}
+
+static void gnss_commit_gsv (const struct gnss_sentence_t *s,
+                             struct gnss *desc)
+{
+    uint8_t gps = s->parser->gps;
+    uint8_t num_in_view = ((s->pending.gsv.num_in_view >
+                            GNSS_MAX_SATS_IN_VIEW) ? GNSS_MAX_SATS_IN_VIEW :
+                           s->pending.gsv.num_in_view);
     
-    // 3: Satellites in View
-    uint8_t num_in_view = strtoul(argv[3], NULL, 10);
     if (gps) {
-        desc->num_gps_sats_in_view = ((num_in_view > GNSS_MAX_SATS_IN_VIEW) ?
-                                      GNSS_MAX_SATS_IN_VIEW : num_in_view);
+        desc->num_gps_sats_in_view = num_in_view;
     } else {
-        desc->num_glonass_sats_in_view = ((num_in_view > GNSS_MAX_SATS_IN_VIEW)
-                                          ? GNSS_MAX_SATS_IN_VIEW :
-                                          num_in_view);
+        desc->num_glonass_sats_in_view = num_in_view;
     }
     
-    // 4 through (argc - 1): In view satellite info
-    uint8_t num_sats = (argc - 4) / 4;
-    for (uint8_t i = 0; i < num_sats; i++) {
-        uint8_t sat = (4 * message_num) + i;
+    for (uint8_t i = 0; i < s->pending.gsv.num_sats; i++) {
+        uint16_t sat = (GNSS_GSV_SATS * s->pending.gsv.message_num) + i;
         
-        uint16_t id = strtoul(argv[(4 * i) + 4], NULL, 10);
-        uint8_t elevation = strtoul((argv[(4 * i) + 5]), NULL, 10);
-        uint16_t azimuth = strtoul((argv[(4 * i) + 6]), NULL, 10);
-        uint8_t snr = strtoul((argv[(4 * i) + 7]), NULL, 10);
+        if (sat >= GNSS_MAX_SATS_IN_VIEW) {
+            break;
+        }
         
         if (gps) {
-            desc->in_view_gps_satellites[sat].prn = id - GPS_SV_OFFSET;
-            desc->in_view_gps_satellites[sat].elevation = elevation;
-            desc->in_view_gps_satellites[sat].azimuth = azimuth;
-            desc->in_view_gps_satellites[sat].snr = snr;
+            desc->in_view_gps_satellites[sat].prn = (s->pending.gsv.sats[i].id -
+                                                     GPS_SV_OFFSET);
+            desc->in_view_gps_satellites[sat].elevation =
+                                            s->pending.gsv.sats[i].elevation;
+            desc->in_view_gps_satellites[sat].azimuth =
+                                            s->pending.gsv.sats[i].azimuth;
+            desc->in_view_gps_satellites[sat].snr = s->pending.gsv.sats[i].snr;
         } else {
-            desc->in_view_glonass_satellites[sat].sat_id = (id -
-                                                            GLONASS_SV_OFFSET);
-            desc->in_view_glonass_satellites[sat].elevation = elevation;
-            desc->in_view_glonass_satellites[sat].azimuth = azimuth;
-            desc->in_view_glonass_satellites[sat].snr = snr;
+            desc->in_view_glonass_satellites[sat].sat_id = (
+                            s->pending.gsv.sats[i].id - GLONASS_SV_OFFSET);
+            desc->in_view_glonass_satellites[sat].elevation =
+                                            s->pending.gsv.sats[i].elevation;
+            desc->in_view_glonass_satellites[sat].azimuth =
+                                            s->pending.gsv.sats[i].azimuth;
+            desc->in_view_glonass_satellites[sat].snr =
+                                            s->pending.gsv.sats[i].snr;
         }
     }
     
-    // All done!
-    desc->last_gsv = millis;
+    desc->last_gsv = s->time;
 }
 #endif
 
-static void gnss_parse_pgack (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_field_pgack (struct gnss_parser_state_t *p, uint8_t n)
 {
-    if (!strncmp(argv[1], "SW_ANT_Internal", 15)) {
+    if (n != 1) {
+        return;
+    }
+    
+    if (gnss_field_is(&p->field, GNSS_KEYWORD_ANT_INTERNAL)) {
         // Using internal antenna
-        desc->antenna = GNSS_ANTENNA_INTERNAL;
-    } else if (!strncmp(argv[1], "SW_ANT_External", 15)) {
+        p->pending.pgack.antenna = GNSS_ANTENNA_INTERNAL;
+    } else if (gnss_field_is(&p->field, GNSS_KEYWORD_ANT_EXTERNAL)) {
         // Using external antenna
-        desc->antenna = GNSS_ANTENNA_EXTERNAL;
+        p->pending.pgack.antenna = GNSS_ANTENNA_EXTERNAL;
+    } else {
+        p->pending.pgack.antenna = GNSS_ANTENNA_UNKOWN;
     }
 }
 
+static void gnss_commit_pgack (const struct gnss_sentence_t *s,
+                               struct gnss *desc)
+{
+    if (s->pending.pgack.antenna != GNSS_ANTENNA_UNKOWN) {
+        desc->antenna = s->pending.pgack.antenna;
+    }
+}
 
 
-
-
-/**
- *  Descriptor for a NMEA sentence parser
- */
-struct gps_parser_t {
-    void (*parse)(uint8_t, char**, struct gnss*);
-    const char *type;
-};
-
 /**
  *  List of available NMEA sentence parsers
  */
 static const struct gps_parser_t nmea_parsers[] = {
-    {.parse = gnss_parse_rmc, .type = "GNRMC"},
+    {.field = gnss_field_rmc, .commit = gnss_commit_rmc,
+     .fields = GNSS_FIELDS(1, 9), .address = GNSS_ADDRESS('G','N','R','M','C')},
 #ifdef GNSS_STORE_IN_VIEW_SAT_INFO
-    {.parse = gnss_parse_gsv, .type = "GPGSV"},
-    {.parse = gnss_parse_gsv, .type = "GLGSV"},
+    {.field = gnss_field_gsv, .commit = gnss_commit_gsv, .gps = 1,
+     .fields = GNSS_FIELDS(1, 19), .address = GNSS_ADDRESS('G','P','G','S','V')},
+    {.field = gnss_field_gsv, .commit = gnss_commit_gsv,
+     .fields = GNSS_FIELDS(1, 19), .address = GNSS_ADDRESS('G','L','G','S','V')},
 #endif
-    {.parse = gnss_parse_gga, .type = "GNGGA"},
+    {.field = gnss_field_gga, .commit = gnss_commit_gga,
+     .fields = (1 << 6) | (1 << 7) | (1 << 9),
+     .address = GNSS_ADDRESS('G','N','G','G','A')},
 #ifdef GNSS_STORE_IN_USE_SAT_SVS
     // Don't need to parse both GSA sentences if we are not keeping track of
     // satellite numbers
-    {.parse = gnss_parse_gsa, .type = "GLGSA"},
+    {.field = gnss_field_gsa, .commit = gnss_commit_gsa,
+     .fields = GNSS_FIELDS(1, 17), .address = GNSS_ADDRESS('G','L','G','S','A')},
+    {.field = gnss_field_gsa, .commit = gnss_commit_gsa, .gps = 1,
+     .fields = GNSS_FIELDS(1, 17), .address = GNSS_ADDRESS('G','P','G','S','A')},
+#else
+    // Satellite numbers are not needed, skip fields 3 through 14
+    {.field = gnss_field_gsa, .commit = gnss_commit_gsa, .gps = 1,
+     .fields = GNSS_FIELDS(1, 2) | GNSS_FIELDS(15, 17),
+     .address = GNSS_ADDRESS('G','P','G','S','A')},
 #endif
-    {.parse = gnss_parse_gsa, .type = "GPGSA"},
-    {.parse = gnss_parse_pgack, .type = "PGACK"}
+    {.field = gnss_field_pgack, .commit = gnss_commit_pgack,
+     .fields = GNSS_FIELDS(1, 1), .address = GNSS_ADDRESS('P','G','A','C','K')}
 };
 
 
 /**
- *  Verify the checksum of a NMEA sentence. The first character of the sentence
- *  (should be '$') is skipped.
+ *  Convert a hexadecimal digit to its value.
  *
- *  @param str The sentence to be verified
+ *  @param c The digit
  *
- *  @return 0 if the checksum is incorrect or the sentence is otherwise invalid,
- *          a positive integer otherwise
+ *  @return The value of the digit, or 0xFF if c is not a hexadecimal digit
  */
-static uint8_t verify_checksum (char *str)
+static inline uint8_t gnss_hex_value (uint8_t c)
 {
-    uint8_t checksum = str[1];
-    uint8_t i;
-    
-    for (i = 2; (str[i] != '*') && (str[i] != '\0'); i++) {
-        checksum ^= str[i];
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    return 0xFF;
+}
+
+/**
+ *  Reset the field accumulator for a new field.
+ */
+static inline void gnss_start_field (struct gnss_parser_state_t *p)
+{
+    p->field.value = 0;
+    p->field.length = 0;
+    p->field.digits = 0;
+    p->field.frac_digits = 0;
+    p->field.first = '\0';
+    p->field.keywords = (1 << GNSS_NUM_KEYWORDS) - 1;
+    p->field.negative = 0;
+    p->field.point = 0;
+}
+
+/**
+ *  Add a character to the field accumulator.
+ */
+static inline void gnss_field_add_char (struct gnss_field_t *f, uint8_t c)
+{
+    if (f->length == 0) {
+        f->first = (char)c;
     }
     
-    if (str[i] != '*') {
-        // No checksum present
-        return 0;
+    // Check which keywords could still match
+    for (uint8_t k = 0; (f->keywords >> k) != 0; k++) {
+        if ((f->keywords & (1 << k)) && (gnss_keywords[k][f->length] != c)) {
+            f->keywords &= ~(1 << k);
+        }
     }
     
-    char* end;
-    uint8_t chk = strtoul(str + i + 1, &end, 16);
-    return (*end == '\0') ? (checksum == chk) : 0;
+    f->length += (f->length != UINT8_MAX);
+    
+    if ((c >= '0') && (c <= '9')) {
+        if (f->digits < GNSS_FIELD_MAX_DIGITS) {
+            f->value = (f->value * 10) + (c - '0');
+            f->digits++;
+            f->frac_digits += f->point;
+        }
+    } else if (c == '.') {
+        f->point = 1;
+    } else if ((c == '-') && (f->length == 1)) {
+        f->negative = 1;
+    }
 }
 
+/**
+ *  Finish the current field and pass it to the sentence parser.
+ */
+static void gnss_end_field (struct gnss_parser_state_t *p)
+{
+    if (p->field_num == 0) {
+        // End of address field, find parser for sentence
+        p->parser = NULL;
+        
+        if (p->field.length == GNSS_ADDRESS_LEN) {
+            uint8_t num_parsers = sizeof(nmea_parsers)/sizeof(nmea_parsers[0]);
+            for (int i = 0; i < num_parsers; i++) {
+                if (p->address == nmea_parsers[i].address) {
+                    p->parser = nmea_parsers + i;
+                    break;
+                }
+            }
+        }
+    } else if (p->field_wanted) {
+        p->parser->field(p, p->field_num);
+    }
+    
+    p->field_num++;
+    p->field_wanted = ((p->parser != NULL) && (p->field_num < 32) &&
+                       (p->parser->fields & (1UL << p->field_num)));
+    gnss_start_field(p);
+}
 
-static void gnss_line_callback (char *line, struct console_desc_t *console,
-                                void *context)
+/**
+ *  Handle a sentence which has been received with a valid checksum by queuing
+ *  it to be committed from gnss_xa1110_service.
+ */
+static void gnss_end_sentence (struct gnss_parser_state_t *p)
 {
-    if (!verify_checksum(line)) {
+    gnss_ready_g.last_sentence = millis;
+    
+    uint8_t next = (gnss_ready_g.head + 1) % GNSS_READY_LEN;
+    if ((p->parser == NULL) || (next == gnss_ready_g.tail)) {
+        // Sentence is not used or the queue is full
         return;
     }
     
-    gnss_xa1110_descriptor.last_sentence = millis;
+    struct gnss_sentence_t *sentence = gnss_ready_g.sentences +
+                                        gnss_ready_g.head;
+    sentence->parser = p->parser;
+    sentence->pending = p->pending;
+    sentence->time = millis;
+    gnss_ready_g.head = next;
+}
+
+/**
+ *  Pass a received byte to the NMEA parser. Called from the UART interrupt
+ *  handler.
+ *
+ *  @param c The received byte
+ *  @param context Unused
+ */
+static void gnss_rx_callback (uint8_t c, void *context)
+{
+    struct gnss_parser_state_t *p = &gnss_parser_g;
     
-    /* Count the number of comma separated tokens in the line */
-    uint8_t num_args = 1;
-    for (uint16_t i = 0; i < strlen(line); i++) {
-        num_args += (line[i] == ',');
+    if (c == '$') {
+        // Start of a new sentence, abandon any sentence in progress
+        p->state = GNSS_PARSE_ADDRESS;
+        p->checksum = 0;
+        p->field_num = 0;
+        p->field_wanted = 0;
+        p->address = 0;
+        p->parser = NULL;
+        gnss_start_field(p);
+        return;
+    } else if ((c == '\r') || (c == '\n')) {
+        // End of line before checksum, sentence is invalid
+        p->state = GNSS_PARSE_IDLE;
+        return;
     }
     
-    /* Create an array of pointers to each token */
-    // Array is one large to leave room for NULL pointer
-    char *args[num_args + 1];
-    for (uint16_t i = 0; (args[i] = strsep(&line, ",")) != NULL; i++);
-    
-    /* Run parser for received sentence */
-    uint8_t num_parsers = sizeof(nmea_parsers)/sizeof(nmea_parsers[0]);
-    for (int i = 0; i < num_parsers; i++) {
-        if (!strcasecmp(args[0] + 1, nmea_parsers[i].type)) {
-            nmea_parsers[i].parse(num_args, args, &gnss_xa1110_descriptor);
+    switch (p->state) {
+        case GNSS_PARSE_IDLE:
             break;
-        }
+        case GNSS_PARSE_ADDRESS:
+            if ((c != ',') && (c != '*')) {
+                p->checksum ^= c;
+                p->address = ((p->address << GNSS_ADDRESS_CHAR_BITS) |
+                               (c & 0x1F));
+                if (!isalpha(c)) {
+                    // Not a valid address
+                    p->field.length = UINT8_MAX;
+                }
+                p->field.length += (p->field.length != UINT8_MAX);
+                break;
+            }
+            p->state = GNSS_PARSE_FIELD;
+            // fall through
+        case GNSS_PARSE_FIELD:
+            if (c == '*') {
+                gnss_end_field(p);
+                p->state = GNSS_PARSE_CHECKSUM_HIGH;
+            } else {
+                p->checksum ^= c;
+                if (c == ',') {
+                    gnss_end_field(p);
+                } else if (p->field_wanted) {
+                    gnss_field_add_char(&p->field, c);
+                }
+            }
+            break;
+        case GNSS_PARSE_CHECKSUM_HIGH:
+            p->received_checksum = gnss_hex_value(c) << 4;
+            p->state = ((gnss_hex_value(c) != 0xFF) ?
+                        GNSS_PARSE_CHECKSUM_LOW : GNSS_PARSE_IDLE);
+            break;
+        case GNSS_PARSE_CHECKSUM_LOW:
+            if ((gnss_hex_value(c) != 0xFF) &&
+                    ((p->received_checksum | gnss_hex_value(c)) ==
+                     p->checksum)) {
+                gnss_end_sentence(p);
+            }
+            p->state = GNSS_PARSE_IDLE;
+            break;
+    }
+}
+
+/**
+ *  Line callback used if the GNSS console is not backed by a UART, passes each
+ *  character of the line to the parser.
+ */
+static void gnss_line_callback (char *line, struct console_desc_t *console,
+                                void *context)
+{
+    for (; *line != '\0'; line++) {
+        gnss_rx_callback((uint8_t)*line, context);
     }
+    gnss_rx_callback('\r', context);
 }
 
 static void gnss_init_callback (struct console_desc_t* console, void* context) {
@@ -520,8 +996,175 @@ static void gnss_init_callback (struct console_desc_t* console, void* context) {
 
 uint8_t init_gnss_xa1110 (struct console_desc_t* console)
 {
-    console_set_line_callback(console, gnss_line_callback, NULL);
+    gnss_parser_g.state = GNSS_PARSE_IDLE;
+    gnss_ready_g.last_sentence = 0;
+    gnss_ready_g.head = 0;
+    gnss_ready_g.tail = 0;
+    
+    if (console->type == CONSOLE_TYPE_UART) {
+        // Parse bytes as they are received
+        sercom_uart_set_rx_callback(console->interface.uart, gnss_rx_callback,
+                                    NULL);
+    } else {
+        console_set_line_callback(console, gnss_line_callback, NULL);
+    }
     console_set_init_callback(console, gnss_init_callback, NULL);
     return 0;
 }
 
+void gnss_xa1110_service (void)
+{
+    gnss_xa1110_descriptor.last_sentence = gnss_ready_g.last_sentence;
+    
+    while (gnss_ready_g.tail != gnss_ready_g.head) {
+        const struct gnss_sentence_t *s = (gnss_ready_g.sentences +
+                                           gnss_ready_g.tail);
+        s->parser->commit(s, &gnss_xa1110_descriptor);
+        gnss_ready_g.tail = (gnss_ready_g.tail + 1) % GNSS_READY_LEN;
+    }
+}
+
+/**
+ *  Called from the Timer Counter interrupt when a pulse is captured.
+ *
+ *  @param capture The captured timer count
+ *  @param context Unused
+ */
+static void gnss_pps_callback (uint32_t capture, void *context)
+{
+    uint32_t interval = capture - gnss_pps_g.capture;
+    uint32_t tolerance = (gnss_pps_g.nominal_ticks_per_second >>
+                          GNSS_PPS_TOLERANCE_SHIFT);
+    
+    // Measure the timer frequency against the pulses, skipping missed pulses
+    // and glitches
+    if (gnss_pps_g.have_capture &&
+            (interval > (gnss_pps_g.nominal_ticks_per_second - tolerance)) &&
+            (interval < (gnss_pps_g.nominal_ticks_per_second + tolerance))) {
+        gnss_pps_g.ticks_per_second = interval;
+    }
+    
+    gnss_pps_g.capture_millis = millis;
+    gnss_pps_g.capture = capture;
+    gnss_pps_g.have_capture = 1;
+}
+
+uint8_t gnss_xa1110_use_pps (Tc *tc, uint32_t clock_mask, uint32_t clock_freq,
+                             union gpio_pin_t pin, uint8_t event_channel)
+{
+    uint8_t generator;
+    
+    gnss_pps_g.have_capture = 0;
+    gnss_pps_g.synced = 0;
+    
+    if (init_tc_capture(tc, clock_mask, clock_freq, gnss_pps_callback, NULL)) {
+        return 1;
+    }
+    
+    gnss_pps_g.tc = tc;
+    gnss_pps_g.nominal_ticks_per_second = tc_capture_get_frequency(tc);
+    gnss_pps_g.ticks_per_second = gnss_pps_g.nominal_ticks_per_second;
+    
+    gpio_set_pin_mode(pin, GPIO_PIN_INPUT);
+    if (gpio_enable_event(pin, GPIO_INTERRUPT_RISING_EDGE, 0, &generator)) {
+        return 1;
+    }
+    
+    // The EIC and Timer Counter are on different clock domains
+    evsys_configure_channel(event_channel, generator, clock_mask,
+                            EVSYS_PATH_RESYNCHRONIZED, EVSYS_EDGE_RISING);
+    evsys_configure_user_mux(tc_get_evsys_user_id(tc), event_channel);
+    
+    return 0;
+}
+
+uint8_t gnss_get_time_sync (struct gnss_time_sync_t *sync)
+{
+    uint8_t sequence;
+    
+    if (!gnss_pps_g.synced) {
+        return 0;
+    }
+    
+    // The sync could be updated by gnss_xa1110_service while we copy it if
+    // we are called from an interrupt
+    do {
+        sequence = gnss_pps_g.sync_sequence;
+        *sync = gnss_pps_g.sync;
+    } while ((sequence & 1) || (sequence != gnss_pps_g.sync_sequence));
+    
+    return 1;
+}
+
+uint32_t gnss_get_ticks (void)
+{
+    if (gnss_pps_g.tc == NULL) {
+        return 0;
+    }
+    return tc_get_count32(gnss_pps_g.tc);
+}
+
+uint8_t gnss_ticks_to_utc (uint32_t ticks, uint32_t *seconds,
+                           uint32_t *microseconds)
+{
+    struct gnss_time_sync_t sync;
+    
+    if (!gnss_get_time_sync(&sync)) {
+        return 0;
+    }
+    
+    // Ticks before the sync pulse are negative
+    int32_t delta = (int32_t)(ticks - sync.ticks);
+    int32_t whole = delta / (int32_t)sync.ticks_per_second;
+    int32_t remainder = delta % (int32_t)sync.ticks_per_second;
+    
+    if (remainder < 0) {
+        whole--;
+        remainder += sync.ticks_per_second;
+    }
+    
+    *seconds = sync.utc_time + whole;
+    *microseconds = (uint32_t)(((uint64_t)remainder * 1000000) /
+                               sync.ticks_per_second);
+    return 1;
+}
+
+uint8_t gnss_utc_to_ticks (uint32_t seconds, uint32_t microseconds,
+                           uint32_t *ticks)
+{
+    struct gnss_time_sync_t sync;
+    
+    if (!gnss_get_time_sync(&sync)) {
+        return 0;
+    }
+    
+    int32_t whole = (int32_t)(seconds - sync.utc_time);
+    uint32_t fraction = (uint32_t)(((uint64_t)microseconds *
+                                    sync.ticks_per_second) / 1000000);
+    
+    *ticks = sync.ticks + (whole * sync.ticks_per_second) + fraction;
+    return 1;
+}
+
+uint8_t gnss_millis_to_utc (uint32_t time, uint32_t *seconds,
+                            uint16_t *milliseconds)
+{
+    struct gnss_time_sync_t sync;
+    
+    if (!gnss_get_time_sync(&sync)) {
+        return 0;
+    }
+    
+    int32_t delta = (int32_t)(time - sync.millis);
+    int32_t whole = delta / 1000;
+    int32_t remainder = delta % 1000;
+    
+    if (remainder < 0) {
+        whole--;
+        remainder += 1000;
+    }
+    
+    *seconds = sync.utc_time + whole;
+    *milliseconds = (uint16_t)remainder;
+    return 1;
+}
@@ -11,6 +11,7 @@
 
 #include "global.h"
 #include "console.h"
+#include "gpio.h"
 
 /* Define in order to parse store the satellite numbers of in use satellites */
 #define GNSS_STORE_IN_USE_SAT_SVS
@@ -22,6 +23,10 @@
 #define GPS_SV_OFFSET       0
 #define GLONASS_SV_OFFSET   65
 
+/** Maximum time in milliseconds between a PPS edge and the RMC sentence which
+    gives its time */
+#define GNSS_PPS_MAX_DELAY  900
+
 /**
  *  Type of fix reported by the GNSS module.
  */
@@ -141,6 +146,21 @@ extern struct gnss {
     enum gnss_fix_quality fix_quality:4;
 } gnss_xa1110_descriptor;
 
+/**
+ *  Relationship between local time and UTC, taken from the GNSS module's pulse
+ *  per second output.
+ */
+struct gnss_time_sync_t {
+    /** UTC time in seconds since Unix epoch at the start of the second which
+        was marked by the most recent matched pulse */
+    uint32_t utc_time;
+    /** Timer count captured at the most recent matched pulse */
+    uint32_t ticks;
+    /** Value of millis when the most recent matched pulse was captured */
+    uint32_t millis;
+    /** Measured number of timer ticks in one second */
+    uint32_t ticks_per_second;
+};
 
 
 
@@ -154,5 +174,93 @@ extern struct gnss {
  */
 extern uint8_t init_gnss_xa1110(struct console_desc_t* console);
 
+/**
+ *  Copy the data from sentences received by the UART interrupt in to the GNSS
+ *  descriptor. Must be called from the main loop, the descriptor is only ever
+ *  updated here.
+ */
+extern void gnss_xa1110_service(void);
+
+/**
+ *  Timestamp the GNSS module's pulse per second output. The pin is routed from
+ *  the EIC to a Timer Counter capture channel through the event system so that
+ *  the timestamp does not depend on interrupt latency. Each pulse is matched
+ *  with the time from the RMC sentence that follows it.
+ *
+ *  @param tc The Timer Counter to use, must be an even numbered instance, the
+ *            following instance is also used
+ *  @param clock_mask Mask for the Generic Clock Generator which should provide
+ *                    the Generic Clock for the Timer Counter and event channel
+ *  @param clock_freq The frequency of the Generic Clock Generator, must be at
+ *                    least 1 MHz
+ *  @param pin The pin connected to the pulse per second output, must be an
+ *             internal pin with an EIC line
+ *  @param event_channel The event channel used to route the pulse to the
+ *                       Timer Counter
+ *
+ *  @return 0 if the pulse per second input was configured successfully
+ */
+extern uint8_t gnss_xa1110_use_pps(Tc *tc, uint32_t clock_mask,
+                                   uint32_t clock_freq, union gpio_pin_t pin,
+                                   uint8_t event_channel);
+
+/**
+ *  Get the most recent relationship between local time and UTC.
+ *
+ *  @param sync Pointer to where the time sync information will be stored
+ *
+ *  @return 1 if a pulse has been matched with a UTC time, 0 otherwise
+ */
+extern uint8_t gnss_get_time_sync(struct gnss_time_sync_t *sync);
+
+/**
+ *  Get the current count of the pulse per second timer, to be used as a high
+ *  resolution timestamp.
+ *
+ *  @return The current timer count, 0 if the pulse per second input is not
+ *          used
+ */
+extern uint32_t gnss_get_ticks(void);
+
+/**
+ *  Convert a pulse per second timer count to UTC.
+ *
+ *  @param ticks The timer count
+ *  @param seconds Pointer to where the UTC time in seconds since Unix epoch
+ *                 will be stored
+ *  @param microseconds Pointer to where the number of microseconds into the
+ *                      second will be stored
+ *
+ *  @return 1 if the time was converted, 0 if no time sync is available
+ */
+extern uint8_t gnss_ticks_to_utc(uint32_t ticks, uint32_t *seconds,
+                                 uint32_t *microseconds);
+
+/**
+ *  Convert a UTC time to a pulse per second timer count.
+ *
+ *  @param seconds The UTC time in seconds since Unix epoch
+ *  @param microseconds The number of microseconds into the second
+ *  @param ticks Pointer to where the timer count will be stored
+ *
+ *  @return 1 if the time was converted, 0 if no time sync is available
+ */
+extern uint8_t gnss_utc_to_ticks(uint32_t seconds, uint32_t microseconds,
+                                 uint32_t *ticks);
+
+/**
+ *  Convert a value of millis to UTC.
+ *
+ *  @param time The value of millis
+ *  @param seconds Pointer to where the UTC time in seconds since Unix epoch
+ *                 will be stored
+ *  @param milliseconds Pointer to where the number of milliseconds into the
+ *                      second will be stored
+ *
+ *  @return 1 if the time was converted, 0 if no time sync is available
+ */
+extern uint8_t gnss_millis_to_utc(uint32_t time, uint32_t *seconds,
+                                  uint16_t *milliseconds);
+
 
 #endif /* gnss_h */
@@ -407,6 +407,59 @@ static uint8_t get_pin_for_interrupt (int8_t interrupt, union gpio_pin_t *pin)
     return 1;
 }
 
+/**
+ *  Connect an internal pin to its EIC line and configure the sense and filter
+ *  for the line.
+ *
+ *  @param pin The pin
+ *  @param int_num The EIC line for the pin
+ *  @param trigger The trigger type for the line
+ *  @param filter Whether or not the filter should be enabled
+ */
+static void gpio_configure_eic_line (union gpio_pin_t pin, int8_t int_num,
+                                     enum gpio_interrupt_trigger trigger,
+                                     uint8_t filter)
+{
+    // Set PMUX to interrupt (function A)
+    if (pin.internal.pin & 1) {
+        PORT_IOBUS->Group[pin.internal.port].PMUX[pin.internal.pin >> 1].bit.PMUXO = 0;
+    } else {
+        PORT_IOBUS->Group[pin.internal.port].PMUX[pin.internal.pin >> 1].bit.PMUXE = 0;
+    }
+    // Enable PMUX
+    PORT_IOBUS->Group[pin.internal.port].PINCFG[pin.internal.pin].bit.PMUXEN = 1;
+
+    // Set sense for interrupt
+    switch (trigger) {
+        case GPIO_INTERRUPT_RISING_EDGE:
+            EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_RISE <<
+                                              (4 * (int_num & 0x7)));
+            break;
+        case GPIO_INTERRUPT_FALLING_EDGE:
+            EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_FALL <<
+                                              (4 * (int_num & 0x7)));
+            break;
+        case GPIO_INTERRUPT_BOTH_EDGES:
+            EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_BOTH <<
+                                              (4 * (int_num & 0x7)));
+            break;
+        case GPIO_INTERRUPT_HIGH:
+            EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_HIGH <<
+                                              (4 * (int_num & 0x7)));
+            break;
+        case GPIO_INTERRUPT_LOW:
+            EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_LOW <<
+                                              (4 * (int_num & 0x7)));
+            break;
+    }
+
+    // Enable filter if requested
+    if (filter) {
+        EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_FILTEN0 <<
+                                          (4 * (int_num & 0x7)));
+    }
+}
+
 uint8_t gpio_enable_interrupt(union gpio_pin_t pin,
                               enum gpio_interrupt_trigger trigger,
                               uint8_t filter, gpio_interrupt_cb callback)
@@ -436,44 +489,7 @@ uint8_t gpio_enable_interrupt(union gpio_pin_t pin,
             // Set callback function
             gpio_int_callbacks[int_num] = callback;
 
-            // Set PMUX to interrupt (function A)
-            if (pin.internal.pin & 1) {
-                PORT_IOBUS->Group[pin.internal.port].PMUX[pin.internal.pin >> 1].bit.PMUXO = 0;
-            } else {
-                PORT_IOBUS->Group[pin.internal.port].PMUX[pin.internal.pin >> 1].bit.PMUXE = 0;
-            }
-            // Enable PMUX
-            PORT_IOBUS->Group[pin.internal.port].PINCFG[pin.internal.pin].bit.PMUXEN = 1;
-
-            // Set sense for interrupt
-            switch (trigger) {
-                case GPIO_INTERRUPT_RISING_EDGE:
-                    EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_RISE <<
-                                                      (4 * (int_num & 0x7)));
-                    break;
-                case GPIO_INTERRUPT_FALLING_EDGE:
-                    EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_FALL <<
-                                                      (4 * (int_num & 0x7)));
-                    break;
-                case GPIO_INTERRUPT_BOTH_EDGES:
-                    EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_BOTH <<
-                                                      (4 * (int_num & 0x7)));
-                    break;
-                case GPIO_INTERRUPT_HIGH:
-                    EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_HIGH <<
-                                                      (4 * (int_num & 0x7)));
-                    break;
-                case GPIO_INTERRUPT_LOW:
-                    EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_SENSE0_LOW <<
-                                                      (4 * (int_num & 0x7)));
-                    break;
-            }
-
-            // Enable filter if requested
-            if (filter) {
-                EIC->CONFIG[int_num >> 3].reg |= (EIC_CONFIG_FILTEN0 <<
-                                                  (4 * (int_num & 0x7)));
-            }
+            gpio_configure_eic_line(pin, int_num, trigger, filter);
 
             // Enable waking from interrupt
             EIC->WAKEUP.reg |= (1 << int_num);
@@ -516,6 +532,43 @@ uint8_t gpio_enable_interrupt(union gpio_pin_t pin,
     return 1;
 }
 
+uint8_t gpio_enable_event(union gpio_pin_t pin,
+                          enum gpio_interrupt_trigger trigger, uint8_t filter,
+                          uint8_t *generator)
+{
+    if (pin.type != GPIO_INTERNAL_PIN) {
+        // Only internal pins can generate events
+        return 1;
+    }
+
+    int8_t int_num = gpio_pin_interrupts[pin.internal.raw];
+
+    if (int_num < 0) {
+        // This pin cannot be used with the EIC (or doesn't exist)
+        return 1;
+    }
+
+    if (gpio_get_pin_mode(pin) != GPIO_PIN_INPUT) {
+        // This pin is not configured as an input
+        return 1;
+    }
+
+    union gpio_pin_t pin_temp;
+    if (!get_pin_for_interrupt(int_num, &pin_temp)) {
+        // The EIC line for this pin is already in use (by another pin or this
+        // one)
+        return 1;
+    }
+
+    gpio_configure_eic_line(pin, int_num, trigger, filter);
+
+    // Enable event output
+    EIC->EVCTRL.reg |= (1 << int_num);
+
+    *generator = EVSYS_ID_GEN_EIC_EXTINT_0 + int_num;
+    return 0;
+}
+
 uint8_t gpio_disable_interrupt(union gpio_pin_t pin)
 {
     switch (pin.type) {
@@ -541,6 +594,8 @@ uint8_t gpio_disable_interrupt(union gpio_pin_t pin)
 
             // Disable the interrupt in the EIC
             EIC->INTENCLR.reg = (1 << int_num);
+            // Disable the event output
+            EIC->EVCTRL.reg &= ~(1 << int_num);
             // Ensure that the interrupt will not wake the CPU
             EIC->WAKEUP.reg &= ~(1 << int_num);
 
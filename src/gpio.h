@@ -207,6 +207,23 @@ extern uint8_t gpio_enable_interrupt(union gpio_pin_t pin,
                                     uint8_t filter,
                                     gpio_interrupt_cb callback);
 
+/**
+ *  Configure a pin which is configured as an input to generate an EVSYS event.
+ *  The pin's EIC line is used, so the pin can not also be used for an
+ *  interrupt. Only internal pins can generate events.
+ *
+ *  @param pin The pin for which the event should be enabled
+ *  @param trigger The trigger type for the event
+ *  @param filter Whether or not a filter should be
+ *  @param generator Pointer to where the EVSYS event generator ID for the pin
+ *                   will be stored
+ *
+ *  @return 0 if event enabled successfully, 1 otherwise
+ */
+extern uint8_t gpio_enable_event(union gpio_pin_t pin,
+                                 enum gpio_interrupt_trigger trigger,
+                                 uint8_t filter, uint8_t *generator);
+
 /**
  *  Disable the interrupt for a pin.
  *
@@ -10,28 +10,353 @@
 #include "ground.h"
 
 #include "console.h"
+#include "telemetry-format.h"
+#include "telemetry-codec.h"
+#include "reed-solomon.h"
+#include "telemetry-link.h"
 
+#include <string.h>
+
+/** Period in milliseconds at which link statistics are sent to the host */
+#define GROUND_LINK_STATS_PERIOD    5000
+
+/** Size of a full USB CDC transfer, frames for the host are written in
+    multiples of this size when possible */
+#define GROUND_TRANSFER_SIZE        64
+/** Longest time in milliseconds that frames are held waiting for enough data
+    to fill a transfer */
+#define GROUND_COALESCE_TIME        2
+/** Size of the buffer in which frames for the host are collected */
+#define GROUND_OUT_BUFFER_LEN       256
+/** Longest time in milliseconds that a frame is held waiting for copies from
+    the other radios, a frame is relayed sooner if every radio has received
+    it */
+#define GROUND_DIVERSITY_WINDOW     25
+
+/**
+ *  State for each radio from which frames are received.
+ */
+struct ground_radio_t {
+    struct rn2483_desc_t *radio;
+    /** Statistics for the frames received by this radio */
+    struct telemetry_link_stats_t stats;
+    enum rn2483_operation_result op_status;
+    uint8_t index;
+};
+
+/**
+ *  The best copy received so far of the newest frame, which is held until
+ *  each radio has had a chance to receive it.
+ */
+struct ground_pending_t {
+    uint8_t frame[RN2483_SEND_MAX_LEN];
+    uint32_t time;
+    int16_t corrected;
+    uint16_t sequence;
+    uint8_t length;
+    int8_t snr;
+    int8_t rssi;
+    /** Bitmap of the radios which have received the frame, zero if no frame
+        is held */
+    uint8_t radios;
+};
 
 static struct console_desc_t *ground_console_g;
 
-static struct rn2483_desc_t *ground_radio_g;
+static struct ground_radio_t ground_radios_g[GROUND_MAX_RADIOS];
+static uint8_t ground_num_radios_g;
+
+static struct ground_pending_t ground_pending_g;
 
 static uint8_t ready_to_send_g;
 
-static enum rn2483_operation_result ground_op_status_g;
+static struct telemetry_decoder_t ground_decoder_g;
+
+static struct rs_codec_t ground_fec_g;
+static uint8_t ground_fec_depth_g;
+/** Number of parity bytes at the end of each frame, zero if forward error
+    correction is not used */
+static uint8_t ground_fec_parity_g;
+
+/** Statistics for the frames merged from all of the radios */
+static struct telemetry_link_stats_t ground_link_stats_g;
+static uint32_t ground_link_stats_time_g;
+
+/** Frames waiting to be written to the host */
+static uint8_t ground_out_buffer_g[GROUND_OUT_BUFFER_LEN];
+/** Number of bytes in the out buffer */
+static uint16_t ground_out_length_g;
+/** Time at which the oldest data in the out buffer was added */
+static uint32_t ground_out_time_g;
+
+
+
+/**
+ *  Write data from the start of the out buffer to the host.
+ *
+ *  @param length The number of bytes to be written
+ */
+static void ground_flush (uint16_t length)
+{
+    console_send_bytes(ground_console_g, ground_out_buffer_g, length);
+    ground_out_length_g -= length;
+    memmove(ground_out_buffer_g, ground_out_buffer_g + length,
+            ground_out_length_g);
+    ground_out_time_g = millis;
+}
+
+/**
+ *  Frame a payload for the host and add it to the out buffer. As many full
+ *  transfers as possible are written right away, the rest is held until
+ *  another frame fills the transfer or GROUND_COALESCE_TIME passes.
+ *
+ *  @param payload The payload to be sent
+ *  @param length The length of the payload
+ *  @param time The time at which the payload was received
+ *  @param snr The signal to noise ratio for the payload
+ *  @param rssi The signal strength for the payload
+ */
+static void ground_send_frame (const uint8_t *payload, uint16_t length,
+                               uint32_t time, int8_t snr, int8_t rssi)
+{
+    uint16_t frame_length = (sizeof(struct ground_frame_header) + length +
+                             GROUND_FRAME_CRC_LEN);
+    if (frame_length > GROUND_OUT_BUFFER_LEN) {
+        return;
+    }
+    if ((ground_out_length_g + frame_length) > GROUND_OUT_BUFFER_LEN) {
+        ground_flush(ground_out_length_g);
+    }
+    if (ground_out_length_g == 0) {
+        ground_out_time_g = millis;
+    }
+    
+    uint8_t *frame = ground_out_buffer_g + ground_out_length_g;
+    struct ground_frame_header header = {
+        .sync = GROUND_FRAME_SYNC,
+        .length = length,
+        .time = time,
+        .snr = snr,
+        .rssi = rssi
+    };
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), payload, length);
+    uint16_t crc = telemetry_link_crc(frame, sizeof(header) + length);
+    memcpy(frame + sizeof(header) + length, &crc, GROUND_FRAME_CRC_LEN);
+    ground_out_length_g += frame_length;
+    
+    uint16_t full = ground_out_length_g - (ground_out_length_g %
+                                           GROUND_TRANSFER_SIZE);
+    if (full != 0) {
+        ground_flush(full);
+    }
+}
+
+
+/**
+ *  Expand a frame of encoded samples into one frame of struct telemetry_frame
+ *  for each sample so that the host receives the same frames as before
+ *  samples were encoded.
+ *
+ *  @param data The received frame
+ *  @param length The length of the received frame
+ *  @param time The time at which the frame was received
+ *  @param snr The signal to noise ratio for the received frame
+ *  @param rssi The signal strength for the received frame
+ *
+ *  @return 0 if the frame was expanded, 1 if it is not a frame of encoded
+ *          samples
+ */
+static uint8_t ground_expand_compact (const uint8_t *data, uint8_t length,
+                                      uint32_t time, int8_t snr, int8_t rssi)
+{
+    if (length < (5 + TELEMETRY_COMPACT_HEADER_LEN)) {
+        return 1;
+    }
+    
+    uint16_t payload_length;
+    memcpy(&payload_length, data + 2, sizeof(payload_length));
+    
+    if ((data[0] != TELEMETRY_START_DELIMITER) ||
+            (data[1] != TELEMETRY_PAYLOAD_COMPACT) ||
+            (payload_length != (length - 5)) ||
+            (data[length - 1] != TELEMETRY_END_DELIMITER)) {
+        return 1;
+    }
+    
+    // All of the samples in the frame share a time base
+    uint32_t time_base;
+    memcpy(&time_base, data + 4, sizeof(time_base));
+    uint8_t num_samples = data[8];
+    
+    struct telemetry_api_frame frame;
+    frame.start_delimiter = TELEMETRY_START_DELIMITER;
+    frame.payload_type = TELEMETRY_PAYLOAD_RAW;
+    frame.length = sizeof(frame.payload);
+    frame.end_delimiter = TELEMETRY_END_DELIMITER;
+    
+    const uint8_t *s = data + 4 + TELEMETRY_COMPACT_HEADER_LEN;
+    const uint8_t *end = data + length - 1;
+    for (; num_samples && (s != end); num_samples--) {
+        uint8_t consumed;
+        enum telemetry_decode_result result = telemetry_decode(
+                                            &ground_decoder_g, s,
+                                            (uint8_t)(end - s), time_base,
+                                            &consumed,
+                                            &frame.payload);
+        if (result == TELEMETRY_DECODE_INVALID) {
+            break;
+        }
+        s += consumed;
+        
+        if (result == TELEMETRY_DECODE_OK) {
+            ground_send_frame((uint8_t*)&frame, sizeof(frame), time, snr,
+                              rssi);
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ *  Relay a frame to the host if it has not already been relayed.
+ *
+ *  @param frame The frame, starting with the sequence number
+ *  @param length The length of the frame, including the CRC
+ *  @param corrected The number of bytes corrected in the frame
+ *  @param time The time at which the frame was received
+ *  @param snr The signal to noise ratio for the frame
+ *  @param rssi The signal strength for the frame
+ */
+static void ground_relay (const uint8_t *frame, uint8_t length,
+                          int16_t corrected, uint32_t time, int8_t snr,
+                          int8_t rssi)
+{
+    if (telemetry_link_receive(&ground_link_stats_g, frame, length, corrected,
+                               time, snr, rssi) != TELEMETRY_LINK_OK) {
+        return;
+    }
+    frame += TELEMETRY_LINK_HEADER_LEN;
+    length -= TELEMETRY_LINK_OVERHEAD;
+    
+    if (length && ready_to_send_g &&
+            ground_expand_compact(frame, length, time, snr, rssi)) {
+        ground_send_frame(frame, length, time, snr, rssi);
+    }
+}
 
+/**
+ *  Relay the held frame, if there is one.
+ */
+static void ground_release_pending (void)
+{
+    if (ground_pending_g.radios == 0) {
+        return;
+    }
+    ground_pending_g.radios = 0;
+    ground_relay(ground_pending_g.frame, ground_pending_g.length,
+                 ground_pending_g.corrected, ground_pending_g.time,
+                 ground_pending_g.snr, ground_pending_g.rssi);
+}
 
+/**
+ *  Merge an intact copy of a frame from one of the radios. Copies of a frame
+ *  are identical once they have passed the CRC check, so only the time of the
+ *  first copy and the signal quality of the copy with the best SNR are kept.
+ */
+static void ground_merge (struct ground_radio_t *radio, const uint8_t *frame,
+                          uint8_t length, int16_t corrected, uint32_t time,
+                          int8_t snr, int8_t rssi)
+{
+    struct ground_pending_t *pending = &ground_pending_g;
+    uint16_t sequence;
+    memcpy(&sequence, frame, sizeof(sequence));
+    
+    if (pending->radios && (sequence == pending->sequence)) {
+        pending->radios |= (1 << radio->index);
+        if (snr > pending->snr) {
+            pending->snr = snr;
+            pending->rssi = rssi;
+            pending->corrected = corrected;
+        }
+    } else if ((pending->radios &&
+                ((int16_t)(sequence - pending->sequence) < 0)) ||
+               (ground_link_stats_g.have_sequence &&
+                ((int16_t)(sequence -
+                           ground_link_stats_g.last_sequence) <= 0))) {
+        // A late copy of an older frame, which is relayed right away if no
+        // other radio received it
+        ground_relay(frame, length, corrected, time, snr, rssi);
+        return;
+    } else {
+        ground_release_pending();
+        
+        memcpy(pending->frame, frame, length);
+        pending->length = length;
+        pending->sequence = sequence;
+        pending->time = time;
+        pending->corrected = corrected;
+        pending->snr = snr;
+        pending->rssi = rssi;
+        pending->radios = (1 << radio->index);
+    }
+    
+    if (pending->radios == ((1 << ground_num_radios_g) - 1)) {
+        ground_release_pending();
+    }
+}
 
 static void ground_radio_recv_callback (struct rn2483_desc_t *inst,
                                        void *context, uint8_t *data,
                                        uint8_t length, int8_t snr, int8_t rssi)
 {
-    if (length && ready_to_send_g) {
-        console_send_bytes(ground_console_g, data, length);
-        console_send_bytes(ground_console_g, (uint8_t*)&snr, 1);
+    struct ground_radio_t *radio = (struct ground_radio_t*)context;
+    uint32_t time = millis;
+    
+    if ((length == 0) || (length > RN2483_SEND_MAX_LEN)) {
+        goto receive;
+    }
+    
+    // Correct errors and remove the parity bytes
+    int16_t corrected = 0;
+    if (ground_fec_parity_g != 0) {
+        if (length <= ground_fec_parity_g) {
+            corrected = -1;
+        } else {
+            length -= ground_fec_parity_g;
+            corrected = rs_decode(&ground_fec_g, data, length, data + length,
+                                  ground_fec_depth_g);
+        }
+    }
+    
+    // Frames which are corrupt or which this radio has already received are
+    // dropped
+    if (telemetry_link_receive(&radio->stats, data, length, corrected, time,
+                               snr, rssi) == TELEMETRY_LINK_OK) {
+        ground_merge(radio, data, length, corrected, time, snr, rssi);
     }
-    ground_op_status_g =  rn2483_receive(ground_radio_g,
-                                         ground_radio_recv_callback, NULL);
+    
+receive:
+    radio->op_status = rn2483_receive(inst, ground_radio_recv_callback, radio);
+}
+
+/**
+ *  Send link statistics to the host.
+ *
+ *  @param radio The index of the radio, or TELEMETRY_LINK_ALL_RADIOS
+ *  @param report The statistics
+ */
+static void ground_send_link_stats (uint8_t radio,
+                                    const struct telemetry_link_report *report)
+{
+    struct telemetry_link_api_frame frame;
+    frame.start_delimiter = TELEMETRY_START_DELIMITER;
+    frame.payload_type = TELEMETRY_PAYLOAD_LINK_STATS;
+    frame.length = sizeof(frame.radio) + sizeof(frame.payload);
+    frame.radio = radio;
+    frame.payload = *report;
+    frame.end_delimiter = TELEMETRY_END_DELIMITER;
+    ground_send_frame((uint8_t*)&frame, sizeof(frame), millis, 0, INT8_MIN);
 }
 
 static void console_ready (struct console_desc_t *console, void *context)
@@ -41,22 +366,81 @@ static void console_ready (struct console_desc_t *console, void *context)
 
 
 void init_ground_service(struct console_desc_t *out_console,
-                         struct rn2483_desc_t *radio)
+                         struct rn2483_desc_t **radios, uint8_t fec_roots,
+                         uint8_t fec_depth)
 {
     ground_console_g = out_console;
-    ground_radio_g = radio;
     ready_to_send_g = 0;
+    ground_pending_g.radios = 0;
     
-    ground_op_status_g = rn2483_receive(ground_radio_g,
-                                        ground_radio_recv_callback, NULL);
+    init_telemetry_decoder(&ground_decoder_g);
+    init_telemetry_link_stats(&ground_link_stats_g);
+    ground_link_stats_time_g = millis;
+    ground_out_length_g = 0;
+    
+    ground_fec_parity_g = 0;
+    if ((fec_roots >= 2) && (fec_roots <= RS_MAX_ROOTS) && (fec_depth != 0)) {
+        init_rs_codec(&ground_fec_g, fec_roots);
+        ground_fec_depth_g = fec_depth;
+        ground_fec_parity_g = fec_roots * fec_depth;
+    }
+    
+    ground_num_radios_g = 0;
+    for (; (*radios != NULL) && (ground_num_radios_g < GROUND_MAX_RADIOS);
+         radios++) {
+        struct ground_radio_t *radio = ground_radios_g + ground_num_radios_g;
+        radio->radio = *radios;
+        radio->index = ground_num_radios_g++;
+        init_telemetry_link_stats(&radio->stats);
+        radio->op_status = rn2483_receive(radio->radio,
+                                          ground_radio_recv_callback, radio);
+    }
     
     console_set_init_callback(ground_console_g, console_ready, NULL);
 }
 
 void ground_service (void)
 {
-    if (ground_op_status_g != RN2483_OP_SUCCESS) {
-        ground_op_status_g = rn2483_receive(ground_radio_g,
-                                            ground_radio_recv_callback, NULL);
+    for (uint8_t i = 0; i < ground_num_radios_g; i++) {
+        struct ground_radio_t *radio = ground_radios_g + i;
+        if (radio->op_status != RN2483_OP_SUCCESS) {
+            radio->op_status = rn2483_receive(radio->radio,
+                                              ground_radio_recv_callback,
+                                              radio);
+        }
+    }
+    
+    if (ground_pending_g.radios &&
+            ((millis - ground_pending_g.time) >= GROUND_DIVERSITY_WINDOW)) {
+        ground_release_pending();
+    }
+    
+    if (((millis - ground_link_stats_time_g) >= GROUND_LINK_STATS_PERIOD) &&
+            ready_to_send_g) {
+        ground_link_stats_time_g = millis;
+        
+        ground_send_link_stats(TELEMETRY_LINK_ALL_RADIOS,
+                               &ground_link_stats_g.report);
+        for (uint8_t i = 0; i < ground_num_radios_g; i++) {
+            ground_send_link_stats(i, &ground_radios_g[i].stats.report);
+        }
+    }
+    
+    if ((ground_out_length_g != 0) &&
+            ((millis - ground_out_time_g) >= GROUND_COALESCE_TIME)) {
+        ground_flush(ground_out_length_g);
+    }
+}
+
+const struct telemetry_link_report *ground_get_link_stats (void)
+{
+    return &ground_link_stats_g.report;
+}
+
+const struct telemetry_link_report *ground_get_radio_stats (uint8_t radio)
+{
+    if (radio >= ground_num_radios_g) {
+        return NULL;
     }
+    return &ground_radios_g[radio].stats.report;
 }
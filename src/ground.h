@@ -14,10 +14,47 @@
 
 #include "console.h"
 #include "rn2483.h"
+#include "telemetry-format.h"
 
+/** Maximum number of radios from which the ground service can receive */
+#define GROUND_MAX_RADIOS   4
+
+/**
+ *  Initialize the ground service. Frames are received on every radio and the
+ *  copies of each frame are merged by sequence number, so that each frame is
+ *  relayed to the host once.
+ *
+ *  @param out_console The console to which frames are relayed
+ *  @param radios NULL terminated list of radios, at most GROUND_MAX_RADIOS
+ *                are used
+ *  @param fec_roots The number of Reed-Solomon parity bytes per codeword
+ *  @param fec_depth The number of interleaved codewords per frame
+ */
 extern void init_ground_service(struct console_desc_t *out_console,
-                                struct rn2483_desc_t *radio);
+                                struct rn2483_desc_t **radios,
+                                uint8_t fec_roots, uint8_t fec_depth);
 
 extern void ground_service (void);
 
+/**
+ *  Get the statistics for the telemetry link, counting the frames merged from
+ *  all of the radios. The statistics are also sent to the host periodically in
+ *  a TELEMETRY_PAYLOAD_LINK_STATS frame.
+ *
+ *  @return The link statistics
+ */
+extern const struct telemetry_link_report *ground_get_link_stats (void);
+
+/**
+ *  Get the statistics for the frames received by one radio. The statistics for
+ *  each radio are sent to the host along with the merged statistics.
+ *
+ *  @param radio The index of the radio in the list given to
+ *               init_ground_service
+ *
+ *  @return The radio's link statistics, or NULL if there is no such radio
+ */
+extern const struct telemetry_link_report *ground_get_radio_stats (
+                                                                uint8_t radio);
+
 #endif /* ground_h */
@@ -13,6 +13,7 @@
 #include "wdt.h"
 #include "gpio.h"
 #include "dma.h"
+#include "evsys.h"
 #include "adc.h"
 #include "sercom-uart.h"
 #include "sercom-spi.h"
@@ -31,6 +32,8 @@
 
 #include "gnss-xa1110.h"
 #include "ms5611.h"
+#include "estimator.h"
+#include "flight-state.h"
 #include "rn2483.h"
 
 #include "ground.h"
@@ -74,14 +77,28 @@ struct mcp23s17_desc_t io_expander_g;
 
 #ifdef ENABLE_LORA_RADIO
 struct rn2483_desc_t rn2483_g;
+#ifdef ENABLE_LORA_RADIO_2
+struct rn2483_desc_t rn2483_2_g;
 
+static struct rn2483_desc_t *rn2483_list_g[] = { &rn2483_g, &rn2483_2_g,
+                                                 NULL };
+#else
 static struct rn2483_desc_t *rn2483_list_g[] = { &rn2483_g, NULL };
 #endif
+#endif
 
 #ifdef ENABLE_ALTIMETER
 struct ms5611_desc_t altimeter_g;
 #endif
 
+#ifdef ENABLE_ESTIMATOR
+struct estimator_t estimator_g;
+#endif
+
+#ifdef ENABLE_FLIGHT_STATE
+struct flight_state_desc_t flight_state_g;
+#endif
+
 #ifdef ENABLE_GNSS
 struct console_desc_t gnss_console_g;
 #endif
@@ -387,11 +404,44 @@ int main(void)
                           (1 << ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC));
     init_adc(GCLK_CLKCTRL_GEN_GCLK3, 8000000UL, chan_mask, ADC_PERIOD,
              ADC_SOURCE_IMPEDANCE, ADC_DMA_CHAN);
+#ifdef ADC_SINGLE_SHOT_MASK
+    adc_configure_channels(ADC_SINGLE_SHOT_MASK, ADC_OVERSAMPLE_NONE,
+                           ADC_GAIN_1X);
+#endif
+#ifdef ADC_16X_OVERSAMPLE_MASK
+    adc_configure_channels(ADC_16X_OVERSAMPLE_MASK, ADC_OVERSAMPLE_16X,
+                           ADC_GAIN_1X);
+#endif
+#ifdef ADC_STATS_MASK
+    adc_stats_configure(ADC_STATS_MASK, ADC_STATS_WINDOW);
+#endif
 #endif
     
     // Init Altimeter
 #ifdef ENABLE_ALTIMETER
     init_ms5611(&altimeter_g, &i2c_g, ALTIMETER_CSB, ALTIMETER_PERIOD, 1);
+    ms5611_set_oversampling(&altimeter_g, ALTIMETER_PRES_OSR,
+                            ALTIMETER_TEMP_OSR);
+    ms5611_set_temp_period(&altimeter_g, ALTIMETER_TEMP_PERIOD);
+#ifdef ALTIMETER_TC
+    ms5611_use_timer(&altimeter_g, ALTIMETER_TC, GCLK_CLKCTRL_GEN_GCLK0, F_CPU);
+#endif
+#endif
+    
+    // Init Estimator
+#ifdef ENABLE_ESTIMATOR
+    init_estimator(&estimator_g, &altimeter_g, ESTIMATOR_ALPHA,
+                   ESTIMATOR_BETA);
+#endif
+    
+    // Init Flight State
+#ifdef ENABLE_FLIGHT_STATE
+    init_flight_state(&flight_state_g, &estimator_g,
+                      flight_state_default_rates);
+#ifdef FLIGHT_STATE_ACCEL_CHAN
+    flight_state_use_accel(&flight_state_g, FLIGHT_STATE_ACCEL_CHAN,
+                           FLIGHT_STATE_ACCEL_ZERO, FLIGHT_STATE_ACCEL_SCALE);
+#endif
 #endif
     
     // Init GNSS
@@ -438,6 +488,11 @@ int main(void)
                 LORA_SPREADING_FACTOR, LORA_CODING_RATE, LORA_BANDWIDTH,
                 LORA_CRC, LORA_INVERT_IQ, LORA_SYNC_WORD);
 #endif
+#ifdef ENABLE_LORA_RADIO_2
+    init_rn2483(&rn2483_2_g, &LORA_2_UART, LORA_2_FREQ, LORA_POWER,
+                LORA_SPREADING_FACTOR, LORA_CODING_RATE, LORA_BANDWIDTH,
+                LORA_CRC, LORA_INVERT_IQ, LORA_SYNC_WORD);
+#endif
     
     // GPIO
 #ifdef ENABLE_IO_EXPANDER
@@ -465,6 +520,13 @@ int main(void)
     
     gpio_set_output(STAT_G_LED_PIN, 1);
     
+    // Init GNSS PPS timestamping
+#if defined(ENABLE_GNSS) && defined(GNSS_PPS_TC)
+    init_evsys();
+    gnss_xa1110_use_pps(GNSS_PPS_TC, GCLK_CLKCTRL_GEN_GCLK0, F_CPU,
+                        GNSS_PPS_PIN, GNSS_PPS_EVENT_CHAN);
+#endif
+    
     
     // Ground station console
 #ifdef ENABLE_GROUND_SERVICE
@@ -479,12 +541,23 @@ int main(void)
 #else
 #error Ground console is configured to use USB, but USB is not enabled.
 #endif
-    init_ground_service(&ground_station_console_g, &rn2483_g);
+    init_ground_service(&ground_station_console_g, rn2483_list_g,
+                        GROUND_FEC_ROOTS, GROUND_FEC_DEPTH);
 #endif
     
     // Telemetry service
 #ifdef ENABLE_TELEMETRY_SERVICE
-    init_telemetry_service(&rn2483_g, &altimeter_g, TELEMETRY_RATE);
+#ifdef ENABLE_FLIGHT_STATE
+    init_telemetry_service(&rn2483_g, &altimeter_g, &flight_state_g,
+                           TELEMETRY_RATE, TELEMETRY_MAX_DUTY_CYCLE,
+                           TELEMETRY_KEYFRAME_INTERVAL, TELEMETRY_FEC_ROOTS,
+                           TELEMETRY_FEC_DEPTH);
+#else
+    init_telemetry_service(&rn2483_g, &altimeter_g, NULL, TELEMETRY_RATE,
+                           TELEMETRY_MAX_DUTY_CYCLE,
+                           TELEMETRY_KEYFRAME_INTERVAL, TELEMETRY_FEC_ROOTS,
+                           TELEMETRY_FEC_DEPTH);
+#endif
 #endif
     
     
@@ -551,13 +624,25 @@ static void main_loop (void)
     ms5611_service(&altimeter_g);
 #endif
     
+#ifdef ENABLE_ESTIMATOR
+    estimator_service(&estimator_g);
+#endif
+    
+#ifdef ENABLE_FLIGHT_STATE
+    flight_state_service(&flight_state_g);
+#endif
+    
 #ifdef ENABLE_GNSS
     console_service(&gnss_console_g);
+    gnss_xa1110_service();
 #endif
     
 #ifdef ENABLE_LORA_RADIO
     rn2483_service(&rn2483_g);
 #endif
+#ifdef ENABLE_LORA_RADIO_2
+    rn2483_service(&rn2483_2_g);
+#endif
     
 #ifdef ENABLE_GROUND_SERVICE
     ground_service();
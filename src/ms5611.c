@@ -11,14 +11,249 @@
 
 #include "ms5611-commands.h"
 
-#include <math.h>
-
 
 #define CONV_WAIT_TIME 10
 
 static const uint8_t reset_cmd = MS5611_CMD_RESET;
-static const uint8_t adc_conv_d1_cmd = MS5611_CMD_D1 | MS5611_OSR_4096;
-static const uint8_t adc_conv_d2_cmd = MS5611_CMD_D2 | MS5611_OSR_4096;
+
+/**
+ *  Maximum conversion time in microseconds for each oversampling ratio.
+ */
+static const uint16_t ms5611_conv_times[] = {
+    [MS5611_OSR_256_Val] = 600,
+    [MS5611_OSR_512_Val] = 1170,
+    [MS5611_OSR_1024_Val] = 2280,
+    [MS5611_OSR_2048_Val] = 4540,
+    [MS5611_OSR_4096_Val] = 9040
+};
+
+
+/*
+ *  Fixed point altitude calculation
+ *
+ *  The altitude is found from the international barometric formula:
+ *
+ *      h = (T / L) * ((p0 / p)^(R * L / (g * M)) - 1)
+ *
+ *  The power is calculated as 2^(0.1902225604 * (log2(p0) - log2(p))). Both
+ *  log2 and 2^x are found by quadratic interpolation between the values in 129
+ *  entry lookup tables.
+ *
+ *  Over pressures from 10 to 1200 mbar, with any reference pressure in the same
+ *  range and temperatures from -40 to 85 degrees celsius, the result is within
+ *  3 mm of the formula evaluated in double precision. The single precision
+ *  powf implementation which this replaces had errors of up to 18 mm over the
+ *  same range.
+ */
+
+/**
+ *  log2(1 + i/128) for i from 0 to 129 (Q2.30)
+ */
+static const int32_t ms5611_log2_table[] = {
+    0, 12055174, 24017256, 35887675, 47667823, 59359063, 70962728, 82480119,
+    93912511, 105261148, 116527248, 127712004, 138816582, 149842124, 160789745,
+    171660541, 182455581, 193175914, 203822568, 214396548, 224898839, 235330407,
+    245692198, 255985140, 266210141, 276368092, 286459867, 296486323, 306448299,
+    316346620, 326182095, 335955515, 345667660, 355319292, 364911162, 374444004,
+    383918542, 393335482, 402695523, 411999347, 421247625, 430441017, 439580170,
+    448665721, 457698295, 466678506, 475606957, 484484242, 493310944, 502087636,
+    510814882, 519493235, 528123241, 536705435, 545240343, 553728485, 562170370,
+    570566499, 578917365, 587223455, 595485245, 603703206, 611877800, 620009483,
+    628098702, 636145900, 644151509, 652115959, 660039669, 667923055, 675766525,
+    683570481, 691335320, 699061430, 706749198, 714399001, 722011213, 729586201,
+    737124328, 744625951, 752091421, 759521085, 766915285, 774274358, 781598637,
+    788888448, 796144114, 803365955, 810554283, 817709409, 824831638, 831921271,
+    838978604, 846003931, 852997541, 859959719, 866890747, 873790901, 880660455,
+    887499680, 894308843, 901088206, 907838029, 914558569, 921250079, 927912807,
+    934547002, 941152905, 947730758, 954280797, 960803257, 967298370, 973766362,
+    980207461, 986621888, 993009864, 999371606, 1005707329, 1012017244,
+    1018301561, 1024560487, 1030794226, 1037002979, 1043186948, 1049346328,
+    1055481314, 1061592099, 1067678873, 1073741824, 1079781138
+};
+
+/**
+ *  2^(i/128) for i from 0 to 129 (Q2.30)
+ */
+static const int32_t ms5611_exp2_table[] = {
+    1073741824, 1079572136, 1085434106, 1091327906, 1097253708, 1103211687,
+    1109202018, 1115224875, 1121280436, 1127368878, 1133490379, 1139645120,
+    1145833280, 1152055042, 1158310587, 1164600099, 1170923762, 1177281762,
+    1183674286, 1190101520, 1196563654, 1203060876, 1209593378, 1216161350,
+    1222764986, 1229404479, 1236080024, 1242791816, 1249540052, 1256324931,
+    1263146652, 1270005413, 1276901417, 1283834865, 1290805962, 1297814910,
+    1304861917, 1311947188, 1319070932, 1326233356, 1333434672, 1340675091,
+    1347954824, 1355274085, 1362633090, 1370032052, 1377471191, 1384950723,
+    1392470869, 1400031848, 1407633882, 1415277195, 1422962010, 1430688553,
+    1438457051, 1446267730, 1454120821, 1462016553, 1469955159, 1477936870,
+    1485961921, 1494030547, 1502142985, 1510299473, 1518500250, 1526745556,
+    1535035634, 1543370725, 1551751076, 1560176931, 1568648537, 1577166143,
+    1585730000, 1594340357, 1602997467, 1611701585, 1620452965, 1629251865,
+    1638098541, 1646993254, 1655936265, 1664927835, 1673968228, 1683057710,
+    1692196547, 1701385007, 1710623359, 1719911875, 1729250827, 1738640488,
+    1748081133, 1757573041, 1767116489, 1776711757, 1786359126, 1796058879,
+    1805811301, 1815616678, 1825475297, 1835387448, 1845353420, 1855373507,
+    1865448001, 1875577199, 1885761398, 1896000896, 1906295993, 1916646992,
+    1927054196, 1937517909, 1948038440, 1958616096, 1969251188, 1979944027,
+    1990694927, 2001504204, 2012372174, 2023299156, 2034285470, 2045331439,
+    2056437387, 2067603638, 2078830522, 2090118366, 2101467502, 2112878262,
+    2124350982, 2135885998, 2147483648, 2159144272
+};
+
+/** Number of fractional bits in log2 values */
+#define MS5611_LOG2_FRAC_BITS   26
+/** Number of bits used to select a table segment */
+#define MS5611_TABLE_BITS       7
+
+/** 0.1902225604 (Q0.32), exponent of barometric formula */
+#define MS5611_ALT_EXPONENT     816999676
+/** 1000 / (100 * 0.0065) (Q11.20), converts from hundredths of a kelvin to
+    millimetres over the temperature lapse rate */
+#define MS5611_ALT_SCALE        1613193846
+/** Largest exponent passed to ms5611_exp2, the start of the last table segment
+    below 2 so that the result fits in Q2.30 */
+#define MS5611_EXP2_MAX         ((2L << MS5611_LOG2_FRAC_BITS) - \
+                                 (1L << (MS5611_LOG2_FRAC_BITS - \
+                                         MS5611_TABLE_BITS)))
+
+/**
+ *  Interpolate between values in a lookup table using the value in the table
+ *  for the given segment and the two values after it.
+ *
+ *  @param table The lookup table
+ *  @param index The segment of the table
+ *  @param t The position within the segment
+ *  @param t_bits The number of fractional bits in t
+ *
+ *  @return The interpolated value
+ */
+static int32_t ms5611_interpolate (const int32_t *table, uint8_t index,
+                                   uint32_t t, uint8_t t_bits)
+{
+    int32_t y0 = table[index];
+    int32_t y1 = table[index + 1];
+    int32_t y2 = table[index + 2];
+    
+    // Linear term
+    int64_t lin = ((int64_t)(y1 - y0) * t) >> t_bits;
+    // Quadratic term, t * (t - 1) / 2 times the second difference
+    int64_t quad = (((int64_t)t * ((int64_t)t - ((int64_t)1 << t_bits))) >>
+                    t_bits);
+    quad = ((int64_t)((y2 - y1) - (y1 - y0)) * quad) >> (t_bits + 1);
+    
+    return (int32_t)(y0 + lin + quad);
+}
+
+/**
+ *  Calculate the base 2 logarithm of an integer.
+ *
+ *  @param x The value of which the logarithm should be found, must not be 0
+ *
+ *  @return log2(x) with MS5611_LOG2_FRAC_BITS fractional bits
+ */
+static int32_t ms5611_log2 (uint32_t x)
+{
+    uint8_t exponent = 31 - __builtin_clz(x);
+    // Normalize so that the most significant bit is bit 31
+    uint32_t m = x << (31 - exponent);
+    
+    uint8_t index = (m >> (31 - MS5611_TABLE_BITS)) &
+                        ((1 << MS5611_TABLE_BITS) - 1);
+    uint32_t t = m & ((1UL << (31 - MS5611_TABLE_BITS)) - 1);
+    int32_t frac = ms5611_interpolate(ms5611_log2_table, index, t,
+                                      31 - MS5611_TABLE_BITS);
+    
+    return (((int32_t)exponent << MS5611_LOG2_FRAC_BITS) +
+            ((frac + (1 << (29 - MS5611_LOG2_FRAC_BITS))) >>
+             (30 - MS5611_LOG2_FRAC_BITS)));
+}
+
+/**
+ *  Calculate 2 to the power of a fixed point number.
+ *
+ *  @param x The exponent with MS5611_LOG2_FRAC_BITS fractional bits, must be
+ *           at most MS5611_EXP2_MAX
+ *
+ *  @return 2^x (Q2.30)
+ */
+static uint32_t ms5611_exp2 (int32_t x)
+{
+    int32_t exponent = x >> MS5611_LOG2_FRAC_BITS;
+    uint32_t frac = x & ((1UL << MS5611_LOG2_FRAC_BITS) - 1);
+    
+    uint8_t index = frac >> (MS5611_LOG2_FRAC_BITS - MS5611_TABLE_BITS);
+    uint32_t t = frac & ((1UL << (MS5611_LOG2_FRAC_BITS -
+                                  MS5611_TABLE_BITS)) - 1);
+    uint32_t y = (uint32_t)ms5611_interpolate(ms5611_exp2_table, index, t,
+                                              (MS5611_LOG2_FRAC_BITS -
+                                               MS5611_TABLE_BITS));
+    
+    if (exponent >= 0) {
+        return y << exponent;
+    } else {
+        return y >> -exponent;
+    }
+}
+
+/**
+ *  Calculate the altitude relative to a reference pressure.
+ *
+ *  @param p0 The reference pressure in hundredths of a mbar
+ *  @param p The measured pressure in hundredths of a mbar
+ *  @param temperature The measured temperature in hundredths of a degree
+ *                     celsius
+ *
+ *  @return The altitude in millimetres
+ */
+static int32_t ms5611_calc_altitude (int32_t p0, int32_t p,
+                                     int32_t temperature)
+{
+    if ((p0 <= 0) || (p <= 0)) {
+        return 0;
+    }
+    
+    // log2(p0 / p) * 0.1902225604
+    int32_t l = ms5611_log2((uint32_t)p0) - ms5611_log2((uint32_t)p);
+    int32_t e = (int32_t)((((int64_t)l * MS5611_ALT_EXPONENT) +
+                           ((int64_t)1 << 31)) >> 32);
+    
+    // The result of ms5611_exp2 must be less than 4, which limits p0 / p to
+    // about 1450. Only a glitched reading can be that far below the reference
+    // pressure, saturate the altitude rather than overflowing.
+    if (e > MS5611_EXP2_MAX) {
+        e = MS5611_EXP2_MAX;
+    }
+    
+    // (p0 / p)^0.1902225604 - 1 (Q2.30)
+    int64_t f = (int64_t)ms5611_exp2(e) - ((int64_t)1 << 30);
+    
+    // Multiply by temperature in hundredths of a kelvin, keeping 14 fractional
+    // bits so that the scaling factor can be applied without overflow
+    int64_t a = (f * (temperature + 27315)) >> 16;
+    
+    return (int32_t)(((a * MS5611_ALT_SCALE) + ((int64_t)1 << 33)) >> 34);
+}
+
+/**
+ * Calculate the time taken by a reading which includes both pressure and
+ * temperature conversions, waiting for each conversion as
+ * ms5611_conv_complete does.
+ *
+ * @param inst The MS5611 driver instance
+ */
+static void ms5611_update_min_period (struct ms5611_desc_t *inst)
+{
+    uint32_t pres = ms5611_conv_times[inst->pres_osr];
+    uint32_t temp = ms5611_conv_times[inst->temp_osr];
+    
+    if (inst->tc != NULL) {
+        // The result is read as soon as each conversion is complete
+        inst->min_period = (uint16_t)((pres + temp + 999) / 1000);
+    } else {
+        // Each conversion waits for whole milliseconds plus one
+        inst->min_period = (uint16_t)(((pres + 999) / 1000) + 1 +
+                                      ((temp + 999) / 1000) + 1);
+    }
+}
 
 
 void init_ms5611 (struct ms5611_desc_t *inst,
@@ -33,12 +268,112 @@ void init_ms5611 (struct ms5611_desc_t *inst,
     
     inst->p0_set = 0;
     
+    inst->tc = NULL;
+    inst->pres_osr = MS5611_OSR_4096_Val;
+    inst->temp_osr = MS5611_OSR_4096_Val;
+    inst->temp_period = 1;
+    // Measure temperature with the first pressure measurement
+    inst->temp_count = 0;
+    ms5611_update_min_period(inst);
+    
     // Start by reading the factory calibration data
     inst->state = MS5611_READ_C1;
     
     ms5611_service(inst);
 }
 
+/**
+ * Callback for the conversion timer.
+ *
+ * @param state The MS5611 driver instance
+ */
+static void ms5611_timer_callback (void *state)
+{
+    ((struct ms5611_desc_t*)state)->conv_done = 1;
+}
+
+uint8_t ms5611_use_timer (struct ms5611_desc_t *inst, Tc *tc,
+                          uint32_t clock_mask, uint32_t clock_freq)
+{
+    if (init_tc_one_shot(tc, clock_mask, clock_freq, ms5611_timer_callback,
+                         inst)) {
+        return 1;
+    }
+    inst->tc = tc;
+    ms5611_update_min_period(inst);
+    return 0;
+}
+
+/**
+ * Get the value for the OSR field of a conversion command.
+ *
+ * @param osr The oversampling ratio
+ *
+ * @return The field value, or 0xFF if the oversampling ratio is not valid
+ */
+static uint8_t ms5611_osr_val (uint16_t osr)
+{
+    if ((osr < 256) || (osr > 4096) || (osr & (osr - 1))) {
+        return 0xFF;
+    }
+    // 256 is 2^8
+    return __builtin_ctz(osr) - 8;
+}
+
+uint8_t ms5611_set_oversampling (struct ms5611_desc_t *inst,
+                                 uint16_t pressure_osr,
+                                 uint16_t temperature_osr)
+{
+    uint8_t pres_osr = ms5611_osr_val(pressure_osr);
+    uint8_t temp_osr = ms5611_osr_val(temperature_osr);
+    
+    if ((pres_osr == 0xFF) || (temp_osr == 0xFF)) {
+        return 1;
+    }
+    
+    inst->pres_osr = pres_osr;
+    inst->temp_osr = temp_osr;
+    ms5611_update_min_period(inst);
+    return 0;
+}
+
+/**
+ * Start waiting for a conversion to complete.
+ *
+ * @param inst The MS5611 driver instance
+ * @param osr The oversampling ratio of the conversion
+ */
+static void ms5611_start_conv_wait (struct ms5611_desc_t *inst, uint8_t osr)
+{
+    inst->conv_start_time = millis;
+    
+    if (inst->tc != NULL) {
+        inst->conv_done = 0;
+        tc_one_shot_start(inst->tc, ms5611_conv_times[osr]);
+    }
+}
+
+/**
+ * Check whether a conversion has completed.
+ *
+ * @param inst The MS5611 driver instance
+ * @param osr The oversampling ratio of the conversion
+ *
+ * @return 1 if the conversion is complete, 0 otherwise
+ */
+static uint8_t ms5611_conv_complete (struct ms5611_desc_t *inst, uint8_t osr)
+{
+    if (inst->tc != NULL) {
+        return inst->conv_done;
+    }
+    
+    // Round the conversion time up to the next millisecond and wait for one
+    // more, since the conversion may have started just before millis was
+    // incremented
+    uint32_t wait = ((ms5611_conv_times[osr] + 999) / 1000) + 1;
+    return (millis - inst->conv_start_time) >= wait;
+}
+
 /**
  * Handle a state in which a value should be read from the sensor.
  *
@@ -94,9 +429,7 @@ static uint8_t handle_write_state (struct ms5611_desc_t *inst,
         inst->i2c_in_progress = 0;
         
         if (state == I2C_STATE_DONE) {
-            // Got result!
-            // Swap the bytes so that they are in the correct order
-            inst->prom_values[0] = __builtin_bswap16(inst->prom_values[0]);
+            // Command sent
             // go to next state
             return 1;
         }
@@ -146,16 +479,16 @@ static void do_calculations (struct ms5611_desc_t *inst)
     inst->pressure = ((((inst->d1 * sensitivity) / 2097152) - offset) / 32768);
     // Set p0 if it has not already been set
     if (!inst->p0_set) {
-        inst->p0 = ((float)inst->pressure) / 100.0f;
+        inst->p0 = inst->pressure;
         inst->p0_set = 1;
     }
     // Calculate altitude
     if (inst->calc_altitude) {
-        float t = ((float)(inst->temperature + 27315)) / 100;
-        float p = ((float)inst->pressure) / 100;
-        inst->altitude = (((powf((inst->p0 / p), 0.1902225604f) - 1.0f) * t) /
-                          0.0065f);
+        inst->altitude = ms5611_calc_altitude(inst->p0, inst->pressure,
+                                              inst->temperature);
     }
+    
+    inst->sample_count++;
 }
 
 void ms5611_service (struct ms5611_desc_t *inst)
@@ -275,18 +608,22 @@ void ms5611_service (struct ms5611_desc_t *inst)
             /* fall through */
         case MS5611_CONVERT_PRES:
             // In process of sending command to take presure measurment
-            if (handle_write_state(inst, &adc_conv_d1_cmd)) {
+            if (!inst->i2c_in_progress) {
+                inst->cmd = (MS5611_CMD_D1 |
+                             (inst->pres_osr << MS5611_OSR_Pos));
+            }
+            if (handle_write_state(inst, &inst->cmd)) {
                 // Go to the next state
                 inst->state = MS5611_CONVERT_PRES_WAIT;
-                // Record time
-                inst->conv_start_time = millis;
+                // Start timing conversion
+                ms5611_start_conv_wait(inst, inst->pres_osr);
             } else {
                 break;
             }
             /* fall through */
         case MS5611_CONVERT_PRES_WAIT:
             // Waiting for it to be time to read result
-            if ((millis - inst->conv_start_time) < CONV_WAIT_TIME) {
+            if (!ms5611_conv_complete(inst, inst->pres_osr)) {
                 // Not yet time to move on
                 break;
             }
@@ -299,6 +636,15 @@ void ms5611_service (struct ms5611_desc_t *inst)
                 *((uint8_t*)(&(inst->d1))) = 0;
                 // Swap bytes to correct endianness
                 inst->d1 = __builtin_bswap32(inst->d1);
+                
+                if (inst->temp_count != 0) {
+                    // Use the last temperature measurment
+                    inst->temp_count--;
+                    do_calculations(inst);
+                    // Wait till next measurment should be taken
+                    inst->state = MS5611_IDLE;
+                    break;
+                }
                 // Go to the next state
                 inst->state = MS5611_CONVERT_TEMP;
             } else {
@@ -307,18 +653,22 @@ void ms5611_service (struct ms5611_desc_t *inst)
             /* fall through */
         case MS5611_CONVERT_TEMP:
             // In process of sending command to take temperature measurment
-            if (handle_write_state(inst, &adc_conv_d2_cmd)) {
+            if (!inst->i2c_in_progress) {
+                inst->cmd = (MS5611_CMD_D2 |
+                             (inst->temp_osr << MS5611_OSR_Pos));
+            }
+            if (handle_write_state(inst, &inst->cmd)) {
                 // Go to the next state
                 inst->state = MS5611_CONVERT_TEMP_WAIT;
-                // Record time
-                inst->conv_start_time = millis;
+                // Start timing conversion
+                ms5611_start_conv_wait(inst, inst->temp_osr);
             } else {
                 break;
             }
             /* fall through */
         case MS5611_CONVERT_TEMP_WAIT:
             // Waiting for it to be time to read result
-            if ((millis - inst->conv_start_time) < CONV_WAIT_TIME) {
+            if (!ms5611_conv_complete(inst, inst->temp_osr)) {
                 // Not yet time to move on
                 break;
             }
@@ -333,6 +683,7 @@ void ms5611_service (struct ms5611_desc_t *inst)
             // Swap bytes to correct endianness
             *((uint8_t*)(&(inst->d2))) = 0;
             inst->d2 = __builtin_bswap32(inst->d2);
+            inst->temp_count = inst->temp_period - 1;
             do_calculations(inst);
             // Wait till next measurment should be taken
             inst->state = MS5611_IDLE;
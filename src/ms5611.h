@@ -13,6 +13,7 @@
 #include "global.h"
 
 #include "sercom-i2c.h"
+#include "tc.h"
 
 enum ms5611_state {
     MS5611_RESET,
@@ -39,15 +40,17 @@ struct ms5611_desc_t {
     
     /** Time of last reading from sensor */
     uint32_t last_reading_time;
+    /** Number of readings which have been completed */
+    uint32_t sample_count;
     /** Temperature compensated presure read from sensor */
     int32_t pressure;
     /** Temperature read from sensor */
     int32_t temperature;
-    /** Altitude calculated from sensor */
-    float altitude;
+    /** Altitude calculated from sensor in millimetres */
+    int32_t altitude;
     
-    /** Pressure used as 0 for altitude calculations */
-    float p0;
+    /** Pressure used as 0 for altitude calculations in hundredths of a mbar */
+    int32_t p0;
     /** Digital pressure value from ADC  */
     uint32_t d1;
     /** Digital tempuratue value from ADC */
@@ -55,9 +58,14 @@ struct ms5611_desc_t {
 
     /** Conversion start time */
     uint32_t conv_start_time;
+    /** Timer Counter used to time conversions, NULL if millis is used */
+    Tc *tc;
     
     /** Time between readings of the sensor */
     uint32_t period;
+    /** Shortest time in milliseconds in which a reading with both pressure
+        and temperature conversions can be completed */
+    uint16_t min_period;
     
     /** Values read from sensor PROM */
     uint16_t prom_values[6];
@@ -65,6 +73,19 @@ struct ms5611_desc_t {
     uint8_t address;
     /** I2C transaction id */
     uint8_t t_id;
+    /** Command being sent to the sensor */
+    uint8_t cmd;
+    /** Number of pressure measurements per temperature measurement */
+    uint8_t temp_period;
+    /** Number of pressure measurements until the next temperature
+        measurement */
+    uint8_t temp_count;
+    /** Set from the timer interrupt when a conversion is complete */
+    volatile uint8_t conv_done;
+    /** Oversampling ratio for pressure conversions */
+    uint8_t pres_osr:3;
+    /** Oversampling ratio for temperature conversions */
+    uint8_t temp_osr:3;
     /** Drive current state */
     enum ms5611_state state:4;
     /** Currently waiting for an I2C transaction to complete */
@@ -92,6 +113,56 @@ extern void init_ms5611 (struct ms5611_desc_t *inst,
 
 
 
+/**
+ * Use a Timer Counter to time conversions instead of millis. This allows
+ * conversion results to be read as soon as they are ready.
+ *
+ * @param inst The MS5611 driver instance
+ * @param tc The Timer Counter to be used
+ * @param clock_mask Mask for the Generic Clock Generator which should provide
+ *                   the Generic Clock for the Timer Counter
+ * @param clock_freq The frequency of the Generic Clock Generator, must be at
+ *                   least 1 MHz
+ *
+ * @return 0 if the timer was configured successfully
+ */
+extern uint8_t ms5611_use_timer (struct ms5611_desc_t *inst, Tc *tc,
+                                 uint32_t clock_mask, uint32_t clock_freq);
+
+/**
+ * Set the oversampling ratios used for pressure and temperature conversions.
+ * Higher oversampling ratios give lower noise but take longer, from 0.6 ms at
+ * 256 to 9.04 ms at 4096.
+ *
+ * @param inst The MS5611 driver instance
+ * @param pressure_osr Oversampling ratio for pressure, one of 256, 512, 1024,
+ *                     2048 or 4096
+ * @param temperature_osr Oversampling ratio for temperature, one of 256, 512,
+ *                        1024, 2048 or 4096
+ *
+ * @return 0 if the oversampling ratios were set successfully
+ */
+extern uint8_t ms5611_set_oversampling (struct ms5611_desc_t *inst,
+                                        uint16_t pressure_osr,
+                                        uint16_t temperature_osr);
+
+/**
+ * Set how often temperature is measured. The most recent temperature is used
+ * to compensate the pressure measurements in between.
+ *
+ * @param inst The MS5611 driver instance
+ * @param period The number of pressure measurements for each temperature
+ *               measurement, must not be 0
+ */
+static inline void ms5611_set_temp_period (struct ms5611_desc_t *inst,
+                                           uint8_t period)
+{
+    inst->temp_period = (period != 0) ? period : 1;
+    if (inst->temp_count >= inst->temp_period) {
+        inst->temp_count = inst->temp_period - 1;
+    }
+}
+
 /**
  * Service to be run in each iteration of the main loop.
  *
@@ -129,13 +200,26 @@ static inline int32_t ms5611_get_temperature (struct ms5611_desc_t *inst)
  *
  * @param inst The MS5611 driver instance
  *
- * @return The most recently measured altitude in meters
+ * @return The most recently measured altitude in millimetres
  */
-static inline float ms5611_get_altitude (struct ms5611_desc_t *inst)
+static inline int32_t ms5611_get_altitude (struct ms5611_desc_t *inst)
 {
     return inst->altitude;
 }
 
+/**
+ * Get the number of readings which have been completed. This can be used to
+ * determine whether a new reading is available.
+ *
+ * @param inst The MS5611 driver instance
+ *
+ * @return The number of completed readings
+ */
+static inline uint32_t ms5611_get_sample_count (struct ms5611_desc_t *inst)
+{
+    return inst->sample_count;
+}
+
 /**
  * Get the last time at which a reading was started.
  *
@@ -161,6 +245,20 @@ static inline void ms5611_set_period (struct ms5611_desc_t *inst,
     inst->period = period;
 }
 
+/**
+ * Get the shortest period at which readings can be taken with the current
+ * oversampling ratios. Any shorter period will not be met, since each reading
+ * which includes a temperature measurement waits for both conversions.
+ *
+ * @param inst The MS5611 driver instance
+ *
+ * @return The minimum period in milliseconds
+ */
+static inline uint16_t ms5611_get_min_period (struct ms5611_desc_t *inst)
+{
+    return inst->min_period;
+}
+
 /**
  * Tare altitude calculations by setting the refernce pressure to the last
  * measured pressure.
@@ -169,7 +267,7 @@ static inline void ms5611_set_period (struct ms5611_desc_t *inst,
  */
 static inline void ms5611_tare_now (struct ms5611_desc_t *inst)
 {
-    inst->p0 = ((float)inst->pressure) / 100.0f;
+    inst->p0 = inst->pressure;
 }
 
 /**
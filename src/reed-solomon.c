@@ -0,0 +1,411 @@
+/**
+ * @file reed-solomon.c
+ * @desc Reed-Solomon error correcting code with byte interleaving
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "reed-solomon.h"
+
+#include <string.h>
+
+/** Powers of alpha, repeated so that the sum of two logarithms can be used as
+    an index without being reduced modulo 255 */
+static const uint8_t gf_exp[510] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8,
+    0xCD, 0x87, 0x13, 0x26, 0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9,
+    0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D, 0x27, 0x4E, 0x9C,
+    0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+    0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2,
+    0xB9, 0x6F, 0xDE, 0xA1, 0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC,
+    0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD, 0xE7, 0xD3, 0xBB,
+    0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+    0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68,
+    0xD0, 0xBD, 0x67, 0xCE, 0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93,
+    0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85, 0x17, 0x2E, 0x5C,
+    0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+    0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72,
+    0xE4, 0xD5, 0xB7, 0x73, 0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E,
+    0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3, 0xDB, 0xAB, 0x4B,
+    0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0,
+    0xDD, 0xA7, 0x53, 0xA6, 0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF,
+    0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12, 0x24, 0x48, 0x90,
+    0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+    0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8,
+    0xAD, 0x47, 0x8E, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D,
+    0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26, 0x4C, 0x98, 0x2D, 0x5A, 0xB4,
+    0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D,
+    0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE,
+    0xC1, 0x9F, 0x23, 0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D,
+    0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1, 0x5F, 0xBE, 0x61, 0xC2, 0x99,
+    0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD,
+    0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B,
+    0xB6, 0x71, 0xE2, 0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D,
+    0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE, 0x81, 0x1F, 0x3E, 0x7C, 0xF8,
+    0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85,
+    0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84,
+    0x15, 0x2A, 0x54, 0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49,
+    0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73, 0xE6, 0xD1, 0xBF, 0x63, 0xC6,
+    0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3,
+    0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5,
+    0x57, 0xAE, 0x41, 0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C,
+    0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6, 0x51, 0xA2, 0x59, 0xB2, 0x79,
+    0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB,
+    0x8B, 0x0B, 0x16, 0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B,
+    0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E
+};
+
+/** Logarithms to the base alpha, the logarithm of zero is undefined */
+static const uint8_t gf_log[256] = {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE,
+    0x1B, 0x68, 0xC7, 0x4B, 0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81,
+    0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71, 0x05, 0x8A, 0x65, 0x2F,
+    0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+    0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78,
+    0x4D, 0xE4, 0x72, 0xA6, 0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD,
+    0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88, 0x36, 0xD0, 0x94, 0xCE,
+    0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+    0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54,
+    0xFA, 0x85, 0xBA, 0x3D, 0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B,
+    0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57, 0x07, 0x70, 0xC0, 0xF7,
+    0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+    0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9,
+    0x23, 0x20, 0x89, 0x2E, 0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD,
+    0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61, 0xF2, 0x56, 0xD3, 0xAB,
+    0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+    0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC,
+    0x7F, 0x0C, 0x6F, 0xF6, 0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA,
+    0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A, 0xCB, 0x59, 0x5F, 0xB0,
+    0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+    0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA,
+    0xA8, 0x50, 0x58, 0xAF
+};
+
+
+/** Marks a coefficient which is zero in a polynomial stored as logarithms */
+#define GF_LOG_ZERO 0xFF
+
+
+static inline uint8_t gf_mul (uint8_t a, uint8_t b)
+{
+    if ((a == 0) || (b == 0)) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static inline uint8_t gf_div (uint8_t a, uint8_t b)
+{
+    if (a == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + 255 - gf_log[b]];
+}
+
+/**
+ *  Evaluate a polynomial at alpha^log_x.
+ *
+ *  @param poly Coefficients, lowest order first
+ *  @param degree Degree of the polynomial
+ *  @param log_x Logarithm of the point at which the polynomial is evaluated
+ */
+static uint8_t gf_poly_eval (const uint8_t *poly, uint8_t degree,
+                             uint8_t log_x)
+{
+    uint8_t result = 0;
+    for (int16_t i = degree; i >= 0; i--) {
+        result = (uint8_t)(((result != 0) ? gf_exp[gf_log[result] + log_x] :
+                                            0) ^ poly[i]);
+    }
+    return result;
+}
+
+
+void init_rs_codec (struct rs_codec_t *rs, uint8_t nroots)
+{
+    // The generator polynomial is the product of (x + alpha^i) for i from 1 to
+    // nroots, built up one factor at a time
+    uint8_t g[RS_MAX_ROOTS + 1];
+    g[0] = 1;
+    
+    for (uint8_t i = 1; i <= nroots; i++) {
+        uint8_t root = gf_exp[i];
+        g[i] = g[i - 1];
+        for (uint8_t j = i - 1; j > 0; j--) {
+            g[j] = g[j - 1] ^ gf_mul(g[j], root);
+        }
+        g[0] = gf_mul(g[0], root);
+    }
+    
+    memcpy(rs->genpoly, g, nroots);
+    rs->nroots = nroots;
+}
+
+/**
+ *  Calculate the parity bytes for one codeword.
+ *
+ *  @param rs The code
+ *  @param data The first byte of data in the codeword
+ *  @param length The number of data bytes in the codeword
+ *  @param parity The first parity byte of the codeword
+ *  @param stride The distance between consecutive bytes of the codeword
+ */
+static void rs_encode_codeword (const struct rs_codec_t *rs,
+                                const uint8_t *data, uint8_t length,
+                                uint8_t *parity, uint8_t stride)
+{
+    const uint8_t nroots = rs->nroots;
+    // Remainder of dividing the data by the generator polynomial, highest order
+    // coefficient first
+    uint8_t rem[RS_MAX_ROOTS];
+    memset(rem, 0, nroots);
+    
+    for (uint8_t i = 0; i < length; i++, data += stride) {
+        uint8_t feedback = *data ^ rem[0];
+        
+        if (feedback == 0) {
+            memmove(rem, rem + 1, nroots - 1);
+            rem[nroots - 1] = 0;
+            continue;
+        }
+        
+        uint8_t log_feedback = gf_log[feedback];
+        for (uint8_t j = 0; j < (nroots - 1); j++) {
+            uint8_t g = rs->genpoly[nroots - 1 - j];
+            rem[j] = rem[j + 1] ^ ((g != 0) ? gf_exp[gf_log[g] + log_feedback] :
+                                              0);
+        }
+        uint8_t g = rs->genpoly[0];
+        rem[nroots - 1] = (g != 0) ? gf_exp[gf_log[g] + log_feedback] : 0;
+    }
+    
+    for (uint8_t i = 0; i < nroots; i++, parity += stride) {
+        *parity = rem[i];
+    }
+}
+
+/**
+ *  Find the first parity byte of a codeword. The interleaving continues from
+ *  the data into the parity bytes, so byte i of the data followed by the
+ *  parity bytes always belongs to codeword i % depth.
+ *
+ *  @param length The length of the data
+ *  @param depth The number of interleaved codewords
+ *  @param codeword The index of the codeword
+ */
+static inline uint8_t rs_parity_offset (uint8_t length, uint8_t depth,
+                                        uint8_t codeword)
+{
+    return (uint8_t)((codeword + depth - (length % depth)) % depth);
+}
+
+void rs_encode (const struct rs_codec_t *rs, const uint8_t *data,
+                uint8_t length, uint8_t *parity, uint8_t depth)
+{
+    for (uint8_t i = 0; i < depth; i++) {
+        rs_encode_codeword(rs, data + i, (uint8_t)((length - i + depth - 1) /
+                                                   depth),
+                           parity + rs_parity_offset(length, depth, i), depth);
+    }
+}
+
+/**
+ *  Get a pointer to a byte of a codeword.
+ *
+ *  @param index Index of the byte in the codeword, data bytes first
+ */
+static inline uint8_t *rs_symbol (uint8_t *data, uint8_t length,
+                                  uint8_t *parity, uint8_t stride,
+                                  uint8_t index)
+{
+    if (index < length) {
+        return data + (index * stride);
+    }
+    return parity + ((index - length) * stride);
+}
+
+/**
+ *  Correct errors in one codeword.
+ *
+ *  The syndromes are found by evaluating the received codeword at each root of
+ *  the generator polynomial, the error locator polynomial is found from the
+ *  syndromes with the Berlekamp-Massey algorithm, its roots are found by a
+ *  Chien search and the error values are found with Forney's algorithm.
+ *
+ *  @param rs The code
+ *  @param data The first byte of data in the codeword
+ *  @param length The number of data bytes in the codeword
+ *  @param parity The first parity byte of the codeword
+ *  @param stride The distance between consecutive bytes of the codeword
+ *
+ *  @return The number of bytes corrected or -1 if there are too many errors
+ */
+static int16_t rs_decode_codeword (const struct rs_codec_t *rs, uint8_t *data,
+                                   uint8_t length, uint8_t *parity,
+                                   uint8_t stride)
+{
+    const uint8_t nroots = rs->nroots;
+    const uint8_t n = length + nroots;
+    
+    // Syndromes, syndrome[i] is the codeword evaluated at alpha^(i + 1)
+    uint8_t syndrome[RS_MAX_ROOTS];
+    memset(syndrome, 0, nroots);
+    uint8_t errors = 0;
+    
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t c = *rs_symbol(data, length, parity, stride, i);
+        for (uint8_t j = 0; j < nroots; j++) {
+            uint8_t s = syndrome[j];
+            syndrome[j] = c ^ ((s != 0) ? gf_exp[gf_log[s] + j + 1] : 0);
+        }
+    }
+    for (uint8_t j = 0; j < nroots; j++) {
+        errors |= syndrome[j];
+    }
+    if (errors == 0) {
+        return 0;
+    }
+    
+    // Berlekamp-Massey
+    uint8_t lambda[RS_MAX_ROOTS + 1];
+    uint8_t prev[RS_MAX_ROOTS + 1];
+    uint8_t temp[RS_MAX_ROOTS + 1];
+    memset(lambda, 0, nroots + 1);
+    memset(prev, 0, nroots + 1);
+    lambda[0] = 1;
+    prev[0] = 1;
+    uint8_t degree = 0;
+    uint8_t shift = 1;
+    uint8_t prev_discrepancy = 1;
+    
+    for (uint8_t i = 0; i < nroots; i++) {
+        uint8_t discrepancy = syndrome[i];
+        for (uint8_t j = 1; j <= degree; j++) {
+            discrepancy ^= gf_mul(lambda[j], syndrome[i - j]);
+        }
+        
+        if (discrepancy == 0) {
+            shift++;
+            continue;
+        }
+        
+        uint8_t coef = gf_div(discrepancy, prev_discrepancy);
+        uint8_t grow = (2 * degree) <= i;
+        if (grow) {
+            memcpy(temp, lambda, nroots + 1);
+        }
+        for (uint8_t j = 0; (j + shift) <= nroots; j++) {
+            lambda[j + shift] ^= gf_mul(coef, prev[j]);
+        }
+        
+        if (grow) {
+            degree = i + 1 - degree;
+            memcpy(prev, temp, nroots + 1);
+            prev_discrepancy = discrepancy;
+            shift = 1;
+        } else {
+            shift++;
+        }
+    }
+    
+    if ((2 * degree) > nroots) {
+        return -1;
+    }
+    
+    // Error evaluator polynomial, the syndrome polynomial times lambda modulo
+    // x^nroots
+    uint8_t omega[RS_MAX_ROOTS];
+    for (uint8_t i = 0; i < degree; i++) {
+        omega[i] = 0;
+        for (uint8_t j = 0; j <= i; j++) {
+            omega[i] ^= gf_mul(syndrome[i - j], lambda[j]);
+        }
+    }
+    
+    // Formal derivative of lambda, only the odd terms remain
+    uint8_t lambda_prime[RS_MAX_ROOTS];
+    for (uint8_t i = 0; i < degree; i++) {
+        lambda_prime[i] = (i & 1) ? 0 : lambda[i + 1];
+    }
+    
+    // Chien search, term[j] holds the log of lambda[j] * alpha^(-i * j) as the
+    // power i of each possible error location is stepped through
+    uint8_t term[RS_MAX_ROOTS + 1];
+    for (uint8_t j = 1; j <= degree; j++) {
+        term[j] = (lambda[j] != 0) ? gf_log[lambda[j]] : GF_LOG_ZERO;
+    }
+    
+    uint8_t location[RS_MAX_ROOTS / 2];
+    uint8_t magnitude[RS_MAX_ROOTS / 2];
+    uint8_t found = 0;
+    
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t sum = 1;
+        for (uint8_t j = 1; j <= degree; j++) {
+            if (term[j] == GF_LOG_ZERO) {
+                continue;
+            }
+            sum ^= gf_exp[term[j]];
+            // Step to the next power by multiplying by alpha^(-j)
+            uint16_t next = (uint16_t)term[j] + 255 - j;
+            term[j] = (uint8_t)((next >= 255) ? (next - 255) : next);
+        }
+        
+        if (sum != 0) {
+            continue;
+        }
+        
+        // alpha^(-i) is a root, so there is an error in the byte with power i
+        uint8_t log_x_inv = (uint8_t)((255 - i) % 255);
+        uint8_t denominator = gf_poly_eval(lambda_prime, degree - 1,
+                                           log_x_inv);
+        if (denominator == 0) {
+            return -1;
+        }
+        location[found] = (uint8_t)(n - 1 - i);
+        magnitude[found] = gf_div(gf_poly_eval(omega, degree - 1, log_x_inv),
+                                  denominator);
+        found++;
+        
+        if (found == degree) {
+            break;
+        }
+    }
+    
+    // If lambda doesn't have as many roots within the codeword as its degree
+    // there are too many errors to be located
+    if (found != degree) {
+        return -1;
+    }
+    
+    for (uint8_t i = 0; i < found; i++) {
+        *rs_symbol(data, length, parity, stride, location[i]) ^= magnitude[i];
+    }
+    
+    return found;
+}
+
+int16_t rs_decode (const struct rs_codec_t *rs, uint8_t *data, uint8_t length,
+                   uint8_t *parity, uint8_t depth)
+{
+    int16_t corrected = 0;
+    
+    for (uint8_t i = 0; i < depth; i++) {
+        int16_t ret = rs_decode_codeword(rs, data + i,
+                                         (uint8_t)((length - i + depth - 1) /
+                                                   depth),
+                                         parity + rs_parity_offset(length,
+                                                                   depth, i),
+                                         depth);
+        if (ret < 0) {
+            return -1;
+        }
+        corrected += ret;
+    }
+    
+    return corrected;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file reed-solomon.h
+ * @desc Reed-Solomon error correcting code with byte interleaving
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef reed_solomon_h
+#define reed_solomon_h
+
+#include "global.h"
+
+/*
+ *  A shortened systematic Reed-Solomon code over GF(2^8) with the field
+ *  polynomial x^8 + x^4 + x^3 + x^2 + 1 and generator roots alpha^1 to
+ *  alpha^nroots. Each codeword can correct up to nroots / 2 bytes which are in
+ *  error anywhere in the codeword.
+ *
+ *  A block of data is split into depth codewords by interleaving bytes, so byte
+ *  i of the data belongs to codeword i % depth. The interleaving continues
+ *  into the parity bytes which follow the data, so each byte of the data and
+ *  parity belongs to the codeword given by its index modulo depth.
+ *
+ *  A burst of consecutive errors is spread over all of the codewords, so a
+ *  burst of up to depth * nroots / 2 bytes can be corrected.
+ *
+ *  All arithmetic is done with logarithm tables which are stored in flash.
+ */
+
+/** Largest number of parity bytes per codeword */
+#define RS_MAX_ROOTS    32
+
+/**
+ *  Parameters for a Reed-Solomon code.
+ */
+struct rs_codec_t {
+    /** Coefficients of the generator polynomial, lowest order first, the
+        leading coefficient is always one and is not stored */
+    uint8_t genpoly[RS_MAX_ROOTS];
+    /** Number of parity bytes per codeword */
+    uint8_t nroots;
+};
+
+/**
+ *  Initialize a Reed-Solomon code.
+ *
+ *  @param rs The code to be initialized
+ *  @param nroots The number of parity bytes per codeword, from 2 to
+ *                RS_MAX_ROOTS
+ */
+extern void init_rs_codec (struct rs_codec_t *rs, uint8_t nroots);
+
+/**
+ *  Calculate the parity bytes for a block of data.
+ *
+ *  @param rs The code
+ *  @param data The data to be encoded
+ *  @param length The length of the data, each codeword may have at most
+ *                255 - nroots bytes of data
+ *  @param parity Buffer where the parity bytes will be stored, must have space
+ *                for nroots * depth bytes
+ *  @param depth The number of interleaved codewords
+ */
+extern void rs_encode (const struct rs_codec_t *rs, const uint8_t *data,
+                       uint8_t length, uint8_t *parity, uint8_t depth);
+
+/**
+ *  Correct errors in a block of data and its parity bytes.
+ *
+ *  @param rs The code
+ *  @param data The data to be corrected in place
+ *  @param length The length of the data
+ *  @param parity The parity bytes, also corrected in place
+ *  @param depth The number of interleaved codewords
+ *
+ *  @return The number of bytes which were corrected, or -1 if a codeword has
+ *          too many errors to be corrected
+ */
+extern int16_t rs_decode (const struct rs_codec_t *rs, uint8_t *data,
+                          uint8_t length, uint8_t *parity, uint8_t depth);
+
+#endif /* reed_solomon_h */
@@ -96,6 +96,36 @@ static const char* const RN2483_PIN_NAMES[] = { "GPIO0",  "GPIO1",  "GPIO2",
                                                 "TEST1" };
 
 
+#define RN2483_HEX_DIGIT(n) (((n) < 10) ? ('0' + (n)) : ('A' + (n) - 10))
+#define RN2483_HEX_BYTE(n) { RN2483_HEX_DIGIT((n) >> 4), \
+                             RN2483_HEX_DIGIT((n) & 0xF) }
+#define RN2483_HEX_ROW(h) RN2483_HEX_BYTE((h << 4) | 0x0), \
+                          RN2483_HEX_BYTE((h << 4) | 0x1), \
+                          RN2483_HEX_BYTE((h << 4) | 0x2), \
+                          RN2483_HEX_BYTE((h << 4) | 0x3), \
+                          RN2483_HEX_BYTE((h << 4) | 0x4), \
+                          RN2483_HEX_BYTE((h << 4) | 0x5), \
+                          RN2483_HEX_BYTE((h << 4) | 0x6), \
+                          RN2483_HEX_BYTE((h << 4) | 0x7), \
+                          RN2483_HEX_BYTE((h << 4) | 0x8), \
+                          RN2483_HEX_BYTE((h << 4) | 0x9), \
+                          RN2483_HEX_BYTE((h << 4) | 0xA), \
+                          RN2483_HEX_BYTE((h << 4) | 0xB), \
+                          RN2483_HEX_BYTE((h << 4) | 0xC), \
+                          RN2483_HEX_BYTE((h << 4) | 0xD), \
+                          RN2483_HEX_BYTE((h << 4) | 0xE), \
+                          RN2483_HEX_BYTE((h << 4) | 0xF)
+
+/** Hexadecimal digits for every byte value, used to marshal data to be sent */
+static const char RN2483_HEX_TABLE[256][2] = {
+    RN2483_HEX_ROW(0x0), RN2483_HEX_ROW(0x1), RN2483_HEX_ROW(0x2),
+    RN2483_HEX_ROW(0x3), RN2483_HEX_ROW(0x4), RN2483_HEX_ROW(0x5),
+    RN2483_HEX_ROW(0x6), RN2483_HEX_ROW(0x7), RN2483_HEX_ROW(0x8),
+    RN2483_HEX_ROW(0x9), RN2483_HEX_ROW(0xA), RN2483_HEX_ROW(0xB),
+    RN2483_HEX_ROW(0xC), RN2483_HEX_ROW(0xD), RN2483_HEX_ROW(0xE),
+    RN2483_HEX_ROW(0xF)
+};
+
 
 // MARK: Helpers
 
@@ -164,35 +194,112 @@ static uint8_t __attribute__((pure)) parse_version (struct rn2483_desc_t *inst,
 }
 
 /**
- *  Parse a nibble from a single hexadecimal digit.
+ *  Decode four hexadecimal digits packed into a word.
  *
- *  @param c Character containing the digit to be parsed
- *  @param dest Pointer to where data should be stored
- *  @param offset Number of bits which data should be offset within byte
+ *  All four digits are checked and converted at once, one per byte lane of the
+ *  word, so that there are no branches per character.
  *
- *  @return 0 If successful
+ *  @param w The digits, with the first digit in the least significant byte
+ *  @param dest Pointer to where the two decoded bytes should be stored
+ *
+ *  @return 0 if all four characters are valid hexadecimal digits
  */
-static uint8_t parse_nibble (char c, uint8_t *dest, int offset)
+static uint8_t decode_hex_word (uint32_t w, uint8_t *dest)
 {
-    if (c < '0') {
+    // Each lane of a SWAR range check has its high bit set if the character in
+    // that lane is within the range. This relies on the high bit of every
+    // lane being clear so that the additions can't carry between lanes.
+#define HEX_LANES(x)        (((uint32_t)(x)) * 0x01010101UL)
+#define HEX_IN_RANGE(x, lo, hi) (((x) + HEX_LANES(0x80 - (lo))) & \
+                                 ~((x) + HEX_LANES(0x7F - (hi))))
+    
+    // Folding to lower case maps 'A' to 'F' on to 'a' to 'f', digits already
+    // have the case bit set
+    uint32_t lower = w | HEX_LANES(0x20);
+    uint32_t valid = (HEX_IN_RANGE(w, '0', '9') |
+                      HEX_IN_RANGE(lower, 'a', 'f'));
+    
+    if ((w & HEX_LANES(0x80)) || ((valid & HEX_LANES(0x80)) !=
+                                  HEX_LANES(0x80))) {
         return 1;
-    } else if (c >= 'a') {
-        c -= 32;
     }
-    c -= '0';
-    if (c <= 9) {
-        goto store_nibble;
+    
+    // The low nibble of each character is the value of a digit or one less
+    // than the value of a letter, less 9
+    uint32_t letter = (w >> 6) & HEX_LANES(1);
+    uint32_t n = (w & HEX_LANES(0xF)) + (letter << 3) + letter;
+    
+    // Combine pairs of nibbles in to bytes in lanes 0 and 2
+    n = (n << 4) | (n >> 8);
+    dest[0] = (uint8_t)n;
+    dest[1] = (uint8_t)(n >> 16);
+    return 0;
+    
+#undef HEX_IN_RANGE
+#undef HEX_LANES
+}
+
+/**
+ *  Decode a string of hexadecimal digits. The string is decoded four digits
+ *  at a time and can be decoded in place. A single digit left at the end of
+ *  the string is ignored.
+ *
+ *  @param dest Pointer to where the decoded data should be stored, this may
+ *              be the same as str
+ *  @param str The string to be decoded
+ *
+ *  @return The number of bytes decoded or -1 if the string contains a
+ *          character which is not a hexadecimal digit
+ */
+static int decode_hex (uint8_t *dest, const char *str)
+{
+    size_t length = strlen(str) / 2;
+    const uint8_t *s = (const uint8_t*)str;
+    uint8_t *d = dest;
+    
+    // The destination never overtakes the source since each word of
+    // characters is read before the two bytes decoded from it are written
+    for (const uint8_t *end = s + ((length / 2) * 4); s != end; s += 4) {
+        // The string might not be word aligned
+        uint32_t w = (s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) |
+                      ((uint32_t)s[3] << 24));
+        if (decode_hex_word(w, d)) {
+            return -1;
+        }
+        d += 2;
     }
-    c -= 7;
-    if (c <= 9) {
-        return 1;
-    } else if (c <= 15) {
-        goto store_nibble;
+    
+    if (length & 1) {
+        // Pad the last pair of digits out to a full word
+        uint8_t last[2];
+        uint32_t w = (s[0] | ((uint32_t)s[1] << 8) |
+                      ((uint32_t)'0' << 16) | ((uint32_t)'0' << 24));
+        if (decode_hex_word(w, last)) {
+            return -1;
+        }
+        *d++ = last[0];
     }
-    return 1;
-store_nibble:
-    *dest |= (c << offset);
-    return 0;
+    
+    return (int)(d - dest);
+}
+
+/**
+ *  Encode data as uppercase hexadecimal digits.
+ *
+ *  @param dest Buffer where the digits should be stored, must have space for
+ *              two characters per byte of data
+ *  @param data The data to be encoded
+ *  @param length The number of bytes to be encoded
+ *
+ *  @return Pointer to the character following the last digit in dest
+ */
+static char *encode_hex (char *dest, const uint8_t *data, uint8_t length)
+{
+    for (const uint8_t *end = data + length; data != end; data++) {
+        *dest++ = RN2483_HEX_TABLE[*data][0];
+        *dest++ = RN2483_HEX_TABLE[*data][1];
+    }
+    return dest;
 }
 
 /**
@@ -263,25 +370,56 @@ static uint32_t *get_word_ptr (struct rn2483_desc_t *inst)
     return __builtin_assume_aligned(buffer, 4);
 }
 
-void set_send_trans_state(struct rn2483_desc_t *inst, int n,
-                          enum rn2483_send_trans_state state)
+/**
+ *  Marshal a radio tx command for a frame from the send queue into the command
+ *  buffer.
+ *
+ *  @param inst The RN2483 driver instance
+ *  @param frame The frame to be sent
+ */
+static void marshal_send (struct rn2483_desc_t *inst,
+                          const struct rn2483_send_frame_t *frame)
 {
-    unsigned int offset = (RN2483_SEND_TRANSACTION_SIZE * n);
-    inst->send_transactions &= ~(RN2483_SEND_TRANSACTION_MASK << offset);
-    inst->send_transactions |= ((state & RN2483_SEND_TRANSACTION_MASK) <<
-                                offset);
+    memcpy(inst->buffer, RN2483_CMD_TX, RN2483_CMD_TX_LEN);
+    char *end = encode_hex(inst->buffer + RN2483_CMD_TX_LEN, frame->data,
+                           frame->length);
+    *(end + 0) = '\r';
+    *(end + 1) = '\n';
+    inst->cmd_ready = 1;
 }
 
-uint8_t find_send_trans(struct rn2483_desc_t *inst,
-                        enum rn2483_send_trans_state state)
+/**
+ *  Record the result for the frame at the head of the send queue and move on
+ *  to the next frame.
+ *
+ *  @param inst The RN2483 driver instance
+ *  @param state The final state of the transaction
+ */
+static void finish_send (struct rn2483_desc_t *inst,
+                         enum rn2483_send_trans_state state)
 {
-    uint8_t id = 0;
-    for (; id < RN2483_NUM_SEND_TRANSACTIONS; id++) {
-        if (rn2483_get_send_state(inst, id) == state) {
-            break;
-        }
+    struct rn2483_send_frame_t *frame = inst->send_queue + inst->send_head;
+    
+    // The transaction may have already been cleared
+    if (frame->state == RN2483_SEND_TRANS_WRITTEN) {
+        frame->state = state;
+    }
+    
+    inst->send_head = (inst->send_head + 1) % RN2483_SEND_QUEUE_LEN;
+    
+    // Go back to idle, which will start the next frame right away if there is
+    // one
+    inst->state = RN2483_IDLE;
+}
+
+void rn2483_prepare_next_send(struct rn2483_desc_t *inst)
+{
+    uint8_t next = (inst->send_head + 1) % RN2483_SEND_QUEUE_LEN;
+    
+    if ((inst->state == RN2483_SEND_WAIT) && !inst->cmd_ready &&
+        (inst->send_queue[next].state == RN2483_SEND_TRANS_PENDING)) {
+        marshal_send(inst, inst->send_queue + next);
     }
-    return id;
 }
 
 
@@ -301,6 +439,9 @@ static int rn2483_case_reset (struct rn2483_desc_t *inst)
         inst->state = RN2483_FAILED;
         return 0;
     }
+    // The module is back to its default settings, all of our settings need to
+    // be written once it is configured for LoRa
+    inst->settings_dirty = RN2483_SETTINGS_ALL;
     return 1;
 }
 
@@ -328,7 +469,7 @@ static int rn2483_case_write_mode (struct rn2483_desc_t *inst)
 {
     // Handle writing of command and reception of response
     if (handle_state(inst, RN2483_CMD_MODE, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_FREQ)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -350,7 +491,7 @@ static int rn2483_case_write_freq (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_PWR)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -372,7 +513,7 @@ static int rn2483_case_write_pwr (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_SF)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -409,7 +550,7 @@ static int rn2483_case_write_sf (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_CRC)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -431,7 +572,7 @@ static int rn2483_case_write_crc (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_IQI)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -453,7 +594,7 @@ static int rn2483_case_write_iqi (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_CR)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -484,7 +625,7 @@ static int rn2483_case_write_cr (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_SYNC)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -506,7 +647,7 @@ static int rn2483_case_write_sync (struct rn2483_desc_t *inst)
     }
     // Handle writing of command and reception of response
     if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                     RN2483_RSP_OK_LEN, RN2483_WRITE_BW)) {
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -533,8 +674,8 @@ static int rn2483_case_write_bw (struct rn2483_desc_t *inst)
         inst->cmd_ready = 1;
     }
     // Handle writing of command and reception of response
-    if (!handle_state(inst, inst->buffer, RN2483_RSP_OK,
-                      RN2483_RSP_OK_LEN, RN2483_IDLE)) {
+    if (handle_state(inst, inst->buffer, RN2483_RSP_OK,
+                     RN2483_RSP_OK_LEN, RN2483_IDLE)) {
         return 0;
     }
     return 1;
@@ -544,8 +685,21 @@ static int rn2483_case_write_bw (struct rn2483_desc_t *inst)
 
 static int rn2483_case_idle (struct rn2483_desc_t *inst)
 {
+    /* Check for settings which need to be written to the module */
+    if (inst->settings_dirty) {
+        // Write the first changed setting, the rest will be written when we
+        // get back to idle
+        uint8_t setting = (uint8_t)__builtin_ctz(inst->settings_dirty);
+        inst->settings_dirty &= ~(1 << setting);
+        inst->state = RN2483_WRITE_FREQ + setting;
+        // Discard any radio tx command that was marshaled while the last
+        // frame was being sent, it will be marshaled again afterwards
+        inst->cmd_ready = 0;
+        return 1;
+    }
+    
     /* Check if we need to be sending anything */
-    if (inst->send_buffer != NULL) {
+    if (inst->send_queue[inst->send_head].state == RN2483_SEND_TRANS_PENDING) {
         inst->state = RN2483_SEND;
         return 1;
     }
@@ -604,67 +758,35 @@ static int rn2483_case_idle (struct rn2483_desc_t *inst)
 
 static int rn2483_case_send (struct rn2483_desc_t *inst)
 {
+    struct rn2483_send_frame_t *frame = inst->send_queue + inst->send_head;
+    
     if (!inst->waiting_for_line) {
-        // Continue sending command
-        uint8_t cmd_len = (uint8_t)strlen(RN2483_CMD_TX);
-        uint8_t data_len = (uint8_t)inst->send_length * 2;
-        if (inst->out_pos < cmd_len) {
-            // Still sending command
-            inst->out_pos += sercom_uart_put_string(inst->uart, (RN2483_CMD_TX +
-                                                                inst->out_pos));
-            if (inst->out_pos < cmd_len) {
-                // Didn't finish sending command, uart buffer must be full
-                return 0;
-            }
-        }
+        // Length of the command, payload and line terminator
+        uint8_t length = (RN2483_CMD_TX_LEN + (2 * frame->length) + 2);
         
-        // Send data
-        while (inst->out_pos < (cmd_len + data_len)) {
-            uint8_t data_pos = inst->out_pos - cmd_len;
-            uint8_t i = data_pos / 2;
-            uint8_t shift = (data_pos & 1) ? 0 : 4;
-            
-            uint8_t data = (inst->send_buffer[i] >> shift) & 0xF;
-            char str[2];
-            str[0] = (data < 10) ? ('0' + data) : ('A' + data - 10);
-            str[1] = '\0';
-            
-            uint8_t sent = sercom_uart_put_string(inst->uart, str);
-            
-            if (sent == 0) {
-                // Character was not sent, uart buffer must be full
-                return 0;
-            }
-            
-            inst->out_pos++;
+        // Marshal the whole command if it was not already done while the
+        // previous frame was being transmitted
+        if (!inst->cmd_ready) {
+            marshal_send(inst, frame);
         }
         
-        // Sending line terminator
-        if (inst->out_pos == (cmd_len + data_len)) {
-            // Sending "\r\n"
-            inst->out_pos += sercom_uart_put_string(inst->uart, "\r\n");
-            
-            if (inst->out_pos < (cmd_len + data_len + 2)) {
-                // uart buffer must be full
-                return 0;
-            }
-        } else {
-            // Just sending "\n"
-            inst->out_pos += sercom_uart_put_string(inst->uart, "\n");
-            
-            if (inst->out_pos < (cmd_len + data_len + 2)) {
-                // uart buffer must be full
-                return 0;
-            }
+        // Send as much of the command as we can fit in the SERCOM driver's
+        // output buffer
+        inst->out_pos += sercom_uart_put_bytes(inst->uart,
+                                               ((uint8_t*)inst->buffer +
+                                                inst->out_pos),
+                                               length - inst->out_pos);
+        if (inst->out_pos < length) {
+            // Didn't finish sending command, uart buffer must be full
+            return 0;
         }
         
         // Done sending line
         inst->waiting_for_line = 1;
-        inst->send_buffer = NULL;
+        inst->cmd_ready = 0;
         
-        // Find send transaction and update state
-        uint8_t id = find_send_trans(inst, RN2483_SEND_TRANS_PENDING);
-        set_send_trans_state(inst, id, RN2483_SEND_TRANS_WRITTEN);
+        // The frame's buffer is no longer needed
+        frame->state = RN2483_SEND_TRANS_WRITTEN;
         
         return 0;
     } else if (sercom_uart_has_line(inst->uart)) {
@@ -676,15 +798,12 @@ static int rn2483_case_send (struct rn2483_desc_t *inst)
         if (!strncmp(inst->buffer, RN2483_RSP_OK, RN2483_RSP_OK_LEN)) {
             // Success! Wait for second response
             inst->state = RN2483_SEND_WAIT;
+            // Get the next frame ready while this one is transmitted
+            rn2483_prepare_next_send(inst);
         } else {
-            // Something went wrong, go back to idle state
-            inst->state = RN2483_IDLE;
-            // Got a response
+            // Something went wrong
             inst->waiting_for_line = 0;
-            // Find transaction number for transaction to be updated
-            uint8_t id = find_send_trans(inst, RN2483_SEND_TRANS_WRITTEN);
-            // Update transaction state
-            set_send_trans_state(inst, id, RN2483_SEND_TRANS_FAILED);
+            finish_send(inst, RN2483_SEND_TRANS_FAILED);
         }
         return 1;
     }
@@ -693,25 +812,20 @@ static int rn2483_case_send (struct rn2483_desc_t *inst)
 
 static int rn2483_case_send_wait (struct rn2483_desc_t *inst)
 {
-    // Wait for second response and return to idle
-    if (!handle_state(inst, inst->buffer, RN2483_RSP_TX_OK, RN2483_RSP_TX_OK_LEN,
-                      RN2483_IDLE)) {
+    // Get second response, the command buffer may already contain the command
+    // for the next frame so the response is read into a separate buffer
+    char response[RN2483_RSP_TX_OK_LEN + 16];
+    sercom_uart_get_line(inst->uart, response, sizeof(response));
+    inst->waiting_for_line = 0;
+    
+    if (!strncmp(response, RN2483_RSP_TX_OK, RN2483_RSP_TX_OK_LEN)) {
         // Success! Sending is complete
-        // Find transaction number for transaction to be updated
-        uint8_t id = find_send_trans(inst, RN2483_SEND_TRANS_WRITTEN);
-        // Update transaction state
-        set_send_trans_state(inst, id, RN2483_SEND_TRANS_DONE);
-    } else if (inst->state == RN2483_FAILED) {
-        // Sending failed, go back to idle
-        inst->state = RN2483_IDLE;
-        // Find transaction number for transaction to be updated
-        uint8_t id = find_send_trans(inst, RN2483_SEND_TRANS_WRITTEN);
-        // Update transaction state
-        set_send_trans_state(inst, id, RN2483_SEND_TRANS_FAILED);
+        finish_send(inst, RN2483_SEND_TRANS_DONE);
     } else {
-        // Still waiting
-        return 0;
+        // Sending failed
+        finish_send(inst, RN2483_SEND_TRANS_FAILED);
     }
+    
     return 1;
 }
 
@@ -817,32 +931,22 @@ static int rn2483_case_get_rssi (struct rn2483_desc_t *inst)
     // Get SNR from buffer
     int8_t snr = (int8_t)inst->buffer[RN2483_RSP_RX_OK_LEN - 1];
     
-    // Setup pointers for parsing
-    char *s = inst->buffer + RN2483_RSP_RX_OK_LEN;
-    uint8_t *b = (uint8_t*)inst->buffer;
-    
     // Skip extra spaces that are sometimes between OK response and data
+    char *s = inst->buffer + RN2483_RSP_RX_OK_LEN;
     while (*s == ' ') {
         s++;
     }
     
     // Parse packet into buffer
-    for (; (*s != '\0') && (*(s + 1) != '\0'); b++) {
-        *b = 0;
-        uint8_t ret = parse_nibble(*s, b, 4);
-        s++;
-        ret |= parse_nibble(*s, b, 0);
-        if (ret != 0) {
-            // Failed to parse byte
-            return 0;
-        }
-        s++;
+    int len = decode_hex((uint8_t*)inst->buffer, s);
+    if (len < 0) {
+        // Failed to parse packet
+        return 0;
     }
     
     // Call receive callback
-    uintptr_t len = (uintptr_t)b - (uintptr_t)inst->buffer;
     inst->receive_callback(inst, inst->callback_context, (uint8_t*)inst->buffer,
-                           len, snr, rssi);
+                           (uint8_t)len, snr, rssi);
     
     // Receive is finished
     inst->receive = 0;
@@ -23,6 +23,12 @@
 
 #define RN2483_CMD_TX_LEN 9
 
+/** Bit in the settings dirty mask for the state which writes a setting */
+#define RN2483_SETTING_DIRTY(state) (1 << ((state) - RN2483_WRITE_FREQ))
+/** Settings dirty mask with every setting marked as changed */
+#define RN2483_SETTINGS_ALL         ((1 << (RN2483_WRITE_BW + 1 - \
+                                            RN2483_WRITE_FREQ)) - 1)
+
 
 typedef int (*rn2483_stat_handler_t)(struct rn2483_desc_t *inst);
 
@@ -34,12 +40,8 @@ typedef int (*rn2483_stat_handler_t)(struct rn2483_desc_t *inst);
  */
 extern const rn2483_stat_handler_t rn2483_state_handlers[];
 
-/** Set the current state of a transaction entry */
-extern void set_send_trans_state(struct rn2483_desc_t *inst, int n,
-                                 enum rn2483_send_trans_state state);
-
-/** Find the first send transaction with a given state */
-extern uint8_t find_send_trans(struct rn2483_desc_t *inst,
-                               enum rn2483_send_trans_state state);
+/** Marshal the next frame in the send queue into the command buffer if the
+    radio is still transmitting the previous frame */
+extern void rn2483_prepare_next_send(struct rn2483_desc_t *inst);
 
 #endif /* rn2483_states_h */
@@ -24,30 +24,36 @@
 
 
 
-void init_rn2483 (struct rn2483_desc_t *inst, struct sercom_uart_desc_t *uart,
-                  uint32_t freq, int8_t power, enum rn2483_sf spreading_factor,
-                  enum rn2483_cr coding_rate, enum rn2483_bw bandwidth,
-                  uint8_t send_crc, uint8_t invert_qi, uint8_t sync_byte)
+static uint32_t clamp_freq (uint32_t freq)
 {
-    inst->uart = uart;
-    
-    
     if (freq > RN2483_FREQ_MAX) {
-        inst->settings.freq = RN2483_FREQ_MAX;
+        return RN2483_FREQ_MAX;
     } else if (freq < RN2483_FREQ_MIN) {
-        inst->settings.freq = RN2483_FREQ_MIN;
-    } else {
-        inst->settings.freq = freq;
+        return RN2483_FREQ_MIN;
     }
-    
+    return freq;
+}
+
+static int8_t clamp_power (int8_t power)
+{
     if (power > RN2483_PWR_MAX) {
-        inst->settings.power = RN2483_PWR_MAX;
+        return RN2483_PWR_MAX;
     } else if (power < RN2483_PWR_MIN) {
-        inst->settings.power = RN2483_PWR_MIN;
-    } else {
-        inst->settings.power = power;
+        return RN2483_PWR_MIN;
     }
+    return power;
+}
+
+void init_rn2483 (struct rn2483_desc_t *inst, struct sercom_uart_desc_t *uart,
+                  uint32_t freq, int8_t power, enum rn2483_sf spreading_factor,
+                  enum rn2483_cr coding_rate, enum rn2483_bw bandwidth,
+                  uint8_t send_crc, uint8_t invert_qi, uint8_t sync_byte)
+{
+    inst->uart = uart;
+    
     
+    inst->settings.freq = clamp_freq(freq);
+    inst->settings.power = clamp_power(power);
     inst->settings.spreading_factor = spreading_factor;
     inst->settings.coding_rate = coding_rate;
     inst->settings.bandwidth = bandwidth;
@@ -61,7 +67,15 @@ void init_rn2483 (struct rn2483_desc_t *inst, struct sercom_uart_desc_t *uart,
                                RN2483_PIN_DESC_MODE_DIRTY);
     }
     
-    // Start by reseting module
+    // Empty send queue
+    for (uint8_t i = 0; i < RN2483_SEND_QUEUE_LEN; i++) {
+        inst->send_queue[i].state = RN2483_SEND_TRANS_INVALID;
+    }
+    inst->send_head = 0;
+    inst->send_tail = 0;
+    
+    // Start by reseting module, settings will be written once it has reset
+    inst->settings_dirty = 0;
     inst->state = RN2483_RESET;
     
     inst->waiting_for_line = 0;
@@ -101,35 +115,63 @@ static void cancel_receive (struct rn2483_desc_t *inst)
 }
 
 
-enum rn2483_operation_result rn2483_send (struct rn2483_desc_t *inst,
-                                          uint8_t const *data, uint8_t length,
-                                          uint8_t *transaction_id)
+/**
+ *  Add a frame to the send queue.
+ *
+ *  @param inst Driver instance
+ *  @param data The data to be sent
+ *  @param length The number of bytes to be sent
+ *  @param copy Whether the data should be copied into the queue
+ *  @param transaction_id Pointer to where transaction ID should be stored
+ *
+ *  @return Operation status
+ */
+static enum rn2483_operation_result queue_send (struct rn2483_desc_t *inst,
+                                                const uint8_t *data,
+                                                uint8_t length, uint8_t copy,
+                                                uint8_t *transaction_id)
 {
-    // Check that we are not already sending something and for message length
-    if (inst->send_buffer != NULL) {
-        return RN2483_OP_BUSY;
-    } else if (length > ((RN2483_BUFFER_LEN - (RN2483_CMD_TX_LEN + 2)) / 2)) {
+    // Check for message length
+    if (length > RN2483_SEND_MAX_LEN) {
         // Message is too large to be sent
         return RN2483_OP_TOO_LONG;
+    } else if (copy && (length > RN2483_SEND_COPY_LEN)) {
+        // Message is too large to be copied
+        return RN2483_OP_TOO_LONG;
     }
     
-    // Check for an open transaction slot
-    uint8_t id = find_send_trans(inst, RN2483_SEND_TRANS_INVALID);\
-    if (id == RN2483_NUM_SEND_TRANSACTIONS) {
+    // Entries are used in order, check that the next one is free. An entry
+    // which has been cleared while it is still being sent can't be reused yet.
+    uint8_t id = inst->send_tail;
+    struct rn2483_send_frame_t *frame = inst->send_queue + id;
+    uint8_t sending = ((inst->state == RN2483_SEND) ||
+                       (inst->state == RN2483_SEND_WAIT));
+    if ((frame->state != RN2483_SEND_TRANS_INVALID) ||
+        (sending && (id == inst->send_head))) {
         return RN2483_OP_BUSY;
     }
     
     // Get transaction ready
     *transaction_id = id;
     
-    inst->send_buffer = data;
-    inst->send_length = length;
+    if (copy) {
+        memcpy(inst->send_copies[id], data, length);
+        frame->data = inst->send_copies[id];
+    } else {
+        frame->data = data;
+    }
+    frame->length = length;
+    frame->state = RN2483_SEND_TRANS_PENDING;
     
-    set_send_trans_state(inst, id, RN2483_SEND_TRANS_PENDING);
+    inst->send_tail = (id + 1) % RN2483_SEND_QUEUE_LEN;
     
     if (inst->state == RN2483_IDLE) {
         // If we are idle, jump right to send state
         inst->state = RN2483_SEND;
+    } else if (inst->state == RN2483_SEND_WAIT) {
+        // Get this frame ready to go as soon as the radio is done with the
+        // last one
+        rn2483_prepare_next_send(inst);
     } else {
         // Cancel the receive operation if there is one ongoing
         cancel_receive(inst);
@@ -141,20 +183,153 @@ enum rn2483_operation_result rn2483_send (struct rn2483_desc_t *inst,
     return RN2483_OP_SUCCESS;
 }
 
+enum rn2483_operation_result rn2483_send (struct rn2483_desc_t *inst,
+                                          uint8_t const *data, uint8_t length,
+                                          uint8_t *transaction_id)
+{
+    return queue_send(inst, data, length, 0, transaction_id);
+}
+
+enum rn2483_operation_result rn2483_send_copy (struct rn2483_desc_t *inst,
+                                               uint8_t const *data,
+                                               uint8_t length,
+                                               uint8_t *transaction_id)
+{
+    return queue_send(inst, data, length, 1, transaction_id);
+}
+
 enum rn2483_send_trans_state rn2483_get_send_state (struct rn2483_desc_t *inst,
                                                     uint8_t transaction_id)
 {
-    unsigned int offset = (RN2483_SEND_TRANSACTION_SIZE * transaction_id);
-    uint16_t state = ((inst->send_transactions >> offset) &
-                      RN2483_SEND_TRANSACTION_MASK);
-    
-    return (enum rn2483_send_trans_state)state;
+    return inst->send_queue[transaction_id].state;
 }
 
 void rn2483_clear_send_transaction (struct rn2483_desc_t *inst,
                                     uint8_t transaction_id)
 {
-    set_send_trans_state(inst, transaction_id, RN2483_SEND_TRANS_INVALID);
+    if (inst->send_queue[transaction_id].state == RN2483_SEND_TRANS_PENDING) {
+        // The frame has not been sent yet and is still needed
+        return;
+    }
+    inst->send_queue[transaction_id].state = RN2483_SEND_TRANS_INVALID;
+}
+
+uint32_t rn2483_get_airtime (struct rn2483_desc_t *inst, uint8_t length)
+{
+    int32_t sf = 7 + inst->settings.spreading_factor;
+    
+    // Symbol time is 2^SF / BW, with BW in kHz that is 2^SF * 8 us at 125 kHz,
+    // 2^SF * 4 us at 250 kHz and 2^SF * 2 us at 500 kHz
+    uint8_t symbol_shift = (uint8_t)(sf + 3 - inst->settings.bandwidth);
+    uint32_t symbol_time = ((uint32_t)1) << symbol_shift;
+    
+    // Low data rate optimization is required for symbols longer than 16 ms
+    int32_t de = symbol_time >= 16384;
+    
+    // Preamble is RN2483_PREAMBLE_LEN + 4.25 symbols
+    uint32_t preamble = (((4 * RN2483_PREAMBLE_LEN) + 17) * symbol_time) / 4;
+    
+    // 8 symbols plus enough blocks of 4 + CR symbols for the payload, CRC and
+    // explicit header
+    int32_t bits = ((8 * (int32_t)length) - (4 * sf) + 28 +
+                    (16 * inst->settings.crc));
+    int32_t bits_per_block = 4 * (sf - (2 * de));
+    uint32_t symbols = 8;
+    if (bits > 0) {
+        uint32_t blocks = (uint32_t)((bits + bits_per_block - 1) /
+                                     bits_per_block);
+        symbols += blocks * (4 + 1 + inst->settings.coding_rate);
+    }
+    
+    return preamble + (symbols * symbol_time);
+}
+
+/**
+ *  Mark a setting as changed so that it is written to the module the next time
+ *  the driver is idle.
+ *
+ *  @param inst Driver instance
+ *  @param write_state The state which writes the setting
+ */
+static void update_setting (struct rn2483_desc_t *inst,
+                            enum rn2483_state write_state)
+{
+    inst->settings_dirty |= RN2483_SETTING_DIRTY(write_state);
+    // Cancel any ongoing receive so that the setting is written right away
+    cancel_receive(inst);
+    // Run service to start sending command to radio if possible
+    rn2483_service(inst);
+}
+
+void rn2483_set_freq (struct rn2483_desc_t *inst, uint32_t freq)
+{
+    freq = clamp_freq(freq);
+    if (inst->settings.freq != freq) {
+        inst->settings.freq = freq;
+        update_setting(inst, RN2483_WRITE_FREQ);
+    }
+}
+
+void rn2483_set_power (struct rn2483_desc_t *inst, int8_t power)
+{
+    power = clamp_power(power);
+    if (inst->settings.power != power) {
+        inst->settings.power = power;
+        update_setting(inst, RN2483_WRITE_PWR);
+    }
+}
+
+void rn2483_set_spreading_factor (struct rn2483_desc_t *inst,
+                                  enum rn2483_sf spreading_factor)
+{
+    if (inst->settings.spreading_factor != spreading_factor) {
+        inst->settings.spreading_factor = spreading_factor;
+        update_setting(inst, RN2483_WRITE_SF);
+    }
+}
+
+void rn2483_set_coding_rate (struct rn2483_desc_t *inst,
+                             enum rn2483_cr coding_rate)
+{
+    if (inst->settings.coding_rate != coding_rate) {
+        inst->settings.coding_rate = coding_rate;
+        update_setting(inst, RN2483_WRITE_CR);
+    }
+}
+
+void rn2483_set_bandwidth (struct rn2483_desc_t *inst,
+                           enum rn2483_bw bandwidth)
+{
+    if (inst->settings.bandwidth != bandwidth) {
+        inst->settings.bandwidth = bandwidth;
+        update_setting(inst, RN2483_WRITE_BW);
+    }
+}
+
+void rn2483_set_crc (struct rn2483_desc_t *inst, uint8_t send_crc)
+{
+    send_crc = !!send_crc;
+    if (inst->settings.crc != send_crc) {
+        inst->settings.crc = send_crc;
+        update_setting(inst, RN2483_WRITE_CRC);
+    }
+}
+
+void rn2483_set_invert_qi (struct rn2483_desc_t *inst, uint8_t invert_qi)
+{
+    invert_qi = !!invert_qi;
+    if (inst->settings.invert_qi != invert_qi) {
+        inst->settings.invert_qi = invert_qi;
+        update_setting(inst, RN2483_WRITE_IQI);
+    }
+}
+
+void rn2483_set_sync_byte (struct rn2483_desc_t *inst, uint8_t sync_byte)
+{
+    if (inst->settings.sync_byte != sync_byte) {
+        inst->settings.sync_byte = sync_byte;
+        update_setting(inst, RN2483_WRITE_SYNC);
+    }
 }
 
 enum rn2483_operation_result rn2483_receive (struct rn2483_desc_t *inst,
@@ -24,6 +24,13 @@
 
 #define RN2483_NUM_PINS 18
 
+/** Number of symbols in the preamble, the module's default is used */
+#define RN2483_PREAMBLE_LEN 8
+
+/** Maximum length of a frame which can be sent, the hex encoded frame must fit
+    in the driver's buffer along with "radio tx " and "\r\n" */
+#define RN2483_SEND_MAX_LEN ((RN2483_BUFFER_LEN - 11) / 2)
+
 /** Period in milliseconds at which inputs should be polled, if 0 inputs will
  not be polled automatically */
 #define RN2483_GPIO_UPDATE_PERIOD 0
@@ -193,9 +200,23 @@ typedef void (*rn2483_recv_callback)(struct rn2483_desc_t *inst, void *context,
                                  | (((uint16_t)r << RN2483_VER_NUM_REV_POS)\
                                                 & RN2483_VER_NUM_REV_MASK))
 
-#define RN2483_SEND_TRANSACTION_SIZE    3
-#define RN2483_NUM_SEND_TRANSACTIONS    3
-#define RN2483_SEND_TRANSACTION_MASK    ((1 << 3) - 1)
+/** Number of frames which can be queued to be sent */
+#define RN2483_SEND_QUEUE_LEN   4
+/** Maximum length of a frame which is copied into the send queue */
+#define RN2483_SEND_COPY_LEN    64
+
+/**
+ *  Entry in the send queue.
+ */
+struct rn2483_send_frame_t {
+    /** Data to be sent, either the caller's buffer or the copy for this
+        entry */
+    const uint8_t *data;
+    /** Length of data */
+    uint8_t length;
+    /** State of the send transaction */
+    enum rn2483_send_trans_state state:3;
+};
 
 /**
  *  Descriptor for RN2483 radio module driver instance.
@@ -210,9 +231,6 @@ struct rn2483_desc_t {
     /** Context variable for callback */
     void *callback_context;
     
-    /** Pointer to buffer of data to be send */
-    const uint8_t *send_buffer;
-    
     /** Stores the last time at which the GPIO registers where polled */
     uint32_t last_polled;
     
@@ -261,14 +279,26 @@ struct rn2483_desc_t {
         uint16_t raw;
     } pins[RN2483_NUM_PINS];
     
+    /** Queue of frames to be sent, the index of an entry is the transaction
+        ID for the frame */
+    struct rn2483_send_frame_t send_queue[RN2483_SEND_QUEUE_LEN];
+    
+    /** Storage for frames which are copied into the send queue */
+    uint8_t send_copies[RN2483_SEND_QUEUE_LEN][RN2483_SEND_COPY_LEN];
+    
     /** Module firmware version*/
     uint16_t version;
     
-    /** Information about send transactions */
-    uint16_t send_transactions:9;
+    /** Settings which have been changed since they were last written to the
+        module, one bit for each of the states which write settings */
+    uint8_t settings_dirty;
+    
+    /** Index of the send queue entry which is being sent or will be sent
+        next */
+    uint8_t send_head;
     
-    /** Length of data in send buffer */
-    uint16_t send_length:7;
+    /** Index of the send queue entry which will be used for the next frame */
+    uint8_t send_tail;
     
     /** Pointer for sending commands over multiple calls to service if UART
      buffer becomes full */
@@ -318,20 +348,42 @@ extern void init_rn2483 (struct rn2483_desc_t *inst,
 extern void rn2483_service (struct rn2483_desc_t *inst);
 
 /**
- *  Send data via radio.
+ *  Queue data to be sent via radio. Frames are sent in the order in which they
+ *  are queued, the next frame is sent as soon as the radio has finished
+ *  transmitting the previous one.
+ *
+ *  The data is not copied, the buffer belongs to the driver until the state of
+ *  the transaction is no longer RN2483_SEND_TRANS_PENDING.
  *
  *  @param inst Driver instance
  *  @param data The data to be sent
  *  @param length The number of bytes to be sent
  *  @param transaction_id Pointer to where transaction ID should be stored
  *
- *  @return Operation status
+ *  @return Operation status, RN2483_OP_BUSY if the queue is full
  */
 extern enum rn2483_operation_result rn2483_send (struct rn2483_desc_t *inst,
                                                  const uint8_t *data,
                                                  uint8_t length,
                                                  uint8_t *transaction_id);
 
+/**
+ *  Copy data into the send queue to be sent via radio. The caller's buffer can
+ *  be reused as soon as this function returns.
+ *
+ *  @param inst Driver instance
+ *  @param data The data to be sent
+ *  @param length The number of bytes to be sent, at most RN2483_SEND_COPY_LEN
+ *  @param transaction_id Pointer to where transaction ID should be stored
+ *
+ *  @return Operation status, RN2483_OP_BUSY if the queue is full
+ */
+extern enum rn2483_operation_result rn2483_send_copy (
+                                                    struct rn2483_desc_t *inst,
+                                                    const uint8_t *data,
+                                                    uint8_t length,
+                                                    uint8_t *transaction_id);
+
 /**
  *  Get the current state of a send transaction.
  *
@@ -345,7 +397,9 @@ extern enum rn2483_send_trans_state rn2483_get_send_state (
                                                     uint8_t transaction_id);
 
 /**
- *  Clear an entry in the send transaction table.
+ *  Clear an entry in the send transaction table. Entries are reused in order,
+ *  so each transaction should be cleared once it is no longer pending. Pending
+ *  transactions can not be cleared.
  *
  *  @param inst Driver instance
  *  @param transaction_id ID of transaction to be cleared
@@ -353,6 +407,101 @@ extern enum rn2483_send_trans_state rn2483_get_send_state (
 extern void rn2483_clear_send_transaction (struct rn2483_desc_t *inst,
                                            uint8_t transaction_id);
 
+/**
+ *  Change the centre frequency. The new frequency is written to the module the
+ *  next time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param freq Centre frequency in hertz, from 433050000 to 434790000
+ */
+extern void rn2483_set_freq (struct rn2483_desc_t *inst, uint32_t freq);
+
+/**
+ *  Change the power level. The new power level is written to the module the
+ *  next time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param power Power level in dBm, from -3 to 14
+ */
+extern void rn2483_set_power (struct rn2483_desc_t *inst, int8_t power);
+
+/**
+ *  Change the LoRa spreading factor. The new spreading factor is written to the
+ *  module the next time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param spreading_factor LoRa spreading factor
+ */
+extern void rn2483_set_spreading_factor (struct rn2483_desc_t *inst,
+                                         enum rn2483_sf spreading_factor);
+
+/**
+ *  Change the LoRa coding rate. The new coding rate is written to the module
+ *  the next time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param coding_rate LoRa coding rate
+ */
+extern void rn2483_set_coding_rate (struct rn2483_desc_t *inst,
+                                    enum rn2483_cr coding_rate);
+
+/**
+ *  Change the bandwidth. The new bandwidth is written to the module the next
+ *  time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param bandwidth Bandwidth
+ */
+extern void rn2483_set_bandwidth (struct rn2483_desc_t *inst,
+                                  enum rn2483_bw bandwidth);
+
+/**
+ *  Change whether a CRC is added to the data. The new setting is written to
+ *  the module the next time the driver is idle, before any more frames are
+ *  sent.
+ *
+ *  @param inst Driver instance
+ *  @param send_crc Whether a CRC should be added to the data
+ */
+extern void rn2483_set_crc (struct rn2483_desc_t *inst, uint8_t send_crc);
+
+/**
+ *  Change whether the I and Q streams are inverted. The new setting is written
+ *  to the module the next time the driver is idle, before any more frames are
+ *  sent.
+ *
+ *  @param inst Driver instance
+ *  @param invert_qi Whether the I and Q streams should be inverted
+ */
+extern void rn2483_set_invert_qi (struct rn2483_desc_t *inst,
+                                  uint8_t invert_qi);
+
+/**
+ *  Change the sync word. The new sync word is written to the module the next
+ *  time the driver is idle, before any more frames are sent.
+ *
+ *  @param inst Driver instance
+ *  @param sync_byte Sync word
+ */
+extern void rn2483_set_sync_byte (struct rn2483_desc_t *inst,
+                                  uint8_t sync_byte);
+
+/**
+ *  Calculate the time on air for a frame with the radio's current settings.
+ *
+ *  The calculation follows the formula from the SX1276 datasheet, with an
+ *  explicit header and RN2483_PREAMBLE_LEN preamble symbols. Low data rate
+ *  optimization is assumed to be enabled whenever the symbol time is longer
+ *  than 16 ms, as the datasheet requires.
+ *
+ *  @param inst Driver instance
+ *  @param length Length of the frame in bytes
+ *
+ *  @return The time on air in microseconds
+ */
+extern uint32_t rn2483_get_airtime (struct rn2483_desc_t *inst,
+                                    uint8_t length);
+
 /**
  *  Start receiving data from radio. Radio will be put into receive mode
  *  whenever another operation is not in progress until a packet has been
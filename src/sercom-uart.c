@@ -86,6 +86,7 @@ void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
     descriptor->sercom = sercom;
     descriptor->sercom_instnum = instance_num;
     descriptor->echo = echo;
+    descriptor->rx_callback = NULL;
     
     // Configure buffers
     init_circular_buffer(&descriptor->out_buffer,
@@ -174,12 +175,21 @@ uint16_t sercom_uart_put_bytes(struct sercom_uart_desc_t *uart,
                                const uint8_t *bytes, uint16_t length)
 {
     uint16_t i = 0;
-    for (; i < length; i++) {
-        if (circular_buffer_is_full(&uart->out_buffer)) {
+    while (i < length) {
+        // Copy as much as possible into the contiguous free space at the tail
+        // of the buffer, the free space can be split in two if it wraps around
+        uint8_t *tail;
+        uint16_t space = circular_buffer_get_tail(&uart->out_buffer, &tail);
+        
+        if (space == 0) {
             break;
+        } else if (space > (length - i)) {
+            space = length - i;
         }
         
-        circular_buffer_push(&uart->out_buffer, (uint8_t)bytes[i]);
+        memcpy(tail, bytes + i, space);
+        circular_buffer_move_tail(&uart->out_buffer, space);
+        i += space;
     }
     
     // Make sure that we start transmission right away if there is no
@@ -306,6 +316,15 @@ char sercom_uart_get_char (struct sercom_uart_desc_t *uart)
     return c;
 }
 
+void sercom_uart_set_rx_callback (struct sercom_uart_desc_t *uart,
+                                  void (*rx_callback)(uint8_t, void*),
+                                  void *context)
+{
+    uart->rx_callback = NULL;
+    uart->rx_callback_context = context;
+    uart->rx_callback = rx_callback;
+}
+
 uint8_t sercom_uart_out_buffer_empty (struct sercom_uart_desc_t *uart)
 {
     return circular_buffer_is_empty(&uart->out_buffer);
@@ -353,7 +372,10 @@ static void sercom_uart_isr (Sercom *sercom, uint8_t inst_num, void *state)
     if (sercom->USART.INTFLAG.bit.RXC) {
         uint8_t data = sercom->USART.DATA.reg;
         
-        if (!uart->echo) {
+        if (uart->rx_callback != NULL) {
+            // Pass bytes straight to callback
+            uart->rx_callback(data, uart->rx_callback_context);
+        } else if (!uart->echo) {
             // Always add bytes to input buffer when echo is off
             circular_buffer_try_push(&uart->in_buffer, data);
         } else if (!iscntrl(data) || (data == '\r')) {
@@ -33,6 +33,12 @@ struct sercom_uart_desc_t {
     char in_buffer_mem[SERCOM_UART_IN_BUFFER_LEN];
     struct circular_buffer_t in_buffer;
     
+    /** Function called from the interrupt handler with each received byte, if
+        set bytes are not added to the input buffer */
+    void (*rx_callback)(uint8_t, void*);
+    /** Context passed to rx_callback */
+    void *rx_callback_context;
+    
     uint8_t sercom_instnum;
     
     /** DMA channel for data transmission */
@@ -185,6 +191,20 @@ extern void sercom_uart_get_line (struct sercom_uart_desc_t *uart, char *str,
  */
 extern char sercom_uart_get_char (struct sercom_uart_desc_t *uart);
 
+/**
+ *  Set a function to be called with each byte as it is received. The function
+ *  is called from the SERCOM interrupt handler, so it must be short. While a
+ *  callback is set received bytes are not stored in the input buffer.
+ *
+ *  @param uart The UART for which the callback should be set
+ *  @param rx_callback The function to be called with each received byte, or
+ *                     NULL to store received bytes in the input buffer
+ *  @param context A pointer which will be passed to the callback
+ */
+extern void sercom_uart_set_rx_callback (struct sercom_uart_desc_t *uart,
+                                         void (*rx_callback)(uint8_t, void*),
+                                         void *context);
+
 /**
  *  Determine if the out buffer of a UART is empty.
  *
@@ -92,9 +92,49 @@ static const uint8_t tc_evsys_gen_ovf_ids[] = {
 #endif
 };
 
+static const uint8_t tc_evsys_user_ids[] = {
+#ifdef TC3
+    EVSYS_ID_USER_TC3_EVU,
+#endif
+#ifdef TC4
+    EVSYS_ID_USER_TC4_EVU,
+#endif
+#ifdef TC5
+    EVSYS_ID_USER_TC5_EVU,
+#endif
+#ifdef TC6
+    EVSYS_ID_USER_TC6_EVU,
+#endif
+#ifdef TC7
+    EVSYS_ID_USER_TC7_EVU,
+#endif
+};
+
 #define TC_NUM_PRESCALER_VALUES 8
 static const uint16_t tc_prescaler_values[] = {1, 2, 4, 8, 16, 64, 256, 1024};
 
+#define TC_IRQ_PRIORITY 1
+
+/**
+ *  Callbacks for Timer Counters used as one-shot timers.
+ */
+static struct {
+    void (*callback)(void*);
+    void *state;
+    /** Number of timer ticks per microsecond */
+    uint8_t ticks_per_us;
+} tc_one_shot_g[TC_INST_NUM];
+
+/**
+ *  Callbacks for Timer Counters used for capture.
+ */
+static struct {
+    void (*callback)(uint32_t, void*);
+    void *state;
+    /** Counter frequency in Hz */
+    uint32_t frequency;
+} tc_capture_g[TC_INST_NUM];
+
 
 static int8_t tc_get_inst_num (Tc *const inst)
 {
@@ -189,7 +229,247 @@ uint8_t init_tc_periodic_event (Tc *tc, uint32_t period, uint32_t clock_mask,
     return 0;
 }
 
+uint8_t init_tc_one_shot (Tc *tc, uint32_t clock_mask, uint32_t clock_freq,
+                          void (*callback)(void*), void *state)
+{
+    int8_t inst_num = tc_get_inst_num(tc);
+    
+    if ((inst_num < 0) || (clock_freq < 1000000UL)) {
+        return 1;
+    }
+    
+    /* Enable TC instance interface clock */
+    PM->APBCMASK.reg |= (1 << tc_apb_masks[inst_num]);
+    
+    /* Configure generic clock for TC instance */
+    GCLK->CLKCTRL.reg = (GCLK_CLKCTRL_CLKEN | clock_mask |
+                         GCLK_CLKCTRL_ID(tc_clk_ids[inst_num]));
+    // Wait for synchronization
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    
+    /* Reset TC */
+    tc->COUNT16.CTRLA.bit.SWRST = 1;
+    // Wait for reset to complete
+    while (tc->COUNT16.CTRLA.bit.SWRST | tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    /* Find the largest prescaler which gives at least one tick per
+       microsecond */
+    uint8_t prescaler = 0;
+    for (int8_t i = TC_NUM_PRESCALER_VALUES - 1; i >= 0; i--) {
+        if ((clock_freq / tc_prescaler_values[i]) >= 1000000UL) {
+            prescaler = i;
+            break;
+        }
+    }
+    
+    uint32_t ticks_per_us = ((clock_freq / tc_prescaler_values[prescaler]) /
+                             1000000UL);
+    tc_one_shot_g[inst_num].ticks_per_us = ((ticks_per_us > UINT8_MAX) ?
+                                            UINT8_MAX : ticks_per_us);
+    tc_one_shot_g[inst_num].callback = callback;
+    tc_one_shot_g[inst_num].state = state;
+    
+    /* Write CTRLA */
+    tc->COUNT16.CTRLA.reg = (TC_CTRLA_PRESCSYNC_RESYNC |
+                             TC_CTRLA_PRESCALER(prescaler) |
+                             TC_CTRLA_WAVEGEN_MFRQ |
+                             TC_CTRLA_MODE_COUNT16);
+    // Wait for synchronization
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    /* Stop when TOP is reached */
+    tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+    // Wait for synchronization
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    /* Enable overflow interrupt */
+    tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+    NVIC_SetPriority(TC3_IRQn + inst_num, TC_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TC3_IRQn + inst_num);
+    
+    /* Enable timer, it will not count until it is retriggered */
+    tc->COUNT16.CTRLA.bit.ENABLE = 1;
+    // Wait for synchronization
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    /* Make sure the timer is stopped */
+    tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+    // Wait for synchronization
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    return 0;
+}
+
+void tc_one_shot_start (Tc *tc, uint16_t period)
+{
+    int8_t inst_num = tc_get_inst_num(tc);
+    
+    uint32_t top = (uint32_t)period * tc_one_shot_g[inst_num].ticks_per_us;
+    
+    tc->COUNT16.CC[0].reg = (top > UINT16_MAX) ? UINT16_MAX : (uint16_t)top;
+    // Wait for synchronization
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    
+    /* Start counting from zero */
+    tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+}
+
+uint8_t init_tc_capture (Tc *tc, uint32_t clock_mask, uint32_t clock_freq,
+                         void (*callback)(uint32_t, void*), void *state)
+{
+    int8_t inst_num = tc_get_inst_num(tc);
+    
+    // TC3 is instance 0, only even numbered TCs can be used in 32 bit mode
+    if ((inst_num < 0) || !(inst_num & 1) || ((inst_num + 1) >= TC_INST_NUM) ||
+            (clock_freq < 1000000UL)) {
+        return 1;
+    }
+    
+    /* Enable interface clocks for both TC instances */
+    PM->APBCMASK.reg |= ((1 << tc_apb_masks[inst_num]) |
+                         (1 << tc_apb_masks[inst_num + 1]));
+    
+    /* Configure generic clock for TC pair */
+    GCLK->CLKCTRL.reg = (GCLK_CLKCTRL_CLKEN | clock_mask |
+                         GCLK_CLKCTRL_ID(tc_clk_ids[inst_num]));
+    // Wait for synchronization
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    
+    /* Reset TC */
+    tc->COUNT32.CTRLA.bit.SWRST = 1;
+    // Wait for reset to complete
+    while (tc->COUNT32.CTRLA.bit.SWRST | tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    /* Find the largest prescaler which gives at least one tick per
+       microsecond */
+    uint8_t prescaler = 0;
+    for (int8_t i = TC_NUM_PRESCALER_VALUES - 1; i >= 0; i--) {
+        if ((clock_freq / tc_prescaler_values[i]) >= 1000000UL) {
+            prescaler = i;
+            break;
+        }
+    }
+    
+    tc_capture_g[inst_num].frequency = (clock_freq /
+                                        tc_prescaler_values[prescaler]);
+    tc_capture_g[inst_num].callback = callback;
+    tc_capture_g[inst_num].state = state;
+    
+    /* Write CTRLA */
+    tc->COUNT32.CTRLA.reg = (TC_CTRLA_PRESCSYNC_RESYNC |
+                             TC_CTRLA_PRESCALER(prescaler) |
+                             TC_CTRLA_WAVEGEN_NFRQ |
+                             TC_CTRLA_MODE_COUNT32);
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    /* Enable capture on channel 0 */
+    tc->COUNT32.CTRLC.reg = TC_CTRLC_CPTEN0;
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    /* Capture when an event is received */
+    tc->COUNT32.EVCTRL.reg = TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_OFF;
+    
+    /* Enable capture interrupt */
+    tc->COUNT32.INTENSET.reg = TC_INTENSET_MC0;
+    NVIC_SetPriority(TC3_IRQn + inst_num, TC_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TC3_IRQn + inst_num);
+    
+    /* Enable timer */
+    tc->COUNT32.CTRLA.bit.ENABLE = 1;
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    return 0;
+}
+
+uint32_t tc_capture_get_frequency (Tc *tc)
+{
+    return tc_capture_g[tc_get_inst_num(tc)].frequency;
+}
+
+uint32_t tc_get_count32 (Tc *tc)
+{
+    tc->COUNT32.READREQ.reg = (TC_READREQ_RREQ |
+                               TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET));
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    return tc->COUNT32.COUNT.reg;
+}
+
+uint8_t tc_get_evsys_user_id (Tc *tc)
+{
+    return tc_evsys_user_ids[tc_get_inst_num(tc)];
+}
+
 uint8_t tc_get_evsys_gen_ovf_id (Tc *tc)
 {
     return tc_evsys_gen_ovf_ids[tc_get_inst_num(tc)];
 }
+
+/**
+ *  Handle an interrupt for a Timer Counter.
+ *
+ *  @param inst_num The index of the Timer Counter instance
+ */
+static void tc_handle_interrupt (uint8_t inst_num)
+{
+    Tc *const tc_insts[TC_INST_NUM] = TC_INSTS;
+    Tc *tc = tc_insts[inst_num];
+    
+    if (tc->COUNT16.INTFLAG.bit.OVF) {
+        // Clear interrupt flag
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        
+        if (tc_one_shot_g[inst_num].callback != NULL) {
+            tc_one_shot_g[inst_num].callback(tc_one_shot_g[inst_num].state);
+        }
+    }
+    
+    if (tc->COUNT32.INTFLAG.bit.MC0) {
+        // Reading the captured value clears the interrupt flag
+        uint32_t capture = tc->COUNT32.CC[0].reg;
+        
+        if (tc_capture_g[inst_num].callback != NULL) {
+            tc_capture_g[inst_num].callback(capture,
+                                            tc_capture_g[inst_num].state);
+        }
+    }
+}
+
+#ifdef TC3
+void TC3_Handler (void)
+{
+    tc_handle_interrupt(0);
+}
+#endif
+
+#ifdef TC4
+void TC4_Handler (void)
+{
+    tc_handle_interrupt(1);
+}
+#endif
+
+#ifdef TC5
+void TC5_Handler (void)
+{
+    tc_handle_interrupt(2);
+}
+#endif
+
+#ifdef TC6
+void TC6_Handler (void)
+{
+    tc_handle_interrupt(3);
+}
+#endif
+
+#ifdef TC7
+void TC7_Handler (void)
+{
+    tc_handle_interrupt(4);
+}
+#endif
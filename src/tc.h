@@ -29,6 +29,89 @@ extern uint8_t init_tc_periodic_event (Tc *tc, uint32_t period,
                                        uint32_t clock_mask,
                                        uint32_t clock_freq);
 
+/**
+ *  Initilize a Timer Counter to be used as a one-shot timer with a resolution
+ *  of at least one microsecond. The timer is not started until
+ *  tc_one_shot_start is called.
+ *
+ *  @param tc The Timer Counter instance to be initilized
+ *  @param clock_mask Mask for the Generic Clock Generator which should provide
+ *                    the Generic Clock for the Timer Counter
+ *  @param clock_freq The frequency of the Generic Clock Generator for the Timer
+ *                    Counter, must be at least 1 MHz
+ *  @param callback Function to be called from the Timer Counter interrupt
+ *                  when the timer expires
+ *  @param state Pointer which is passed to the callback function
+ *
+ *  @return 0 if successfull
+ */
+extern uint8_t init_tc_one_shot (Tc *tc, uint32_t clock_mask,
+                                 uint32_t clock_freq,
+                                 void (*callback)(void*), void *state);
+
+/**
+ *  Start a one-shot timer. If the timer is already running it is restarted
+ *  with the new period.
+ *
+ *  @param tc The Timer Counter instance, must have been initilized with
+ *            init_tc_one_shot
+ *  @param period The time in microseconds after which the callback should be
+ *                called, must be at most 65535
+ */
+extern void tc_one_shot_start (Tc *tc, uint16_t period);
+
+/**
+ *  Initilize a Timer Counter as a free running 32 bit counter which captures
+ *  its count on channel 0 each time an event is received. The Timer Counter
+ *  must be an even numbered instance, the following instance is used as the
+ *  high half of the counter. The counter runs at the highest rate which is at
+ *  most the clock frequency and no less than 1 MHz.
+ *
+ *  @param tc The Timer Counter instance to be initilized
+ *  @param clock_mask Mask for the Generic Clock Generator which should provide
+ *                    the Generic Clock for the Timer Counter
+ *  @param clock_freq The frequency of the Generic Clock Generator for the Timer
+ *                    Counter, must be at least 1 MHz
+ *  @param callback Function to be called from the Timer Counter interrupt
+ *                  with the captured count
+ *  @param state Pointer which is passed to the callback function
+ *
+ *  @return 0 if successfull
+ */
+extern uint8_t init_tc_capture (Tc *tc, uint32_t clock_mask,
+                                uint32_t clock_freq,
+                                void (*callback)(uint32_t, void*),
+                                void *state);
+
+/**
+ *  Get the frequency at which a capture Timer Counter counts.
+ *
+ *  @param tc The Timer Counter instance, must have been initilized with
+ *            init_tc_capture
+ *
+ *  @return The counter frequency in Hz
+ */
+extern uint32_t tc_capture_get_frequency (Tc *tc);
+
+/**
+ *  Read the current count of a 32 bit Timer Counter.
+ *
+ *  @param tc The Timer Counter instance, must have been initilized with
+ *            init_tc_capture
+ *
+ *  @return The current count
+ */
+extern uint32_t tc_get_count32 (Tc *tc);
+
+/**
+ *  Get the EVSYS event user ID for a Timer Counter's event input.
+ *
+ *  @param tc The Timer Counter for which the event ID should be found
+ *
+ *  @return The event user ID for the Timer Counter's event input
+ */
+extern uint8_t tc_get_evsys_user_id (Tc *tc) __attribute__((const));
+
 /**
  *  Get the EVSYS event generator ID for a Timer Counter's overflow event.
  *
@@ -0,0 +1,301 @@
+/**
+ * @file telemetry-codec.c
+ * @desc Compact variable length encoding for telemetry samples
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "telemetry-codec.h"
+
+#include <string.h>
+
+
+/**
+ *  Location of a field within a telemetry sample.
+ */
+struct telemetry_codec_field_t {
+    uint8_t offset;
+    uint8_t size;
+};
+
+#define TELEMETRY_FIELD(name) { offsetof(struct telemetry_frame, name), \
+                                sizeof(((struct telemetry_frame*)0)->name) }
+
+/** Every field of a telemetry sample, in the order they are encoded */
+static const struct telemetry_codec_field_t telemetry_codec_fields[] = {
+    TELEMETRY_FIELD(mission_time),
+    TELEMETRY_FIELD(flags),
+    TELEMETRY_FIELD(adc_data[0]),
+    TELEMETRY_FIELD(adc_data[1]),
+    TELEMETRY_FIELD(adc_data[2]),
+    TELEMETRY_FIELD(adc_data[3]),
+    TELEMETRY_FIELD(adc_data[4]),
+    TELEMETRY_FIELD(adc_data[5]),
+    TELEMETRY_FIELD(adc_data[6]),
+    TELEMETRY_FIELD(adc_data[7]),
+    TELEMETRY_FIELD(accel_x),
+    TELEMETRY_FIELD(accel_y),
+    TELEMETRY_FIELD(accel_z),
+    TELEMETRY_FIELD(accel_temp),
+    TELEMETRY_FIELD(altimeter_temp),
+    // The altitude is encoded by its bit pattern, nearby values of the same
+    // sign have nearby bit patterns
+    TELEMETRY_FIELD(altimeter_altitude),
+    TELEMETRY_FIELD(gps_utc_time),
+    TELEMETRY_FIELD(gps_latitude),
+    TELEMETRY_FIELD(gps_longitude),
+    TELEMETRY_FIELD(gps_speed),
+    TELEMETRY_FIELD(gps_course),
+    TELEMETRY_FIELD(gps_altitude)
+};
+
+_Static_assert((sizeof(telemetry_codec_fields) /
+                sizeof(telemetry_codec_fields[0])) ==
+               TELEMETRY_CODEC_NUM_FIELDS, "Telemetry field table is wrong");
+
+/** A sample with every field zero, which keyframes are encoded against */
+static const struct telemetry_frame telemetry_codec_zero;
+
+
+/**
+ *  Get the value of a field.
+ */
+static uint32_t get_field (const struct telemetry_frame *sample,
+                           const struct telemetry_codec_field_t *field)
+{
+    const uint8_t *src = (const uint8_t*)sample + field->offset;
+    if (field->size == 2) {
+        uint16_t value;
+        memcpy(&value, src, 2);
+        return value;
+    } else {
+        uint32_t value;
+        memcpy(&value, src, 4);
+        return value;
+    }
+}
+
+/**
+ *  Get the value against which a field is encoded. The mission time is always
+ *  encoded against the time base of the frame, every other field is encoded
+ *  against the reference sample.
+ */
+static uint32_t get_reference (const struct telemetry_frame *reference,
+                               const struct telemetry_codec_field_t *field,
+                               uint32_t time_base)
+{
+    if (field->offset == offsetof(struct telemetry_frame, mission_time)) {
+        return time_base;
+    }
+    return get_field(reference, field);
+}
+
+/**
+ *  Set the value of a field, truncated to the size of the field.
+ */
+static void set_field (struct telemetry_frame *sample,
+                       const struct telemetry_codec_field_t *field,
+                       uint32_t value)
+{
+    uint8_t *dest = (uint8_t*)sample + field->offset;
+    if (field->size == 2) {
+        uint16_t v = (uint16_t)value;
+        memcpy(dest, &v, 2);
+    } else {
+        memcpy(dest, &value, 4);
+    }
+}
+
+/**
+ *  Write an unsigned value as a varint, least significant group first.
+ *
+ *  @return Pointer to the byte following the varint
+ */
+static uint8_t *put_varint (uint8_t *dest, uint32_t value)
+{
+    while (value >= 0x80) {
+        *dest++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *dest++ = (uint8_t)value;
+    return dest;
+}
+
+/**
+ *  Read a varint.
+ *
+ *  @param src Pointer to the next byte to be read, updated to point after the
+ *             varint
+ *  @param end Pointer to the byte after the end of the data
+ *  @param value Pointer to where the value will be stored
+ *
+ *  @return 0 if successful, 1 if the varint runs past the end of the data or
+ *          is too long
+ */
+static uint8_t get_varint (const uint8_t **src, const uint8_t *end,
+                           uint32_t *value)
+{
+    uint32_t v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*src == end) {
+            return 1;
+        }
+        uint8_t b = *(*src)++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *value = v;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ *  Find the zig-zag encoded difference between a field's value and a
+ *  reference value, the difference wraps at the size of the field.
+ */
+static uint32_t zigzag_delta (uint32_t value, uint32_t reference, uint8_t size)
+{
+    int32_t delta;
+    if (size == 2) {
+        delta = (int16_t)(uint16_t)(value - reference);
+    } else {
+        delta = (int32_t)(value - reference);
+    }
+    return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+/**
+ *  Undo zig-zag encoding.
+ */
+static uint32_t unzigzag (uint32_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+
+void init_telemetry_encoder (struct telemetry_encoder_t *enc,
+                             uint8_t keyframe_interval)
+{
+    enc->keyframe = telemetry_codec_zero;
+    enc->keyframe_id = 0xFF;
+    enc->keyframe_interval = keyframe_interval;
+    enc->since_keyframe = 0;
+}
+
+uint8_t telemetry_encode (struct telemetry_encoder_t *enc,
+                          const struct telemetry_frame *sample,
+                          uint32_t time_base, uint8_t *dest)
+{
+    const struct telemetry_frame *reference = &enc->keyframe;
+    uint8_t type = TELEMETRY_CODEC_DELTA;
+    
+    if (enc->since_keyframe == 0) {
+        reference = &telemetry_codec_zero;
+        type = TELEMETRY_CODEC_KEYFRAME;
+        enc->keyframe_id++;
+    }
+    
+    // Find the fields which differ from the reference and their deltas
+    uint32_t deltas[TELEMETRY_CODEC_NUM_FIELDS];
+    uint32_t present = 0;
+    for (uint8_t i = 0; i < TELEMETRY_CODEC_NUM_FIELDS; i++) {
+        const struct telemetry_codec_field_t *field = telemetry_codec_fields + i;
+        deltas[i] = zigzag_delta(get_field(sample, field),
+                                 get_reference(reference, field, time_base),
+                                 field->size);
+        if (deltas[i] != 0) {
+            present |= ((uint32_t)1 << i);
+        }
+    }
+    
+    uint8_t *d = dest;
+    *d++ = (TELEMETRY_CODEC_VERSION << 4) | type;
+    *d++ = enc->keyframe_id;
+    d = put_varint(d, present);
+    for (uint8_t i = 0; i < TELEMETRY_CODEC_NUM_FIELDS; i++) {
+        if (present & ((uint32_t)1 << i)) {
+            d = put_varint(d, deltas[i]);
+        }
+    }
+    
+    if (type == TELEMETRY_CODEC_KEYFRAME) {
+        enc->keyframe = *sample;
+    }
+    
+    enc->since_keyframe++;
+    if (enc->since_keyframe >= enc->keyframe_interval) {
+        enc->since_keyframe = 0;
+    }
+    
+    return (uint8_t)(d - dest);
+}
+
+void init_telemetry_decoder (struct telemetry_decoder_t *dec)
+{
+    dec->keyframe = telemetry_codec_zero;
+    dec->keyframe_id = 0;
+    dec->have_keyframe = 0;
+}
+
+enum telemetry_decode_result telemetry_decode (struct telemetry_decoder_t *dec,
+                                               const uint8_t *src,
+                                               uint8_t length,
+                                               uint32_t time_base,
+                                               uint8_t *consumed,
+                                               struct telemetry_frame *sample)
+{
+    const uint8_t *s = src;
+    const uint8_t *end = src + length;
+    
+    if (length < 3) {
+        return TELEMETRY_DECODE_INVALID;
+    }
+    
+    uint8_t header = *s++;
+    uint8_t id = *s++;
+    uint8_t type = header & 0xF;
+    
+    if (((header >> 4) != TELEMETRY_CODEC_VERSION) ||
+            (type > TELEMETRY_CODEC_DELTA)) {
+        return TELEMETRY_DECODE_INVALID;
+    }
+    
+    uint32_t present;
+    if (get_varint(&s, end, &present) ||
+            (present >> TELEMETRY_CODEC_NUM_FIELDS)) {
+        return TELEMETRY_DECODE_INVALID;
+    }
+    
+    const struct telemetry_frame *reference = &dec->keyframe;
+    if (type == TELEMETRY_CODEC_KEYFRAME) {
+        reference = &telemetry_codec_zero;
+    }
+    
+    struct telemetry_frame decoded;
+    for (uint8_t i = 0; i < TELEMETRY_CODEC_NUM_FIELDS; i++) {
+        const struct telemetry_codec_field_t *field = telemetry_codec_fields + i;
+        uint32_t delta = 0;
+        if ((present & ((uint32_t)1 << i)) && get_varint(&s, end, &delta)) {
+            return TELEMETRY_DECODE_INVALID;
+        }
+        set_field(&decoded, field, get_reference(reference, field,
+                                                 time_base) +
+                                   unzigzag(delta));
+    }
+    
+    *consumed = (uint8_t)(s - src);
+    
+    if (type == TELEMETRY_CODEC_KEYFRAME) {
+        dec->keyframe = decoded;
+        dec->keyframe_id = id;
+        dec->have_keyframe = 1;
+    } else if (!dec->have_keyframe || (id != dec->keyframe_id)) {
+        return TELEMETRY_DECODE_NO_KEYFRAME;
+    }
+    
+    *sample = decoded;
+    return TELEMETRY_DECODE_OK;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file telemetry-codec.h
+ * @desc Compact variable length encoding for telemetry samples
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef telemetry_codec_h
+#define telemetry_codec_h
+
+#include "global.h"
+
+#include "telemetry-format.h"
+
+/*
+ *  Each sample is encoded as:
+ *      - A header byte with the codec version in the high nibble and the
+ *        sample type in the low nibble
+ *      - The ID of the keyframe which the sample is encoded against
+ *      - A varint bitmap of the fields which are present
+ *      - A zig-zag varint for each field which is present, in the order of the
+ *        fields in struct telemetry_frame
+ *
+ *  A keyframe is encoded against a sample with every field zero, so only non
+ *  zero fields are present and each value is sent in full. A delta sample is
+ *  encoded against the most recent keyframe, so only fields which have changed
+ *  are present and each value is the difference from the keyframe. Since every
+ *  delta sample depends only on the keyframe, losing a delta sample does not
+ *  affect any other samples.
+ *
+ *  The mission time is the exception, it is always encoded as the difference
+ *  from a time base which is shared by all of the samples in a frame.
+ */
+
+/** Version of the encoding, stored in the header of every sample */
+#define TELEMETRY_CODEC_VERSION     1
+
+/** Header sample type for a keyframe */
+#define TELEMETRY_CODEC_KEYFRAME    0
+/** Header sample type for a sample encoded against a keyframe */
+#define TELEMETRY_CODEC_DELTA       1
+
+/** Number of fields in a telemetry sample */
+#define TELEMETRY_CODEC_NUM_FIELDS  22
+
+/** Maximum length of an encoded sample: two header bytes, a 22 bit bitmap in
+    four bytes, seven 32 bit fields in five bytes each and fifteen 16 bit fields
+    in three bytes each */
+#define TELEMETRY_CODEC_MAX_LEN     86
+
+/**
+ *  State for encoding a stream of samples.
+ */
+struct telemetry_encoder_t {
+    /** The keyframe against which samples are encoded */
+    struct telemetry_frame keyframe;
+    /** ID of the current keyframe */
+    uint8_t keyframe_id;
+    /** Number of samples between keyframes, including the keyframe */
+    uint8_t keyframe_interval;
+    /** Number of samples encoded since the last keyframe */
+    uint8_t since_keyframe;
+};
+
+/**
+ *  State for decoding a stream of samples.
+ */
+struct telemetry_decoder_t {
+    /** The last keyframe received */
+    struct telemetry_frame keyframe;
+    /** ID of the last keyframe received */
+    uint8_t keyframe_id;
+    /** Whether a keyframe has been received */
+    uint8_t have_keyframe;
+};
+
+/**
+ *  Result of decoding a sample.
+ */
+enum telemetry_decode_result {
+    /** The sample was decoded */
+    TELEMETRY_DECODE_OK,
+    /** The keyframe which the sample was encoded against has not been
+        received, the sample was skipped */
+    TELEMETRY_DECODE_NO_KEYFRAME,
+    /** The data is not a valid sample, the rest of the data can not be
+        decoded */
+    TELEMETRY_DECODE_INVALID
+};
+
+/**
+ *  Initialize a telemetry encoder.
+ *
+ *  @param enc The encoder to be initialized
+ *  @param keyframe_interval The number of samples between keyframes, a
+ *                           keyframe is sent first and then every time this
+ *                           many samples have been encoded
+ */
+extern void init_telemetry_encoder (struct telemetry_encoder_t *enc,
+                                    uint8_t keyframe_interval);
+
+/**
+ *  Make the next sample a keyframe.
+ *
+ *  @param enc The encoder
+ */
+static inline void telemetry_encoder_force_keyframe (
+                                                struct telemetry_encoder_t *enc)
+{
+    enc->since_keyframe = 0;
+}
+
+/**
+ *  Encode a sample.
+ *
+ *  @param enc The encoder
+ *  @param sample The sample to be encoded
+ *  @param time_base The time against which the sample's mission time is
+ *                   encoded
+ *  @param dest Buffer where the encoded sample will be placed, must have space
+ *              for at least TELEMETRY_CODEC_MAX_LEN bytes
+ *
+ *  @return The length of the encoded sample
+ */
+extern uint8_t telemetry_encode (struct telemetry_encoder_t *enc,
+                                 const struct telemetry_frame *sample,
+                                 uint32_t time_base, uint8_t *dest);
+
+/**
+ *  Initialize a telemetry decoder.
+ *
+ *  @param dec The decoder to be initialized
+ */
+extern void init_telemetry_decoder (struct telemetry_decoder_t *dec);
+
+/**
+ *  Decode a sample.
+ *
+ *  @param dec The decoder
+ *  @param src The encoded data
+ *  @param length The number of bytes available in src
+ *  @param time_base The time against which the sample's mission time was
+ *                   encoded
+ *  @param consumed Pointer to where the length of the encoded sample will be
+ *                  stored, unless the data is invalid
+ *  @param sample Pointer to where the decoded sample will be stored
+ *
+ *  @return The result of decoding
+ */
+extern enum telemetry_decode_result telemetry_decode (
+                                            struct telemetry_decoder_t *dec,
+                                            const uint8_t *src, uint8_t length,
+                                            uint32_t time_base,
+                                            uint8_t *consumed,
+                                            struct telemetry_frame *sample);
+
+#endif /* telemetry_codec_h */
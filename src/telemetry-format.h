@@ -10,6 +10,47 @@
 #ifndef telemetry_format_h
 #define telemetry_format_h
 
+/** First byte of a telemetry API frame */
+#define TELEMETRY_START_DELIMITER       0x52
+/** Last byte of a telemetry API frame */
+#define TELEMETRY_END_DELIMITER         0xCC
+
+/** Payload type for a frame containing struct telemetry_frame samples */
+#define TELEMETRY_PAYLOAD_RAW           0
+/** Payload type for a frame containing samples encoded with the telemetry
+    codec. The payload starts with the 32 bit mission time against which the
+    samples' times are encoded and the number of samples in the frame, followed
+    by the encoded samples. */
+#define TELEMETRY_PAYLOAD_COMPACT       1
+/** Length of the header at the start of a compact payload */
+#define TELEMETRY_COMPACT_HEADER_LEN    5
+/** Payload type for a frame containing struct telemetry_link_report, sent by
+    the ground station to the host */
+#define TELEMETRY_PAYLOAD_LINK_STATS    2
+
+/** Radio index in a link statistics frame whose statistics are for the frames
+    merged from all of the ground station's radios */
+#define TELEMETRY_LINK_ALL_RADIOS       0xFF
+
+/** First two bytes of each frame sent from the ground station to the host, sent
+    as 0xA5 0x5A */
+#define GROUND_FRAME_SYNC               0x5AA5
+/** Length of the CRC which follows each frame sent to the host */
+#define GROUND_FRAME_CRC_LEN            2
+
+/** Number of buckets in each of the link histograms */
+#define TELEMETRY_LINK_HISTOGRAM_BUCKETS    8
+/** Lowest SNR in dB of the first SNR bucket, values outside of the range of
+    the buckets are counted in the first or last bucket */
+#define TELEMETRY_LINK_SNR_MIN              -20
+/** Width of each SNR bucket in dB */
+#define TELEMETRY_LINK_SNR_STEP             4
+/** Lowest RSSI in dBm of the first RSSI bucket, values outside of the range
+    of the buckets are counted in the first or last bucket */
+#define TELEMETRY_LINK_RSSI_MIN             -130
+/** Width of each RSSI bucket in dB */
+#define TELEMETRY_LINK_RSSI_STEP            10
+
 // Ignore warnings in this file about inefficient alignment
 #pragma GCC diagnostic ignored "-Wattributes"
 #pragma GCC diagnostic ignored "-Wpacked"
@@ -62,6 +103,63 @@ struct telemetry_api_frame {
     uint8_t end_delimiter;              // 0xCC
 } __attribute__ ((packed));
 
+
+/**
+ *  Statistics for a telemetry link.
+ */
+struct telemetry_link_report {
+    /** Number of intact frames received */
+    uint32_t received;
+    /** Number of frames which were missing from the sequence */
+    uint32_t lost;
+    /** Number of frames which were received more than once */
+    uint32_t duplicate;
+    /** Number of frames which were corrupted */
+    uint32_t corrupt;
+    /** Number of bytes fixed by forward error correction */
+    uint32_t corrected;
+    /** Average interval between frames in sixteenths of a millisecond */
+    uint32_t interval;
+    /** Average deviation from the average interval in sixteenths of a
+        millisecond */
+    uint32_t jitter;
+    /** Number of frames received in each SNR bucket */
+    uint16_t snr_histogram[TELEMETRY_LINK_HISTOGRAM_BUCKETS];
+    /** Number of frames received in each RSSI bucket */
+    uint16_t rssi_histogram[TELEMETRY_LINK_HISTOGRAM_BUCKETS];
+} __attribute__ ((packed));
+
+/**
+ *  Header for each frame sent from the ground station to the host. The header
+ *  is followed by the payload, which is a telemetry API frame, and then a
+ *  CRC-16-CCITT of the header and payload.
+ */
+struct ground_frame_header {
+    /** Always GROUND_FRAME_SYNC */
+    uint16_t sync;
+    /** Length of the payload */
+    uint16_t length;
+    /** Time at which the payload was received in milliseconds since the ground
+        station was reset */
+    uint32_t time;
+    /** Signal to noise ratio of the received frame in dB */
+    int8_t snr;
+    /** Received signal strength in dBm, INT8_MIN if it is not known */
+    int8_t rssi;
+} __attribute__ ((packed));
+
+struct telemetry_link_api_frame {
+    uint8_t start_delimiter;            // 0x52
+    uint8_t payload_type;
+    
+    uint16_t length;
+    
+    uint8_t radio;                      // TELEMETRY_LINK_ALL_RADIOS or index
+    struct telemetry_link_report payload;
+    
+    uint8_t end_delimiter;              // 0xCC
+} __attribute__ ((packed));
+
 // Stop ignoring warnings about inefficient alignment
 #pragma GCC diagnostic pop
 
@@ -0,0 +1,126 @@
+/**
+ * @file telemetry-link.h
+ * @desc Sequence numbers, CRC and link statistics for telemetry frames
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef telemetry_link_h
+#define telemetry_link_h
+
+#include "global.h"
+
+#include "telemetry-format.h"
+
+/*
+ *  Each telemetry API frame is sent over the radio with a 16 bit sequence
+ *  number before it and a CRC-16-CCITT of the sequence number and frame after
+ *  it. The sequence number lets the receiver tell lost frames from duplicated
+ *  frames and the CRC lets it discard frames which were corrupted.
+ */
+
+/** Length of the sequence number before each frame */
+#define TELEMETRY_LINK_HEADER_LEN   2
+/** Length of the CRC after each frame */
+#define TELEMETRY_LINK_CRC_LEN      2
+/** Total number of bytes added to each frame */
+#define TELEMETRY_LINK_OVERHEAD     (TELEMETRY_LINK_HEADER_LEN + \
+                                     TELEMETRY_LINK_CRC_LEN)
+
+/** Frames whose sequence number is less than this far behind the last frame
+    are accepted late if they have not been received yet and are duplicates
+    otherwise, frames which are further behind are assumed to be from a sender
+    which has restarted. At most the number of bits in
+    telemetry_link_stats_t.seen. */
+#define TELEMETRY_LINK_REORDER_WINDOW   32
+
+/**
+ *  Statistics for a telemetry link along with the state needed to keep them.
+ */
+struct telemetry_link_stats_t {
+    /** Statistics which are reported to the host */
+    struct telemetry_link_report report;
+    /** Time in milliseconds at which the last frame arrived */
+    uint32_t last_arrival;
+    /** Bitmap of the frames in the reorder window which have been received,
+        bit n is set if the frame n before the last frame was received */
+    uint32_t seen;
+    /** Sequence number of the last frame */
+    uint16_t last_sequence;
+    /** Whether a frame has been received */
+    uint8_t have_sequence:1;
+    /** Whether the average interval between frames is valid */
+    uint8_t have_interval:1;
+};
+
+/**
+ *  Result of receiving a frame.
+ */
+enum telemetry_link_result {
+    /** The frame is intact and has not been received before */
+    TELEMETRY_LINK_OK,
+    /** The frame has already been received */
+    TELEMETRY_LINK_DUPLICATE,
+    /** The frame was corrupted */
+    TELEMETRY_LINK_CORRUPT
+};
+
+/**
+ *  Calculate the CRC-16-CCITT of some data, with an initial value of 0xFFFF
+ *  and no final exclusive or.
+ *
+ *  @param data The data
+ *  @param length The length of the data
+ *
+ *  @return The CRC
+ */
+extern uint16_t telemetry_link_crc (const uint8_t *data, uint16_t length);
+
+/**
+ *  Add a sequence number and CRC to a frame.
+ *
+ *  @param frame Buffer with TELEMETRY_LINK_HEADER_LEN bytes for the sequence
+ *               number followed by the frame, and space for the CRC after it
+ *  @param length The length of the frame, including the space for the sequence
+ *                number but not the CRC
+ *  @param sequence The sequence number for the frame
+ *
+ *  @return The length of the frame with the CRC
+ */
+extern uint8_t telemetry_link_seal (uint8_t *frame, uint8_t length,
+                                    uint16_t sequence);
+
+/**
+ *  Initialize the statistics for a link.
+ *
+ *  @param stats The statistics to be initialized
+ */
+extern void init_telemetry_link_stats (struct telemetry_link_stats_t *stats);
+
+/**
+ *  Check a received frame and update the link statistics. A frame which was
+ *  counted as lost is accepted if it arrives late, within
+ *  TELEMETRY_LINK_REORDER_WINDOW of the last frame, and is no longer counted
+ *  as lost.
+ *
+ *  @param stats The statistics for the link on which the frame was received
+ *  @param frame The received frame, starting with the sequence number
+ *  @param length The length of the frame, including the CRC
+ *  @param corrected The number of bytes which were corrected by forward error
+ *                   correction, or -1 if there were too many errors to be
+ *                   corrected
+ *  @param time The time in milliseconds at which the frame was received
+ *  @param snr The signal to noise ratio of the frame in dB
+ *  @param rssi The received signal strength in dBm, or INT8_MIN if unknown
+ *
+ *  @return The result of checking the frame
+ */
+extern enum telemetry_link_result telemetry_link_receive (
+                                        struct telemetry_link_stats_t *stats,
+                                        const uint8_t *frame, uint8_t length,
+                                        int16_t corrected, uint32_t time,
+                                        int8_t snr, int8_t rssi);
+
+#endif /* telemetry_link_h */
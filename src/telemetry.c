@@ -9,6 +9,11 @@
 #include "telemetry.h"
 
 #include "telemetry-format.h"
+#include "telemetry-codec.h"
+#include "reed-solomon.h"
+#include "telemetry-link.h"
+
+#include <string.h>
 
 
 
@@ -17,12 +22,82 @@ static struct rn2483_desc_t *telemetry_radio_g;
 
 static struct ms5611_desc_t *telemetry_altimeter_g;
 
+static struct flight_state_desc_t *telemetry_flight_state_g;
+
+/** Bytes in a frame other than samples and parity: sequence number,
+    delimiters, payload type, length, time base, number of samples and CRC */
+#define TELEMETRY_FRAME_OVERHEAD    (5 + TELEMETRY_COMPACT_HEADER_LEN + \
+                                     TELEMETRY_LINK_OVERHEAD)
+/** Maximum number of bytes of encoded samples in a frame without forward
+    error correction */
+#define TELEMETRY_MAX_PAYLOAD       (RN2483_SEND_MAX_LEN - \
+                                     TELEMETRY_FRAME_OVERHEAD)
+
 static uint32_t rate_g;
 static uint32_t last_time_g;
+static uint16_t max_duty_cycle_g;
 
 uint8_t telemetry_paused = 0;
 
-static struct telemetry_api_frame packet_g;
+static struct telemetry_schedule_t schedule_g;
+
+/** Average length of an encoded sample in sixteenths of a byte */
+static uint16_t sample_length_avg_g;
+
+static struct telemetry_encoder_t encoder_g;
+
+/** Code used to add parity bytes to each frame */
+static struct rs_codec_t fec_g;
+/** Number of interleaved codewords in each frame */
+static uint8_t fec_depth_g;
+/** Number of parity bytes added to each frame, zero if forward error
+    correction is disabled */
+static uint8_t fec_parity_g;
+/** Maximum number of bytes of encoded samples in a frame */
+static uint8_t max_payload_g;
+
+/** Number of samples which can be waiting to be sent, must be a power of two */
+#define TELEMETRY_RING_LEN  16
+
+/** Samples which have been taken but not yet added to a frame */
+static struct telemetry_frame ring_g[TELEMETRY_RING_LEN];
+/** Index in the ring where the next sample will be stored */
+static uint8_t ring_head_g;
+/** Number of samples in the ring */
+static uint8_t ring_count_g;
+
+/**
+ *  A telemetry API frame containing encoded samples.
+ */
+struct telemetry_packet_t {
+    /** Link layer sequence number */
+    uint16_t sequence;
+    uint8_t start_delimiter;
+    uint8_t payload_type;
+    /** Length of the payload, including the time base and number of
+        samples */
+    uint16_t length;
+    /** Mission time against which the samples' times are encoded */
+    uint32_t time_base;
+    /** Number of samples in the frame */
+    uint8_t num_samples;
+    /** Encoded samples followed by the end delimiter, the CRC and then the
+        parity bytes */
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD + 1 + TELEMETRY_LINK_CRC_LEN];
+} __attribute__ ((packed));
+
+/** Frames being assembled and sent, the radio driver keeps a reference to a
+    frame until it has been written so a new frame is started in the other
+    buffer */
+static struct telemetry_packet_t packets_g[2];
+/** Index of the frame which is being assembled */
+static uint8_t packet_index_g;
+/** Length of a frame which has been assembled but not yet accepted by the
+    radio driver, zero if there is no such frame */
+static uint8_t packet_length_g;
+
+/** Sequence number for the next frame */
+static uint16_t sequence_g;
 
 static uint8_t send_transaction;
 static uint8_t send_in_progress;
@@ -30,45 +105,287 @@ static uint8_t send_in_progress;
 
 void init_telemetry_service (struct rn2483_desc_t *radio,
                              struct ms5611_desc_t *altimeter,
-                             uint32_t telemetry_rate)
+                             struct flight_state_desc_t *flight_state,
+                             uint32_t telemetry_rate, uint16_t max_duty_cycle,
+                             uint8_t keyframe_interval, uint8_t fec_roots,
+                             uint8_t fec_depth)
 {
     telemetry_radio_g = radio;
     telemetry_altimeter_g = altimeter;
+    telemetry_flight_state_g = flight_state;
     rate_g = telemetry_rate;
+    max_duty_cycle_g = max_duty_cycle;
+    
+    init_telemetry_encoder(&encoder_g, keyframe_interval);
     
-    packet_g.start_delimiter = 0x52;
-    packet_g.payload_type = 0;
-    packet_g.length = sizeof packet_g.payload;
-    packet_g.end_delimiter = 0xcc;
+    // Forward error correction is only used if there would still be space for
+    // the longest possible sample in each frame
+    fec_parity_g = 0;
+    if ((fec_roots >= 2) && (fec_roots <= RS_MAX_ROOTS) && (fec_depth != 0) &&
+            ((fec_roots * fec_depth) <= (TELEMETRY_MAX_PAYLOAD -
+                                         TELEMETRY_CODEC_MAX_LEN))) {
+        init_rs_codec(&fec_g, fec_roots);
+        fec_depth_g = fec_depth;
+        fec_parity_g = fec_roots * fec_depth;
+    }
+    max_payload_g = TELEMETRY_MAX_PAYLOAD - fec_parity_g;
+    
+    for (uint8_t i = 0; i < 2; i++) {
+        packets_g[i].start_delimiter = TELEMETRY_START_DELIMITER;
+        packets_g[i].payload_type = TELEMETRY_PAYLOAD_COMPACT;
+    }
+    packet_index_g = 0;
+    packet_length_g = 0;
+    sequence_g = 0;
+    ring_head_g = 0;
+    ring_count_g = 0;
+    
+    // Assume the worst until some samples have been encoded
+    sample_length_avg_g = TELEMETRY_CODEC_MAX_LEN << 4;
+    
+    schedule_g.requested_period = 0;
+    schedule_g.samples_dropped = 0;
 }
 
-void telemetry_service (void)
+const struct telemetry_schedule_t *telemetry_get_schedule (void)
+{
+    return &schedule_g;
+}
+
+/**
+ *  Choose how many samples should be packed into each frame and how often
+ *  samples should be taken for a requested period.
+ *
+ *  The fewest samples per frame which allow the requested period to be met
+ *  within the duty cycle limit are used. If the period can not be met even
+ *  with as many samples as fit in a frame, full frames are sent as often as the
+ *  duty cycle allows. Frame lengths are estimated from the average length of
+ *  an encoded sample.
+ *
+ *  @param period The requested period in milliseconds
+ */
+static void telemetry_plan (uint32_t period)
 {
-    if (send_in_progress) {
-        if (rn2483_get_send_state(telemetry_radio_g, send_transaction) ==
-                RN2483_SEND_TRANS_PENDING) {
-            return;
+    uint16_t sample_length = (sample_length_avg_g + 15) >> 4;
+    uint8_t max_samples = max_payload_g / sample_length;
+    // Leave room in the ring for the next frame to be sampled while a frame is
+    // being sent
+    if (max_samples > (TELEMETRY_RING_LEN / 2)) {
+        max_samples = TELEMETRY_RING_LEN / 2;
+    }
+    uint32_t airtime = 0;
+    uint32_t min_period = 0;
+    uint8_t samples;
+    
+    for (samples = 1; samples <= max_samples; samples++) {
+        airtime = rn2483_get_airtime(telemetry_radio_g,
+                                     (uint8_t)(TELEMETRY_FRAME_OVERHEAD +
+                                               fec_parity_g +
+                                               (samples * sample_length)));
+        // Airtime is in microseconds and duty cycle in tenths of a percent, so
+        // this is the shortest frame period in milliseconds
+        min_period = ((airtime + max_duty_cycle_g - 1) / max_duty_cycle_g);
+        
+        if ((min_period <= (samples * period)) || (samples == max_samples)) {
+            break;
         }
-        rn2483_clear_send_transaction(telemetry_radio_g, send_transaction);
-        send_in_progress = 0;
     }
     
-    if (((millis - last_time_g) >= rate_g) && !telemetry_paused) {
-        last_time_g = millis;
+    uint32_t frame_period = samples * period;
+    if (frame_period < min_period) {
+        frame_period = min_period;
+    }
+    
+    schedule_g.requested_period = period;
+    schedule_g.sample_period = frame_period / samples;
+    schedule_g.frame_period = schedule_g.sample_period * samples;
+    schedule_g.frame_airtime = airtime;
+    // Microseconds over milliseconds gives tenths of a percent
+    schedule_g.utilisation = (uint16_t)(airtime / schedule_g.frame_period);
+    schedule_g.sample_length = (uint8_t)sample_length;
+    schedule_g.samples_per_frame = samples;
+}
+
+/**
+ *  Take a sample.
+ *
+ *  @param sample Pointer to where the sample will be stored
+ */
+static void telemetry_sample (struct telemetry_frame *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+    
+    sample->mission_time = millis;
+    sample->altimeter_temp = ms5611_get_temperature(telemetry_altimeter_g);
+    sample->altimeter_altitude = ((float)ms5611_get_altitude(
+                                            telemetry_altimeter_g)) / 1000.0f;
+    
+    sample->gps_utc_time = gnss_xa1110_descriptor.utc_time;
+    sample->gps_latitude = gnss_xa1110_descriptor.latitude;
+    sample->gps_longitude = gnss_xa1110_descriptor.longitude;
+    sample->gps_altitude = gnss_xa1110_descriptor.altitude;
+    sample->gps_speed = gnss_xa1110_descriptor.speed;
+    sample->gps_course = gnss_xa1110_descriptor.course;
+    sample->flags.gps_data_valid = gnss_xa1110_descriptor.last_fix != 0;
+    
+    if (telemetry_flight_state_g != NULL) {
+        enum flight_state state = flight_state_get_state(
+                                                    telemetry_flight_state_g);
+        
+        sample->flags.state_standby = state == FLIGHT_STATE_STANDBY;
+        sample->flags.state_pre_flight = state == FLIGHT_STATE_PRE_FLIGHT;
+        sample->flags.state_powered_ascent =
+                                        state == FLIGHT_STATE_POWERED_ASCENT;
+        sample->flags.state_coasting_ascent =
+                                        state == FLIGHT_STATE_COASTING_ASCENT;
+        sample->flags.state_descents = state == FLIGHT_STATE_DESCENT;
+        sample->flags.state_recovery = state == FLIGHT_STATE_RECOVERY;
+        sample->flags.parachute_deployed =
+                    flight_state_parachute_deployed(telemetry_flight_state_g);
+    }
+}
+
+/**
+ *  Get space in the ring for a new sample. If the ring is full the oldest
+ *  sample is discarded.
+ *
+ *  @return Pointer to where the sample should be stored
+ */
+static struct telemetry_frame *telemetry_ring_push (void)
+{
+    struct telemetry_frame *sample = ring_g + ring_head_g;
+    ring_head_g = (ring_head_g + 1) & (TELEMETRY_RING_LEN - 1);
+    
+    if (ring_count_g == TELEMETRY_RING_LEN) {
+        schedule_g.samples_dropped++;
+    } else {
+        ring_count_g++;
+    }
+    
+    return sample;
+}
+
+/**
+ *  Get the oldest sample in the ring.
+ */
+static inline struct telemetry_frame *telemetry_ring_tail (void)
+{
+    return ring_g + ((ring_head_g - ring_count_g) & (TELEMETRY_RING_LEN - 1));
+}
+
+/**
+ *  Pass the assembled frame to the radio driver. The frame is kept until the
+ *  driver accepts it, so if the driver's send queue is full it is sent again
+ *  on a later run of the service instead of a new frame being assembled over
+ *  it.
+ */
+static void telemetry_start_send (void)
+{
+    const uint8_t *packet = (const uint8_t*)(packets_g + packet_index_g);
+    enum rn2483_operation_result result = rn2483_send(telemetry_radio_g,
+                                                      packet, packet_length_g,
+                                                      &send_transaction);
+    if (result == RN2483_OP_BUSY) {
+        // Try again later
+        return;
+    } else if (result == RN2483_OP_SUCCESS) {
+        send_in_progress = 1;
+        packet_index_g ^= 1;
+    } else {
+        // The frame can never be sent, the samples after it must not be
+        // encoded against the ones which were lost with it
+        telemetry_encoder_force_keyframe(&encoder_g);
+    }
+    packet_length_g = 0;
+}
+
+/**
+ *  Encode as many samples from the ring as fit into a frame, oldest first, and
+ *  send the frame. All of the samples in the frame share the time base of the
+ *  first sample.
+ */
+static void telemetry_send_frame (void)
+{
+    struct telemetry_packet_t *packet = packets_g + packet_index_g;
+    
+    packet->time_base = telemetry_ring_tail()->mission_time;
+    packet->num_samples = 0;
+    uint8_t used = 0;
+    
+    while (ring_count_g != 0) {
+        // If the sample doesn't fit it must be encoded again for the next
+        // frame, so keep the encoder state to undo encoding it
+        struct telemetry_encoder_t saved = encoder_g;
+        uint8_t encoded[TELEMETRY_CODEC_MAX_LEN];
+        uint8_t length = telemetry_encode(&encoder_g, telemetry_ring_tail(),
+                                          packet->time_base, encoded);
         
-        packet_g.payload.mission_time = millis;
-        packet_g.payload.altimeter_temp = ms5611_get_temperature(telemetry_altimeter_g);
-        packet_g.payload.altimeter_altitude = ms5611_get_altitude(telemetry_altimeter_g);
+        if ((used + length) > max_payload_g) {
+            encoder_g = saved;
+            break;
+        }
         
-        packet_g.payload.gps_utc_time = gnss_xa1110_descriptor.utc_time;
-        packet_g.payload.gps_latitude = gnss_xa1110_descriptor.latitude;
-        packet_g.payload.gps_longitude = gnss_xa1110_descriptor.longitude;
-        packet_g.payload.gps_altitude = gnss_xa1110_descriptor.altitude;
-        packet_g.payload.gps_speed = gnss_xa1110_descriptor.speed;
-        packet_g.payload.gps_course = gnss_xa1110_descriptor.course;
-        packet_g.payload.flags.gps_data_valid = gnss_xa1110_descriptor.last_fix != 0;
+        memcpy(packet->payload + used, encoded, length);
+        used += length;
+        packet->num_samples++;
+        ring_count_g--;
         
-        rn2483_send(telemetry_radio_g, (uint8_t*)(&packet_g), sizeof packet_g,
-                    &send_transaction);
+        // Keep track of the average length for planning
+        int16_t error = (int16_t)((length << 4) - sample_length_avg_g);
+        sample_length_avg_g = (uint16_t)(sample_length_avg_g + (error >> 3));
+    }
+    
+    packet->payload[used] = TELEMETRY_END_DELIMITER;
+    packet->length = (uint16_t)(sizeof(packet->time_base) +
+                                sizeof(packet->num_samples) + used);
+    
+    // The CRC follows the end delimiter and the parity bytes follow the CRC
+    uint8_t frame_length = telemetry_link_seal((uint8_t*)packet,
+                                               (TELEMETRY_FRAME_OVERHEAD -
+                                                TELEMETRY_LINK_CRC_LEN) + used,
+                                               sequence_g++);
+    if (fec_parity_g != 0) {
+        rs_encode(&fec_g, (uint8_t*)packet, frame_length,
+                  (uint8_t*)packet + frame_length, fec_depth_g);
+    }
+    
+    packet_length_g = frame_length + fec_parity_g;
+    telemetry_start_send();
+}
+
+void telemetry_service (void)
+{
+    if (send_in_progress && (rn2483_get_send_state(telemetry_radio_g,
+                                                   send_transaction) !=
+                             RN2483_SEND_TRANS_PENDING)) {
+        rn2483_clear_send_transaction(telemetry_radio_g, send_transaction);
+        send_in_progress = 0;
+    }
+    
+    uint32_t rate = rate_g;
+    if (telemetry_flight_state_g != NULL) {
+        rate = flight_state_get_telemetry_period(telemetry_flight_state_g);
+    }
+    
+    if (rate != schedule_g.requested_period) {
+        telemetry_plan(rate);
+    }
+    
+    // Samples are taken on schedule whether or not a frame is being sent
+    if (((millis - last_time_g) >= schedule_g.sample_period) &&
+            !telemetry_paused) {
+        last_time_g = millis;
+        telemetry_sample(telemetry_ring_push());
+    }
+    
+    if (!send_in_progress && (packet_length_g != 0)) {
+        // The last frame has not been accepted by the radio driver yet
+        telemetry_start_send();
+    } else if (!send_in_progress &&
+            (ring_count_g >= schedule_g.samples_per_frame)) {
+        telemetry_send_frame();
+        // Plan again after each frame in case the radio settings or the length
+        // of samples have changed
+        telemetry_plan(rate);
     }
 }
@@ -16,13 +16,79 @@
 
 #include "ms5611.h"
 #include "gnss-xa1110.h"
+#include "flight-state.h"
 
 extern uint8_t telemetry_paused;
 
+/**
+ *  Schedule on which telemetry is sent.
+ */
+struct telemetry_schedule_t {
+    /** Period in milliseconds at which telemetry has been requested */
+    uint32_t requested_period;
+    /** Period in milliseconds at which samples are taken */
+    uint32_t sample_period;
+    /** Period in milliseconds at which frames are sent */
+    uint32_t frame_period;
+    /** Time on air for each frame in microseconds */
+    uint32_t frame_airtime;
+    /** Fraction of the time for which the radio is transmitting, in tenths of
+        a percent */
+    uint16_t utilisation;
+    /** Average length of an encoded sample in bytes */
+    uint8_t sample_length;
+    /** Number of samples packed into each frame */
+    uint8_t samples_per_frame;
+    /** Number of samples which were discarded because they could not be sent
+        before the ring of samples waiting to be sent filled up */
+    uint32_t samples_dropped;
+};
+
+/**
+ *  Initialize the telemetry service.
+ *
+ *  @param radio The radio with which telemetry is sent
+ *  @param altimeter The altimeter from which altitude is taken
+ *  @param flight_state The flight state machine from which the state flags and
+ *                      telemetry rate are taken, may be NULL
+ *  @param telemetry_rate The period in milliseconds at which telemetry is sent
+ *                        if flight_state is NULL
+ *  @param max_duty_cycle The maximum fraction of the time for which the radio
+ *                        may transmit, in tenths of a percent from 1 to 1000
+ *  @param keyframe_interval The number of samples between keyframes, all other
+ *                           samples are sent as differences from the last
+ *                           keyframe
+ *  @param fec_roots The number of Reed-Solomon parity bytes for each codeword
+ *                   or zero to send frames without forward error correction
+ *  @param fec_depth The number of interleaved codewords in each frame
+ */
 extern void init_telemetry_service (struct rn2483_desc_t *radio,
                                     struct ms5611_desc_t *altimeter,
-                                    uint32_t telemetry_rate);
+                                    struct flight_state_desc_t *flight_state,
+                                    uint32_t telemetry_rate,
+                                    uint16_t max_duty_cycle,
+                                    uint8_t keyframe_interval,
+                                    uint8_t fec_roots, uint8_t fec_depth);
 
+/**
+ *  Service to be run in each iteration of the main loop.
+ *
+ *  Samples are taken at the requested period if the radio's duty cycle allows
+ *  it and are kept in a ring until they are sent, so sampling continues while
+ *  a frame is being transmitted. When the time on air for a frame is short
+ *  compared to the period, several samples are packed into each frame so that
+ *  fewer frames need to be sent. The samples in a frame are encoded with the
+ *  telemetry codec against a time base in the frame header. If the requested
+ *  period can not be met, samples are taken as often as the duty cycle
+ *  allows.
+ */
 extern void telemetry_service (void);
 
+/**
+ *  Get the schedule on which telemetry is currently being sent.
+ *
+ *  @return The current schedule
+ */
+extern const struct telemetry_schedule_t *telemetry_get_schedule (void);
+
 #endif /* telemetry_h */
@@ -11,6 +11,9 @@
 
 #include "usb-cdc-standard.h"
 #include "usb.h"
+#ifdef ENABLE_USB_VENDOR
+#include "usb-vendor.h"
+#endif
 
 #include "circular-buffer.h"
 
@@ -18,27 +21,31 @@
 
 
 // MARK: Static variables
-/** Buffers for notification endpoints */
-__attribute__((__aligned__(4)))
-static uint8_t notification_buffers_g[USB_CDC_HIGHEST_PORT + 1][8];
-/** Buffers for data out endpoints */
-__attribute__((__aligned__(4)))
-static uint8_t out_buffers_g[USB_CDC_HIGHEST_PORT + 1][USB_CDC_DATA_EP_SIZE];
-/** Buffers for data in endpoints */
+/** Buffers for data out endpoints, each port has two so that data can be
+    received into one while the data in the other is handled */
 __attribute__((__aligned__(4)))
-static uint8_t align_buffers_g[USB_CDC_HIGHEST_PORT + 1][4];
+static uint8_t out_buffers_g[USB_CDC_HIGHEST_PORT + 1][2][USB_CDC_DATA_EP_SIZE];
 
 /** Global flags */
 static struct {
     uint8_t initialized:3;
-    uint8_t in_ongoing:3;
+    uint8_t out_buffer:3;
     uint8_t echo:3;
 } usb_cdc_flags_g;
 
-/** Lengths by which buffer heads need to be moved in in complete callbacks */
-static uint16_t in_lengths[USB_CDC_HIGHEST_PORT + 1];
+/** Number of in transactions queued on each port, at most one for each bank of
+    the data in endpoint */
+static uint8_t in_queued_g[USB_CDC_HIGHEST_PORT + 1];
+/** Lengths by which buffer heads need to be moved in in complete callbacks,
+    for each queued in transaction from oldest to newest, including any bytes
+    skipped to align the next transaction */
+static uint16_t in_lengths[USB_CDC_HIGHEST_PORT + 1][2];
 
 #define USB_CDC_CIRC_BUFF_SIZE  128
+/** Size of the transmit buffers, each in transaction can send up to this many
+    bytes in multiple packets. Must be a multiple of 4 so that transactions
+    which end at the end of the buffer leave the next one aligned. */
+#define USB_CDC_TX_BUFF_SIZE    512
 /** Receive circual buffers */
 static struct circular_buffer_t rx_circ_buffs_g[USB_CDC_HIGHEST_PORT + 1];
 /** Transmit circulat buffers */
@@ -48,7 +55,7 @@ static struct circular_buffer_t tx_circ_buffs_g[USB_CDC_HIGHEST_PORT + 1];
 static uint8_t rx_buffs_g[USB_CDC_HIGHEST_PORT + 1][USB_CDC_CIRC_BUFF_SIZE];
 /** Buffers for data to be transmitted */
 __attribute__((__aligned__(4)))
-static uint8_t tx_buffs_g[USB_CDC_HIGHEST_PORT + 1][USB_CDC_CIRC_BUFF_SIZE];
+static uint8_t tx_buffs_g[USB_CDC_HIGHEST_PORT + 1][USB_CDC_TX_BUFF_SIZE];
 
 /** Callback functions for when CDC interface becomes ready */
 static void (*usb_cdc_ready_callbacks[USB_CDC_HIGHEST_PORT + 1]) (void *);
@@ -56,107 +63,150 @@ static void (*usb_cdc_ready_callbacks[USB_CDC_HIGHEST_PORT + 1]) (void *);
 static void *usb_cdc_callback_contexts[USB_CDC_HIGHEST_PORT + 1];
 
 
-// MARK: Service function
+// MARK: Endpoint helpers
 /**
- *  Service function which starts a new USB in transaction if there is data to
- *  be send.
+ *  Start an in transaction on the data in endpoint of a port.
  *
- *  @param port The port for which the service should be run
+ *  @param port The port on which the transaction should be started
+ *  @param data The data to be sent
+ *  @param length The number of bytes to be sent
+ *
+ *  @return 0 if the transaction was started, 1 otherwise
  */
-static void usb_cdc_service (uint8_t port)
+static uint8_t usb_cdc_start_in (uint8_t port, const uint8_t *data,
+                                 uint16_t length)
 {
-    if (!(usb_cdc_flags_g.in_ongoing & (1 << port))) {
-        /* We are not currently sending data */
-        // Find the head of the tx buffer
-        uint8_t *head;
-        uint16_t len = circular_buffer_get_head(tx_circ_buffs_g + port, &head);
-        if (!len) {
-            // No data to be sent
-            return;
-        }
-        /* Check alignment of head */
-        if ((uintptr_t)head & 0x3) {
-            /* Head is not 4 byte aligned */
-            // Copy however many bytes we need to to align the head into our
-            // aligned buffer
-            uint8_t i = 0;
-            uint8_t result = 0;
-            do {
-                result = circular_buffer_pop(tx_circ_buffs_g + port,
-                                             align_buffers_g[port] + i);
-                (uintptr_t)head++;
-                i += !result;
-            } while (!result && ((uintptr_t)head & 0x3) && (i < len));
-            // Make head point to our align buffer so that we will transmit
-            // from there instead of from the circular buffer
-            head = align_buffers_g[port];
-            // Update len to the number of bytes that need to be sent from the
-            // align buffer
-            len = i;
-            // Since we popped the bytes from the circular buffer, the head has
-            // already been moved, it doesn't need to be moved again when the
-            // in is complete
-            in_lengths[port] = 0;
-        } else {
-            /* Head is 4 byte aligned */
-            // Record by how much the head of the circular buffer needs to be
-            // moved in the in complete callback
-            in_lengths[port] = len;
-        }
-        usb_cdc_flags_g.in_ongoing |= (1 << port);
-        /* Start transmitting data from head */
 #ifdef ENABLE_USB_CDC_PORT_0
-        if (port == 0) {
-            usb_start_in(USB_CDC_DATA_IN_ENDPOINT_0, head, len, 1);
-        }
+    if (port == 0) {
+        return usb_start_in(USB_CDC_DATA_IN_ENDPOINT_0, data, length, 1);
+    }
 #endif
 #ifdef ENABLE_USB_CDC_PORT_1
-        else if (port == 1) {
-            usb_start_in(USB_CDC_DATA_IN_ENDPOINT_1, head, len, 1);
-        }
+    if (port == 1) {
+        return usb_start_in(USB_CDC_DATA_IN_ENDPOINT_1, data, length, 1);
+    }
 #endif
 #ifdef ENABLE_USB_CDC_PORT_2
-        else if (port == 2) {
-            usb_start_in(USB_CDC_DATA_IN_ENDPOINT_2, head, len, 1);
-        }
-#endif
+    if (port == 2) {
+        return usb_start_in(USB_CDC_DATA_IN_ENDPOINT_2, data, length, 1);
     }
+#endif
+    return 1;
 }
 
-// MARK: USB Callbacks
-
-#ifdef ENABLE_USB_CDC_PORT_0
-static void notification_0_out_complete (uint16_t length)
+/**
+ *  Start an out transaction on the data out endpoint of a port into the out
+ *  buffer which is not in use.
+ *
+ *  @param port The port on which the transaction should be started
+ */
+static void usb_cdc_start_out (uint8_t port)
 {
-    // Ignore anything on the notification endpoint
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_0, notification_buffers_g[0],
-                  8);
-}
+    usb_cdc_flags_g.out_buffer ^= (1 << port);
+    uint8_t *buffer = out_buffers_g[port][!!(usb_cdc_flags_g.out_buffer &
+                                             (1 << port))];
+#ifdef ENABLE_USB_CDC_PORT_0
+    if (port == 0) {
+        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_0, buffer,
+                      USB_CDC_DATA_EP_SIZE);
+    }
 #endif
-
 #ifdef ENABLE_USB_CDC_PORT_1
-static void notification_1_out_complete (uint16_t length)
-{
-    // Ignore anything on the notification endpoint
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_0, notification_buffers_g[1],
-                  8);
-}
+    if (port == 1) {
+        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_1, buffer,
+                      USB_CDC_DATA_EP_SIZE);
+    }
 #endif
-
 #ifdef ENABLE_USB_CDC_PORT_2
-static void notification_2_out_complete (uint16_t length)
+    if (port == 2) {
+        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_2, buffer,
+                      USB_CDC_DATA_EP_SIZE);
+    }
+#endif
+}
+
+// MARK: Service function
+/**
+ *  Service function which queues new USB in transactions if there is data to
+ *  be sent. Up to two transactions are queued, so that the next is ready as
+ *  soon as the hardware finishes sending the current one.
+ *
+ *  The USB can only send from 4 byte aligned memory, so every transaction
+ *  starts on a word boundary in the transmit buffer. When a transaction ends
+ *  part way through a word the tail of the buffer is moved past the rest of
+ *  the word, and those bytes are skipped along with the transaction when it
+ *  completes.
+ *
+ *  This function is run both from the main loop and from the in complete
+ *  callback, which also changes the queued transactions, so the USB interrupt
+ *  is masked while transactions are queued.
+ *
+ *  @param port The port for which the service should be run
+ */
+static void usb_cdc_service (uint8_t port)
 {
-    // Ignore anything on the notification endpoint
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_0, notification_buffers_g[2],
-                  8);
+    struct circular_buffer_t *buffer = tx_circ_buffs_g + port;
+    
+    NVIC_DisableIRQ(USB_IRQn);
+    __DSB();
+    __ISB();
+    
+    while (in_queued_g[port] < 2) {
+        /* Find the data after any which has already been queued */
+        uint8_t *start;
+        uint16_t queued = in_lengths[port][0] + in_lengths[port][1];
+        uint16_t len = circular_buffer_get_after_head(buffer, queued, &start);
+        if (!len) {
+            // No data to be sent
+            break;
+        }
+        
+        /* Keep the start of the next transaction aligned */
+        // The end of the buffer is aligned, so only a transaction which ends
+        // at the tail can end part way through a word
+        uint8_t pad = (uint8_t)(-(uintptr_t)(start + len) & 0x3);
+        if (pad && (circular_buffer_unused(buffer) < pad) && (len > 0x3)) {
+            // No space to skip the rest of the word, send only the whole
+            // words for now
+            len &= ~0x3;
+            pad = 0;
+        } else if (pad && (circular_buffer_unused(buffer) < pad)) {
+            // Wait for space
+            break;
+        }
+        
+        /* Start transmitting data */
+        if (usb_cdc_start_in(port, start, len)) {
+            // Both banks are still in use, try again when one completes
+            break;
+        }
+        
+        if (pad) {
+            // Skip the rest of the word
+            circular_buffer_move_tail(buffer, pad);
+        }
+        // Record by how much the head of the circular buffer needs to be
+        // moved in the in complete callback
+        in_lengths[port][in_queued_g[port]++] = len + pad;
+    }
+    
+    NVIC_EnableIRQ(USB_IRQn);
 }
-#endif
+
+// MARK: USB Callbacks
 
 static void data_out_complete (uint8_t port, uint16_t length)
 {
+    // Start receiving into the other out buffer right away so that the host
+    // does not have to wait while the received data is handled
+    const uint8_t *out_buffer = out_buffers_g[port][
+                                        !!(usb_cdc_flags_g.out_buffer &
+                                           (1 << port))];
+    usb_cdc_start_out(port);
+    
     // Copy data from out_buffers_g to rx_circ_buff_g and echo as required
     for (uint16_t i = 0; i < length; i++) {
-        uint8_t data = out_buffers_g[port][i];
+        uint8_t data = out_buffer[i];
         uint8_t full = 0;
         
         if (usb_cdc_flags_g.echo & (1 << port)) {
@@ -184,36 +234,24 @@ static void data_out_complete (uint8_t port, uint16_t length)
             circular_buffer_push(rx_circ_buffs_g + port, data);
         }
     }
-    
-#ifdef ENABLE_USB_CDC_PORT_0
-    if (port == 0) {
-        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_0, out_buffers_g[0],
-                      USB_CDC_DATA_EP_SIZE);
-    }
-#endif
-#ifdef ENABLE_USB_CDC_PORT_1
-    else if (port == 1) {
-        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_1, out_buffers_g[1],
-                      USB_CDC_DATA_EP_SIZE);
-    }
-#endif
-#ifdef ENABLE_USB_CDC_PORT_2
-    else if (port == 2) {
-        usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_2, out_buffers_g[2],
-                      USB_CDC_DATA_EP_SIZE);
+}
+
+static void data_in_complete (uint8_t port)
+{
+    // Transactions complete in the order in which they were queued
+    if (in_lengths[port][0]) {
+        circular_buffer_move_head(tx_circ_buffs_g + port, in_lengths[port][0]);
     }
-#endif
+    in_lengths[port][0] = in_lengths[port][1];
+    in_lengths[port][1] = 0;
+    in_queued_g[port]--;
+    usb_cdc_service(port);
 }
 
 #ifdef ENABLE_USB_CDC_PORT_0
 static void data_0_in_complete (void)
 {
-    if (in_lengths[0]) {
-        circular_buffer_move_head(tx_circ_buffs_g + 0, in_lengths[0]);
-        in_lengths[0] = 0;
-    }
-    usb_cdc_flags_g.in_ongoing &= ~(1 << 0);
-    usb_cdc_service(0);
+    data_in_complete(0);
 }
 
 static void data_0_out_complete (uint16_t length)
@@ -225,12 +263,7 @@ static void data_0_out_complete (uint16_t length)
 #ifdef ENABLE_USB_CDC_PORT_1
 static void data_1_in_complete (void)
 {
-    if (in_lengths[1]) {
-        circular_buffer_move_head(tx_circ_buffs_g + 1, in_lengths[1]);
-        in_lengths[1] = 0;
-    }
-    usb_cdc_flags_g.in_ongoing &= ~(1 << 1);
-    usb_cdc_service(1);
+    data_in_complete(1);
 }
 
 static void data_1_out_complete (uint16_t length)
@@ -242,12 +275,7 @@ static void data_1_out_complete (uint16_t length)
 #ifdef ENABLE_USB_CDC_PORT_2
 static void data_2_in_complete (void)
 {
-    if (in_lengths[2]) {
-        circular_buffer_move_head(tx_circ_buffs_g + 2, in_lengths[2]);
-        in_lengths[2] = 0;
-    }
-    usb_cdc_flags_g.in_ongoing &= ~(1 << 2);
-    usb_cdc_service(2);
+    data_in_complete(2);
 }
 
 static void data_2_out_complete (uint16_t length)
@@ -268,21 +296,22 @@ void usb_cdc_enable_config_callback (void)
     init_circular_buffer(rx_circ_buffs_g + 0, rx_buffs_g[0],
                          USB_CDC_CIRC_BUFF_SIZE);
     init_circular_buffer(tx_circ_buffs_g + 0, tx_buffs_g[0],
-                         USB_CDC_CIRC_BUFF_SIZE);
+                         USB_CDC_TX_BUFF_SIZE);
+    in_queued_g[0] = 0;
+    in_lengths[0][0] = 0;
+    in_lengths[0][1] = 0;
     /* Enable endpoints for CDC ACM interface 0 */
-    usb_enable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_0,
-                            USB_CDC_NOTIFICATION_EP_SIZE,
-                            USB_ENDPOINT_TYPE_INTERRUPT,
-                            &notification_0_out_complete);
-    usb_enable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_0, USB_CDC_DATA_EP_SIZE,
-                           USB_ENDPOINT_TYPE_INTERRUPT, &data_0_in_complete);
+    usb_enable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_0,
+                           USB_CDC_NOTIFICATION_EP_SIZE,
+                           USB_ENDPOINT_TYPE_INTERRUPT, NULL);
+    usb_enable_endpoint_in_dual_bank(USB_CDC_DATA_IN_ENDPOINT_0,
+                                     USB_CDC_DATA_EP_SIZE,
+                                     USB_ENDPOINT_TYPE_INTERRUPT,
+                                     &data_0_in_complete);
     usb_enable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_0, USB_CDC_DATA_EP_SIZE,
                             USB_ENDPOINT_TYPE_INTERRUPT, &data_0_out_complete);
     /* Start endpoints for interface 0 */
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_0, notification_buffers_g[0],
-                  USB_CDC_NOTIFICATION_EP_SIZE);
-    usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_0, out_buffers_g[0],
-                  USB_CDC_DATA_EP_SIZE);
+    usb_cdc_start_out(0);
     /* Mark port as initialized */
     usb_cdc_flags_g.initialized |= (1 << 0);
     /* Call ready callback for interface 0 */
@@ -299,20 +328,22 @@ void usb_cdc_enable_config_callback (void)
     init_circular_buffer(rx_circ_buffs_g + 1, rx_buffs_g[1],
                          USB_CDC_CIRC_BUFF_SIZE);
     init_circular_buffer(tx_circ_buffs_g + 1, tx_buffs_g[1],
-                         USB_CDC_CIRC_BUFF_SIZE);
+                         USB_CDC_TX_BUFF_SIZE);
+    in_queued_g[1] = 0;
+    in_lengths[1][0] = 0;
+    in_lengths[1][1] = 0;
     /* Enable endpoints for CDC ACM interface 1 */
-    usb_enable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_1, 8,
-                            USB_ENDPOINT_TYPE_INTERRUPT,
-                            &notification_1_out_complete);
-    usb_enable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_1, USB_CDC_DATA_EP_SIZE,
-                           USB_ENDPOINT_TYPE_INTERRUPT, &data_1_in_complete);
+    usb_enable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_1,
+                           USB_CDC_NOTIFICATION_EP_SIZE,
+                           USB_ENDPOINT_TYPE_INTERRUPT, NULL);
+    usb_enable_endpoint_in_dual_bank(USB_CDC_DATA_IN_ENDPOINT_1,
+                                     USB_CDC_DATA_EP_SIZE,
+                                     USB_ENDPOINT_TYPE_INTERRUPT,
+                                     &data_1_in_complete);
     usb_enable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_1, USB_CDC_DATA_EP_SIZE,
                             USB_ENDPOINT_TYPE_INTERRUPT, &data_1_out_complete);
     /* Start endpoints for interface 1 */
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_1, notification_buffers_g[1],
-                  8);
-    usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_1, out_buffers_g[1],
-                  USB_CDC_DATA_EP_SIZE);
+    usb_cdc_start_out(1);
     /* Mark port as initialized */
     usb_cdc_flags_g.initialized |= (1 << 1);
     /* Call ready callback for interface 1 */
@@ -329,20 +360,22 @@ void usb_cdc_enable_config_callback (void)
     init_circular_buffer(rx_circ_buffs_g + 2, rx_buffs_g[2],
                          USB_CDC_CIRC_BUFF_SIZE);
     init_circular_buffer(tx_circ_buffs_g + 2, tx_buffs_g[2],
-                         USB_CDC_CIRC_BUFF_SIZE);
+                         USB_CDC_TX_BUFF_SIZE);
+    in_queued_g[2] = 0;
+    in_lengths[2][0] = 0;
+    in_lengths[2][1] = 0;
     /* Enable endpoints for CDC ACM interface 2 */
-    usb_enable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_2, 8,
-                            USB_ENDPOINT_TYPE_INTERRUPT,
-                            &notification_2_out_complete);
-    usb_enable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_2, USB_CDC_DATA_EP_SIZE,
-                           USB_ENDPOINT_TYPE_INTERRUPT, &data_2_in_complete);
+    usb_enable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_2,
+                           USB_CDC_NOTIFICATION_EP_SIZE,
+                           USB_ENDPOINT_TYPE_INTERRUPT, NULL);
+    usb_enable_endpoint_in_dual_bank(USB_CDC_DATA_IN_ENDPOINT_2,
+                                     USB_CDC_DATA_EP_SIZE,
+                                     USB_ENDPOINT_TYPE_INTERRUPT,
+                                     &data_2_in_complete);
     usb_enable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_2, USB_CDC_DATA_EP_SIZE,
                             USB_ENDPOINT_TYPE_INTERRUPT, &data_2_out_complete);
     /* Start endpoints for interface 2 */
-    usb_start_out(USB_CDC_NOTIFICATION_ENDPOINT_2, notification_buffers_g[2],
-                  8);
-    usb_start_out(USB_CDC_DATA_OUT_ENDPOINT_2, out_buffers_g[2],
-                  USB_CDC_DATA_EP_SIZE);
+    usb_cdc_start_out(2);
     /* Mark port as initialized */
     usb_cdc_flags_g.initialized |= (1 << 2);
     /* Call ready callback for interface 2 */
@@ -350,26 +383,32 @@ void usb_cdc_enable_config_callback (void)
         usb_cdc_ready_callbacks[2](usb_cdc_callback_contexts[2]);
     }
 #endif
+#ifdef ENABLE_USB_VENDOR
+    /* Enable endpoints for vendor interface */
+    usb_vendor_enable_config_callback();
+#endif
 }
 
 void usb_cdc_disable_config_callback (void)
 {
 #ifdef ENABLE_USB_CDC_PORT_0
-    usb_disable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_0);
+    usb_disable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_0);
     usb_disable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_0);
     usb_disable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_0);
 #endif
 #ifdef ENABLE_USB_CDC_PORT_1
-    usb_disable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_1);
+    usb_disable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_1);
     usb_disable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_1);
     usb_disable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_1);
 #endif
 #ifdef ENABLE_USB_CDC_PORT_2
-    usb_disable_endpoint_out(USB_CDC_NOTIFICATION_ENDPOINT_2);
+    usb_disable_endpoint_in(USB_CDC_NOTIFICATION_ENDPOINT_2);
     usb_disable_endpoint_in(USB_CDC_DATA_IN_ENDPOINT_2);
     usb_disable_endpoint_out(USB_CDC_DATA_OUT_ENDPOINT_2);
 #endif
-    usb_cdc_flags_g.in_ongoing = 0;
+#ifdef ENABLE_USB_VENDOR
+    usb_vendor_disable_config_callback();
+#endif
     usb_cdc_flags_g.initialized = 0;
 }
 
@@ -515,12 +554,14 @@ void usb_cdc_put_bytes_blocking(uint8_t port, const uint8_t *bytes,
 
 void usb_cdc_put_char (uint8_t port, const char c)
 {
-    circular_buffer_push(tx_circ_buffs_g + port, (uint8_t)c);
+    // Data which has been queued for transmission must not be overwritten, so
+    // the character is dropped if the buffer is full
+    circular_buffer_try_push(tx_circ_buffs_g + port, (uint8_t)c);
     
     if (c == '\n') {
         // Add carriage return as some terminal emulators seem to think that
         // they are typewriters.
-        circular_buffer_push(tx_circ_buffs_g + port, (uint8_t)'\r');
+        circular_buffer_try_push(tx_circ_buffs_g + port, (uint8_t)'\r');
     }
     
     // Make sure that we start transmition right away if there is no transmition
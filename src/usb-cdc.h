@@ -18,25 +18,29 @@
 #define USB_CDC_NOTIFICATION_EP_SIZE    64
 #define USB_CDC_DATA_EP_SIZE            64
 
+// The data in endpoint of each port uses both banks of its endpoint number, so
+// the data out endpoint shares an endpoint number with the notification
+// endpoint, which is only used for in.
+
 #ifdef ENABLE_USB_CDC_PORT_0
 #define USB_CDC_FIRST_INTERFACE_0 0
 #define USB_CDC_NOTIFICATION_ENDPOINT_0 1
 #define USB_CDC_DATA_IN_ENDPOINT_0  2
-#define USB_CDC_DATA_OUT_ENDPOINT_0 2
+#define USB_CDC_DATA_OUT_ENDPOINT_0 1
 #endif
 
 #ifdef ENABLE_USB_CDC_PORT_1
 #define USB_CDC_FIRST_INTERFACE_1 2
 #define USB_CDC_NOTIFICATION_ENDPOINT_1 3
 #define USB_CDC_DATA_IN_ENDPOINT_1  4
-#define USB_CDC_DATA_OUT_ENDPOINT_1 4
+#define USB_CDC_DATA_OUT_ENDPOINT_1 3
 #endif
 
 #ifdef ENABLE_USB_CDC_PORT_2
 #define USB_CDC_FIRST_INTERFACE_2 4
 #define USB_CDC_NOTIFICATION_ENDPOINT_2 5
 #define USB_CDC_DATA_IN_ENDPOINT_2  6
-#define USB_CDC_DATA_OUT_ENDPOINT_2 6
+#define USB_CDC_DATA_OUT_ENDPOINT_2 5
 #endif
 
 #ifdef ENABLE_USB_CDC_PORT_0
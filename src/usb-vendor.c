@@ -0,0 +1,127 @@
+/**
+ * @file usb-vendor.c
+ * @desc USB vendor specific bulk interface
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "usb-vendor.h"
+
+#include "usb.h"
+
+
+// MARK: Static variables
+/** Global flags */
+static struct {
+    uint8_t initialized:1;
+    uint8_t in_ongoing:1;
+    uint8_t out_ongoing:1;
+} usb_vendor_flags_g;
+
+/** Buffer into which data is being received */
+static uint8_t *usb_vendor_out_buffer_g;
+
+/** Callback for when an in transaction is complete */
+static void (*usb_vendor_in_callback_g)(void*);
+/** Callback for when an out transaction is complete */
+static void (*usb_vendor_out_callback_g)(void*, uint8_t*, uint16_t);
+/** Context information to be provided to callbacks */
+static void *usb_vendor_callback_context_g;
+
+
+// MARK: USB Callbacks
+
+static void usb_vendor_in_complete (void)
+{
+    usb_vendor_flags_g.in_ongoing = 0;
+    
+    if (usb_vendor_in_callback_g != NULL) {
+        usb_vendor_in_callback_g(usb_vendor_callback_context_g);
+    }
+}
+
+static void usb_vendor_out_complete (uint16_t length)
+{
+    usb_vendor_flags_g.out_ongoing = 0;
+    
+    if (usb_vendor_out_callback_g != NULL) {
+        usb_vendor_out_callback_g(usb_vendor_callback_context_g,
+                                  usb_vendor_out_buffer_g, length);
+    }
+}
+
+void usb_vendor_enable_config_callback (void)
+{
+    usb_enable_endpoint_in(USB_VENDOR_IN_ENDPOINT, USB_VENDOR_EP_SIZE,
+                           USB_ENDPOINT_TYPE_BULK, &usb_vendor_in_complete);
+    usb_enable_endpoint_out(USB_VENDOR_OUT_ENDPOINT, USB_VENDOR_EP_SIZE,
+                            USB_ENDPOINT_TYPE_BULK, &usb_vendor_out_complete);
+    
+    usb_vendor_flags_g.in_ongoing = 0;
+    usb_vendor_flags_g.out_ongoing = 0;
+    usb_vendor_flags_g.initialized = 1;
+}
+
+void usb_vendor_disable_config_callback (void)
+{
+    usb_disable_endpoint_in(USB_VENDOR_IN_ENDPOINT);
+    usb_disable_endpoint_out(USB_VENDOR_OUT_ENDPOINT);
+    
+    usb_vendor_flags_g.in_ongoing = 0;
+    usb_vendor_flags_g.out_ongoing = 0;
+    usb_vendor_flags_g.initialized = 0;
+}
+
+
+// MARK: External functions
+
+void usb_vendor_set_callbacks (void (*in_callback)(void*),
+                               void (*out_callback)(void*, uint8_t*, uint16_t),
+                               void *context)
+{
+    usb_vendor_in_callback_g = in_callback;
+    usb_vendor_out_callback_g = out_callback;
+    usb_vendor_callback_context_g = context;
+}
+
+uint8_t usb_vendor_is_ready (void)
+{
+    return usb_vendor_flags_g.initialized;
+}
+
+uint8_t usb_vendor_send_busy (void)
+{
+    return usb_vendor_flags_g.in_ongoing;
+}
+
+uint8_t usb_vendor_send (const uint8_t *data, uint16_t length)
+{
+    if (!usb_vendor_flags_g.initialized || usb_vendor_flags_g.in_ongoing ||
+            ((uintptr_t)data & 0x3) || (length > USB_VENDOR_MAX_LENGTH)) {
+        return 1;
+    }
+    
+    usb_vendor_flags_g.in_ongoing = 1;
+    if (usb_start_in(USB_VENDOR_IN_ENDPOINT, data, length, 1)) {
+        usb_vendor_flags_g.in_ongoing = 0;
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t usb_vendor_receive (uint8_t *buffer, uint16_t length)
+{
+    if (!usb_vendor_flags_g.initialized || usb_vendor_flags_g.out_ongoing ||
+            ((uintptr_t)buffer & 0x3) || (length == 0) ||
+            (length & (USB_VENDOR_EP_SIZE - 1)) ||
+            (length > USB_VENDOR_MAX_LENGTH)) {
+        return 1;
+    }
+    
+    usb_vendor_out_buffer_g = buffer;
+    usb_vendor_flags_g.out_ongoing = 1;
+    usb_start_out(USB_VENDOR_OUT_ENDPOINT, buffer, length);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file usb-vendor.h
+ * @desc USB vendor specific bulk interface
+ * @author agent
+ * @date 2026-10-18
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef usb_vendor_h
+#define usb_vendor_h
+
+#include "global.h"
+#include "config.h"
+
+#include "usb-cdc.h"
+
+/*
+ *  The vendor interface is a pair of bulk endpoints for binary data, which do
+ *  not have the overhead of a CDC port. Data is sent and received directly
+ *  from buffers provided by the caller, and each transaction can be many
+ *  packets long, so only one interrupt is needed for each buffer.
+ */
+
+#define USB_VENDOR_EP_SIZE          64
+
+/** The CDC ports use endpoints 1 to 6, the vendor interface uses both
+    directions of endpoint 7 */
+#define USB_VENDOR_IN_ENDPOINT      7
+#define USB_VENDOR_OUT_ENDPOINT     7
+
+/** Interface number for the vendor interface, after the CDC interfaces */
+#define USB_VENDOR_INTERFACE        (USB_CDC_NUM_PORTS * 2)
+
+/** Interface class code for a vendor specific interface */
+#define USB_VENDOR_INTERFACE_CLASS  0xFF
+
+/** Maximum length of a single transaction in either direction */
+#define USB_VENDOR_MAX_LENGTH       16320
+
+/**
+ *  Callback for when the vendor interface is enabled by host.
+ */
+extern void usb_vendor_enable_config_callback (void);
+
+/**
+ *  Callback for when the vendor interface is disabled by host.
+ */
+extern void usb_vendor_disable_config_callback (void);
+
+/**
+ *  Configure the functions which are called when transactions complete. The
+ *  functions are called from the USB interrupt.
+ *
+ *  @param in_callback Function called when the data passed to
+ *                     usb_vendor_send has been sent and the buffer can be
+ *                     reused, may be NULL
+ *  @param out_callback Function called when data has been received into the
+ *                      buffer passed to usb_vendor_receive, may be NULL
+ *  @param context Pointer to be provided to callbacks
+ */
+extern void usb_vendor_set_callbacks (void (*in_callback)(void*),
+                                      void (*out_callback)(void*, uint8_t*,
+                                                           uint16_t),
+                                      void *context);
+
+/**
+ *  Determine if the vendor interface has been enabled by the host.
+ *
+ *  @return 1 if the interface is enabled, 0 otherwise
+ */
+extern uint8_t usb_vendor_is_ready (void);
+
+/**
+ *  Determine if data is being sent.
+ *
+ *  @return 1 if a transaction started by usb_vendor_send has not completed, 0
+ *          otherwise
+ */
+extern uint8_t usb_vendor_send_busy (void);
+
+/**
+ *  Send data to the host. The data is not copied, it must stay in place until
+ *  the transaction is complete.
+ *
+ *  @param data The data to be sent, must be in RAM and 4 byte aligned
+ *  @param length The number of bytes to be sent, at most
+ *                USB_VENDOR_MAX_LENGTH
+ *
+ *  @return 0 if the transaction was started, 1 if the interface is not ready,
+ *          is already sending or the data can not be sent
+ */
+extern uint8_t usb_vendor_send (const uint8_t *data, uint16_t length);
+
+/**
+ *  Receive data from the host directly into a buffer. The transaction
+ *  completes when the buffer is full or the host sends a short packet.
+ *
+ *  @param buffer Buffer for received data, must be 4 byte aligned
+ *  @param length The length of the buffer, must be a multiple of
+ *                USB_VENDOR_EP_SIZE and at most USB_VENDOR_MAX_LENGTH
+ *
+ *  @return 0 if the transaction was started, 1 if the interface is not ready,
+ *          is already receiving or the buffer can not be used
+ */
+extern uint8_t usb_vendor_receive (uint8_t *buffer, uint16_t length);
+
+#endif /* usb_vendor_h */
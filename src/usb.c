@@ -32,6 +32,11 @@ static uint8_t usb_ep_0_out_buf_g[USB_EP_0_LENGTH]
 
 /** Transmit complete callback functions */
 static void (*usb_in_callbacks_g[8])(void);
+/** Bitmap of the in endpoints which use both banks */
+static uint8_t usb_dual_bank_in_g;
+/** Bitmap of the dual bank in endpoints for which the next transaction should
+    be placed in bank 1 */
+static uint8_t usb_next_bank_g;
 /** Receive complete callback functions */
 static void (*usb_out_callbacks_g[8])(uint16_t length);
 /** Enable configuration callback */
@@ -265,6 +270,35 @@ void usb_enable_endpoint_in (uint8_t ep, enum usb_endpoint_size size,
                                                  USB_DEVICE_EPSTATUSCLR_DTGLIN);
 }
 
+void usb_enable_endpoint_in_dual_bank (uint8_t ep, enum usb_endpoint_size size,
+                                       enum usb_endpoint_type type,
+                                       void (*callback)(void))
+{
+    /* Store callback */
+    usb_in_callbacks_g[ep] = callback;
+    usb_dual_bank_in_g |= (1 << ep);
+    usb_next_bank_g &= ~(1 << ep);
+    /* Configure bank sizes */
+    UsbDeviceDescBank *banks = usb_ep_descriptors_g[ep].DeviceDescBank;
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        banks[bank].PCKSIZE.bit.SIZE = (__builtin_ctz(size) - 3);
+        banks[bank].PCKSIZE.bit.AUTO_ZLP = 0b1;
+    }
+    /* Configure endpoint registers */
+    // Configure bank type, bank 0 is configured as the second bank of the in
+    // endpoint
+    USB->DEVICE.DeviceEndpoint[ep].EPCFG.bit.EPTYPE1 = type;
+    USB->DEVICE.DeviceEndpoint[ep].EPCFG.bit.EPTYPE0 =
+                                                USB_ENDPOINT_TYPE_DUAL_BANK;
+    // Indicate that both banks are not ready, start from bank 0 and clear
+    // data toggle
+    USB->DEVICE.DeviceEndpoint[ep].EPSTATUSCLR.reg =
+                                                (USB_DEVICE_EPSTATUSCLR_BK0RDY |
+                                                 USB_DEVICE_EPSTATUSCLR_BK1RDY |
+                                                 USB_DEVICE_EPSTATUSCLR_CURBK |
+                                                 USB_DEVICE_EPSTATUSCLR_DTGLIN);
+}
+
 void usb_enable_endpoint_out (uint8_t ep, enum usb_endpoint_size size,
                               enum usb_endpoint_type type,
                               void (*callback)(uint16_t length))
@@ -287,6 +321,14 @@ void usb_enable_endpoint_out (uint8_t ep, enum usb_endpoint_size size,
 
 void usb_disable_endpoint_in (uint8_t ep)
 {
+    if (usb_dual_bank_in_g & (1 << ep)) {
+        /* Indicate that bank 0 is not ready and stop using it for in */
+        USB->DEVICE.DeviceEndpoint[ep].EPSTATUSCLR.reg =
+                                                USB_DEVICE_EPSTATUSCLR_BK0RDY;
+        USB->DEVICE.DeviceEndpoint[ep].EPCFG.bit.EPTYPE0 =
+                                                USB_ENDPOINT_TYPE_DISABLED;
+        usb_dual_bank_in_g &= ~(1 << ep);
+    }
     /* Indicate that bank is not ready */
     USB->DEVICE.DeviceEndpoint[ep].EPSTATUSCLR.reg =
                                                 USB_DEVICE_EPSTATUSCLR_BK1RDY;
@@ -305,26 +347,40 @@ void usb_disable_endpoint_out (uint8_t ep)
                                                 USB_ENDPOINT_TYPE_DISABLED;
 }
 
-void usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
-                   uint8_t zlp)
+uint8_t usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
+                      uint8_t zlp)
 {
+    /* Select the bank */
+    uint8_t bank = 1;
+    if (usb_dual_bank_in_g & (1 << ep)) {
+        // Banks are used alternately, which is the order in which the
+        // hardware sends them
+        bank = !!(usb_next_bank_g & (1 << ep));
+        if (USB->DEVICE.DeviceEndpoint[ep].EPSTATUS.reg &
+                (USB_DEVICE_EPSTATUS_BK0RDY << bank)) {
+            // Both banks are full
+            return 1;
+        }
+        usb_next_bank_g ^= (1 << ep);
+    }
     /* Configure endpoint descriptor */
-    usb_ep_descriptors_g[ep].DeviceDescBank[1].PCKSIZE.bit.AUTO_ZLP = zlp;
-    usb_ep_descriptors_g[ep].DeviceDescBank[1].PCKSIZE.bit.MULTI_PACKET_SIZE =
-                                                                            0;
-    usb_ep_descriptors_g[ep].DeviceDescBank[1].PCKSIZE.bit.BYTE_COUNT = length;
-    usb_ep_descriptors_g[ep].DeviceDescBank[1].ADDR.reg = (uint32_t)data;
+    UsbDeviceDescBank *desc = usb_ep_descriptors_g[ep].DeviceDescBank + bank;
+    desc->PCKSIZE.bit.AUTO_ZLP = zlp;
+    desc->PCKSIZE.bit.MULTI_PACKET_SIZE = 0;
+    desc->PCKSIZE.bit.BYTE_COUNT = length;
+    desc->ADDR.reg = (uint32_t)data;
     /* Configure endpoint registers */
-    // Make sure we don't have any pending interrupts for bank 1
+    // Make sure we don't have any pending interrupts for the bank
     USB->DEVICE.DeviceEndpoint[ep].EPINTFLAG.reg =
-                                                (USB_DEVICE_EPINTFLAG_TRCPT1 |
-                                                USB_DEVICE_EPINTFLAG_TRFAIL1);
-    // Enable the transmission complete interrupt for bank 1
+                                    ((USB_DEVICE_EPINTFLAG_TRCPT0 |
+                                      USB_DEVICE_EPINTFLAG_TRFAIL0) << bank);
+    // Enable the transmission complete interrupt for the bank
     USB->DEVICE.DeviceEndpoint[ep].EPINTENSET.reg =
-                                                USB_DEVICE_EPINTENSET_TRCPT1;
+                                        (USB_DEVICE_EPINTENSET_TRCPT0 << bank);
     // Indicate that bank is full
     USB->DEVICE.DeviceEndpoint[ep].EPSTATUSSET.reg =
-                                                USB_DEVICE_EPSTATUSSET_BK1RDY;
+                                        (USB_DEVICE_EPSTATUSSET_BK0RDY << bank);
+    return 0;
 }
 
 void usb_start_out (uint8_t ep, uint8_t *data, uint16_t length)
@@ -569,7 +625,16 @@ void USB_Handler (void)
     while (USB->DEVICE.EPINTSMRY.reg) {
         uint8_t i = __builtin_ctz(USB->DEVICE.EPINTSMRY.reg);
         /* Interrupt on endpoint i */
-        if (USB->DEVICE.DeviceEndpoint[i].EPINTFLAG.bit.TRCPT0) {
+        if (USB->DEVICE.DeviceEndpoint[i].EPINTFLAG.bit.TRCPT0 &&
+                (usb_dual_bank_in_g & (1 << i))) {
+            /* In complete on bank 0 of a dual bank endpoint */
+            if (usb_in_callbacks_g[i] != NULL) {
+                usb_in_callbacks_g[i]();
+            }
+            // Clear interrupt flag
+            USB->DEVICE.DeviceEndpoint[i].EPINTFLAG.reg =
+                                                USB_DEVICE_EPINTFLAG_TRCPT0;
+        } else if (USB->DEVICE.DeviceEndpoint[i].EPINTFLAG.bit.TRCPT0) {
             /* Out complete */
             if (usb_out_callbacks_g[i] != NULL) {
                 usb_out_callbacks_g[i](
@@ -66,6 +66,22 @@ extern void usb_enable_endpoint_in (uint8_t ep, enum usb_endpoint_size size,
                                     enum usb_endpoint_type type,
                                     void (*callback)(void));
 
+/**
+ *  Enable an in endpoint which uses both of its banks. One bank can be filled
+ *  while the other is being sent, so that the host does not need to wait
+ *  between transactions. A dual bank in endpoint can not also be used for out
+ *  transactions.
+ *
+ *  @param ep The endpoint to be enabled
+ *  @param size The maximum packet size for the endpoint
+ *  @param type The type of the endpoint
+ *  @param callback Function called each time a transaction is completed
+ */
+extern void usb_enable_endpoint_in_dual_bank (uint8_t ep,
+                                              enum usb_endpoint_size size,
+                                              enum usb_endpoint_type type,
+                                              void (*callback)(void));
+
 extern void usb_enable_endpoint_out (uint8_t ep, enum usb_endpoint_size size,
                                      enum usb_endpoint_type type,
                                      void (*callback)(uint16_t length));
@@ -86,17 +102,23 @@ extern void usb_disable_endpoint_out (uint8_t ep);
 extern void usb_start_out (uint8_t ep, uint8_t *data, uint16_t length);
 
 /**
- *  Start a transaction from device to host.
+ *  Start a transaction from device to host. Transactions longer than the
+ *  endpoint size are split into multiple packets by the hardware. On a dual
+ *  bank endpoint a transaction can be started while another is in progress,
+ *  the transactions are sent in the order that they were started.
  *
  *  @note The data buffer used with this function must be 4 byte aligned.
  *
  *  @param ep The endpoint on which the out transaction should be started
  *  @param data Pointer to the data to be sent
- *  @param length Length of data to be received
+ *  @param length Length of data to be received, at most 16383 bytes
  *  @param zlp Perform automatic Zero Length Packet handshake
+ *
+ *  @return 0 if the transaction was started, 1 if both banks of a dual bank
+ *          endpoint are already in use
  */
-extern void usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
-                          uint8_t zlp);
+extern uint8_t usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
+                             uint8_t zlp);
 
 /**
  *  Stall an endpoint.
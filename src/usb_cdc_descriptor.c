@@ -10,6 +10,9 @@
 #include "usb-cdc.h"
 
 #include "usb-cdc-standard.h"
+#ifdef ENABLE_USB_VENDOR
+#include "usb-vendor.h"
+#endif
 
 // Ignore warnings in this file about inefficient alignment
 #pragma GCC diagnostic ignored "-Wattributes"
@@ -63,6 +66,12 @@ struct usb_cdc_configuration_descriptor {
     struct usb_endpoint_descriptor cdc_data_in_endpoint_2;
     struct usb_endpoint_descriptor cdc_data_out_endpoint_2;
 #endif
+#ifdef ENABLE_USB_VENDOR
+    /* Vendor Specific Bulk Interface */
+    struct usb_interface_descriptor vendor_interface;
+    struct usb_endpoint_descriptor vendor_in_endpoint;
+    struct usb_endpoint_descriptor vendor_out_endpoint;
+#endif
 } __attribute__((packed));
 
 // Stop ignoring warnings about inefficient alignment
@@ -75,7 +84,11 @@ const struct usb_cdc_configuration_descriptor usb_cdc_config_descriptor = {
         .bLength = sizeof(struct usb_configuration_descriptor),
         .bDescriptorType = USB_DESC_TYPE_CONFIGURATION,
         .wTotalLength  = sizeof(struct usb_cdc_configuration_descriptor),
+#ifdef ENABLE_USB_VENDOR
+        .bNumInterfaces = (USB_CDC_NUM_PORTS * 2) + 1,
+#else
         .bNumInterfaces = USB_CDC_NUM_PORTS * 2,
+#endif
         .bConfigurationValue = 1,
         .iConfiguration = 0,
         .bmAttributes.RESERVED = 1,
@@ -328,7 +341,7 @@ const struct usb_cdc_configuration_descriptor usb_cdc_config_descriptor = {
         .bLength = sizeof(struct usb_endpoint_descriptor),
         .bDescriptorType = USB_DESC_TYPE_ENDPOINT,
         .bEndpointAddress.direction = USB_DATA_TRANS_DEVICE_TO_HOST,
-        .bEndpointAddress.endpoint_number = USB_CDC_NOTIFICATION_ENDPOINT_1,
+        .bEndpointAddress.endpoint_number = USB_CDC_NOTIFICATION_ENDPOINT_2,
         .bmAttributes.transfer_type = USB_TRANS_TYPE_INTERRUPT,
         .bmAttributes.sync_type = USB_SYNC_TYPE_NONE,
         .bmAttributes.usage_type = USB_USAGE_TYPE_DATA,
@@ -368,6 +381,42 @@ const struct usb_cdc_configuration_descriptor usb_cdc_config_descriptor = {
         .bmAttributes.usage_type = USB_USAGE_TYPE_DATA,
         .wMaxPacketSize = USB_CDC_DATA_EP_SIZE,
         .bInterval = 0
+    },
+#endif
+#ifdef ENABLE_USB_VENDOR
+    /* Vendor Specific Bulk Interface */
+    .vendor_interface = {
+        .bLength = sizeof(struct usb_interface_descriptor),
+        .bDescriptorType = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber = USB_VENDOR_INTERFACE,
+        .bAlternateSetting = 0,
+        .bNumEndpoints = 2,
+        .bInterfaceClass = USB_VENDOR_INTERFACE_CLASS,
+        .bInterfaceSubClass = 0,
+        .bInterfaceProtocol = 0,
+        .iInterface = 0
+    },
+    .vendor_in_endpoint = {
+        .bLength = sizeof(struct usb_endpoint_descriptor),
+        .bDescriptorType = USB_DESC_TYPE_ENDPOINT,
+        .bEndpointAddress.direction = USB_DATA_TRANS_DEVICE_TO_HOST,
+        .bEndpointAddress.endpoint_number = USB_VENDOR_IN_ENDPOINT,
+        .bmAttributes.transfer_type = USB_TRANS_TYPE_BULK,
+        .bmAttributes.sync_type = USB_SYNC_TYPE_NONE,
+        .bmAttributes.usage_type = USB_USAGE_TYPE_DATA,
+        .wMaxPacketSize = USB_VENDOR_EP_SIZE,
+        .bInterval = 0
+    },
+    .vendor_out_endpoint = {
+        .bLength = sizeof(struct usb_endpoint_descriptor),
+        .bDescriptorType = USB_DESC_TYPE_ENDPOINT,
+        .bEndpointAddress.direction = USB_DATA_TRANS_HOST_TO_DEVICE,
+        .bEndpointAddress.endpoint_number = USB_VENDOR_OUT_ENDPOINT,
+        .bmAttributes.transfer_type = USB_TRANS_TYPE_BULK,
+        .bmAttributes.sync_type = USB_SYNC_TYPE_NONE,
+        .bmAttributes.usage_type = USB_USAGE_TYPE_DATA,
+        .wMaxPacketSize = USB_VENDOR_EP_SIZE,
+        .bInterval = 0
     }
 #endif
 };
@@ -0,0 +1,70 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  adc_get_core_vcc() converts the value from the scaled core voltage channel
+ *  to millivolts. The scaled core voltage is one quarter of the core voltage.
+ */
+
+
+int main (int argc, char **argv)
+{
+    // The voltage should not be available if the channel is not enabled.
+    {
+        reset();
+        adc_state_g.channel_mask &= ~(1 << ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val);
+        adc_init_vcc_cal();
+        
+        ut_assert(adc_get_core_vcc() == INT16_MIN);
+    }
+    
+    // The result should match the direct calculation for every possible ADC
+    // value.
+    {
+        reset();
+        adc_init_vcc_cal();
+        
+        for (uint32_t m = 0; m <= UINT16_MAX; m++) {
+            set_value(ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val, (uint16_t)m);
+            ut_assert(adc_get_core_vcc() == reference_vcc((uint16_t)m));
+        }
+    }
+    
+    // Every 12 bit value should be scaled to 16 bits before being converted
+    // when the channel is sampled without oversampling.
+    {
+        reset();
+        adc_state_g.chan_conf[ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val].oversample =
+                                                            ADC_OVERSAMPLE_NONE;
+        adc_init_vcc_cal();
+        
+        for (uint32_t m = 0; m < (1 << 12); m++) {
+            set_value(ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val, (uint16_t)m);
+            ut_assert(adc_get_core_vcc() == reference_vcc((uint16_t)(m << 4)));
+        }
+    }
+    
+    // The gain of the channel should be accounted for.
+    {
+        reset();
+        adc_state_g.chan_conf[ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val].gain =
+                                                                    ADC_GAIN_4X;
+        adc_init_vcc_cal();
+        
+        for (uint32_t m = 0; m <= UINT16_MAX; m++) {
+            set_value(ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val, (uint16_t)m);
+            ut_assert(adc_get_core_vcc() == (int16_t)((4000 * m) / (65535 * 4)));
+        }
+        
+        adc_state_g.chan_conf[ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val].gain =
+                                                                ADC_GAIN_DIV2;
+        adc_init_vcc_cal();
+        
+        for (uint32_t m = 0; m <= UINT16_MAX; m++) {
+            set_value(ADC_INPUTCTRL_MUXPOS_SCALEDCOREVCC_Val, (uint16_t)m);
+            ut_assert(adc_get_core_vcc() == (int16_t)((8000 * m) / 65535));
+        }
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,152 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  adc_get_stats() returns the minimum, maximum, mean and RMS of the samples
+ *  from the last completed window of a channel. Samples are accumulated as
+ *  each scan completes.
+ */
+
+#define CHAN_A  ADC_INPUTCTRL_MUXPOS_TEMP_Val
+#define CHAN_B  ADC_INPUTCTRL_MUXPOS_SCALEDIOVCC_Val
+
+/**
+ *  Store a sample for a channel and run the end of scan update.
+ */
+static void sample (uint8_t channel, uint16_t value)
+{
+    set_value(channel, value);
+    adc_stats_update_scan(channel, channel);
+}
+
+
+int main (int argc, char **argv)
+{
+    struct adc_stats_t stats;
+    
+    // Statistics should not be available for channels which have not been
+    // configured, or before the first window is complete.
+    {
+        reset();
+        
+        ut_assert(adc_get_stats(CHAN_A, &stats) == 1);
+        ut_assert(adc_stats_configure(1UL << CHAN_A, 4) == 0);
+        ut_assert(adc_get_stats(CHAN_A, &stats) == 1);
+        ut_assert(adc_get_stats(CHAN_B, &stats) == 1);
+        
+        for (int i = 0; i < 3; i++) {
+            sample(CHAN_A, 100);
+            ut_assert(adc_get_stats(CHAN_A, &stats) == 1);
+        }
+        sample(CHAN_A, 100);
+        ut_assert(adc_get_stats(CHAN_A, &stats) == 0);
+        ut_assert(stats.count == 4);
+    }
+    
+    // Invalid configurations should be rejected.
+    {
+        reset();
+        
+        ut_assert(adc_stats_configure(1UL << CHAN_A, 0) == 1);
+        
+        adc_state_g.channel_mask = 0x1FFFFFF;
+        ut_assert(adc_stats_configure(0x7F, 8) == 1);
+        ut_assert(adc_stats_configure(0x3F, 8) == 0);
+        
+        // Disabled channels are ignored
+        adc_state_g.channel_mask = ADC_RANGE_INT_MASK;
+        ut_assert(adc_stats_configure(0x3F | (1UL << CHAN_A), 8) == 0);
+        ut_assert(adc_stats_slots_g[0] == ADC_STATS_NO_SLOT);
+        ut_assert(adc_stats_slots_g[CHAN_A] != ADC_STATS_NO_SLOT);
+    }
+    
+    // Statistics should match a direct calculation over each window.
+    {
+        reset();
+        ut_assert(adc_stats_configure((1UL << CHAN_A) | (1UL << CHAN_B),
+                                      100) == 0);
+        
+        for (int w = 0; w < 20; w++) {
+            uint16_t min = UINT16_MAX;
+            uint16_t max = 0;
+            uint64_t sum = 0;
+            uint64_t sum_sq = 0;
+            
+            for (int i = 0; i < 100; i++) {
+                uint16_t v = (uint16_t)test_rand();
+                if (w == 0) {
+                    // Make sure the extremes are handled
+                    v = (i % 2) ? UINT16_MAX : 0;
+                }
+                
+                set_value(CHAN_A, v);
+                set_value(CHAN_B, (uint16_t)(UINT16_MAX - v));
+                adc_stats_update_scan(CHAN_A, CHAN_B);
+                
+                if (v < min) {
+                    min = v;
+                }
+                if (v > max) {
+                    max = v;
+                }
+                sum += v;
+                sum_sq += (uint64_t)v * v;
+            }
+            
+            ut_assert(adc_get_stats(CHAN_A, &stats) == 0);
+            ut_assert(stats.count == 100);
+            ut_assert(stats.min == min);
+            ut_assert(stats.max == max);
+            ut_assert(stats.mean == (uint16_t)(sum / 100));
+            uint64_t mean_sq = sum_sq / 100;
+            ut_assert(((uint64_t)stats.rms * stats.rms) <= mean_sq);
+            ut_assert(((uint64_t)(stats.rms + 1) * (stats.rms + 1)) > mean_sq);
+            
+            ut_assert(adc_get_stats(CHAN_B, &stats) == 0);
+            ut_assert(stats.min == (UINT16_MAX - (uint32_t)max));
+            ut_assert(stats.max == (UINT16_MAX - (uint32_t)min));
+        }
+    }
+    
+    // Values should be scaled to 16 bits before being accumulated.
+    {
+        reset();
+        adc_state_g.chan_conf[CHAN_A].oversample = ADC_OVERSAMPLE_NONE;
+        ut_assert(adc_stats_configure(1UL << CHAN_A, 2) == 0);
+        
+        sample(CHAN_A, 0xFFF);
+        sample(CHAN_A, 0x001);
+        
+        ut_assert(adc_get_stats(CHAN_A, &stats) == 0);
+        ut_assert(stats.min == 0x0010);
+        ut_assert(stats.max == 0xFFF0);
+        ut_assert(stats.mean == 0x8000);
+    }
+    
+    // The largest window should not overflow the accumulators.
+    {
+        reset();
+        ut_assert(adc_stats_configure(1UL << CHAN_A, UINT16_MAX) == 0);
+        
+        for (uint32_t i = 0; i < UINT16_MAX; i++) {
+            sample(CHAN_A, UINT16_MAX);
+        }
+        
+        ut_assert(adc_get_stats(CHAN_A, &stats) == 0);
+        ut_assert(stats.mean == UINT16_MAX);
+        ut_assert(stats.rms == UINT16_MAX);
+    }
+    
+    // The integer square root should be exact for every perfect square and
+    // the values around it.
+    {
+        for (uint32_t r = 1; r <= UINT16_MAX; r++) {
+            ut_assert(adc_isqrt(r * r) == r);
+            ut_assert(adc_isqrt((r * r) - 1) == (r - 1));
+        }
+        ut_assert(adc_isqrt(0) == 0);
+        ut_assert(adc_isqrt(UINT32_MAX) == UINT16_MAX);
+    }
+    
+    return UT_PASS;
+}
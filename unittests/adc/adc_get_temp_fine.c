@@ -0,0 +1,61 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  adc_get_temp_fine() converts the value from the internal temperature
+ *  sensor to hundredths of a degree celsius, compensating for the drift of
+ *  the internal 1 V reference with temperature, using calibration constants
+ *  computed from the NVM Temperature Log Row in init_adc().
+ *
+ *  The temperature log row is described in section 10.3.2 of the SAMD21
+ *  datasheet and the conversion in section 33.6.9.
+ */
+
+
+int main (int argc, char **argv)
+{
+    // The temperature should not be available if the temperature sensor
+    // channel is not enabled.
+    {
+        struct temp_log_values v;
+        get_temp_log_values(0, &v);
+        set_temp_log(&v);
+        
+        reset();
+        adc_state_g.channel_mask &= ~(1 << ADC_INPUTCTRL_MUXPOS_TEMP_Val);
+        adc_init_temp_cal();
+        
+        ut_assert(adc_get_temp_fine() == INT16_MIN);
+    }
+    
+    // The temperature should not be available if the temperature log row is
+    // not valid.
+    {
+        temp_log[0] = 0;
+        temp_log[1] = 0;
+        
+        reset();
+        adc_init_temp_cal();
+        
+        ut_assert(adc_get_temp_fine() == INT16_MIN);
+    }
+    
+    // The result should match the direct calculation for every possible ADC
+    // value (including every 12 bit value) with a number of different sets of
+    // calibration values.
+    for (unsigned i = 0; i < NUM_TEMP_LOG_SETS; i++) {
+        struct temp_log_values v;
+        get_temp_log_values(i, &v);
+        set_temp_log(&v);
+        
+        reset();
+        adc_init_temp_cal();
+        
+        for (uint32_t m = 0; m <= UINT16_MAX; m++) {
+            set_value(ADC_INPUTCTRL_MUXPOS_TEMP_Val, (uint16_t)m);
+            ut_assert(adc_get_temp_fine() == reference_temp((uint16_t)m, 1));
+        }
+    }
+    
+    return UT_PASS;
+}
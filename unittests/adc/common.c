@@ -0,0 +1,235 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+
+// Temperature Log Row
+static uint32_t temp_log[2];
+#undef NVMCTRL_TEMP_LOG
+#define NVMCTRL_TEMP_LOG ((uintptr_t)temp_log)
+
+// Interrupts can not be masked on the host
+#define NVIC_DisableIRQ(irq)
+#define NVIC_EnableIRQ(irq)
+#define __DSB()
+#define __ISB()
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+struct dma_callback_t dma_callbacks[DMAC_CH_NUM];
+
+void dma_start_static_to_buffer_hword(uint8_t chan, uint16_t *buffer,
+                                      uint16_t length,
+                                      const volatile uint16_t *source,
+                                      uint8_t trigger, uint8_t priority)
+{
+}
+
+/**
+ *  Calibration values for a temperature log row.
+ */
+struct temp_log_values {
+    uint8_t room_temp_int;
+    uint8_t room_temp_dec;
+    uint8_t hot_temp_int;
+    uint8_t hot_temp_dec;
+    int8_t room_int1v;
+    int8_t hot_int1v;
+    uint16_t room_adc;
+    uint16_t hot_adc;
+};
+
+static void set_temp_log (const struct temp_log_values *v)
+{
+    temp_log[0] = (NVMCTRL_FUSES_ROOM_TEMP_VAL_INT(v->room_temp_int) |
+                   NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC(v->room_temp_dec) |
+                   NVMCTRL_FUSES_HOT_TEMP_VAL_INT(v->hot_temp_int) |
+                   NVMCTRL_FUSES_HOT_TEMP_VAL_DEC(v->hot_temp_dec) |
+                   NVMCTRL_FUSES_ROOM_INT1V_VAL((uint32_t)(uint8_t)v->room_int1v));
+    temp_log[1] = (NVMCTRL_FUSES_HOT_INT1V_VAL((uint32_t)(uint8_t)v->hot_int1v) |
+                   NVMCTRL_FUSES_ROOM_ADC_VAL((uint32_t)v->room_adc) |
+                   NVMCTRL_FUSES_HOT_ADC_VAL((uint32_t)v->hot_adc));
+}
+
+/**
+ *  Simple pseudo random number generator so that tests are repeatable.
+ */
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t test_rand (void)
+{
+    rand_state = (rand_state * 1103515245) + 12345;
+    return rand_state >> 8;
+}
+
+/**
+ *  Get a plausible set of temperature log values.
+ *
+ *  @param i The index of the set, the first few sets are fixed and the rest are
+ *           pseudo random
+ */
+static void get_temp_log_values (unsigned i, struct temp_log_values *v)
+{
+    static const struct temp_log_values fixed[] = {
+        // Typical values
+        { 25, 0, 85, 0, 0, 0, 2700, 3290 },
+        { 25, 5, 85, 2, -3, 4, 2731, 3310 },
+        { 24, 9, 84, 7, 7, -6, 2650, 3260 },
+        // Large reference drifts
+        { 30, 1, 90, 3, -100, 100, 2800, 3400 },
+        { 20, 0, 80, 9, 127, -128, 2500, 3100 }
+    };
+    
+    if (i < (sizeof(fixed) / sizeof(fixed[0]))) {
+        *v = fixed[i];
+        return;
+    }
+    
+    v->room_temp_int = 20 + (test_rand() % 11);
+    v->room_temp_dec = test_rand() % 10;
+    v->hot_temp_int = 80 + (test_rand() % 11);
+    v->hot_temp_dec = test_rand() % 10;
+    v->room_int1v = (int8_t)((test_rand() % 41) - 20);
+    v->hot_int1v = (int8_t)((test_rand() % 41) - 20);
+    v->room_adc = 2400 + (test_rand() % 600);
+    v->hot_adc = v->room_adc + 400 + (test_rand() % 400);
+}
+
+#define NUM_TEMP_LOG_SETS   40
+
+/**
+ *  Reference implementation of the temperature calculation, as it was before
+ *  calibration constants were cached.
+ */
+static int16_t reference_temp (uint16_t adc_m_val, uint8_t fine)
+{
+    /* Read values from Temperature Log Row */
+    // Room temperature (in hundred nanodegrees celsius)
+    uint8_t room_temp_val_int = (uint8_t)(((*((uint32_t*)
+                                        NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_ADDR)) &
+                                        NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Msk) >>
+                                          NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Pos);
+    uint8_t room_temp_val_dec = (uint8_t)(((*((uint32_t*)
+                                        NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC_ADDR)) &
+                                        NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC_Msk) >>
+                                          NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC_Pos);
+    int64_t temp_r = (((uint64_t)room_temp_val_int * 100000000UL) +
+                      ((uint64_t)room_temp_val_dec * 10000000UL));
+    
+    // Hot temperature (in nanodegrees celsius)
+    uint8_t hot_temp_val_int = (uint8_t)(((*((uint32_t*)
+                                        NVMCTRL_FUSES_HOT_TEMP_VAL_INT_ADDR)) &
+                                          NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Msk) >>
+                                         NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Pos);
+    uint8_t hot_temp_val_dec = (uint8_t)(((*((uint32_t*)
+                                        NVMCTRL_FUSES_HOT_TEMP_VAL_DEC_ADDR)) &
+                                          NVMCTRL_FUSES_HOT_TEMP_VAL_DEC_Msk) >>
+                                         NVMCTRL_FUSES_HOT_TEMP_VAL_DEC_Pos);
+    int64_t temp_h = (((uint64_t)hot_temp_val_int * 100000000UL) +
+                      ((uint64_t)hot_temp_val_dec * 10000000UL));
+    
+    // 1 V reference actual voltage for room temperature measurment
+    int16_t int1v_r = 1000 - ((int8_t)(((*((uint32_t*)
+                                           NVMCTRL_FUSES_ROOM_INT1V_VAL_ADDR)) &
+                                            NVMCTRL_FUSES_ROOM_INT1V_VAL_Msk) >>
+                                            NVMCTRL_FUSES_ROOM_INT1V_VAL_Pos));
+    
+    // 1 V reference actual voltage for hot temperature measurment
+    int16_t int1v_h = 1000 - ((int8_t)(((*((uint32_t*)
+                                          NVMCTRL_FUSES_HOT_INT1V_VAL_ADDR)) &
+                                            NVMCTRL_FUSES_HOT_INT1V_VAL_Msk) >>
+                                            NVMCTRL_FUSES_HOT_INT1V_VAL_Pos));
+    
+    // ADC value for room temperature measurment
+    uint16_t adc_r_val = (uint16_t)(((*((uint32_t*)
+                                           NVMCTRL_FUSES_ROOM_ADC_VAL_ADDR)) &
+                                        NVMCTRL_FUSES_ROOM_ADC_VAL_Msk) >>
+                                       NVMCTRL_FUSES_ROOM_ADC_VAL_Pos);
+    
+    // ADC value for hot temperature measurment
+    uint16_t adc_h_val = (uint16_t)(((*((uint32_t*)
+                                          NVMCTRL_FUSES_HOT_ADC_VAL_ADDR)) &
+                                       NVMCTRL_FUSES_HOT_ADC_VAL_Msk) >>
+                                      NVMCTRL_FUSES_HOT_ADC_VAL_Pos);
+    
+    /* Compute coefficients to convert ADC values to nanovolts */
+    uint32_t adc_r_co = ((100000 * (uint32_t)int1v_r) + 2048) / 4095;
+    uint32_t adc_h_co = ((100000 * (uint32_t)int1v_h) + 2048) / 4095;
+    uint32_t adc_m_course_co = ((100000 * (uint32_t)1000) + 32768) / 65535;
+    
+    /* Compute voltages (in nanovolts) */
+    uint32_t v_adc_r = adc_r_val * adc_r_co;
+    uint32_t v_adc_h = adc_h_val * adc_h_co;
+    uint32_t v_adc_m_course = adc_m_val * adc_m_course_co;
+    
+    /* Compute course temp (in nanodegrees celsius) */
+    int32_t denominator = v_adc_h - v_adc_r;
+    int32_t delta_v_course = v_adc_m_course - v_adc_r;
+    int64_t delta_t = temp_h - temp_r;
+    
+    int64_t numerator_course = (int64_t)delta_v_course * delta_t;
+    int64_t temp_c = temp_r + (numerator_course / denominator);
+    
+    if (!fine) {
+        // Return course value
+        return (int16_t)(temp_c / 1000000);
+    }
+    
+    /* Estimate 1 V reference actual voltage (in nanovolts) */
+    int16_t delta_int1v = int1v_h - int1v_r;
+    int32_t delta_t_s = delta_t / 100000;
+    int32_t int1v_r_s = 100000 * int1v_r;
+    int32_t int1v_m = int1v_r_s + (delta_int1v * (temp_c - temp_r) / delta_t_s);
+
+    /* Compute new coefficient for measured temp ADC value */
+    uint32_t adc_m_fine_co = (int1v_m + 32768) / 65535;
+    
+    /* Compute new measured ACD voltage (in nanovolts) */
+    uint32_t v_adc_m_fine = adc_m_val * adc_m_fine_co;
+    
+    /* Compute fine temp (in nanodegrees celsius) */
+    int32_t delta_v_fine = v_adc_m_fine - v_adc_r;
+    int64_t numerator_fine = (int64_t)delta_v_fine * delta_t;
+    int64_t temp_f = temp_r + (numerator_fine / denominator);
+    
+    // Return fine value
+    return (int16_t)(temp_f / 1000000);
+}
+
+/**
+ *  Reference implementation of the scaled VCC calculation, as it was before
+ *  calibration constants were cached.
+ */
+static int16_t reference_vcc (uint16_t adc_m)
+{
+    return (uint16_t)((4000 * (uint32_t)adc_m) / 65535);
+}
+
+/**
+ *  Reset the ADC driver state so that all internal channels are enabled and
+ *  sampled at 16 bit resolution, with no statistics kept.
+ */
+static void reset (void)
+{
+    memset(&adc_state_g, 0, sizeof(adc_state_g));
+    adc_state_g.channel_mask = ADC_RANGE_INT_MASK;
+    for (uint8_t i = 0; i < ADC_NUM_CHANNELS; i++) {
+        adc_state_g.chan_conf[i].oversample = ADC_OVERSAMPLE_256X;
+        adc_state_g.chan_conf[i].gain = ADC_GAIN_1X;
+        adc_stats_slots_g[i] = ADC_STATS_NO_SLOT;
+    }
+    memset(adc_stats_g, 0, sizeof(adc_stats_g));
+}
+
+/**
+ *  Set the stored result for a channel.
+ */
+static void set_value (uint8_t channel, uint16_t value)
+{
+    if (channel >= ADC_RANGE_INT_FIRST) {
+        adc_state_g.adc_in_buffer_internal[channel - ADC_RANGE_INT_FIRST] = value;
+    } else {
+        adc_state_g.adc_in_buffer_pins[channel] = value;
+    }
+}
@@ -0,0 +1,102 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_get_after_head() retrieves a pointer to the byte a given
+ *  distance after the head of the buffer and returns the length of the
+ *  largest contiguous block of data in the buffer starting at that byte.
+ *
+ *  This function can be used to queue a DMA transaction out of the buffer
+ *  while another transaction from the head is still in progress.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    memset(&cb, 0, sizeof(cb));
+
+    // An offset of zero should match circular_buffer_get_head().
+    {
+        cb.buffer = (uint8_t*)0x1000;
+        cb.capacity = 256;
+        cb.head = 20;
+        cb.tail = 100;
+        cb.length = 80;
+        uint8_t *start;
+        uint8_t *head;
+        uint16_t ret = circular_buffer_get_after_head(&cb, 0, &start);
+
+        ut_assert(ret == circular_buffer_get_head(&cb, &head));
+        ut_assert(start == head);
+    }
+
+    // Data after the offset should be contiguous up to the tail.
+    {
+        cb.buffer = (uint8_t*)0x1000;
+        cb.capacity = 256;
+        cb.head = 20;
+        cb.tail = 100;
+        cb.length = 80;
+        uint8_t *start;
+        uint16_t ret = circular_buffer_get_after_head(&cb, 30, &start);
+
+        ut_assert(ret == 50);
+        ut_assert(start == cb.buffer + 50);
+    }
+
+    // Data after the offset should be contiguous up to the end of the memory
+    // when the buffer wraps.
+    {
+        cb.buffer = (uint8_t*)0x12345678;
+        cb.capacity = 128;
+        cb.head = 100;
+        cb.tail = 40;
+        cb.length = 68;
+        uint8_t *start;
+        uint16_t ret = circular_buffer_get_after_head(&cb, 8, &start);
+
+        ut_assert(ret == 20);
+        ut_assert(start == cb.buffer + 108);
+    }
+
+    // An offset past the end of the memory should wrap to the start.
+    {
+        cb.buffer = (uint8_t*)0x12345678;
+        cb.capacity = 128;
+        cb.head = 100;
+        cb.tail = 40;
+        cb.length = 68;
+        uint8_t *start;
+        uint16_t ret = circular_buffer_get_after_head(&cb, 28, &start);
+
+        ut_assert(ret == 40);
+        ut_assert(start == cb.buffer);
+
+        ret = circular_buffer_get_after_head(&cb, 35, &start);
+
+        ut_assert(ret == 33);
+        ut_assert(start == cb.buffer + 7);
+    }
+
+    // An offset at or past the end of the data should return no data.
+    {
+        cb.buffer = (uint8_t*)0xAAAA;
+        cb.capacity = 123;
+        cb.head = 50;
+        cb.tail = 60;
+        cb.length = 10;
+        uint8_t *start;
+
+        ut_assert(circular_buffer_get_after_head(&cb, 10, &start) == 0);
+        ut_assert(circular_buffer_get_after_head(&cb, 11, &start) == 0);
+
+        cb.head = 0;
+        cb.tail = 0;
+        cb.length = 0;
+
+        ut_assert(circular_buffer_get_after_head(&cb, 0, &start) == 0);
+    }
+
+    return UT_PASS;
+}
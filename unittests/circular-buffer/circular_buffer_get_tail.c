@@ -0,0 +1,75 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_get_tail() retrieves a pointer to tail of the buffer and
+ *  returns the length of the largest contiguous block of free space in the
+ *  buffer starting at the tail.
+ *
+ *  This function can be used to copy blocks of data into the buffer.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    memset(&cb, 0, sizeof(cb));
+
+    // Get free space where tail is after head.
+    {
+        cb.buffer = (uint8_t*)0x1000;
+        cb.capacity = 256;
+        cb.head = 0;
+        cb.tail = 10;
+        cb.length = 10;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 246);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get free space where tail is before head.
+    {
+        cb.buffer = (uint8_t*)0x12345678;
+        cb.capacity = 32768;
+        cb.head = 24500;
+        cb.tail = 10000;
+        cb.length = 18268;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 14500);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get free space of empty buffer.
+    {
+        cb.buffer = (uint8_t*)0xAAAA;
+        cb.capacity = 123;
+        cb.head = 40;
+        cb.tail = 40;
+        cb.length = 0;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 83);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get free space of full buffer.
+    {
+        cb.buffer = (uint8_t*)0xAAAA;
+        cb.capacity = 123;
+        cb.head = 40;
+        cb.tail = 40;
+        cb.length = 123;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 0);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,93 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_move_tail() allows the tail position to be updated.
+ *
+ *  This function can be used to update the buffer state after data has been
+ *  copied to the tail of the buffer.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    memset(&cb, 0, sizeof(cb));
+
+    // Move tail of buffer when tail is higher than head.
+    {
+        cb.capacity = 500;
+        cb.head = 60;
+        cb.tail = 284;
+        cb.length = 224;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 100);
+
+        ut_assert(cb.head == 60);
+        ut_assert(cb.tail == 384);
+        ut_assert(cb.length == 324);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail of buffer when tail is lower than head.
+    {
+        cb.capacity = 64;
+        cb.head = 54;
+        cb.tail = 20;
+        cb.length = 30;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 6);
+
+        ut_assert(cb.head == 54);
+        ut_assert(cb.tail == 26);
+        ut_assert(cb.length == 36);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail so that it loops back to 0.
+    {
+        cb.capacity = 256;
+        cb.head = 57;
+        cb.tail = 210;
+        cb.length = 153;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 46);
+
+        ut_assert(cb.head == 57);
+        ut_assert(cb.tail == 0);
+        ut_assert(cb.length == 199);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail by more than the free space.
+    {
+        cb.capacity = 512;
+        cb.head = 40;
+        cb.tail = 500;
+        cb.length = 460;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 70);
+
+        ut_assert(cb.head == 40);
+        ut_assert(cb.tail == 40);
+        ut_assert(cb.length == 512);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail of full buffer.
+    {
+        cb.capacity = 2048;
+        cb.head = 600;
+        cb.tail = 600;
+        cb.length = 2048;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 70);
+
+        ut_assert(cb.head == 600);
+        ut_assert(cb.tail == 600);
+        ut_assert(cb.length == 2048);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    return UT_PASS;
+}
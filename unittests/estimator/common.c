@@ -0,0 +1,143 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+/** Gains used for tests, the same as the default configuration */
+#define TEST_ALPHA  13107
+#define TEST_BETA   1456
+
+/** Standard gravity in metres per second squared */
+#define G           9.80665
+
+/**
+ *  Simple pseudo random number generator so that tests are repeatable.
+ */
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t test_rand (void)
+{
+    rand_state = (rand_state * 1103515245) + 12345;
+    return rand_state >> 8;
+}
+
+/**
+ *  Get a normally distributed pseudo random number with a mean of 0 and a
+ *  standard deviation of 1.
+ */
+static double test_rand_normal (void)
+{
+    double u1 = ((double)(test_rand() & 0xFFFFFF) + 1) / 16777217.0;
+    double u2 = ((double)(test_rand() & 0xFFFFFF)) / 16777216.0;
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/**
+ *  Simulated flight profile, a constant acceleration boost followed by a
+ *  ballistic coast to apogee and a descent under parachute.
+ */
+#define FLIGHT_PAD_TIME         2.0
+#define FLIGHT_BOOST_TIME       3.0
+#define FLIGHT_BOOST_ACCEL      100.0
+#define FLIGHT_DESCENT_RATE     20.0
+
+#define FLIGHT_BURNOUT_TIME     (FLIGHT_PAD_TIME + FLIGHT_BOOST_TIME)
+#define FLIGHT_BURNOUT_VEL      (FLIGHT_BOOST_ACCEL * FLIGHT_BOOST_TIME)
+#define FLIGHT_BURNOUT_ALT      (FLIGHT_BOOST_ACCEL * FLIGHT_BOOST_TIME * \
+                                 FLIGHT_BOOST_TIME / 2)
+#define FLIGHT_APOGEE_TIME      (FLIGHT_BURNOUT_TIME + (FLIGHT_BURNOUT_VEL / G))
+#define FLIGHT_APOGEE_ALT       (FLIGHT_BURNOUT_ALT + (FLIGHT_BURNOUT_VEL * \
+                                 FLIGHT_BURNOUT_VEL / (2 * G)))
+
+/**
+ *  Get the true state of the simulated flight at a given time.
+ *
+ *  @param t Time in seconds
+ *  @param alt Altitude in metres
+ *  @param vel Vertical velocity in metres per second
+ *  @param accel Vertical acceleration in metres per second squared
+ */
+static void flight_state (double t, double *alt, double *vel, double *accel)
+{
+    if (t < FLIGHT_PAD_TIME) {
+        *alt = 0;
+        *vel = 0;
+        *accel = 0;
+    } else if (t < FLIGHT_BURNOUT_TIME) {
+        double tb = t - FLIGHT_PAD_TIME;
+        *alt = FLIGHT_BOOST_ACCEL * tb * tb / 2;
+        *vel = FLIGHT_BOOST_ACCEL * tb;
+        *accel = FLIGHT_BOOST_ACCEL;
+    } else if (t < FLIGHT_APOGEE_TIME) {
+        double tc = t - FLIGHT_BURNOUT_TIME;
+        *alt = FLIGHT_BURNOUT_ALT + (FLIGHT_BURNOUT_VEL * tc) - (G * tc * tc / 2);
+        *vel = FLIGHT_BURNOUT_VEL - (G * tc);
+        *accel = -G;
+    } else {
+        double td = t - FLIGHT_APOGEE_TIME;
+        *alt = FLIGHT_APOGEE_ALT - (FLIGHT_DESCENT_RATE * td);
+        *vel = -FLIGHT_DESCENT_RATE;
+        *accel = 0;
+    }
+}
+
+/**
+ *  Get the pressure at an altitude in the standard atmosphere.
+ *
+ *  @param alt Altitude in metres
+ *
+ *  @return Pressure in hundredths of a mbar
+ */
+static double pressure_at_altitude (double alt)
+{
+    return 101325.0 * pow(1 - ((0.0065 * alt) / 288.15), 1 / 0.1902225604);
+}
+
+/**
+ *  Get the temperature at an altitude in the standard atmosphere.
+ *
+ *  @param alt Altitude in metres
+ *
+ *  @return Temperature in hundredths of a degree celsius
+ */
+static int32_t temperature_at_altitude (double alt)
+{
+    return (int32_t)lround((15 - (0.0065 * alt)) * 100);
+}
+
+/**
+ *  Calculate altitude from pressure in the same way as the altimeter driver.
+ *
+ *  @param p0 Reference pressure in hundredths of a mbar
+ *  @param p Measured pressure in hundredths of a mbar
+ *  @param temperature Temperature in hundredths of a degree celsius
+ *
+ *  @return Altitude in millimetres
+ */
+static int32_t altitude_from_pressure (int32_t p0, int32_t p,
+                                       int32_t temperature)
+{
+    double t = ((double)(temperature + 27315)) / 100;
+    return (int32_t)lround(((pow(((double)p0 / (double)p), 0.1902225604) -
+                             1.0) * t) / 0.0065 * 1000);
+}
+
+/**
+ *  Get a simulated altimeter pressure measurement.
+ *
+ *  @param alt True altitude in metres
+ *  @param noise Standard deviation of the pressure noise in hundredths of a
+ *               mbar
+ *
+ *  @return Pressure in hundredths of a mbar
+ */
+static int32_t simulated_pressure (double alt, double noise)
+{
+    return (int32_t)lround(pressure_at_altitude(alt) +
+                           (noise * test_rand_normal()));
+}
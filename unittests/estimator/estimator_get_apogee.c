@@ -0,0 +1,87 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  estimator_get_apogee() and estimator_get_time_to_apogee() predict the
+ *  altitude of and time until apogee from the current state.
+ */
+
+
+int main (int argc, char **argv)
+{
+    static struct estimator_t est;
+    
+    // When not ascending the apogee should be the current altitude.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_altitude(&est, 1000000, 0);
+        
+        ut_assert(estimator_get_apogee(&est) == 1000000);
+        ut_assert(estimator_get_time_to_apogee(&est) == 0);
+        
+        est.velocity = -(100000 << 8);
+        ut_assert(estimator_get_apogee(&est) == 1000000);
+        ut_assert(estimator_get_time_to_apogee(&est) == 0);
+    }
+    
+    // With only gravity the prediction should match the ballistic formula.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_altitude(&est, 1000000, 0);
+        
+        for (int32_t v = 1; v <= 1000000; v += 997) {
+            est.velocity = v << 8;
+            double h = 1000000 + ((double)v * v / (2 * ESTIMATOR_GRAVITY));
+            double t = (double)v * 1000 / ESTIMATOR_GRAVITY;
+            
+            ut_assert(fabs(estimator_get_apogee(&est) - h) <= 2);
+            ut_assert(fabs(estimator_get_time_to_apogee(&est) - t) <= 1);
+        }
+    }
+    
+    // A measured deceleration greater than gravity should be used.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_altitude(&est, 0, 0);
+        est.velocity = 200000 << 8;
+        
+        estimator_update_accel(&est, -20000, 0);
+        ut_assert(estimator_get_apogee(&est) == 1000000);
+        ut_assert(estimator_get_time_to_apogee(&est) == 10000);
+        
+        // A deceleration less than gravity should not be used
+        estimator_update_accel(&est, -5000, 0);
+        ut_assert(estimator_get_time_to_apogee(&est) ==
+                  (uint32_t)(((uint64_t)200000 * 1000) / ESTIMATOR_GRAVITY));
+    }
+    
+    // During a simulated coast the predicted apogee should converge on the
+    // actual apogee. Without acceleration measurements the filter lags behind
+    // the deceleration, so the prediction is less accurate.
+    for (int use_accel = 0; use_accel <= 1; use_accel++) {
+        double apogee_tolerance = use_accel ? 500 : 50000;
+        double time_tolerance = use_accel ? 10 : 200;
+        
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        
+        for (uint32_t t = 0; t < (FLIGHT_APOGEE_TIME * 1000); t += 20) {
+            double alt, vel, accel;
+            flight_state(t / 1000.0, &alt, &vel, &accel);
+            
+            if (use_accel) {
+                estimator_update_accel(&est, (int32_t)lround(accel * 1000), t);
+            }
+            estimator_update_altitude(&est, (int32_t)lround(alt * 1000), t);
+            
+            if (t > ((FLIGHT_BURNOUT_TIME + 5) * 1000)) {
+                ut_assert(fabs(estimator_get_apogee(&est) -
+                               (FLIGHT_APOGEE_ALT * 1000)) < apogee_tolerance);
+                ut_assert(fabs(estimator_get_time_to_apogee(&est) -
+                               ((FLIGHT_APOGEE_TIME * 1000) - t)) <
+                          time_tolerance);
+            }
+        }
+    }
+    
+    return UT_PASS;
+}
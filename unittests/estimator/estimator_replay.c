@@ -0,0 +1,191 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define REPLAY_HAVE_TSC
+#endif
+
+/*
+ *  Replays altimeter logs through the estimator and reports how long each
+ *  update takes on the host.
+ *
+ *  If run with no arguments a simulated flight is replayed and the estimates
+ *  are checked against the true state. A recorded log can be replayed by
+ *  passing the path to a CSV file with one sample per line in the form:
+ *      time (ms),pressure (0.01 mbar),temperature (0.01 C)
+ *  The estimates for each sample are printed as CSV.
+ */
+
+/** Interval between simulated samples in milliseconds */
+#define SIM_INTERVAL        20
+/** Length of the simulated log in milliseconds */
+#define SIM_LENGTH          ((uint32_t)((FLIGHT_APOGEE_TIME + 20) * 1000))
+/** Standard deviation of simulated pressure noise in 0.01 mbar */
+#define SIM_NOISE           1.2
+
+
+struct replay_stats_t {
+    uint64_t ns;
+    uint64_t cycles;
+    uint32_t updates;
+};
+
+static uint64_t get_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Pass one logged sample through the estimator.
+ *
+ *  @return The altitude calculated from the sample in millimetres
+ */
+static int32_t replay_sample (struct estimator_t *est,
+                              struct replay_stats_t *stats, int32_t p0,
+                              uint32_t time, int32_t pressure,
+                              int32_t temperature)
+{
+    int32_t altitude = altitude_from_pressure(p0, pressure, temperature);
+    
+    uint64_t start_ns = get_ns();
+#ifdef REPLAY_HAVE_TSC
+    uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+    
+    estimator_update_altitude(est, altitude, time);
+    
+#ifdef REPLAY_HAVE_TSC
+    stats->cycles += __builtin_ia32_rdtsc() - start_cycles;
+#endif
+    stats->ns += get_ns() - start_ns;
+    stats->updates++;
+    
+    return altitude;
+}
+
+static void print_stats (struct replay_stats_t *stats)
+{
+    fprintf(stderr, "%u updates, %.1f ns per update", stats->updates,
+            (double)stats->ns / stats->updates);
+#ifdef REPLAY_HAVE_TSC
+    fprintf(stderr, ", %.1f host cycles per update",
+            (double)stats->cycles / stats->updates);
+#endif
+    fprintf(stderr, "\n");
+}
+
+static int replay_file (const char *path)
+{
+    static struct estimator_t est;
+    struct replay_stats_t stats = { 0 };
+    char line[128];
+    int32_t p0 = 0;
+    
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    
+    init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+    
+    printf("time,altitude,estimated altitude,estimated velocity,apogee,"
+           "time to apogee\n");
+    
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned int time;
+        int pressure, temperature;
+        
+        if (sscanf(line, "%u,%d,%d", &time, &pressure, &temperature) != 3) {
+            // Header or blank line
+            continue;
+        }
+        
+        if (p0 == 0) {
+            p0 = pressure;
+        }
+        
+        int32_t altitude = replay_sample(&est, &stats, p0, time, pressure,
+                                         temperature);
+        
+        printf("%u,%d,%d,%d,%d,%u\n", time, (int)altitude,
+               (int)estimator_get_altitude(&est),
+               (int)estimator_get_velocity(&est),
+               (int)estimator_get_apogee(&est),
+               (unsigned int)estimator_get_time_to_apogee(&est));
+    }
+    
+    fclose(f);
+    print_stats(&stats);
+    return 0;
+}
+
+static int replay_simulated (void)
+{
+    static struct estimator_t est;
+    struct replay_stats_t stats = { 0 };
+    
+    init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+    
+    int32_t p0 = simulated_pressure(0, SIM_NOISE);
+    
+    double max_alt_error = 0;
+    double max_vel_error = 0;
+    double max_apogee_error = 0;
+    double max_descent_vel_error = 0;
+    
+    for (uint32_t t = SIM_INTERVAL; t < SIM_LENGTH; t += SIM_INTERVAL) {
+        double ts = t / 1000.0;
+        double alt, vel, accel;
+        flight_state(ts, &alt, &vel, &accel);
+        
+        replay_sample(&est, &stats, p0, t, simulated_pressure(alt, SIM_NOISE),
+                      temperature_at_altitude(alt));
+        
+        double alt_error = fabs(estimator_get_altitude(&est) - (alt * 1000));
+        double vel_error = fabs(estimator_get_velocity(&est) - (vel * 1000));
+        
+        if ((ts > 1) && (ts < FLIGHT_PAD_TIME)) {
+            // On the pad
+            max_alt_error = fmax(max_alt_error, alt_error);
+            max_vel_error = fmax(max_vel_error, vel_error);
+        } else if ((ts > (FLIGHT_BURNOUT_TIME + 5)) &&
+                   (ts < (FLIGHT_APOGEE_TIME - 1))) {
+            // Coasting
+            max_apogee_error = fmax(max_apogee_error,
+                                    fabs(estimator_get_apogee(&est) -
+                                         (FLIGHT_APOGEE_ALT * 1000)));
+        } else if (ts > (FLIGHT_APOGEE_TIME + 10)) {
+            // Descending
+            max_descent_vel_error = fmax(max_descent_vel_error, vel_error);
+        }
+    }
+    
+    fprintf(stderr, "Pad: max altitude error %.3f m, max velocity error "
+            "%.3f m/s\n", max_alt_error / 1000, max_vel_error / 1000);
+    fprintf(stderr, "Coast: max apogee prediction error %.3f m\n",
+            max_apogee_error / 1000);
+    fprintf(stderr, "Descent: max velocity error %.3f m/s\n",
+            max_descent_vel_error / 1000);
+    print_stats(&stats);
+    
+    ut_assert(max_alt_error < 500);
+    ut_assert(max_vel_error < 2000);
+    ut_assert(max_apogee_error < 75000);
+    ut_assert(max_descent_vel_error < 2000);
+    
+    return UT_PASS;
+}
+
+int main (int argc, char **argv)
+{
+    if (argc > 1) {
+        return replay_file(argv[1]);
+    }
+    
+    return replay_simulated();
+}
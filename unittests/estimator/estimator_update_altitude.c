@@ -0,0 +1,125 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  estimator_update_altitude() updates the altitude and velocity estimates
+ *  with a new altitude sample.
+ */
+
+
+int main (int argc, char **argv)
+{
+    static struct estimator_t est;
+    
+    // The first sample should set the altitude with no velocity.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_altitude(&est, 123456, 1000);
+        
+        ut_assert(estimator_get_altitude(&est) == 123456);
+        ut_assert(estimator_get_velocity(&est) == 0);
+    }
+    
+    // A constant altitude should give a constant estimate with no velocity.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        
+        for (uint32_t t = 0; t < 10000; t += 20) {
+            estimator_update_altitude(&est, -5000, t);
+        }
+        
+        ut_assert(estimator_get_altitude(&est) == -5000);
+        ut_assert(estimator_get_velocity(&est) == 0);
+    }
+    
+    // A constant velocity should be tracked with no lag once the filter has
+    // settled, for any sample interval.
+    {
+        static const uint32_t intervals[] = { 1, 10, 20, 100, 1000 };
+        
+        for (unsigned i = 0; i < (sizeof(intervals) / sizeof(intervals[0]));
+             i++) {
+            init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+            
+            int32_t alt = 0;
+            for (uint32_t n = 0; n < 2000; n++) {
+                // 50 m/s
+                alt = (int32_t)(50 * intervals[i] * n);
+                estimator_update_altitude(&est, alt, intervals[i] * n);
+            }
+            
+            ut_assert(abs(estimator_get_altitude(&est) - alt) <= 2);
+            ut_assert(abs(estimator_get_velocity(&est) - 50000) <= 5);
+        }
+    }
+    
+    // Noise in the samples should be reduced.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        
+        double sum_sq_raw = 0;
+        double sum_sq_est = 0;
+        double sum_sq_vel = 0;
+        unsigned n = 0;
+        
+        for (uint32_t t = 0; t < 60000; t += 20) {
+            // 0.5 m standard deviation
+            int32_t sample = (int32_t)lround(500 * test_rand_normal());
+            estimator_update_altitude(&est, sample, t);
+            
+            if (t >= 10000) {
+                double e = estimator_get_altitude(&est);
+                double v = estimator_get_velocity(&est);
+                sum_sq_raw += (double)sample * sample;
+                sum_sq_est += e * e;
+                sum_sq_vel += v * v;
+                n++;
+            }
+        }
+        
+        ut_assert(sqrt(sum_sq_est / n) < (0.5 * sqrt(sum_sq_raw / n)));
+        // Velocity noise should be less than 2 m/s
+        ut_assert(sqrt(sum_sq_vel / n) < 2000);
+    }
+    
+    // An acceleration measurement should be used to predict the state.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        
+        // Constant 10 m/s^2 acceleration
+        for (uint32_t t = 0; t <= 5000; t += 10) {
+            double ts = t / 1000.0;
+            estimator_update_accel(&est, 10000, t);
+            estimator_update_altitude(&est, (int32_t)lround(5000 * ts * ts), t);
+        }
+        
+        // With the acceleration known there should be no lag
+        ut_assert(abs(estimator_get_altitude(&est) - 125000) <= 20);
+        ut_assert(abs(estimator_get_velocity(&est) - 50000) <= 50);
+        
+        // Old acceleration measurements should not be used
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_accel(&est, 10000, 0);
+        estimator_update_altitude(&est, 0, 1000);
+        estimator_update_altitude(&est, 0, 1010);
+        ut_assert(estimator_get_velocity(&est) == 0);
+    }
+    
+    // A long gap between samples should restart the estimate.
+    {
+        init_estimator(&est, NULL, TEST_ALPHA, TEST_BETA);
+        estimator_update_altitude(&est, 0, 0);
+        estimator_update_altitude(&est, 1000, 10);
+        ut_assert(estimator_get_velocity(&est) != 0);
+        
+        estimator_update_altitude(&est, 50000, 100000);
+        ut_assert(estimator_get_altitude(&est) == 50000);
+        ut_assert(estimator_get_velocity(&est) == 0);
+        
+        // Duplicate samples should be ignored
+        estimator_update_altitude(&est, 60000, 100000);
+        ut_assert(estimator_get_altitude(&est) == 50000);
+    }
+    
+    return UT_PASS;
+}
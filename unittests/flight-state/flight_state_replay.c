@@ -0,0 +1,262 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define REPLAY_HAVE_TSC
+#endif
+
+/*
+ *  Replays altimeter logs through the estimator and flight state machine and
+ *  checks when each transition happens.
+ *
+ *  If run with no arguments a simulated flight is replayed, with and without
+ *  an accelerometer, and the transition times are checked against the true
+ *  flight events. The simulated altimeter is sampled at the period requested
+ *  by the state machine. A recorded log can be replayed by passing the path to
+ *  a CSV file with one sample per line in the form:
+ *      time (ms),pressure (0.01 mbar),temperature (0.01 C)
+ *  The time of each transition is printed.
+ */
+
+/** Standard deviation of simulated pressure noise in 0.01 mbar */
+#define SIM_NOISE           1.2
+/** Standard deviation of simulated acceleration noise in m/s^2 */
+#define SIM_ACCEL_NOISE     0.5
+/** Length of the simulated log in milliseconds */
+#define SIM_LENGTH          ((uint32_t)((FLIGHT_LANDING_TIME + 30) * 1000))
+
+
+static struct ms5611_desc_t altimeter;
+static struct estimator_t est;
+static struct flight_state_desc_t fs;
+
+struct replay_stats_t {
+    uint64_t ns;
+    uint64_t max_ns;
+    uint64_t cycles;
+    uint64_t max_cycles;
+    uint32_t services;
+};
+
+static uint64_t get_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+static void reset (void)
+{
+    memset(&altimeter, 0, sizeof(altimeter));
+    init_estimator(&est, &altimeter, TEST_ALPHA, TEST_BETA);
+    init_flight_state(&fs, &est, flight_state_default_rates);
+}
+
+/**
+ *  Pass one logged sample through the estimator and state machine.
+ *
+ *  @return 1 if the state changed
+ */
+static uint8_t replay_sample (struct replay_stats_t *stats, int32_t p0,
+                              uint32_t time, int32_t pressure,
+                              int32_t temperature)
+{
+    enum flight_state state = flight_state_get_state(&fs);
+    
+    estimator_update_altitude(&est, altitude_from_pressure(p0, pressure,
+                                                           temperature), time);
+    
+    uint64_t start_ns = get_ns();
+#ifdef REPLAY_HAVE_TSC
+    uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+    
+    flight_state_service(&fs);
+    
+#ifdef REPLAY_HAVE_TSC
+    uint64_t cycles = __builtin_ia32_rdtsc() - start_cycles;
+    stats->cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+#endif
+    uint64_t ns = get_ns() - start_ns;
+    stats->ns += ns;
+    if (ns > stats->max_ns) {
+        stats->max_ns = ns;
+    }
+    stats->services++;
+    
+    return flight_state_get_state(&fs) != state;
+}
+
+static void print_stats (struct replay_stats_t *stats)
+{
+    fprintf(stderr, "%u services, %.1f ns per service (max %u ns)",
+            stats->services, (double)stats->ns / stats->services,
+            (unsigned int)stats->max_ns);
+#ifdef REPLAY_HAVE_TSC
+    fprintf(stderr, ", %.1f host cycles per service (max %u)",
+            (double)stats->cycles / stats->services,
+            (unsigned int)stats->max_cycles);
+#endif
+    fprintf(stderr, "\n");
+}
+
+static int replay_file (const char *path)
+{
+    struct replay_stats_t stats = { 0 };
+    char line[128];
+    int32_t p0 = 0;
+    
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    
+    reset();
+    
+    printf("time,state\n");
+    
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned int time;
+        int pressure, temperature;
+        
+        if (sscanf(line, "%u,%d,%d", &time, &pressure, &temperature) != 3) {
+            // Header or blank line
+            continue;
+        }
+        
+        if (p0 == 0) {
+            p0 = pressure;
+        }
+        
+        uint8_t parachute = flight_state_parachute_deployed(&fs);
+        
+        if (replay_sample(&stats, p0, time, pressure, temperature)) {
+            enum flight_state state = flight_state_get_state(&fs);
+            printf("%u,%s\n", (unsigned int)flight_state_get_transition_time(
+                                                                &fs, state),
+                   flight_state_name(state));
+        }
+        
+        if (!parachute && flight_state_parachute_deployed(&fs)) {
+            printf("%u,parachute deployed\n", time);
+        }
+    }
+    
+    fclose(f);
+    print_stats(&stats);
+    return 0;
+}
+
+/**
+ *  Replay a simulated flight.
+ *
+ *  @param use_accel Whether a simulated accelerometer should be used
+ *  @param stats Timing statistics
+ */
+static void replay_simulated (uint8_t use_accel, struct replay_stats_t *stats)
+{
+    reset();
+    
+    if (use_accel) {
+        flight_state_use_accel(&fs, TEST_ACCEL_CHAN, TEST_ACCEL_ZERO,
+                               TEST_ACCEL_SCALE);
+    }
+    
+    int32_t p0 = simulated_pressure(0, SIM_NOISE);
+    uint32_t parachute_time = 0;
+    enum flight_state last_state = FLIGHT_STATE_STANDBY;
+    
+    for (uint32_t t = 10; t < SIM_LENGTH; t += altimeter.period) {
+        double ts = t / 1000.0;
+        double alt, vel, accel;
+        flight_state_at(ts, &alt, &vel, &accel);
+        
+        if (use_accel) {
+            set_accel(accel + (SIM_ACCEL_NOISE * test_rand_normal()), t);
+        }
+        
+        replay_sample(stats, p0, t, simulated_pressure(alt, SIM_NOISE),
+                      temperature_at_altitude(alt));
+        
+        // States should only ever advance one at a time
+        enum flight_state state = flight_state_get_state(&fs);
+        ut_assert((state == last_state) || (state == (last_state + 1)));
+        last_state = state;
+        
+        // Sampling rate should follow the state
+        ut_assert(altimeter.period ==
+                  flight_state_default_rates[state].altimeter_period);
+        
+        if (!parachute_time && flight_state_parachute_deployed(&fs)) {
+            parachute_time = t;
+        }
+    }
+    
+    double launch = flight_state_get_transition_time(&fs,
+                                FLIGHT_STATE_POWERED_ASCENT) / 1000.0;
+    double burnout = flight_state_get_transition_time(&fs,
+                                FLIGHT_STATE_COASTING_ASCENT) / 1000.0;
+    double apogee = flight_state_get_transition_time(&fs,
+                                FLIGHT_STATE_DESCENT) / 1000.0;
+    double landing = flight_state_get_transition_time(&fs,
+                                FLIGHT_STATE_RECOVERY) / 1000.0;
+    
+    fprintf(stderr, "%s accelerometer:\n", use_accel ? "With" : "Without");
+    fprintf(stderr, "    pre-flight at %.3f s\n",
+            flight_state_get_transition_time(&fs, FLIGHT_STATE_PRE_FLIGHT) /
+            1000.0);
+    fprintf(stderr, "    launch at %.3f s (%+.3f s)\n", launch,
+            launch - FLIGHT_PAD_TIME);
+    fprintf(stderr, "    burnout at %.3f s (%+.3f s)\n", burnout,
+            burnout - FLIGHT_BURNOUT_TIME);
+    fprintf(stderr, "    apogee at %.3f s (%+.3f s)\n", apogee,
+            apogee - FLIGHT_APOGEE_TIME);
+    fprintf(stderr, "    parachute at %.3f s (%+.3f s after apogee)\n",
+            parachute_time / 1000.0, (parachute_time / 1000.0) -
+            FLIGHT_APOGEE_TIME);
+    fprintf(stderr, "    landing at %.3f s (%+.3f s)\n", landing,
+            landing - FLIGHT_LANDING_TIME);
+    
+    ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_RECOVERY);
+    ut_assert(flight_state_parachute_deployed(&fs));
+    
+    ut_assert(flight_state_get_transition_time(&fs, FLIGHT_STATE_PRE_FLIGHT) <
+              (FLIGHT_PAD_TIME * 1000));
+    ut_assert((launch >= FLIGHT_PAD_TIME) &&
+              (launch < (FLIGHT_PAD_TIME + 0.5)));
+    if (use_accel) {
+        ut_assert((burnout >= FLIGHT_BURNOUT_TIME) &&
+                  (burnout < (FLIGHT_BURNOUT_TIME + 0.1)));
+    } else {
+        ut_assert((burnout >= FLIGHT_BURNOUT_TIME) &&
+                  (burnout < (FLIGHT_BURNOUT_TIME + 1.5)));
+    }
+    ut_assert(fabs(apogee - FLIGHT_APOGEE_TIME) < 1.0);
+    ut_assert(((parachute_time / 1000.0) - FLIGHT_APOGEE_TIME) <
+              ((FLIGHT_STATE_PARACHUTE_DELAY +
+                FLIGHT_STATE_PARACHUTE_DEBOUNCE) / 1000.0) + 1);
+    ut_assert((landing >= FLIGHT_LANDING_TIME - 1) &&
+              (landing < (FLIGHT_LANDING_TIME + 2)));
+}
+
+int main (int argc, char **argv)
+{
+    if (argc > 1) {
+        return replay_file(argv[1]);
+    }
+    
+    struct replay_stats_t stats = { 0 };
+    
+    replay_simulated(0, &stats);
+    replay_simulated(1, &stats);
+    
+    print_stats(&stats);
+    
+    return UT_PASS;
+}
@@ -0,0 +1,259 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  flight_state_service() checks for state transitions each time the
+ *  estimator is updated.
+ */
+
+static struct ms5611_desc_t altimeter;
+static struct estimator_t est;
+static struct flight_state_desc_t fs;
+
+static void reset (void)
+{
+    memset(&altimeter, 0, sizeof(altimeter));
+    memset(adc_gains, 0, sizeof(adc_gains));
+    init_estimator(&est, &altimeter, TEST_ALPHA, TEST_BETA);
+    init_flight_state(&fs, &est, flight_state_default_rates);
+}
+
+/**
+ *  Provide a sample to the estimator and service the state machine.
+ */
+static void sample (int32_t altitude, uint32_t time)
+{
+    estimator_update_altitude(&est, altitude, time);
+    flight_state_service(&fs);
+}
+
+/**
+ *  Provide samples at a constant altitude for a period of time.
+ *
+ *  @return The time after the last sample
+ */
+static uint32_t hold (int32_t altitude, uint32_t start, uint32_t duration)
+{
+    uint32_t t;
+    for (t = start; t < (start + duration); t += 10) {
+        sample(altitude, t);
+    }
+    return t;
+}
+
+
+int main (int argc, char **argv)
+{
+    // The state machine should start in standby with standby rates.
+    {
+        reset();
+        
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_STANDBY);
+        ut_assert(altimeter.period ==
+                  flight_state_default_rates[FLIGHT_STATE_STANDBY].
+                                                            altimeter_period);
+        ut_assert(flight_state_get_telemetry_period(&fs) ==
+                  flight_state_default_rates[FLIGHT_STATE_STANDBY].
+                                                            telemetry_period);
+        ut_assert(!flight_state_parachute_deployed(&fs));
+        
+        // Nothing should happen without estimates
+        for (int i = 0; i < 100; i++) {
+            flight_state_service(&fs);
+        }
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_STANDBY);
+    }
+    
+    // Standby should last until the vehicle has been at rest for long enough.
+    {
+        reset();
+        
+        // Moving, should not leave standby
+        for (uint32_t t = 1; t < 10000; t += 10) {
+            sample((int32_t)(t * 5), t);
+        }
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_STANDBY);
+        
+        uint32_t t = hold(50000, 10001, FLIGHT_STATE_STANDBY_TIME);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_STANDBY);
+        
+        t = hold(50000, t, 3000);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        ut_assert(flight_state_get_transition_time(&fs,
+                                        FLIGHT_STATE_PRE_FLIGHT) > 15000);
+        ut_assert(abs(fs.ground_altitude - 50000) < 100);
+        ut_assert(altimeter.period ==
+                  flight_state_default_rates[FLIGHT_STATE_PRE_FLIGHT].
+                                                            altimeter_period);
+        ut_assert(flight_state_get_telemetry_period(&fs) ==
+                  flight_state_default_rates[FLIGHT_STATE_PRE_FLIGHT].
+                                                            telemetry_period);
+    }
+    
+    // A period shorter than the altimeter can meet should be raised to its
+    // minimum period.
+    {
+        reset();
+        altimeter.min_period = 22;
+        
+        hold(0, 1, FLIGHT_STATE_STANDBY_TIME + 100);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        ut_assert(altimeter.period == 22);
+        
+        // Longer periods should be unchanged
+        altimeter.min_period = 5;
+        flight_state_transition(&fs, FLIGHT_STATE_RECOVERY, 100000);
+        ut_assert(altimeter.period ==
+                  flight_state_default_rates[FLIGHT_STATE_RECOVERY].
+                                                            altimeter_period);
+    }
+    
+    // Launch should require both speed and height above the ground.
+    {
+        reset();
+        uint32_t t = hold(0, 1, FLIGHT_STATE_STANDBY_TIME + 100);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        
+        // A single bad sample should not be a launch
+        sample(20000, t);
+        t = hold(0, t + 10, 5000);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        
+        // Accelerate at 50 m/s^2
+        uint32_t launch = t;
+        for (; t < (launch + 2000); t += 10) {
+            sample((int32_t)(((t - launch) * (t - launch)) / 40), t);
+        }
+        ut_assert(flight_state_get_state(&fs) ==
+                  FLIGHT_STATE_POWERED_ASCENT);
+        ut_assert((flight_state_get_transition_time(&fs,
+                                    FLIGHT_STATE_POWERED_ASCENT) - launch) <
+                  500);
+        ut_assert(altimeter.period ==
+                  flight_state_default_rates[FLIGHT_STATE_POWERED_ASCENT].
+                                                            altimeter_period);
+    }
+    
+    // Launch should be detected from acceleration alone.
+    {
+        reset();
+        flight_state_use_accel(&fs, TEST_ACCEL_CHAN, TEST_ACCEL_ZERO,
+                               TEST_ACCEL_SCALE);
+        
+        uint32_t t = 1;
+        for (; t < (FLIGHT_STATE_STANDBY_TIME + 100); t += 10) {
+            set_accel(0, t);
+            sample(0, t);
+        }
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        ut_assert(adc_last_channel == TEST_ACCEL_CHAN);
+        ut_assert(abs(fs.accel) < TEST_ACCEL_SCALE);
+        ut_assert(abs(est.accel - fs.accel) == 0);
+        
+        // A single spike should not be a launch
+        set_accel(100, t);
+        sample(0, t);
+        t += 10;
+        set_accel(0, t);
+        sample(0, t);
+        t += 10;
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_PRE_FLIGHT);
+        
+        uint32_t launch = t;
+        for (; t < (launch + 100); t += 10) {
+            set_accel(100, t);
+            sample(0, t);
+        }
+        ut_assert(flight_state_get_state(&fs) ==
+                  FLIGHT_STATE_POWERED_ASCENT);
+        ut_assert(flight_state_get_transition_time(&fs,
+                                    FLIGHT_STATE_POWERED_ASCENT) == launch);
+        
+        // Burnout should be detected when thrust stops
+        uint32_t burnout = t;
+        for (; t < (burnout + 200); t += 10) {
+            set_accel(-12, t);
+            sample(0, t);
+        }
+        ut_assert(flight_state_get_state(&fs) ==
+                  FLIGHT_STATE_COASTING_ASCENT);
+        ut_assert(flight_state_get_transition_time(&fs,
+                                FLIGHT_STATE_COASTING_ASCENT) == burnout);
+    }
+    
+    // A realistic accelerometer output should be measured through boost and
+    // burnout of the simulated flight.
+    {
+        reset();
+        flight_state_use_accel(&fs, TEST_ACCEL_CHAN, TEST_ACCEL_ZERO,
+                               TEST_ACCEL_SCALE);
+        ut_assert(adc_gains[TEST_ACCEL_CHAN] == ADC_GAIN_DIV2);
+        
+        uint32_t launch = (uint32_t)(FLIGHT_PAD_TIME * 1000);
+        uint32_t burnout = (uint32_t)(FLIGHT_BURNOUT_TIME * 1000);
+        uint32_t t = 1;
+        for (; t < (burnout + 500); t += 20) {
+            double alt, vel, accel;
+            flight_state_at(t / 1000.0, &alt, &vel, &accel);
+            set_accel(accel, t);
+            sample((int32_t)lround(alt * 1000), t);
+            
+            if (t == (launch - 19)) {
+                // Only gravity on the pad
+                ut_assert(flight_state_get_state(&fs) ==
+                          FLIGHT_STATE_PRE_FLIGHT);
+                ut_assert(abs(fs.accel) < TEST_ACCEL_SCALE);
+            } else if (t == (burnout - 19)) {
+                // Thrust is measured without clipping
+                ut_assert(flight_state_get_state(&fs) ==
+                          FLIGHT_STATE_POWERED_ASCENT);
+                ut_assert(abs(fs.accel - (int32_t)(FLIGHT_BOOST_ACCEL * 1000)) <
+                          TEST_ACCEL_SCALE);
+            }
+        }
+        
+        ut_assert(flight_state_get_state(&fs) ==
+                  FLIGHT_STATE_COASTING_ASCENT);
+        ut_assert((flight_state_get_transition_time(&fs,
+                                    FLIGHT_STATE_POWERED_ASCENT) - launch) <
+                  100);
+        ut_assert((flight_state_get_transition_time(&fs,
+                                    FLIGHT_STATE_COASTING_ASCENT) - burnout) <
+                  100);
+        ut_assert(abs(fs.accel + (int32_t)(G * 1000)) < TEST_ACCEL_SCALE);
+    }
+    
+    // Apogee should be detected from a drop in altitude even if the
+    // velocity estimate is positive.
+    {
+        reset();
+        fs.state = FLIGHT_STATE_COASTING_ASCENT;
+        sample(1000000, 1);
+        fs.max_altitude = 1000000 + FLIGHT_STATE_APOGEE_ALTITUDE_DROP + 1;
+        est.velocity = 1 << 16;
+        
+        est.last_time = 100;
+        flight_state_service(&fs);
+        ut_assert(flight_state_get_state(&fs) ==
+                  FLIGHT_STATE_COASTING_ASCENT);
+        
+        est.last_time = 100 + FLIGHT_STATE_APOGEE_DEBOUNCE;
+        flight_state_service(&fs);
+        ut_assert(flight_state_get_state(&fs) == FLIGHT_STATE_DESCENT);
+        ut_assert(flight_state_get_transition_time(&fs, FLIGHT_STATE_DESCENT) ==
+                  100);
+    }
+    
+    // Names should be available for all states.
+    {
+        for (int i = 0; i < FLIGHT_STATE_NUM_STATES; i++) {
+            ut_assert(flight_state_name((enum flight_state)i) != NULL);
+        }
+        ut_assert(!strcmp(flight_state_name(FLIGHT_STATE_RECOVERY),
+                          "recovery"));
+        ut_assert(!strcmp(flight_state_name(FLIGHT_STATE_NUM_STATES),
+                          "unknown"));
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,128 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+
+/* Console and UART stubs */
+
+static void (*uart_rx_callback)(uint8_t, void*);
+static void (*console_line_callback)(char*, struct console_desc_t*, void*);
+
+void console_set_line_callback (struct console_desc_t *console,
+                                void (*callback)(char*, struct console_desc_t*,
+                                                 void*), void *context)
+{
+    console_line_callback = callback;
+}
+
+void console_set_init_callback (struct console_desc_t *console,
+                                void (*callback)(struct console_desc_t*, void*),
+                                void *context)
+{
+}
+
+void console_send_str (struct console_desc_t *console, const char *str)
+{
+}
+
+void sercom_uart_set_rx_callback (struct sercom_uart_desc_t *uart,
+                                  void (*rx_callback)(uint8_t, void*),
+                                  void *context)
+{
+    uart_rx_callback = rx_callback;
+}
+
+
+
+/* Timer Counter, GPIO and EVSYS stubs */
+
+/** Frequency of the stub capture timer */
+#define TEST_TC_FREQ    3000000UL
+
+static void (*tc_capture_callback)(uint32_t, void*);
+static uint32_t tc_count;
+static uint8_t evsys_channel_generator = 0xFF;
+static uint8_t evsys_user_channel = 0xFF;
+
+uint8_t init_tc_capture (Tc *tc, uint32_t clock_mask, uint32_t clock_freq,
+                         void (*callback)(uint32_t, void*), void *state)
+{
+    tc_capture_callback = callback;
+    return 0;
+}
+
+uint32_t tc_capture_get_frequency (Tc *tc)
+{
+    return TEST_TC_FREQ;
+}
+
+uint32_t tc_get_count32 (Tc *tc)
+{
+    return tc_count;
+}
+
+uint8_t tc_get_evsys_user_id (Tc *tc)
+{
+    return EVSYS_ID_USER_TC6_EVU;
+}
+
+uint8_t gpio_set_pin_mode (union gpio_pin_t pin, enum gpio_pin_mode mode)
+{
+    return 0;
+}
+
+uint8_t gpio_enable_event (union gpio_pin_t pin,
+                           enum gpio_interrupt_trigger trigger, uint8_t filter,
+                           uint8_t *generator)
+{
+    *generator = EVSYS_ID_GEN_EIC_EXTINT_0 + 15;
+    return 0;
+}
+
+void evsys_configure_channel (uint8_t channel, uint8_t generator,
+                              uint32_t clock_mask, enum evsys_path path,
+                              enum evsys_edge edge)
+{
+    evsys_channel_generator = generator;
+}
+
+void evsys_configure_user_mux (uint8_t user, uint8_t channel)
+{
+    evsys_user_channel = channel;
+}
+
+/**
+ *  Pass a string to the parser one byte at a time, as it would be received by
+ *  the UART, then run the service from the main loop.
+ */
+static void feed (const char *str)
+{
+    for (; *str != '\0'; str++) {
+        uart_rx_callback((uint8_t)*str, NULL);
+    }
+    gnss_xa1110_service();
+}
+
+/**
+ *  Pass a sentence to the parser with its checksum and line ending added.
+ *
+ *  @param body The sentence without the leading '$' or the checksum
+ */
+static void feed_sentence (const char *body)
+{
+    char str[128];
+    uint8_t checksum = 0;
+    
+    for (const char *c = body; *c != '\0'; c++) {
+        checksum ^= (uint8_t)*c;
+    }
+    
+    snprintf(str, sizeof(str), "$%s*%02X\r\n", body, checksum);
+    feed(str);
+}
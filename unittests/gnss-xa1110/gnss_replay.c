@@ -0,0 +1,141 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define REPLAY_HAVE_TSC
+#endif
+
+/*
+ *  Replays NMEA logs through the parser and reports how many sentences can be
+ *  parsed per second on the host.
+ *
+ *  If run with no arguments a log made up of one second of output from the
+ *  receiver is replayed repeatedly and every sentence is checked to have been
+ *  accepted. A recorded log can be replayed by passing the path to a file with
+ *  one sentence per line.
+ */
+
+/** Number of times the built in log is replayed */
+#define REPLAY_ITERATIONS   20000
+
+static const char *const replay_log[] = {
+    "$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,"
+        "A*32\r\n",
+    "$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.9,M,17.8,M,,"
+        "*7D\r\n",
+    "$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n",
+    "$GLGSA,A,3,65,66,80,,,,,,,,,,2.32,0.95,2.11*18\r\n",
+    "$GPGSV,3,1,09,29,36,029,42,21,46,314,43,26,44,020,43,15,21,321,39"
+        "*7D\r\n",
+    "$GPGSV,3,3,09,10,05,100,20*47\r\n",
+    "$PGACK,SW_ANT_External*10\r\n"
+};
+
+#define REPLAY_LOG_LEN (sizeof(replay_log) / sizeof(replay_log[0]))
+
+struct replay_stats_t {
+    uint64_t ns;
+    uint64_t cycles;
+    uint64_t bytes;
+    uint32_t sentences;
+    uint32_t accepted;
+};
+
+static struct console_desc_t console;
+
+static uint64_t get_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Pass one sentence through the parser.
+ */
+static void replay_sentence (struct replay_stats_t *stats, const char *str)
+{
+    millis++;
+    
+    uint64_t start_ns = get_ns();
+#ifdef REPLAY_HAVE_TSC
+    uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+    
+    const char *c;
+    for (c = str; *c != '\0'; c++) {
+        gnss_rx_callback((uint8_t)*c, NULL);
+    }
+    gnss_xa1110_service();
+    
+#ifdef REPLAY_HAVE_TSC
+    stats->cycles += __builtin_ia32_rdtsc() - start_cycles;
+#endif
+    stats->ns += get_ns() - start_ns;
+    stats->bytes += (uint64_t)(c - str);
+    stats->sentences++;
+    stats->accepted += gnss_xa1110_descriptor.last_sentence == millis;
+}
+
+static void print_stats (struct replay_stats_t *stats)
+{
+    fprintf(stderr, "%u sentences (%u accepted), %.0f sentences per second, "
+            "%.1f ns per byte", stats->sentences, stats->accepted,
+            stats->sentences / (stats->ns / 1e9),
+            (double)stats->ns / stats->bytes);
+#ifdef REPLAY_HAVE_TSC
+    fprintf(stderr, ", %.1f host cycles per byte",
+            (double)stats->cycles / stats->bytes);
+#endif
+    fprintf(stderr, "\n");
+}
+
+static int replay_file (const char *path)
+{
+    struct replay_stats_t stats = { 0 };
+    char line[128];
+    
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    
+    while (fgets(line, sizeof(line), f) != NULL) {
+        replay_sentence(&stats, line);
+    }
+    
+    fclose(f);
+    print_stats(&stats);
+    return 0;
+}
+
+int main (int argc, char **argv)
+{
+    console.type = CONSOLE_TYPE_UART;
+    init_gnss_xa1110(&console);
+    
+    if (argc > 1) {
+        return replay_file(argv[1]);
+    }
+    
+    struct replay_stats_t stats = { 0 };
+    
+    for (uint32_t i = 0; i < REPLAY_ITERATIONS; i++) {
+        for (uint8_t j = 0; j < REPLAY_LOG_LEN; j++) {
+            replay_sentence(&stats, replay_log[j]);
+        }
+    }
+    
+    print_stats(&stats);
+    
+    ut_assert(stats.accepted == stats.sentences);
+    ut_assert(gnss_xa1110_descriptor.altitude == 39900);
+    ut_assert(gnss_xa1110_descriptor.num_gps_sats_in_view == 9);
+    ut_assert(gnss_xa1110_descriptor.antenna == GNSS_ANTENNA_EXTERNAL);
+    
+    return UT_PASS;
+}
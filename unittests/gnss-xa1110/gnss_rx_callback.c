@@ -0,0 +1,231 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  gnss_rx_callback() parses NMEA sentences one byte at a time and updates the
+ *  GNSS descriptor once a sentence with a valid checksum has been received.
+ */
+
+static struct console_desc_t console;
+
+static void reset (void)
+{
+    memset(&gnss_xa1110_descriptor, 0, sizeof(gnss_xa1110_descriptor));
+    console.type = CONSOLE_TYPE_UART;
+    uart_rx_callback = NULL;
+    init_gnss_xa1110(&console);
+    millis = 1000;
+}
+
+
+int main (int argc, char **argv)
+{
+    struct gnss *desc = &gnss_xa1110_descriptor;
+    
+    // The parser should be attached to the UART receive path.
+    {
+        reset();
+        ut_assert(uart_rx_callback == gnss_rx_callback);
+    }
+    
+    // RMC sentences should update time, position, speed and course.
+    {
+        reset();
+        feed("$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,"
+             "3.05,W,A*32\r\n");
+        
+        ut_assert(desc->last_sentence == 1000);
+        ut_assert(desc->last_fix == 1000);
+        ut_assert(desc->utc_time == 1146034191);
+        ut_assert(desc->latitude == 13871256);
+        ut_assert(desc->longitude == 72164438);
+        ut_assert(desc->speed == 3);
+        ut_assert(desc->course == 16548);
+        
+        // Southern and western hemispheres, leap day
+        millis = 2000;
+        feed("$GNRMC,120000.000,A,4916.4500,S,12311.1200,W,12.50,5.00,290224,"
+             ",,A*48\r\n");
+        
+        ut_assert(desc->last_fix == 2000);
+        ut_assert(desc->utc_time == 1709208000);
+        ut_assert(desc->latitude == -29564500);
+        ut_assert(desc->longitude == -73911200);
+        ut_assert(desc->speed == 1250);
+        ut_assert(desc->course == 500);
+    }
+    
+    // RMC sentences without a fix should only update the time.
+    {
+        reset();
+        desc->latitude = 1234;
+        feed("$GNRMC,235959.000,V,,,,,,,311219,,,N*5B\r\n");
+        
+        ut_assert(desc->last_sentence == 1000);
+        ut_assert(desc->last_fix == 0);
+        ut_assert(desc->utc_time == 1577836799);
+        ut_assert(desc->latitude == 1234);
+    }
+    
+    // GGA sentences should update altitude, fix quality and satellite count.
+    {
+        reset();
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.9,M,17.8,"
+             "M,,*7D\r\n");
+        
+        ut_assert(desc->altitude == 39900);
+        ut_assert(desc->fix_quality == GNSS_QUALITY_GPS_FIX);
+        ut_assert(desc->num_sats_in_use == 8);
+        
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,-12.25,M,"
+             "17.8,M,,*67\r\n");
+        
+        ut_assert(desc->altitude == -12250);
+    }
+    
+    // GSA sentences should update the fix type, DOPs and satellites in use.
+    {
+        reset();
+        feed("$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n");
+        
+        ut_assert(desc->last_meta == 1000);
+        ut_assert(desc->fix_type == GNSS_FIX_3D);
+        ut_assert(desc->pdop == 232);
+        ut_assert(desc->hdop == 95);
+        ut_assert(desc->vdop == 211);
+        ut_assert(desc->gps_sats_in_use == ((1UL << 29) | (1UL << 21) |
+                                            (1UL << 26) | (1UL << 15) |
+                                            (1UL << 18) | (1UL << 9) |
+                                            (1UL << 6) | (1UL << 10)));
+        
+        feed("$GLGSA,A,3,65,66,80,,,,,,,,,,2.32,0.95,2.11*18\r\n");
+        
+        ut_assert(desc->glonass_sats_in_use == ((1UL << 0) | (1UL << 1) |
+                                                (1UL << 15)));
+        ut_assert(desc->gps_sats_in_use & (1UL << 29));
+    }
+    
+    // GSV sentences should update the in view satellites.
+    {
+        reset();
+        feed("$GPGSV,3,1,09,29,36,029,42,21,46,314,43,26,44,020,43,15,21,321,"
+             "39*7D\r\n");
+        
+        ut_assert(desc->last_gsv == 1000);
+        ut_assert(desc->num_gps_sats_in_view == 9);
+        ut_assert(desc->in_view_gps_satellites[0].prn == 29);
+        ut_assert(desc->in_view_gps_satellites[0].elevation == 36);
+        ut_assert(desc->in_view_gps_satellites[0].azimuth == 29);
+        ut_assert(desc->in_view_gps_satellites[0].snr == 42);
+        ut_assert(desc->in_view_gps_satellites[3].prn == 15);
+        ut_assert(desc->in_view_gps_satellites[3].azimuth == 321);
+        
+        feed("$GPGSV,3,3,09,10,05,100,20*47\r\n");
+        
+        ut_assert(desc->in_view_gps_satellites[8].prn == 10);
+        ut_assert(desc->in_view_gps_satellites[8].elevation == 5);
+        ut_assert(desc->in_view_gps_satellites[8].azimuth == 100);
+        ut_assert(desc->in_view_gps_satellites[8].snr == 20);
+        ut_assert(desc->in_view_gps_satellites[9].prn == 0);
+    }
+    
+    // PGACK sentences should update the antenna.
+    {
+        reset();
+        feed("$PGACK,SW_ANT_External*10\r\n");
+        ut_assert(desc->antenna == GNSS_ANTENNA_EXTERNAL);
+        feed("$PGACK,SW_ANT_Internal*0A\r\n");
+        ut_assert(desc->antenna == GNSS_ANTENNA_INTERNAL);
+    }
+    
+    // Sentences with bad checksums should not change anything.
+    {
+        reset();
+        feed("$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,"
+             "3.05,W,A*33\r\n");
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.9,M,17.8,"
+             "M,,*7G\r\n");
+        // Corrupted in transit
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.8,M,17.8,"
+             "M,,*7D\r\n");
+        
+        ut_assert(desc->last_sentence == 0);
+        ut_assert(desc->last_fix == 0);
+        ut_assert(desc->latitude == 0);
+        ut_assert(desc->altitude == 0);
+    }
+    
+    // The parser should resynchronize after garbage and truncated sentences.
+    {
+        reset();
+        // Garbage, then a sentence cut off by the start of another
+        feed("\xff\x00*12,,$GNGGA,064951.000,2307.1256,N,12016.44");
+        // A sentence cut off by the end of a line
+        feed("$GPGSA,A,3,29,21\r\n");
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.9,M,17.8,"
+             "M,,*7D\r\n");
+        
+        ut_assert(desc->altitude == 39900);
+        ut_assert(desc->fix_type == GNSS_FIX_UNKOWN);
+    }
+    
+    // Unknown sentences should be ignored but still count as received.
+    {
+        reset();
+        feed("$GPGSV,3,1,09,29,36,029,42,21,46,314,43,26,44,020,43,15,21,321,"
+             "39*7D\r\n");
+        ut_assert(desc->last_sentence == 1000);
+    }
+    
+    // Sentences should only reach the descriptor from the service, stamped
+    // with the time at which they were received.
+    {
+        reset();
+        const char *str = ("$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,"
+                           "165.48,260406,3.05,W,A*32\r\n");
+        for (; *str != '\0'; str++) {
+            uart_rx_callback((uint8_t)*str, NULL);
+        }
+        
+        ut_assert(desc->last_sentence == 0);
+        ut_assert(desc->last_fix == 0);
+        ut_assert(desc->utc_time == 0);
+        ut_assert(desc->latitude == 0);
+        
+        millis = 1500;
+        gnss_xa1110_service();
+        
+        ut_assert(desc->last_sentence == 1000);
+        ut_assert(desc->last_fix == 1000);
+        ut_assert(desc->utc_time == 1146034191);
+        ut_assert(desc->latitude == 13871256);
+        ut_assert(desc->longitude == 72164438);
+    }
+    
+    // Sentences received while the queue is full should be dropped.
+    {
+        reset();
+        const char *str = ("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,"
+                           "0.95,39.9,M,17.8,M,,*7D\r\n");
+        for (int i = 0; i < GNSS_READY_LEN; i++) {
+            for (const char *c = str; *c != '\0'; c++) {
+                uart_rx_callback((uint8_t)*c, NULL);
+            }
+        }
+        millis = 2000;
+        feed("$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,0.95,39.8,M,17.8,"
+             "M,,*7C\r\n");
+        
+        ut_assert(desc->last_sentence == 2000);
+        ut_assert(desc->altitude == 39900);
+    }
+    
+    // An invalid month should not add a leap day.
+    {
+        reset();
+        feed_sentence("GNRMC,120000.000,V,,,,,,,290024,,,N");
+        ut_assert(desc->utc_time == 1706529600);
+    }
+    
+    return UT_PASS;
+}
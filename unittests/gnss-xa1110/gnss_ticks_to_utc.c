@@ -0,0 +1,175 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  gnss_ticks_to_utc() converts pulse per second timer counts to UTC once a
+ *  pulse has been matched with the time from an RMC sentence.
+ */
+
+/** Simulated timer ticks per second, 100 ppm fast */
+#define TICKS_PER_SECOND    3000300
+/** Time between each pulse and the following RMC sentence in milliseconds */
+#define RMC_DELAY           250
+
+static struct console_desc_t console;
+
+/** UTC time for 12:00:00 on March 1st 2024 */
+#define START_UTC           1709294400UL
+
+static void reset (void)
+{
+    memset(&gnss_xa1110_descriptor, 0, sizeof(gnss_xa1110_descriptor));
+    memset(&gnss_pps_g, 0, sizeof(gnss_pps_g));
+    console.type = CONSOLE_TYPE_UART;
+    init_gnss_xa1110(&console);
+    gnss_xa1110_use_pps(TC6, 0, 48000000UL, GPIO_PIN_FOR(PIN_PA15), 3);
+}
+
+/**
+ *  Simulate a pulse at the start of a second and the RMC sentence after it.
+ *
+ *  @param second The number of seconds since 12:00:00
+ *  @param ticks The timer count at the pulse
+ *  @param pulse Whether the pulse should be generated
+ */
+static void second (uint32_t second, uint32_t ticks, uint8_t pulse)
+{
+    char body[96];
+    
+    millis = 10000 + (second * 1000);
+    if (pulse) {
+        tc_capture_callback(ticks, NULL);
+    }
+    
+    millis += RMC_DELAY;
+    snprintf(body, sizeof(body), "GNRMC,1200%02u.000,A,2307.1256,N,12016.4438,"
+             "E,0.03,165.48,010324,,,A", (unsigned int)second);
+    feed_sentence(body);
+}
+
+
+int main (int argc, char **argv)
+{
+    struct gnss_time_sync_t sync;
+    uint32_t seconds, microseconds, ticks;
+    uint16_t milliseconds;
+    
+    // The pulse should be routed from the EIC to the timer.
+    {
+        reset();
+        ut_assert(tc_capture_callback == gnss_pps_callback);
+        ut_assert(evsys_channel_generator == EVSYS_ID_GEN_EIC_EXTINT_0 + 15);
+        ut_assert(evsys_user_channel == 3);
+    }
+    
+    // Nothing should be converted before the first pulse is matched.
+    {
+        reset();
+        ut_assert(!gnss_ticks_to_utc(0, &seconds, &microseconds));
+        ut_assert(!gnss_millis_to_utc(0, &seconds, &milliseconds));
+        ut_assert(!gnss_utc_to_ticks(START_UTC, 0, &ticks));
+        ut_assert(!gnss_get_time_sync(&sync));
+        
+        // RMC without a pulse
+        second(0, 0, 0);
+        ut_assert(gnss_xa1110_descriptor.utc_time == START_UTC);
+        ut_assert(!gnss_get_time_sync(&sync));
+    }
+    
+    // Pulses should be matched with the following RMC sentence and the timer
+    // frequency should be measured.
+    {
+        reset();
+        uint32_t base = 0xFFF00000;
+        
+        second(0, base, 1);
+        ut_assert(gnss_get_time_sync(&sync));
+        ut_assert(sync.utc_time == START_UTC);
+        ut_assert(sync.ticks == base);
+        ut_assert(sync.millis == 10000);
+        // Only one pulse, nominal frequency
+        ut_assert(sync.ticks_per_second == TEST_TC_FREQ);
+        
+        // Timer wraps between pulses
+        second(1, base + TICKS_PER_SECOND, 1);
+        second(2, base + (2 * TICKS_PER_SECOND), 1);
+        ut_assert(gnss_get_time_sync(&sync));
+        ut_assert(sync.utc_time == START_UTC + 2);
+        ut_assert(sync.ticks == base + (2 * TICKS_PER_SECOND));
+        ut_assert(sync.ticks_per_second == TICKS_PER_SECOND);
+        
+        // Half way through the second
+        uint32_t pulse = base + (2 * TICKS_PER_SECOND);
+        ut_assert(gnss_ticks_to_utc(pulse + (TICKS_PER_SECOND / 2), &seconds,
+                                    &microseconds));
+        ut_assert(seconds == START_UTC + 2);
+        ut_assert(microseconds == 500000);
+        
+        // One tick is a third of a microsecond
+        ut_assert(gnss_ticks_to_utc(pulse + 4, &seconds, &microseconds));
+        ut_assert(seconds == START_UTC + 2);
+        ut_assert(microseconds == 1);
+        
+        // Before the pulse
+        ut_assert(gnss_ticks_to_utc(pulse - (TICKS_PER_SECOND / 4), &seconds,
+                                    &microseconds));
+        ut_assert(seconds == START_UTC + 1);
+        ut_assert(microseconds == 750000);
+        
+        // Several seconds later
+        ut_assert(gnss_ticks_to_utc(pulse + (10 * TICKS_PER_SECOND) + 3000,
+                                    &seconds, &microseconds));
+        ut_assert(seconds == START_UTC + 12);
+        ut_assert(microseconds == 999);
+        
+        // And back
+        ut_assert(gnss_utc_to_ticks(START_UTC + 2, 500000, &ticks));
+        ut_assert(ticks == pulse + (TICKS_PER_SECOND / 2));
+        ut_assert(gnss_utc_to_ticks(START_UTC + 1, 750000, &ticks));
+        ut_assert(ticks == pulse - (TICKS_PER_SECOND / 4));
+        
+        // Millis
+        ut_assert(gnss_millis_to_utc(12000 + 123, &seconds, &milliseconds));
+        ut_assert(seconds == START_UTC + 2);
+        ut_assert(milliseconds == 123);
+        ut_assert(gnss_millis_to_utc(12000 - 1, &seconds, &milliseconds));
+        ut_assert(seconds == START_UTC + 1);
+        ut_assert(milliseconds == 999);
+    }
+    
+    // Missed pulses and glitches should not affect the sync.
+    {
+        reset();
+        second(0, 1000, 1);
+        second(1, 1000 + TICKS_PER_SECOND, 1);
+        
+        // Missed pulse, RMC should not be matched with the old pulse
+        second(2, 0, 0);
+        ut_assert(gnss_get_time_sync(&sync));
+        ut_assert(sync.utc_time == START_UTC + 1);
+        ut_assert(sync.ticks_per_second == TICKS_PER_SECOND);
+        
+        // Two seconds since the last pulse should not be taken as a frequency
+        second(3, 1000 + (3 * TICKS_PER_SECOND), 1);
+        ut_assert(gnss_get_time_sync(&sync));
+        ut_assert(sync.utc_time == START_UTC + 3);
+        ut_assert(sync.ticks_per_second == TICKS_PER_SECOND);
+        
+        // Glitch in the middle of a second
+        millis += 100;
+        tc_capture_callback(1000 + (3 * TICKS_PER_SECOND) + 100000, NULL);
+        second(4, 1000 + (4 * TICKS_PER_SECOND), 1);
+        ut_assert(gnss_get_time_sync(&sync));
+        ut_assert(sync.utc_time == START_UTC + 4);
+        ut_assert(sync.ticks_per_second == TICKS_PER_SECOND);
+    }
+    
+    // The current timer count should be available for timestamping.
+    {
+        reset();
+        tc_count = 123456;
+        ut_assert(gnss_get_ticks() == 123456);
+    }
+    
+    return UT_PASS;
+}
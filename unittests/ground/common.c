@@ -0,0 +1,142 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include SOURCE_C
+#include "telemetry-link.c"
+#include "telemetry-codec.c"
+#include "reed-solomon.c"
+
+volatile uint32_t millis;
+
+
+/* Radio stubs */
+
+/** Radios from which the ground service receives */
+static struct rn2483_desc_t radios[2];
+/** NULL terminated list of the radios */
+static struct rn2483_desc_t *radio_list[] = { radios, radios + 1, NULL };
+
+enum rn2483_operation_result rn2483_receive (struct rn2483_desc_t *inst,
+                                             rn2483_recv_callback callback,
+                                             void *context)
+{
+    return RN2483_OP_SUCCESS;
+}
+
+
+/* Console stubs */
+
+/** Maximum number of bytes which the stub host can receive */
+#define TEST_HOST_LEN   1024
+
+static struct console_desc_t host_console;
+
+/** Everything which has been written to the host */
+static uint8_t host_out[TEST_HOST_LEN];
+/** Number of bytes in host_out */
+static uint16_t host_out_length;
+
+/** Callback for when the console is ready */
+static void (*console_init_callback)(struct console_desc_t*, void*);
+
+void console_send_bytes (struct console_desc_t *console, const uint8_t *data,
+                         uint16_t length)
+{
+    ut_assert((host_out_length + length) <= TEST_HOST_LEN);
+    memcpy(host_out + host_out_length, data, length);
+    host_out_length += length;
+}
+
+void console_set_init_callback (struct console_desc_t *console,
+                                void (*init_callback)(struct console_desc_t*,
+                                                      void*), void *context)
+{
+    console_init_callback = init_callback;
+}
+
+
+/**
+ *  A frame which the stub host has received.
+ */
+struct test_host_frame_t {
+    uint32_t time;
+    /** Low byte of the sequence number of the radio frame */
+    uint8_t sequence;
+    int8_t snr;
+    int8_t rssi;
+};
+
+/**
+ *  Reset the ground service with both radios and a console which is ready.
+ */
+static void reset (void)
+{
+    millis = 1000;
+    host_out_length = 0;
+    init_ground_service(&host_console, radio_list, 0, 0);
+    console_init_callback(&host_console, NULL);
+}
+
+/**
+ *  Have one of the radios receive an intact frame. The payload of the frame
+ *  starts with the low byte of its sequence number.
+ *
+ *  @param radio The index of the radio
+ *  @param sequence The sequence number of the frame
+ *  @param snr The signal to noise ratio for the frame
+ */
+static void radio_receive (uint8_t radio, uint16_t sequence, int8_t snr)
+{
+    uint8_t frame[RN2483_SEND_MAX_LEN];
+    uint8_t payload_length = 10;
+    for (uint8_t i = 0; i < payload_length; i++) {
+        frame[TELEMETRY_LINK_HEADER_LEN + i] = (uint8_t)(sequence + i);
+    }
+    uint8_t length = telemetry_link_seal(frame, TELEMETRY_LINK_HEADER_LEN +
+                                                payload_length, sequence);
+    ground_radio_recv_callback(radios + radio, ground_radios_g + radio, frame,
+                               length, snr, (int8_t)(-100 + radio));
+}
+
+/**
+ *  Write everything which is waiting to the host and parse the frames which
+ *  the host has received.
+ *
+ *  @param frames Array in which the received frames will be stored
+ *  @param max The length of the array
+ *
+ *  @return The number of frames which the host has received
+ */
+static uint8_t host_receive (struct test_host_frame_t *frames, uint8_t max)
+{
+    if (ground_out_length_g != 0) {
+        ground_flush(ground_out_length_g);
+    }
+    
+    uint8_t count = 0;
+    uint16_t i = 0;
+    while (i < host_out_length) {
+        struct ground_frame_header header;
+        memcpy(&header, host_out + i, sizeof(header));
+        ut_assert(header.sync == GROUND_FRAME_SYNC);
+        
+        uint16_t crc;
+        memcpy(&crc, host_out + i + sizeof(header) + header.length,
+               sizeof(crc));
+        ut_assert(crc == telemetry_link_crc(host_out + i,
+                                            sizeof(header) + header.length));
+        
+        ut_assert(count < max);
+        frames[count].time = header.time;
+        frames[count].sequence = host_out[i + sizeof(header)];
+        frames[count].snr = header.snr;
+        frames[count].rssi = header.rssi;
+        count++;
+        
+        i += sizeof(header) + header.length + GROUND_FRAME_CRC_LEN;
+    }
+    
+    return count;
+}
@@ -0,0 +1,123 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Copies of each frame received by the different radios are merged so that
+ *  the host receives each frame once, with the time of the first copy and the
+ *  signal quality of the best copy.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct test_host_frame_t frames[8];
+    
+    // Copies of a frame from both radios should be relayed once, with the
+    // signal quality of the copy with the higher SNR.
+    {
+        reset();
+        radio_receive(0, 7, 3);
+        ut_assert(host_receive(frames, 8) == 0);
+        
+        millis = 1005;
+        radio_receive(1, 7, 8);
+        
+        // Every radio has the frame, so it is relayed without waiting
+        ut_assert(host_receive(frames, 8) == 1);
+        ut_assert(frames[0].sequence == 7);
+        ut_assert(frames[0].time == 1000);
+        ut_assert(frames[0].snr == 8);
+        ut_assert(frames[0].rssi == -99);
+        
+        // A weaker copy should not replace a stronger one
+        radio_receive(1, 8, 6);
+        radio_receive(0, 8, -2);
+        ut_assert(host_receive(frames, 8) == 2);
+        ut_assert(frames[1].sequence == 8);
+        ut_assert(frames[1].snr == 6);
+        ut_assert(frames[1].rssi == -99);
+        
+        ut_assert(ground_get_link_stats()->received == 2);
+        ut_assert(ground_get_link_stats()->duplicate == 0);
+        ut_assert(ground_get_radio_stats(0)->received == 2);
+        ut_assert(ground_get_radio_stats(1)->received == 2);
+    }
+    
+    // A late copy of an older frame which is missing from the merged sequence
+    // should be relayed right away, ahead of the newer frame which is held.
+    {
+        reset();
+        radio_receive(0, 9, 5);
+        radio_receive(1, 9, 5);
+        
+        // The first radio misses frame 10
+        radio_receive(0, 11, 5);
+        radio_receive(1, 10, 5);
+        
+        ut_assert(host_receive(frames, 8) == 2);
+        ut_assert(frames[0].sequence == 9);
+        ut_assert(frames[1].sequence == 10);
+        
+        radio_receive(1, 11, 5);
+        ut_assert(host_receive(frames, 8) == 3);
+        ut_assert(frames[2].sequence == 11);
+        ut_assert(ground_get_link_stats()->received == 3);
+        ut_assert(ground_get_link_stats()->lost == 0);
+    }
+    
+    // A late copy of an older frame should still be relayed after the newer
+    // frame has been released.
+    {
+        reset();
+        radio_receive(0, 30, 5);
+        radio_receive(1, 30, 5);
+        
+        // The first radio misses frame 31 and the second misses frame 32
+        radio_receive(0, 32, 5);
+        millis = 1000 + GROUND_DIVERSITY_WINDOW;
+        ground_service();
+        ut_assert(host_receive(frames, 8) == 2);
+        ut_assert(frames[1].sequence == 32);
+        ut_assert(ground_get_link_stats()->lost == 1);
+        
+        radio_receive(1, 31, 5);
+        ut_assert(host_receive(frames, 8) == 3);
+        ut_assert(frames[2].sequence == 31);
+        ut_assert(frames[2].time == millis);
+        ut_assert(ground_get_link_stats()->received == 3);
+        ut_assert(ground_get_link_stats()->lost == 0);
+        ut_assert(ground_get_link_stats()->duplicate == 0);
+        
+        // Once it has been relayed another copy is a duplicate
+        radio_receive(0, 31, 5);
+        ut_assert(host_receive(frames, 8) == 3);
+        ut_assert(ground_get_link_stats()->duplicate == 1);
+    }
+    
+    // A frame which only one radio receives should be relayed once the
+    // diversity window has passed.
+    {
+        reset();
+        radio_receive(0, 20, 5);
+        
+        millis = 1000 + GROUND_DIVERSITY_WINDOW - 1;
+        ground_service();
+        ut_assert(host_receive(frames, 8) == 0);
+        
+        millis = 1000 + GROUND_DIVERSITY_WINDOW;
+        ground_service();
+        ut_assert(host_receive(frames, 8) == 1);
+        ut_assert(frames[0].sequence == 20);
+        ut_assert(frames[0].time == 1000);
+        
+        // A copy from the other radio after the frame was relayed is a
+        // duplicate
+        radio_receive(1, 20, 9);
+        millis += GROUND_DIVERSITY_WINDOW;
+        ground_service();
+        ut_assert(host_receive(frames, 8) == 1);
+        ut_assert(ground_get_link_stats()->duplicate == 1);
+    }
+    
+    return UT_PASS;
+}
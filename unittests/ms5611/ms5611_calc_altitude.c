@@ -0,0 +1,90 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  ms5611_calc_altitude() calculates the altitude in millimetres from the
+ *  reference pressure, measured pressure and temperature using fixed point
+ *  arithmetic. It should be within 3 mm of the barometric formula for all
+ *  pressures from 10 to 1200 mbar.
+ */
+
+#define MAX_ERROR_MM    3.0
+
+
+int main (int argc, char **argv)
+{
+    static const int32_t p0_values[] = { 1000, 2500, 50000, 95000, 101325,
+                                         120000 };
+    static const int32_t temperatures[] = { -4000, 0, 2000, 8500 };
+    
+    // The altitude should be zero at the reference pressure.
+    {
+        for (unsigned i = 0; i < (sizeof(p0_values) / sizeof(p0_values[0]));
+             i++) {
+            ut_assert(ms5611_calc_altitude(p0_values[i], p0_values[i],
+                                           2000) == 0);
+        }
+    }
+    
+    // Invalid pressures should not cause a result to be calculated.
+    {
+        ut_assert(ms5611_calc_altitude(0, 101325, 2000) == 0);
+        ut_assert(ms5611_calc_altitude(101325, 0, 2000) == 0);
+        ut_assert(ms5611_calc_altitude(101325, -100, 2000) == 0);
+    }
+    
+    // The altitude should be within the error bound of the formula for every
+    // pressure from 10 to 1200 mbar, and should never increase with pressure.
+    {
+        for (unsigned i = 0; i < (sizeof(p0_values) / sizeof(p0_values[0]));
+             i++) {
+            for (unsigned j = 0;
+                 j < (sizeof(temperatures) / sizeof(temperatures[0])); j++) {
+                int32_t last = INT32_MAX;
+                
+                for (int32_t p = 1000; p <= 120000; p++) {
+                    int32_t alt = ms5611_calc_altitude(p0_values[i], p,
+                                                       temperatures[j]);
+                    double ref = reference_altitude(p0_values[i], p,
+                                                    temperatures[j]);
+                    
+                    ut_assert(fabs(alt - ref) < MAX_ERROR_MM);
+                    ut_assert(alt <= last);
+                    last = alt;
+                }
+            }
+        }
+    }
+    
+    // Pressures far below the reference should saturate the altitude instead
+    // of overflowing.
+    {
+        int32_t limit = ms5611_calc_altitude(101325, 1, 2000);
+        int32_t last = 0;
+        
+        ut_assert(limit > 0);
+        for (int32_t p = 1000; p > 0; p--) {
+            int32_t alt = ms5611_calc_altitude(101325, p, 2000);
+            ut_assert(alt >= last);
+            ut_assert(alt <= limit);
+            last = alt;
+        }
+        ut_assert(ms5611_calc_altitude(101325, 50, 2000) == limit);
+        ut_assert(ms5611_calc_altitude(INT32_MAX, 1, 2000) == limit);
+    }
+    
+    // The log2 and exp2 approximations should match the exact functions at
+    // the table boundaries.
+    {
+        for (uint32_t x = 1; x < (1UL << 20); x <<= 1) {
+            ut_assert(ms5611_log2(x) ==
+                      (int32_t)((31 - __builtin_clz(x)) <<
+                                MS5611_LOG2_FRAC_BITS));
+        }
+        ut_assert(ms5611_exp2(0) == (1UL << 30));
+        ut_assert(ms5611_exp2(1 << MS5611_LOG2_FRAC_BITS) == (1UL << 31));
+        ut_assert(ms5611_exp2(-(1 << MS5611_LOG2_FRAC_BITS)) == (1UL << 29));
+    }
+    
+    return UT_PASS;
+}
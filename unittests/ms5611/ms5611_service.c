@@ -0,0 +1,149 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  ms5611_service() runs the driver state machine. Pressure is measured every
+ *  reading and temperature is measured every temp_period readings, using the
+ *  configured oversampling ratios.
+ */
+
+#define CMD_D1(osr) (MS5611_CMD_D1 | ((osr) << MS5611_OSR_Pos))
+#define CMD_D2(osr) (MS5611_CMD_D2 | ((osr) << MS5611_OSR_Pos))
+
+
+int main (int argc, char **argv)
+{
+    static struct ms5611_desc_t inst;
+    
+    // Invalid oversampling ratios should be rejected.
+    {
+        reset(&inst);
+        
+        ut_assert(ms5611_set_oversampling(&inst, 128, 4096) == 1);
+        ut_assert(ms5611_set_oversampling(&inst, 4096, 8192) == 1);
+        ut_assert(ms5611_set_oversampling(&inst, 1000, 4096) == 1);
+        ut_assert(inst.pres_osr == MS5611_OSR_4096_Val);
+        ut_assert(inst.temp_osr == MS5611_OSR_4096_Val);
+        
+        ut_assert(ms5611_set_oversampling(&inst, 256, 2048) == 0);
+        ut_assert(inst.pres_osr == MS5611_OSR_256_Val);
+        ut_assert(inst.temp_osr == MS5611_OSR_2048_Val);
+    }
+    
+    // By default both pressure and temperature should be measured every
+    // reading at an OSR of 4096.
+    {
+        reset(&inst);
+        
+        for (int i = 0; i < 3; i++) {
+            run_reading(&inst);
+        }
+        
+        ut_assert(cmd_log_len == 6);
+        for (int i = 0; i < 3; i++) {
+            ut_assert(cmd_log[2 * i] == CMD_D1(MS5611_OSR_4096_Val));
+            ut_assert(cmd_log[(2 * i) + 1] == CMD_D2(MS5611_OSR_4096_Val));
+        }
+    }
+    
+    // Temperature should only be measured every temp_period readings, and
+    // always on the first reading.
+    {
+        reset(&inst);
+        ut_assert(ms5611_set_oversampling(&inst, 1024, 256) == 0);
+        ms5611_set_temp_period(&inst, 4);
+        
+        for (int i = 0; i < 9; i++) {
+            run_reading(&inst);
+        }
+        
+        // 9 pressure measurements and 3 temperature measurements
+        ut_assert(cmd_log_len == 12);
+        unsigned n = 0;
+        for (int i = 0; i < 9; i++) {
+            ut_assert(cmd_log[n++] == CMD_D1(MS5611_OSR_1024_Val));
+            if ((i % 4) == 0) {
+                ut_assert(cmd_log[n++] == CMD_D2(MS5611_OSR_256_Val));
+            }
+        }
+    }
+    
+    // The minimum period should include both conversions.
+    {
+        reset(&inst);
+        
+        // 9.04 ms each, waiting for 10 ms plus one with millis
+        ut_assert(ms5611_get_min_period(&inst) == 22);
+        
+        ut_assert(ms5611_set_oversampling(&inst, 1024, 256) == 0);
+        ut_assert(ms5611_get_min_period(&inst) == 6);
+    }
+    
+    // A temperature period of 0 should be treated as 1.
+    {
+        reset(&inst);
+        ms5611_set_temp_period(&inst, 0);
+        ut_assert(inst.temp_period == 1);
+    }
+    
+    // Without a timer the result should not be read until the conversion time
+    // has passed.
+    {
+        reset(&inst);
+        ut_assert(ms5611_set_oversampling(&inst, 2048, 2048) == 0);
+        
+        // Send conversion command
+        millis = 100;
+        ms5611_service(&inst);
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_PRES_WAIT);
+        
+        // 4.54 ms conversion, rounded up plus one millisecond
+        millis = 105;
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_PRES_WAIT);
+        millis = 106;
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_READ_PRES);
+    }
+    
+    // With a timer the result should be read as soon as the timer expires.
+    {
+        reset(&inst);
+        ut_assert(ms5611_use_timer(&inst, TC4, 0, 48000000UL) == 0);
+        ut_assert(ms5611_set_oversampling(&inst, 512, 4096) == 0);
+        
+        // Send conversion command
+        millis = 100;
+        ms5611_service(&inst);
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_PRES_WAIT);
+        ut_assert(timer_starts == 1);
+        ut_assert(timer_period == 1170);
+        
+        // Time passing should have no effect
+        millis = 200;
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_PRES_WAIT);
+        
+        // Timer expires, read result and send temperature conversion command
+        inst.conv_done = 1;
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_READ_PRES);
+        ms5611_service(&inst);
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_TEMP_WAIT);
+        ut_assert(timer_starts == 2);
+        ut_assert(timer_period == 9040);
+        
+        // Timer expires, read result
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_CONVERT_TEMP_WAIT);
+        inst.conv_done = 1;
+        ms5611_service(&inst);
+        ms5611_service(&inst);
+        ut_assert(inst.state == MS5611_IDLE);
+    }
+    
+    return UT_PASS;
+}
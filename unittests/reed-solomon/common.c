@@ -0,0 +1,54 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include SOURCE_C
+
+
+/**
+ *  Multiply in GF(2^8) one bit at a time, without the tables.
+ */
+static uint8_t ref_mul (uint8_t a, uint8_t b)
+{
+    uint8_t result = 0;
+    while (b) {
+        if (b & 1) {
+            result ^= a;
+        }
+        b >>= 1;
+        a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1D : 0));
+    }
+    return result;
+}
+
+/**
+ *  Fill a buffer with random bytes.
+ */
+static void random_bytes (uint8_t *dest, int length)
+{
+    for (int i = 0; i < length; i++) {
+        dest[i] = (uint8_t)rand();
+    }
+}
+
+/**
+ *  Corrupt distinct random bytes in a buffer.
+ *
+ *  @param count Number of bytes to corrupt, must not be more than length
+ */
+static void corrupt (uint8_t *buffer, int length, int count)
+{
+    uint8_t hit[256] = { 0 };
+    while (count) {
+        int i = rand() % length;
+        if (hit[i]) {
+            continue;
+        }
+        hit[i] = 1;
+        buffer[i] ^= (uint8_t)((rand() % 255) + 1);
+        count--;
+    }
+}
@@ -0,0 +1,119 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RS_HAVE_TSC
+#endif
+
+/*
+ *  Time encoding and decoding a full length telemetry frame with the default
+ *  telemetry settings: 8 parity bytes per codeword, two codewords deep. The
+ *  codec only uses table lookups, shifts and exclusive ors, so the number of
+ *  host cycles per byte gives a rough idea of the relative cost of each
+ *  operation on the target.
+ */
+
+/** Number of times each operation is timed */
+#define BENCH_ITERATIONS    20000
+/** Parity bytes per codeword */
+#define BENCH_ROOTS         8
+/** Number of interleaved codewords */
+#define BENCH_DEPTH         2
+/** Length of the data in each frame */
+#define BENCH_LENGTH        106
+
+
+static uint64_t get_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Report the time taken for an operation.
+ */
+static void report (const char *name, uint64_t ns, uint64_t cycles)
+{
+    double bytes = (double)BENCH_ITERATIONS * BENCH_LENGTH;
+    fprintf(stderr, "%s: %.2f ns per byte", name, ns / bytes);
+#ifdef RS_HAVE_TSC
+    fprintf(stderr, ", %.2f host cycles per byte", cycles / bytes);
+#endif
+    fprintf(stderr, "\n");
+}
+
+/**
+ *  Time decoding frames with a number of errors in each codeword.
+ */
+static void bench_decode (const struct rs_codec_t *rs, int errors,
+                          const char *name)
+{
+    static uint8_t frames[BENCH_ITERATIONS][BENCH_LENGTH];
+    static uint8_t parity[BENCH_ITERATIONS][BENCH_ROOTS * BENCH_DEPTH];
+    
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        random_bytes(frames[i], BENCH_LENGTH);
+        rs_encode(rs, frames[i], BENCH_LENGTH, parity[i], BENCH_DEPTH);
+        corrupt(frames[i], BENCH_LENGTH, errors * BENCH_DEPTH);
+    }
+    
+    volatile int16_t sink = 0;
+    uint64_t cycles = 0;
+    uint64_t start_ns = get_ns();
+#ifdef RS_HAVE_TSC
+    uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+    
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += rs_decode(rs, frames[i], BENCH_LENGTH, parity[i],
+                          BENCH_DEPTH);
+    }
+
+#ifdef RS_HAVE_TSC
+    cycles = __builtin_ia32_rdtsc() - start_cycles;
+#endif
+    report(name, get_ns() - start_ns, cycles);
+    (void)sink;
+}
+
+
+int main (int argc, char **argv)
+{
+    static struct rs_codec_t rs;
+    static uint8_t frame[BENCH_LENGTH];
+    static uint8_t parity[BENCH_ROOTS * BENCH_DEPTH];
+    
+    srand(46);
+    init_rs_codec(&rs, BENCH_ROOTS);
+    random_bytes(frame, BENCH_LENGTH);
+    
+    // Encoding
+    {
+        uint64_t cycles = 0;
+        uint64_t start_ns = get_ns();
+#ifdef RS_HAVE_TSC
+        uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+        
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            frame[i % BENCH_LENGTH]++;
+            rs_encode(&rs, frame, BENCH_LENGTH, parity, BENCH_DEPTH);
+        }
+
+#ifdef RS_HAVE_TSC
+        cycles = __builtin_ia32_rdtsc() - start_cycles;
+#endif
+        report("encode", get_ns() - start_ns, cycles);
+    }
+    
+    // Decoding with no errors only calculates the syndromes, with errors the
+    // full decoder runs
+    bench_decode(&rs, 0, "decode, no errors");
+    bench_decode(&rs, 1, "decode, one error per codeword");
+    bench_decode(&rs, BENCH_ROOTS / 2, "decode, four errors per codeword");
+    
+    return UT_PASS;
+}
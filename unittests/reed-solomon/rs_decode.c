@@ -0,0 +1,115 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Random blocks are encoded, corrupted and decoded. Every codeword with no
+ *  more than nroots / 2 errors must be corrected, and interleaving must
+ *  correct bursts which are longer than a single codeword can.
+ */
+
+/** Number of random blocks for each number of errors */
+#define ITERATIONS  2000
+
+
+int main (int argc, char **argv)
+{
+    static struct rs_codec_t rs;
+    uint8_t data[255], original[255];
+    uint8_t parity[RS_MAX_ROOTS * 4], original_parity[RS_MAX_ROOTS * 4];
+    
+    srand(45);
+    
+    // A block without errors should be unchanged.
+    {
+        init_rs_codec(&rs, 8);
+        random_bytes(data, 100);
+        rs_encode(&rs, data, 100, parity, 1);
+        memcpy(original, data, 100);
+        ut_assert(rs_decode(&rs, data, 100, parity, 1) == 0);
+        ut_assert(!memcmp(data, original, 100));
+    }
+    
+    // Up to nroots / 2 errors anywhere in a codeword should be corrected.
+    {
+        static const uint8_t roots[] = { 2, 4, 8, 16, 32 };
+        uint8_t codeword[255];
+        
+        for (unsigned r = 0; r < sizeof(roots); r++) {
+            init_rs_codec(&rs, roots[r]);
+            int length = 223;
+            
+            for (int errors = 1; errors <= (roots[r] / 2); errors++) {
+                for (int i = 0; i < ITERATIONS; i++) {
+                    // Vary the length to exercise shortened codes
+                    length = 1 + (rand() % (255 - roots[r]));
+                    random_bytes(codeword, length);
+                    rs_encode(&rs, codeword, (uint8_t)length,
+                              codeword + length, 1);
+                    memcpy(original, codeword, length + roots[r]);
+                    
+                    corrupt(codeword, length + roots[r], errors);
+                    ut_assert(rs_decode(&rs, codeword, (uint8_t)length,
+                                        codeword + length, 1) == errors);
+                    ut_assert(!memcmp(codeword, original, length + roots[r]));
+                }
+            }
+        }
+    }
+    
+    // Too many errors should usually be detected, and should never cause the
+    // decoder to claim to have corrected more errors than it can.
+    {
+        init_rs_codec(&rs, 16);
+        int detected = 0;
+        
+        for (int i = 0; i < ITERATIONS; i++) {
+            random_bytes(data, 100);
+            rs_encode(&rs, data, 100, parity, 1);
+            corrupt(data, 100, 9 + (rand() % 8));
+            
+            int16_t ret = rs_decode(&rs, data, 100, parity, 1);
+            ut_assert(ret <= 8);
+            detected += (ret < 0);
+        }
+        ut_assert(detected > (ITERATIONS * 99 / 100));
+    }
+    
+    // Interleaved codewords should correct a burst of up to
+    // depth * nroots / 2 bytes anywhere in the block, including the parity.
+    {
+        init_rs_codec(&rs, 8);
+        const int depth = 3;
+        const int length = 110;
+        const int burst = depth * 4;
+        
+        for (int start = 0; start <= (length + (8 * depth) - burst); start++) {
+            random_bytes(data, length);
+            rs_encode(&rs, data, length, parity, depth);
+            memcpy(original, data, length);
+            memcpy(original_parity, parity, 8 * depth);
+            
+            for (int i = start; i < (start + burst); i++) {
+                if (i < length) {
+                    data[i] ^= 0xA5;
+                } else {
+                    parity[i - length] ^= 0x5A;
+                }
+            }
+            
+            ut_assert(rs_decode(&rs, data, length, parity, depth) == burst);
+            ut_assert(!memcmp(data, original, length));
+            ut_assert(!memcmp(parity, original_parity, 8 * depth));
+        }
+        
+        // Without interleaving the same burst is too long for the codeword
+        init_rs_codec(&rs, 8);
+        random_bytes(data, length);
+        rs_encode(&rs, data, length, parity, 1);
+        for (int i = 0; i < burst; i++) {
+            data[20 + i] ^= 0xA5;
+        }
+        ut_assert(rs_decode(&rs, data, length, parity, 1) == -1);
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,108 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  The parity bytes must make every interleaved codeword a multiple of the
+ *  generator polynomial, which is checked by evaluating each codeword at each
+ *  root without using the tables.
+ */
+
+/**
+ *  Evaluate codeword number index, interleaved with the given depth, at x.
+ */
+static uint8_t eval_codeword (const uint8_t *data, int length,
+                              const uint8_t *parity, int nroots, int depth,
+                              int index, uint8_t x)
+{
+    uint8_t result = 0;
+    for (int i = index; i < length; i += depth) {
+        result = ref_mul(result, x) ^ data[i];
+    }
+    // The interleaving continues from the data into the parity
+    for (int i = length; i < (length + (nroots * depth)); i++) {
+        if ((i % depth) == index) {
+            result = ref_mul(result, x) ^ parity[i - length];
+        }
+    }
+    return result;
+}
+
+
+int main (int argc, char **argv)
+{
+    static struct rs_codec_t rs;
+    
+    // The tables should match bitwise multiplication.
+    {
+        for (int a = 1; a < 256; a++) {
+            for (int b = 1; b < 256; b++) {
+                ut_assert(gf_mul((uint8_t)a, (uint8_t)b) ==
+                          ref_mul((uint8_t)a, (uint8_t)b));
+                ut_assert(gf_mul(gf_div((uint8_t)a, (uint8_t)b), (uint8_t)b) ==
+                          a);
+            }
+            ut_assert(gf_mul((uint8_t)a, 0) == 0);
+            ut_assert(gf_exp[gf_log[a]] == a);
+        }
+    }
+    
+    // The generator polynomial should be zero at each of its roots.
+    {
+        for (uint8_t nroots = 2; nroots <= RS_MAX_ROOTS; nroots++) {
+            init_rs_codec(&rs, nroots);
+            for (int r = 1; r <= nroots; r++) {
+                uint8_t root = gf_exp[r];
+                uint8_t value = 1;
+                for (int i = nroots - 1; i >= 0; i--) {
+                    value = ref_mul(value, root) ^ rs.genpoly[i];
+                }
+                ut_assert(value == 0);
+            }
+        }
+    }
+    
+    // Every codeword should be zero at each root of the generator polynomial.
+    {
+        static const uint8_t roots[] = { 2, 8, 16, 32 };
+        uint8_t data[255];
+        uint8_t parity[RS_MAX_ROOTS * 4];
+        
+        srand(44);
+        for (unsigned r = 0; r < sizeof(roots); r++) {
+            init_rs_codec(&rs, roots[r]);
+            for (int depth = 1; depth <= 4; depth++) {
+                int max_length = depth * (255 - roots[r]);
+                if (max_length > 255) {
+                    max_length = 255;
+                }
+                for (int length = 0; length <= max_length; length += 7) {
+                    random_bytes(data, length);
+                    rs_encode(&rs, data, (uint8_t)length, parity,
+                              (uint8_t)depth);
+                    
+                    for (int cw = 0; cw < depth; cw++) {
+                        for (int i = 1; i <= roots[r]; i++) {
+                            ut_assert(eval_codeword(data, length, parity,
+                                                    roots[r], depth, cw,
+                                                    gf_exp[i]) == 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    // Data which is all zero should have parity which is all zero.
+    {
+        uint8_t data[64] = { 0 };
+        uint8_t parity[16];
+        init_rs_codec(&rs, 16);
+        memset(parity, 0xFF, sizeof(parity));
+        rs_encode(&rs, data, sizeof(data), parity, 1);
+        for (unsigned i = 0; i < sizeof(parity); i++) {
+            ut_assert(parity[i] == 0);
+        }
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,135 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+char *utoa (unsigned int value, char *str, int base);
+char *itoa (int value, char *str, int base);
+
+#include SOURCE_C
+#include "rn2483.c"
+
+volatile uint32_t millis;
+
+
+/* libc extensions which are not available on the host */
+
+char *utoa (unsigned int value, char *str, int base)
+{
+    sprintf(str, "%u", value);
+    return str;
+}
+
+char *itoa (int value, char *str, int base)
+{
+    sprintf(str, "%d", value);
+    return str;
+}
+
+
+/* UART stubs */
+
+/** Maximum number of bytes which can be written to the stub UART */
+#define TEST_UART_OUT_LEN   1024
+
+/** Everything which has been written to the stub UART */
+static char uart_out[TEST_UART_OUT_LEN];
+/** Number of bytes in uart_out */
+static uint16_t uart_out_length;
+/** Number of bytes which can be written to the stub UART before it is full */
+static uint16_t uart_space;
+/** Number of calls to the stub UART output functions */
+static uint32_t uart_put_calls;
+
+/** Line to be returned by the next call to sercom_uart_get_line */
+static const char *uart_line;
+
+static uint16_t uart_put (const char *data, uint16_t length)
+{
+    uart_put_calls++;
+    
+    if (length > uart_space) {
+        length = uart_space;
+    }
+    ut_assert((uart_out_length + length) <= TEST_UART_OUT_LEN);
+    
+    memcpy(uart_out + uart_out_length, data, length);
+    uart_out_length += length;
+    uart_space -= length;
+    return length;
+}
+
+uint16_t sercom_uart_put_string (struct sercom_uart_desc_t *uart,
+                                 const char *str)
+{
+    return uart_put(str, (uint16_t)strlen(str));
+}
+
+uint16_t sercom_uart_put_bytes (struct sercom_uart_desc_t *uart,
+                                const uint8_t *bytes, uint16_t length)
+{
+    return uart_put((const char*)bytes, length);
+}
+
+uint8_t sercom_uart_has_line (struct sercom_uart_desc_t *uart)
+{
+    return uart_line != NULL;
+}
+
+void sercom_uart_get_line (struct sercom_uart_desc_t *uart, char *str,
+                           uint16_t len)
+{
+    ut_assert(uart_line != NULL);
+    // Like the real driver, nothing after the end of the line is overwritten
+    size_t length = strlen(uart_line) + 1;
+    memcpy(str, uart_line, (length < len) ? length : len);
+    str[len - 1] = '\0';
+    uart_line = NULL;
+}
+
+
+/* Helpers */
+
+/**
+ *  Clear everything that has been written to the stub UART.
+ *
+ *  @param space The number of bytes which can be written before the UART is
+ *               full
+ */
+static void uart_reset (uint16_t space)
+{
+    memset(uart_out, 0, sizeof(uart_out));
+    uart_out_length = 0;
+    uart_space = space;
+    uart_put_calls = 0;
+    uart_line = NULL;
+}
+
+/**
+ *  Initialize a driver instance and skip straight to the idle state.
+ */
+static void init_idle (struct rn2483_desc_t *inst)
+{
+    memset(inst, 0, sizeof(*inst));
+    init_rn2483(inst, NULL, 433050000UL, 14, RN2483_SF_SF9, RN2483_CR_4_5,
+                RN2483_BW_500, 1, 0, 0x43);
+    
+    // Clear the dirty pin modes from initialization
+    for (enum rn2483_pin pin = 0; pin < RN2483_NUM_PINS; pin++) {
+        inst->pins[pin].raw = RN2483_PIN_DESC_MODE(RN2483_PIN_MODE_INPUT);
+    }
+    
+    inst->version = RN2483_VERSION(1, 0, 5);
+    inst->state = RN2483_IDLE;
+}
+
+/**
+ *  Provide a line from the radio and run the driver's service.
+ */
+static void radio_line (struct rn2483_desc_t *inst, const char *line)
+{
+    uart_line = line;
+    rn2483_service(inst);
+    ut_assert(uart_line == NULL);
+}
@@ -0,0 +1,96 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <math.h>
+
+/*
+ *  rn2483_get_airtime() calculates the time on air for a frame from the
+ *  radio's settings. It is checked against the formula from the SX1276
+ *  datasheet, evaluated in floating point, for every combination of settings
+ *  and length.
+ */
+
+/**
+ *  Time on air in milliseconds from the SX1276 datasheet (section 4.1.1.7).
+ */
+static double reference_airtime (int sf, double bw, int cr, int length,
+                                 int crc, int implicit_header, int preamble)
+{
+    double t_sym = pow(2, sf) / bw;
+    int de = t_sym >= 16.0;
+    
+    double t_preamble = (preamble + 4.25) * t_sym;
+    
+    double blocks = ceil((8.0 * length - 4.0 * sf + 28 + 16 * crc -
+                          20 * implicit_header) / (4.0 * (sf - 2 * de)));
+    double payload_symbols = 8 + fmax(blocks * (cr + 4), 0);
+    
+    return t_preamble + (payload_symbols * t_sym);
+}
+
+static void set_radio (struct rn2483_desc_t *inst, enum rn2483_sf sf,
+                       enum rn2483_bw bw, enum rn2483_cr cr, uint8_t crc)
+{
+    inst->settings.spreading_factor = sf;
+    inst->settings.bandwidth = bw;
+    inst->settings.coding_rate = cr;
+    inst->settings.crc = crc;
+}
+
+
+int main (int argc, char **argv)
+{
+    static struct rn2483_desc_t inst;
+    init_idle(&inst);
+    
+    static const double bandwidths[] = { 125, 250, 500 };
+    
+    // All settings and lengths should match the datasheet formula exactly
+    for (enum rn2483_sf sf = RN2483_SF_SF7; sf <= RN2483_SF_SF12; sf++) {
+        for (enum rn2483_bw bw = RN2483_BW_125; bw <= RN2483_BW_500; bw++) {
+            for (enum rn2483_cr cr = RN2483_CR_4_5; cr <= RN2483_CR_4_8; cr++) {
+                for (uint8_t crc = 0; crc < 2; crc++) {
+                    set_radio(&inst, sf, bw, cr, crc);
+                    
+                    for (int length = 0; length < 256; length++) {
+                        double expected = reference_airtime(7 + sf,
+                                                            bandwidths[bw],
+                                                            1 + cr, length,
+                                                            crc, 0,
+                                                            RN2483_PREAMBLE_LEN);
+                        uint32_t airtime = rn2483_get_airtime(&inst,
+                                                              (uint8_t)length);
+                        ut_assert(fabs((airtime / 1000.0) - expected) < 1e-9);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Published values from the Semtech LoRa calculator
+    {
+        set_radio(&inst, RN2483_SF_SF12, RN2483_BW_125, RN2483_CR_4_5, 1);
+        ut_assert(rn2483_get_airtime(&inst, 51) == 2465792);
+        
+        set_radio(&inst, RN2483_SF_SF7, RN2483_BW_125, RN2483_CR_4_5, 1);
+        ut_assert(rn2483_get_airtime(&inst, 51) == 102656);
+        ut_assert(rn2483_get_airtime(&inst, 10) == 41216);
+    }
+    
+    // Default telemetry settings
+    {
+        set_radio(&inst, RN2483_SF_SF9, RN2483_BW_500, RN2483_CR_4_7, 0);
+        ut_assert(rn2483_get_airtime(&inst, 63) == 121088);
+    }
+    
+    // Longer frames should never be faster to send
+    {
+        set_radio(&inst, RN2483_SF_SF10, RN2483_BW_250, RN2483_CR_4_6, 1);
+        for (int length = 1; length < 256; length++) {
+            ut_assert(rn2483_get_airtime(&inst, (uint8_t)length) >=
+                      rn2483_get_airtime(&inst, (uint8_t)(length - 1)));
+        }
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,237 @@
+#include <unittest.h>
+#include "common.c"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DECODE_HAVE_TSC
+#endif
+
+/*
+ *  decode_hex() decodes received payloads four hexadecimal digits at a time.
+ *
+ *  Random strings, both valid and invalid, are decoded and the results are
+ *  checked against the character at a time decoder which was used before.
+ *  The time taken by each decoder for a full length payload is reported.
+ */
+
+/** Number of random strings to be decoded */
+#define FUZZ_ITERATIONS     200000
+/** Number of times a full length payload is decoded for the benchmark */
+#define BENCH_ITERATIONS    200000
+/** Longest string which could be received from the radio */
+#define MAX_DIGITS          (RN2483_BUFFER_LEN - RN2483_RSP_RX_OK_LEN - 1)
+
+
+/**
+ *  Parse a nibble from a single hexadecimal digit, as the driver used to.
+ */
+static uint8_t ref_parse_nibble (char c, uint8_t *dest, int offset)
+{
+    if (c < '0') {
+        return 1;
+    } else if (c >= 'a') {
+        c -= 32;
+    }
+    c -= '0';
+    if (c <= 9) {
+        goto store_nibble;
+    }
+    c -= 7;
+    if (c <= 9) {
+        return 1;
+    } else if (c <= 15) {
+        goto store_nibble;
+    }
+    return 1;
+store_nibble:
+    *dest |= (c << offset);
+    return 0;
+}
+
+/**
+ *  Decode a string a character at a time, as the driver used to.
+ */
+static int ref_decode_hex (uint8_t *dest, const char *s)
+{
+    uint8_t *b = dest;
+    for (; (*s != '\0') && (*(s + 1) != '\0'); b++) {
+        *b = 0;
+        uint8_t ret = ref_parse_nibble(*s, b, 4);
+        s++;
+        ret |= ref_parse_nibble(*s, b, 0);
+        if (ret != 0) {
+            return -1;
+        }
+        s++;
+    }
+    return (int)(b - dest);
+}
+
+static uint64_t get_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Fill a string with random characters.
+ *
+ *  @param str Buffer for string, must have space for length + 1 characters
+ *  @param length Number of characters
+ *  @param invalid Approximate chance out of 1024 for each character to be
+ *                 something other than a hexadecimal digit
+ */
+static void random_string (char *str, int length, int invalid)
+{
+    static const char digits[] = "0123456789ABCDEFabcdef";
+    for (int i = 0; i < length; i++) {
+        if ((rand() % 1024) < invalid) {
+            str[i] = (char)((rand() % 255) + 1);
+        } else {
+            str[i] = digits[rand() % (sizeof(digits) - 1)];
+        }
+    }
+    str[length] = '\0';
+}
+
+/**
+ *  Time a decoder on a full length payload.
+ *
+ *  @return Time in nanoseconds per decoded byte
+ */
+static double bench (int (*decoder)(uint8_t*, const char*), const char *name,
+                     const char *str)
+{
+    static char buffer[RN2483_BUFFER_LEN];
+    volatile int sink = 0;
+    
+    uint64_t start_ns = get_ns();
+#ifdef DECODE_HAVE_TSC
+    uint64_t start_cycles = __builtin_ia32_rdtsc();
+#endif
+    
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        // Decode in place, as in the driver
+        strcpy(buffer + RN2483_RSP_RX_OK_LEN, str);
+        sink += decoder((uint8_t*)buffer, buffer + RN2483_RSP_RX_OK_LEN);
+    }
+    
+#ifdef DECODE_HAVE_TSC
+    uint64_t cycles = __builtin_ia32_rdtsc() - start_cycles;
+#endif
+    uint64_t ns = get_ns() - start_ns;
+    
+    double bytes = (double)BENCH_ITERATIONS * (strlen(str) / 2);
+    fprintf(stderr, "%s: %.2f ns per byte", name, ns / bytes);
+#ifdef DECODE_HAVE_TSC
+    fprintf(stderr, ", %.2f host cycles per byte", cycles / bytes);
+#endif
+    fprintf(stderr, "\n");
+    
+    return ns / bytes;
+}
+
+
+int main (int argc, char **argv)
+{
+    // Decode some known strings.
+    {
+        uint8_t out[8];
+        
+        ut_assert(decode_hex(out, "") == 0);
+        ut_assert(decode_hex(out, "A") == 0);
+        
+        ut_assert(decode_hex(out, "09afAF") == 3);
+        ut_assert((out[0] == 0x09) && (out[1] == 0xAF) && (out[2] == 0xAF));
+        
+        ut_assert(decode_hex(out, "0123456789abcdef") == 8);
+        ut_assert(!memcmp(out, "\x01\x23\x45\x67\x89\xAB\xCD\xEF", 8));
+        
+        // A trailing odd digit is ignored, even if it is not valid
+        ut_assert(decode_hex(out, "FEDCBA987") == 4);
+        ut_assert(!memcmp(out, "\xFE\xDC\xBA\x98", 4));
+        ut_assert(decode_hex(out, "12x") == 1);
+        ut_assert(out[0] == 0x12);
+        
+        // Characters just outside of the valid ranges
+        ut_assert(decode_hex(out, "/0") == -1);
+        ut_assert(decode_hex(out, "0:") == -1);
+        ut_assert(decode_hex(out, "@0") == -1);
+        ut_assert(decode_hex(out, "0G") == -1);
+        ut_assert(decode_hex(out, "`0") == -1);
+        ut_assert(decode_hex(out, "0g") == -1);
+        ut_assert(decode_hex(out, "0000\x10" "0") == -1);
+        ut_assert(decode_hex(out, "0000\x90" "0") == -1);
+        ut_assert(decode_hex(out, "00 0") == -1);
+    }
+    
+    // Every pair of characters should be decoded the same way as before.
+    {
+        for (int a = 1; a < 256; a++) {
+            for (int b = 1; b < 256; b++) {
+                char str[5] = { (char)a, (char)b, '0', '0', '\0' };
+                uint8_t ref[2], out[2];
+                int ref_len = ref_decode_hex(ref, str);
+                int len = decode_hex(out, str);
+                
+                ut_assert(len == ref_len);
+                if (len >= 0) {
+                    ut_assert(!memcmp(out, ref, (size_t)len));
+                }
+                
+                // Also check the other half of the word
+                str[0] = '0';
+                str[1] = '0';
+                str[2] = (char)a;
+                str[3] = (char)b;
+                ut_assert(decode_hex(out, str) == ref_decode_hex(ref, str));
+                if (ref_len >= 0) {
+                    ut_assert(!memcmp(out, ref, 2));
+                }
+            }
+        }
+    }
+    
+    // Random strings should be decoded the same way as before, in place.
+    {
+        srand(38);
+        
+        for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+            char str[MAX_DIGITS + 1];
+            int length = rand() % (MAX_DIGITS + 1);
+            random_string(str, length, (i & 1) ? 0 : (rand() % 16));
+            
+            uint8_t ref[RN2483_BUFFER_LEN];
+            int ref_len = ref_decode_hex(ref, str);
+            
+            // Decode in place after the same offset as a radio_rx response,
+            // which also covers unaligned strings
+            char buffer[RN2483_BUFFER_LEN];
+            int offset = RN2483_RSP_RX_OK_LEN + (rand() % 4);
+            if ((offset + length) >= RN2483_BUFFER_LEN) {
+                offset = RN2483_RSP_RX_OK_LEN;
+            }
+            strcpy(buffer + offset, str);
+            int len = decode_hex((uint8_t*)buffer, buffer + offset);
+            
+            ut_assert(len == ref_len);
+            if (len >= 0) {
+                ut_assert(!memcmp(buffer, ref, (size_t)len));
+            }
+        }
+    }
+    
+    // Compare speed for a full length payload.
+    {
+        char str[MAX_DIGITS + 1];
+        random_string(str, MAX_DIGITS & ~1, 0);
+        
+        double ref_ns = bench(ref_decode_hex, "character at a time", str);
+        double ns = bench(decode_hex, "word at a time", str);
+        fprintf(stderr, "speed up: %.2fx\n", ref_ns / ns);
+    }
+    
+    return UT_PASS;
+}
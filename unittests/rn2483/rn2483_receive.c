@@ -0,0 +1,102 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  rn2483_receive() starts a reception, once a packet has been received the
+ *  SNR and RSSI are read and the decoded payload is passed to the callback.
+ */
+
+static struct rn2483_desc_t radio;
+
+static uint8_t received[RN2483_BUFFER_LEN];
+static int received_length;
+static int8_t received_snr;
+static int8_t received_rssi;
+static int receive_count;
+
+static void receive_callback (struct rn2483_desc_t *inst, void *context,
+                              uint8_t *data, uint8_t length, int8_t snr,
+                              int8_t rssi)
+{
+    ut_assert(inst == &radio);
+    ut_assert(context == &received);
+    
+    if (data != NULL) {
+        memcpy(received, data, length);
+    }
+    received_length = (data != NULL) ? length : -1;
+    received_snr = snr;
+    received_rssi = rssi;
+    receive_count++;
+}
+
+/**
+ *  Start a reception and provide a radio_rx response.
+ */
+static void receive (const char *response)
+{
+    init_idle(&radio);
+    uart_reset(TEST_UART_OUT_LEN);
+    receive_count = 0;
+    
+    ut_assert(rn2483_receive(&radio, receive_callback, &received) ==
+              RN2483_OP_SUCCESS);
+    ut_assert(!strcmp(uart_out, "radio rx 0\r\n"));
+    
+    radio_line(&radio, "ok");
+    ut_assert(radio.state == RN2483_RECEIVE_WAIT);
+    
+    uart_reset(TEST_UART_OUT_LEN);
+    radio_line(&radio, response);
+    ut_assert(!strcmp(uart_out, "radio get snr\r\n"));
+    
+    uart_reset(TEST_UART_OUT_LEN);
+    radio_line(&radio, "-7");
+    ut_assert(!strcmp(uart_out, "radio get rssi\r\n"));
+    
+    radio_line(&radio, "-96");
+}
+
+
+int main (int argc, char **argv)
+{
+    // Receive a packet.
+    {
+        receive("radio_rx  48656c6C6F2C20776F726C6400FF");
+        
+        ut_assert(receive_count == 1);
+        ut_assert(received_length == 14);
+        ut_assert(!memcmp(received, "Hello, world\0\xFF", 14));
+        ut_assert(received_snr == -7);
+        ut_assert(received_rssi == -96);
+        ut_assert(!radio.receive);
+    }
+    
+    // Receive a full length packet.
+    {
+        char response[RN2483_BUFFER_LEN];
+        strcpy(response, "radio_rx ");
+        
+        int length = (RN2483_BUFFER_LEN - RN2483_RSP_RX_OK_LEN - 1) / 2;
+        for (int i = 0; i < length; i++) {
+            sprintf(response + RN2483_RSP_RX_OK_LEN + (2 * i), "%02x",
+                    (i * 37) & 0xFF);
+        }
+        
+        receive(response);
+        
+        ut_assert(receive_count == 1);
+        ut_assert(received_length == length);
+        for (int i = 0; i < length; i++) {
+            ut_assert(received[i] == ((i * 37) & 0xFF));
+        }
+    }
+    
+    // An invalid packet should not be passed to the callback.
+    {
+        receive("radio_rx 48656Z6C");
+        ut_assert(receive_count == 0);
+    }
+    
+    return UT_PASS;
+}
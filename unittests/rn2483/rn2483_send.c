@@ -0,0 +1,135 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  rn2483_send() marshals the radio tx command and payload into the UART's
+ *  output buffer, resuming where it left off when the buffer is full.
+ */
+
+static struct rn2483_desc_t radio;
+
+/**
+ *  Service the driver until the whole tx command has been written, with a
+ *  limited amount of space in the UART each time.
+ */
+static void send_chunked (uint16_t chunk)
+{
+    for (int i = 0; (i < 1000) && !radio.waiting_for_line; i++) {
+        uart_space = chunk;
+        rn2483_service(&radio);
+    }
+    ut_assert(radio.waiting_for_line);
+}
+
+
+int main (int argc, char **argv)
+{
+    // Send a short packet with plenty of space.
+    {
+        static const uint8_t data[] = { 0x00, 0x01, 0x7F, 0x80, 0xFF, 0xAB,
+                                        0x5c };
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        uint8_t id;
+        enum rn2483_operation_result res = rn2483_send(&radio, data,
+                                                       sizeof(data), &id);
+        
+        ut_assert(res == RN2483_OP_SUCCESS);
+        ut_assert(!strcmp(uart_out, "radio tx 00017F80FFAB5C\r\n"));
+        ut_assert(uart_put_calls == 1);
+        ut_assert(rn2483_get_send_state(&radio, id) ==
+                  RN2483_SEND_TRANS_WRITTEN);
+        
+        // Complete the transaction
+        radio_line(&radio, "ok");
+        ut_assert(radio.state == RN2483_SEND_WAIT);
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(radio.state == RN2483_IDLE);
+        ut_assert(rn2483_get_send_state(&radio, id) == RN2483_SEND_TRANS_DONE);
+    }
+    
+    // Send a packet with every byte value, in chunks of every size.
+    {
+        static uint8_t data[256];
+        for (int i = 0; i < 256; i++) {
+            data[i] = (uint8_t)i;
+        }
+        
+        uint8_t max = ((RN2483_BUFFER_LEN - (RN2483_CMD_TX_LEN + 2)) / 2);
+        
+        for (int start = 0; start < 256; start += max) {
+            uint8_t length = ((256 - start) < max) ? (256 - start) : max;
+            
+            char expected[RN2483_BUFFER_LEN + 1];
+            strcpy(expected, "radio tx ");
+            for (int i = 0; i < length; i++) {
+                sprintf(expected + RN2483_CMD_TX_LEN + (2 * i), "%02X",
+                        data[start + i]);
+            }
+            strcat(expected, "\r\n");
+            uint16_t total = (uint16_t)strlen(expected);
+            
+            for (uint16_t chunk = 1; chunk <= (total + 1); chunk++) {
+                init_idle(&radio);
+                uart_reset(0);
+                
+                uint8_t id;
+                ut_assert(rn2483_send(&radio, data + start, length, &id) ==
+                          RN2483_OP_SUCCESS);
+                ut_assert(rn2483_get_send_state(&radio, id) ==
+                          RN2483_SEND_TRANS_PENDING);
+                
+                send_chunked(chunk);
+                
+                ut_assert(uart_out_length == total);
+                ut_assert(!memcmp(uart_out, expected, total));
+                ut_assert(rn2483_get_send_state(&radio, id) ==
+                          RN2483_SEND_TRANS_WRITTEN);
+                
+                // One call to start the send with no space, then one call for
+                // each chunk
+                ut_assert(uart_put_calls ==
+                          (uint32_t)(1 + ((total + chunk - 1) / chunk)));
+            }
+        }
+    }
+    
+    // Data that is too long should be rejected.
+    {
+        static const uint8_t data[128];
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        uint8_t id;
+        ut_assert(rn2483_send(&radio, data, sizeof(data), &id) ==
+                  RN2483_OP_TOO_LONG);
+        ut_assert(uart_out_length == 0);
+    }
+    
+    // A failed send should be reported.
+    {
+        static const uint8_t data[] = { 0x12 };
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        uint8_t id;
+        ut_assert(rn2483_send(&radio, data, sizeof(data), &id) ==
+                  RN2483_OP_SUCCESS);
+        ut_assert(!strcmp(uart_out, "radio tx 12\r\n"));
+        
+        radio_line(&radio, "invalid_param");
+        ut_assert(radio.state == RN2483_IDLE);
+        ut_assert(rn2483_get_send_state(&radio, id) ==
+                  RN2483_SEND_TRANS_FAILED);
+        
+        // The next command should be marshaled from scratch
+        rn2483_clear_send_transaction(&radio, id);
+        uart_reset(TEST_UART_OUT_LEN);
+        ut_assert(rn2483_send(&radio, data, sizeof(data), &id) ==
+                  RN2483_OP_SUCCESS);
+        ut_assert(!strcmp(uart_out, "radio tx 12\r\n"));
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,187 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Frames queued with rn2483_send() and rn2483_send_copy() are sent in order,
+ *  with the next radio tx command written as soon as the radio reports that
+ *  the previous frame has been transmitted.
+ */
+
+static struct rn2483_desc_t radio;
+
+static void expect_tx (const char *command)
+{
+    ut_assert(!strcmp(uart_out, command));
+    uart_reset(TEST_UART_OUT_LEN);
+}
+
+
+int main (int argc, char **argv)
+{
+    // Queue a burst of frames.
+    {
+        static const uint8_t data[RN2483_SEND_QUEUE_LEN][2] = {
+            { 0x00, 0x11 }, { 0x22, 0x33 }, { 0x44, 0x55 }, { 0x66, 0x77 }
+        };
+        uint8_t ids[RN2483_SEND_QUEUE_LEN];
+        
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        for (int i = 0; i < RN2483_SEND_QUEUE_LEN; i++) {
+            ut_assert(rn2483_send(&radio, data[i], 2, ids + i) ==
+                      RN2483_OP_SUCCESS);
+        }
+        
+        // Queue is full
+        uint8_t id;
+        ut_assert(rn2483_send(&radio, data[0], 2, &id) == RN2483_OP_BUSY);
+        
+        // Only the first frame can be written until it has been sent
+        expect_tx("radio tx 0011\r\n");
+        ut_assert(rn2483_get_send_state(&radio, ids[0]) ==
+                  RN2483_SEND_TRANS_WRITTEN);
+        for (int i = 1; i < RN2483_SEND_QUEUE_LEN; i++) {
+            ut_assert(rn2483_get_send_state(&radio, ids[i]) ==
+                      RN2483_SEND_TRANS_PENDING);
+        }
+        
+        radio_line(&radio, "ok");
+        ut_assert(uart_out_length == 0);
+        
+        // Next frame is written right away when the first is done
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[0]) ==
+                  RN2483_SEND_TRANS_DONE);
+        expect_tx("radio tx 2233\r\n");
+        
+        // A frame which fails should not hold up the rest
+        radio_line(&radio, "invalid_param");
+        ut_assert(rn2483_get_send_state(&radio, ids[1]) ==
+                  RN2483_SEND_TRANS_FAILED);
+        expect_tx("radio tx 4455\r\n");
+        
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_err");
+        ut_assert(rn2483_get_send_state(&radio, ids[2]) ==
+                  RN2483_SEND_TRANS_FAILED);
+        expect_tx("radio tx 6677\r\n");
+        
+        // Entries are reused in order
+        ut_assert(rn2483_send(&radio, data[0], 2, &id) == RN2483_OP_BUSY);
+        rn2483_clear_send_transaction(&radio, ids[1]);
+        ut_assert(rn2483_send(&radio, data[0], 2, &id) == RN2483_OP_BUSY);
+        rn2483_clear_send_transaction(&radio, ids[0]);
+        ut_assert(rn2483_send(&radio, data[0], 2, &id) == RN2483_OP_SUCCESS);
+        ut_assert(id == ids[0]);
+        
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[3]) ==
+                  RN2483_SEND_TRANS_DONE);
+        expect_tx("radio tx 0011\r\n");
+        
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[0]) ==
+                  RN2483_SEND_TRANS_DONE);
+        ut_assert(radio.state == RN2483_IDLE);
+        ut_assert(uart_out_length == 0);
+    }
+    
+    // A frame queued while the radio is transmitting is marshaled right away.
+    {
+        static const uint8_t first[] = { 0xAA };
+        static const uint8_t second[] = { 0xBB };
+        uint8_t id1, id2;
+        
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        ut_assert(rn2483_send(&radio, first, 1, &id1) == RN2483_OP_SUCCESS);
+        expect_tx("radio tx AA\r\n");
+        radio_line(&radio, "ok");
+        
+        ut_assert(rn2483_send(&radio, second, 1, &id2) == RN2483_OP_SUCCESS);
+        ut_assert(radio.cmd_ready);
+        ut_assert(uart_out_length == 0);
+        
+        ut_assert(rn2483_get_send_state(&radio, id2) ==
+                  RN2483_SEND_TRANS_PENDING);
+        
+        radio_line(&radio, "radio_tx_ok");
+        expect_tx("radio tx BB\r\n");
+        ut_assert(rn2483_get_send_state(&radio, id2) ==
+                  RN2483_SEND_TRANS_WRITTEN);
+    }
+    
+    // Copied frames don't depend on the caller's buffer.
+    {
+        uint8_t data[RN2483_SEND_COPY_LEN + 1];
+        memset(data, 0x5A, sizeof(data));
+        uint8_t id1, id2;
+        
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        ut_assert(rn2483_send_copy(&radio, data, sizeof(data), &id1) ==
+                  RN2483_OP_TOO_LONG);
+        
+        ut_assert(rn2483_send_copy(&radio, data, 1, &id1) ==
+                  RN2483_OP_SUCCESS);
+        data[0] = 0x12;
+        ut_assert(rn2483_send_copy(&radio, data, 1, &id2) ==
+                  RN2483_OP_SUCCESS);
+        data[0] = 0x34;
+        
+        expect_tx("radio tx 5A\r\n");
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_tx_ok");
+        expect_tx("radio tx 12\r\n");
+    }
+    
+    // Pending transactions can't be cleared, and a transaction which is
+    // cleared while being sent is not reused until it is done.
+    {
+        static const uint8_t data[] = { 0x01 };
+        uint8_t ids[RN2483_SEND_QUEUE_LEN];
+        
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        for (int i = 0; i < RN2483_SEND_QUEUE_LEN; i++) {
+            ut_assert(rn2483_send(&radio, data, 1, ids + i) ==
+                      RN2483_OP_SUCCESS);
+        }
+        
+        rn2483_clear_send_transaction(&radio, ids[1]);
+        ut_assert(rn2483_get_send_state(&radio, ids[1]) ==
+                  RN2483_SEND_TRANS_PENDING);
+        
+        // Send all but the last frame
+        for (int i = 0; i < (RN2483_SEND_QUEUE_LEN - 1); i++) {
+            radio_line(&radio, "ok");
+            radio_line(&radio, "radio_tx_ok");
+            rn2483_clear_send_transaction(&radio, ids[i]);
+        }
+        
+        // Clear the frame which is being sent
+        ut_assert(rn2483_get_send_state(&radio, ids[RN2483_SEND_QUEUE_LEN - 1])
+                  == RN2483_SEND_TRANS_WRITTEN);
+        rn2483_clear_send_transaction(&radio, ids[RN2483_SEND_QUEUE_LEN - 1]);
+        
+        uint8_t id;
+        for (int i = 0; i < (RN2483_SEND_QUEUE_LEN - 1); i++) {
+            ut_assert(rn2483_send(&radio, data, 1, &id) == RN2483_OP_SUCCESS);
+        }
+        ut_assert(rn2483_send(&radio, data, 1, &id) == RN2483_OP_BUSY);
+        
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[RN2483_SEND_QUEUE_LEN - 1])
+                  == RN2483_SEND_TRANS_INVALID);
+        ut_assert(rn2483_send(&radio, data, 1, &id) == RN2483_OP_SUCCESS);
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,176 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Radio settings are written to the module after it is reset and whenever
+ *  they are changed at runtime. Only the settings which have changed are
+ *  written, the next time the driver is idle.
+ */
+
+static struct rn2483_desc_t radio;
+
+static void expect_tx (const char *command)
+{
+    ut_assert(!strcmp(uart_out, command));
+    uart_reset(TEST_UART_OUT_LEN);
+}
+
+/**
+ *  Check that a command is written and respond with ok.
+ */
+static void expect_ok (const char *command)
+{
+    expect_tx(command);
+    radio_line(&radio, "ok");
+}
+
+
+int main (int argc, char **argv)
+{
+    // Every setting should be written after the module is reset.
+    {
+        memset(&radio, 0, sizeof(radio));
+        uart_reset(TEST_UART_OUT_LEN);
+        init_rn2483(&radio, NULL, 434000000UL, 10, RN2483_SF_SF9,
+                    RN2483_CR_4_7, RN2483_BW_500, 0, 1, 0x43);
+        rn2483_service(&radio);
+        
+        expect_tx("sys reset\r\n");
+        radio_line(&radio, "RN2483 1.0.5 Oct 31 2018 15:06:52");
+        expect_ok("radio set wdt 0\r\n");
+        expect_tx("mac pause\r\n");
+        radio_line(&radio, "4294967245");
+        expect_ok("radio set mod lora\r\n");
+        expect_ok("radio set freq 434000000\r\n");
+        expect_ok("radio set pwr 10\r\n");
+        expect_ok("radio set sf sf9\r\n");
+        expect_ok("radio set crc off\r\n");
+        expect_ok("radio set iqi on\r\n");
+        expect_ok("radio set cr 4/7\r\n");
+        expect_ok("radio set sync 67\r\n");
+        expect_ok("radio set bw 500\r\n");
+        
+        // Then the pin modes are written
+        ut_assert(radio.state == RN2483_SET_PIN_MODE);
+        ut_assert(radio.settings_dirty == 0);
+    }
+    
+    // Only a changed setting should be written.
+    {
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        // Setting the current value does nothing
+        rn2483_set_spreading_factor(&radio, RN2483_SF_SF9);
+        rn2483_set_freq(&radio, 433050000UL);
+        ut_assert(uart_out_length == 0);
+        
+        rn2483_set_spreading_factor(&radio, RN2483_SF_SF10);
+        expect_ok("radio set sf sf10\r\n");
+        ut_assert(radio.state == RN2483_IDLE);
+        ut_assert(uart_out_length == 0);
+        
+        // Out of range values are clamped
+        rn2483_set_power(&radio, 20);
+        ut_assert(uart_out_length == 0);
+        rn2483_set_power(&radio, -10);
+        expect_ok("radio set pwr -3\r\n");
+        rn2483_set_freq(&radio, 1);
+        ut_assert(uart_out_length == 0);
+        rn2483_set_freq(&radio, 434790001UL);
+        expect_ok("radio set freq 434790000\r\n");
+        
+        ut_assert(radio.state == RN2483_IDLE);
+    }
+    
+    // Several changes should be written one after another.
+    {
+        init_idle(&radio);
+        uart_reset(0);
+        
+        // Can't write anything until there is space in the UART
+        rn2483_set_bandwidth(&radio, RN2483_BW_125);
+        rn2483_set_coding_rate(&radio, RN2483_CR_4_8);
+        rn2483_set_crc(&radio, 0);
+        rn2483_set_invert_qi(&radio, 1);
+        rn2483_set_sync_byte(&radio, 0x12);
+        rn2483_set_power(&radio, -3);
+        ut_assert(uart_out_length == 0);
+        
+        // The first change was already being written, the rest are written in
+        // order afterwards
+        uart_space = TEST_UART_OUT_LEN;
+        rn2483_service(&radio);
+        expect_ok("radio set bw 125\r\n");
+        expect_ok("radio set pwr -3\r\n");
+        expect_ok("radio set crc off\r\n");
+        expect_ok("radio set iqi on\r\n");
+        expect_ok("radio set cr 4/8\r\n");
+        expect_ok("radio set sync 18\r\n");
+        ut_assert(radio.state == RN2483_IDLE);
+        ut_assert(uart_out_length == 0);
+    }
+    
+    // A change while a frame is being sent should be written before the next
+    // frame.
+    {
+        static const uint8_t first[] = { 0x01, 0x02 };
+        static const uint8_t second[] = { 0x03, 0x04 };
+        uint8_t ids[2];
+        
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        rn2483_send(&radio, first, sizeof(first), ids + 0);
+        expect_tx("radio tx 0102\r\n");
+        radio_line(&radio, "ok");
+        
+        // The next frame is marshaled while the first is transmitted
+        rn2483_send(&radio, second, sizeof(second), ids + 1);
+        ut_assert(radio.cmd_ready);
+        
+        rn2483_set_spreading_factor(&radio, RN2483_SF_SF12);
+        ut_assert(uart_out_length == 0);
+        
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[0]) ==
+                  RN2483_SEND_TRANS_DONE);
+        expect_ok("radio set sf sf12\r\n");
+        expect_tx("radio tx 0304\r\n");
+        radio_line(&radio, "ok");
+        radio_line(&radio, "radio_tx_ok");
+        ut_assert(rn2483_get_send_state(&radio, ids[1]) ==
+                  RN2483_SEND_TRANS_DONE);
+        ut_assert(radio.state == RN2483_IDLE);
+    }
+    
+    // A change while receiving should stop the reception, write the setting
+    // and then start receiving again.
+    {
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        ut_assert(rn2483_receive(&radio, NULL, NULL) == RN2483_OP_SUCCESS);
+        expect_ok("radio rx 0\r\n");
+        ut_assert(radio.state == RN2483_RECEIVE_WAIT);
+        
+        rn2483_set_freq(&radio, 434000000UL);
+        expect_ok("radio rxstop\r\n");
+        radio_line(&radio, "radio_err");
+        expect_ok("radio set freq 434000000\r\n");
+        expect_tx("radio rx 0\r\n");
+    }
+    
+    // A module which can not be configured should fail.
+    {
+        init_idle(&radio);
+        uart_reset(TEST_UART_OUT_LEN);
+        
+        rn2483_set_coding_rate(&radio, RN2483_CR_4_6);
+        expect_tx("radio set cr 4/6\r\n");
+        radio_line(&radio, "invalid_param");
+        ut_assert(radio.state == RN2483_FAILED);
+    }
+    
+    return UT_PASS;
+}
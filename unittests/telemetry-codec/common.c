@@ -0,0 +1,35 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+
+/**
+ *  Fill a sample with values similar to those seen in flight.
+ */
+static void make_sample (struct telemetry_frame *sample, uint32_t time)
+{
+    memset(sample, 0, sizeof(*sample));
+    sample->mission_time = time;
+    sample->flags.gps_data_valid = 1;
+    sample->flags.state_coasting_ascent = 1;
+    for (int i = 0; i < 8; i++) {
+        sample->adc_data[i] = (uint16_t)(2000 + (i * 100) + (time % 7));
+    }
+    sample->accel_x = (uint16_t)(12 + (time % 3));
+    sample->accel_y = (uint16_t)-4;
+    sample->accel_z = (uint16_t)(1024 - (time % 5));
+    sample->accel_temp = 2300;
+    sample->altimeter_temp = 2150;
+    sample->altimeter_altitude = 1500.0f + (time / 100);
+    sample->gps_utc_time = 153015 + (time / 1000);
+    sample->gps_latitude = 453456789 + (int32_t)(time / 10);
+    sample->gps_longitude = -757654321 - (int32_t)(time / 20);
+    sample->gps_speed = 250;
+    sample->gps_course = -12;
+    sample->gps_altitude = 1500 + (int32_t)(time / 100);
+}
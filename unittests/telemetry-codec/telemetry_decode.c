@@ -0,0 +1,131 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  The decoder must recover from lost samples and reject data which is not a
+ *  valid sample without reading past the end of the data.
+ */
+
+int main (int argc, char **argv)
+{
+    static struct telemetry_encoder_t enc;
+    static struct telemetry_decoder_t dec;
+    uint8_t buffer[TELEMETRY_CODEC_MAX_LEN];
+    uint32_t base = 0;
+    struct telemetry_frame sample, decoded;
+    uint8_t consumed;
+    
+    // Samples encoded against a lost keyframe should be skipped until the next
+    // keyframe is received.
+    {
+        init_telemetry_encoder(&enc, 4);
+        init_telemetry_decoder(&dec);
+        
+        for (uint32_t t = 0; t < 12; t++) {
+            make_sample(&sample, t * 100);
+            uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+            
+            if (t == 4) {
+                // Lose the second keyframe
+                continue;
+            }
+            
+            consumed = 0;
+            enum telemetry_decode_result result = telemetry_decode(&dec, buffer,
+                                                                   length, base,
+                                                                   &consumed,
+                                                                   &decoded);
+            ut_assert(consumed == length);
+            if ((t > 4) && (t < 8)) {
+                ut_assert(result == TELEMETRY_DECODE_NO_KEYFRAME);
+            } else {
+                ut_assert(result == TELEMETRY_DECODE_OK);
+                ut_assert(!memcmp(&sample, &decoded, sizeof(sample)));
+            }
+        }
+    }
+    
+    // A delta sample received before any keyframe should be skipped.
+    {
+        init_telemetry_encoder(&enc, 4);
+        init_telemetry_decoder(&dec);
+        
+        make_sample(&sample, 100);
+        telemetry_encode(&enc, &sample, base, buffer);
+        uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+        ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_NO_KEYFRAME);
+    }
+    
+    // Losing a delta sample should not affect any other sample.
+    {
+        init_telemetry_encoder(&enc, 10);
+        init_telemetry_decoder(&dec);
+        
+        for (uint32_t t = 0; t < 10; t++) {
+            make_sample(&sample, t * 100);
+            uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+            if ((t % 3) == 1) {
+                continue;
+            }
+            ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                       &decoded) == TELEMETRY_DECODE_OK);
+            ut_assert(!memcmp(&sample, &decoded, sizeof(sample)));
+        }
+    }
+    
+    // Truncated samples should be invalid.
+    {
+        init_telemetry_encoder(&enc, 10);
+        make_sample(&sample, 100);
+        uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+        
+        for (uint8_t l = 0; l < length; l++) {
+            init_telemetry_decoder(&dec);
+            ut_assert(telemetry_decode(&dec, buffer, l, base, &consumed,
+                                       &decoded) == TELEMETRY_DECODE_INVALID);
+            ut_assert(!dec.have_keyframe);
+        }
+    }
+    
+    // Samples with an unknown version or type should be invalid.
+    {
+        init_telemetry_encoder(&enc, 10);
+        make_sample(&sample, 100);
+        uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+        
+        init_telemetry_decoder(&dec);
+        buffer[0] = (uint8_t)(((TELEMETRY_CODEC_VERSION + 1) << 4) |
+                              TELEMETRY_CODEC_KEYFRAME);
+        ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_INVALID);
+        
+        buffer[0] = (uint8_t)((TELEMETRY_CODEC_VERSION << 4) | 2);
+        ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_INVALID);
+    }
+    
+    // A bitmap with fields that do not exist or a varint that is too long
+    // should be invalid.
+    {
+        init_telemetry_decoder(&dec);
+        
+        static const uint8_t bad_bitmap[] = {
+            (TELEMETRY_CODEC_VERSION << 4) | TELEMETRY_CODEC_KEYFRAME, 0,
+            0x80, 0x80, 0x80, 0x02
+        };
+        ut_assert(telemetry_decode(&dec, bad_bitmap, sizeof(bad_bitmap),
+                                   base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_INVALID);
+        
+        static const uint8_t long_varint[] = {
+            (TELEMETRY_CODEC_VERSION << 4) | TELEMETRY_CODEC_KEYFRAME, 0,
+            0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01
+        };
+        ut_assert(telemetry_decode(&dec, long_varint, sizeof(long_varint),
+                                   base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_INVALID);
+    }
+    
+    return UT_PASS;
+}
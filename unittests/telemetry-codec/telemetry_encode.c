@@ -0,0 +1,138 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Samples are encoded as a keyframe followed by samples encoded against the
+ *  keyframe. Every sample must decode to exactly the sample which was encoded.
+ */
+
+int main (int argc, char **argv)
+{
+    static struct telemetry_encoder_t enc;
+    static struct telemetry_decoder_t dec;
+    uint8_t buffer[TELEMETRY_CODEC_MAX_LEN];
+    uint32_t base = 0;
+    
+    // Samples should round trip through the encoder and decoder.
+    {
+        init_telemetry_encoder(&enc, 10);
+        init_telemetry_decoder(&dec);
+        
+        for (uint32_t t = 0; t < 1000; t++) {
+            struct telemetry_frame sample, decoded;
+            make_sample(&sample, t * 100);
+            // Samples are grouped into frames of four
+            base = (t - (t % 4)) * 100;
+            
+            uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+            ut_assert(length <= TELEMETRY_CODEC_MAX_LEN);
+            ut_assert((buffer[0] & 0xF) == (((t % 10) == 0) ?
+                                            TELEMETRY_CODEC_KEYFRAME :
+                                            TELEMETRY_CODEC_DELTA));
+            
+            uint8_t consumed = 0;
+            ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                       &decoded) == TELEMETRY_DECODE_OK);
+            ut_assert(consumed == length);
+            ut_assert(!memcmp(&sample, &decoded, sizeof(sample)));
+        }
+    }
+    
+    // Samples should be much smaller than a raw sample.
+    {
+        init_telemetry_encoder(&enc, 10);
+        
+        uint32_t total = 0;
+        for (uint32_t t = 0; t < 100; t++) {
+            struct telemetry_frame sample;
+            make_sample(&sample, t * 100);
+            total += telemetry_encode(&enc, &sample, base, buffer);
+        }
+        ut_assert(total < (100 * sizeof(struct telemetry_frame) / 2));
+    }
+    
+    // A sample with every field as far as possible from the keyframe should be
+    // the maximum length.
+    {
+        struct telemetry_frame sample, decoded;
+        init_telemetry_encoder(&enc, 2);
+        init_telemetry_decoder(&dec);
+        
+        memset(&sample, 0x00, sizeof(sample));
+        sample.mission_time = 1;
+        uint8_t length = telemetry_encode(&enc, &sample, base, buffer);
+        uint8_t consumed;
+        ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_OK);
+        
+        // Every field differs from the keyframe by the most negative value
+        // for its size, which has the longest zig-zag encoding
+        for (uint8_t i = 0; i < TELEMETRY_CODEC_NUM_FIELDS; i++) {
+            const struct telemetry_codec_field_t *field =
+                                                    telemetry_codec_fields + i;
+            set_field(&sample, field, get_field(&decoded, field) +
+                                      ((field->size == 2) ? 0x8000 :
+                                                            0x80000000));
+        }
+        length = telemetry_encode(&enc, &sample, base, buffer);
+        ut_assert(length == TELEMETRY_CODEC_MAX_LEN);
+        ut_assert(telemetry_decode(&dec, buffer, length, base, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_OK);
+        ut_assert(!memcmp(&sample, &decoded, sizeof(sample)));
+    }
+    
+    // A sample which is the same as the keyframe should only have a header.
+    {
+        struct telemetry_frame sample;
+        init_telemetry_encoder(&enc, 10);
+        make_sample(&sample, 500);
+        base = sample.mission_time;
+        
+        telemetry_encode(&enc, &sample, base, buffer);
+        ut_assert(telemetry_encode(&enc, &sample, base, buffer) == 3);
+    }
+    
+    // The mission time should be encoded against the time base even in a
+    // keyframe.
+    {
+        struct telemetry_frame sample, decoded;
+        init_telemetry_encoder(&enc, 10);
+        init_telemetry_decoder(&dec);
+        make_sample(&sample, 3600000);
+        
+        uint8_t with_base = telemetry_encode(&enc, &sample, 3599900, buffer);
+        uint8_t consumed;
+        ut_assert(telemetry_decode(&dec, buffer, with_base, 3599900, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_OK);
+        ut_assert(decoded.mission_time == 3600000);
+        
+        telemetry_encoder_force_keyframe(&enc);
+        uint8_t without_base = telemetry_encode(&enc, &sample, 0, buffer);
+        ut_assert(without_base > with_base);
+        
+        // Decoding with the wrong time base gives the wrong time
+        ut_assert(telemetry_decode(&dec, buffer, without_base, 100, &consumed,
+                                   &decoded) == TELEMETRY_DECODE_OK);
+        ut_assert(decoded.mission_time == 3600100);
+    }
+    
+    // Forcing a keyframe should make the next sample a keyframe.
+    {
+        struct telemetry_frame sample;
+        init_telemetry_encoder(&enc, 10);
+        make_sample(&sample, 500);
+        
+        telemetry_encode(&enc, &sample, base, buffer);
+        uint8_t id = buffer[1];
+        telemetry_encode(&enc, &sample, base, buffer);
+        ut_assert((buffer[0] & 0xF) == TELEMETRY_CODEC_DELTA);
+        ut_assert(buffer[1] == id);
+        
+        telemetry_encoder_force_keyframe(&enc);
+        telemetry_encode(&enc, &sample, base, buffer);
+        ut_assert((buffer[0] & 0xF) == TELEMETRY_CODEC_KEYFRAME);
+        ut_assert(buffer[1] == (uint8_t)(id + 1));
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,25 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+
+/**
+ *  Build a sealed frame with a payload of a given length.
+ *
+ *  @return The length of the frame
+ */
+static uint8_t make_frame (uint8_t *frame, uint16_t sequence,
+                           uint8_t payload_length)
+{
+    for (uint8_t i = 0; i < payload_length; i++) {
+        frame[TELEMETRY_LINK_HEADER_LEN + i] = (uint8_t)(sequence + i);
+    }
+    return telemetry_link_seal(frame, TELEMETRY_LINK_HEADER_LEN +
+                                      payload_length, sequence);
+}
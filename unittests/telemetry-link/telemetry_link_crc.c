@@ -0,0 +1,62 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  The table driven CRC must match CRC-16-CCITT with an initial value of
+ *  0xFFFF (CRC-16/CCITT-FALSE), which is what the ground station and the host
+ *  software check frames against.
+ */
+
+/**
+ *  Calculate the CRC one bit at a time.
+ */
+static uint16_t ref_crc (const uint8_t *data, int length)
+{
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (uint16_t)((crc & 0x8000) ? ((crc << 1) ^ 0x1021) :
+                                              (crc << 1));
+        }
+    }
+    return crc;
+}
+
+
+int main (int argc, char **argv)
+{
+    // The standard check value should match.
+    {
+        ut_assert(telemetry_link_crc((const uint8_t*)"123456789", 9) ==
+                  0x29B1);
+        ut_assert(telemetry_link_crc(NULL, 0) == 0xFFFF);
+    }
+    
+    // Random data should match the bitwise calculation.
+    {
+        uint8_t data[256];
+        srand(45);
+        for (int i = 0; i < 1000; i++) {
+            int length = rand() % 257;
+            for (int j = 0; j < length; j++) {
+                data[j] = (uint8_t)rand();
+            }
+            ut_assert(telemetry_link_crc(data, (uint16_t)length) ==
+                      ref_crc(data, length));
+        }
+    }
+    
+    // Sealing a frame should store the sequence number and CRC.
+    {
+        uint8_t frame[16];
+        uint8_t length = make_frame(frame, 0x1234, 8);
+        ut_assert(length == (8 + TELEMETRY_LINK_OVERHEAD));
+        ut_assert((frame[0] == 0x34) && (frame[1] == 0x12));
+        
+        uint16_t crc = ref_crc(frame, 10);
+        ut_assert((frame[10] == (crc & 0xFF)) && (frame[11] == (crc >> 8)));
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,215 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Received frames are checked and counted. Lost frames are found from gaps
+ *  in the sequence numbers, and the interval between frames and its jitter
+ *  are tracked.
+ */
+
+static struct telemetry_link_stats_t stats;
+
+/**
+ *  Receive an intact frame.
+ */
+static enum telemetry_link_result receive (uint16_t sequence, uint32_t time)
+{
+    uint8_t frame[32];
+    uint8_t length = make_frame(frame, sequence, 10);
+    return telemetry_link_receive(&stats, frame, length, 0, time, 5, -90);
+}
+
+
+int main (int argc, char **argv)
+{
+    // Frames in order should all be received.
+    {
+        init_telemetry_link_stats(&stats);
+        for (uint16_t i = 0; i < 100; i++) {
+            ut_assert(receive(i, i * 1000) == TELEMETRY_LINK_OK);
+        }
+        ut_assert(stats.report.received == 100);
+        ut_assert(stats.report.lost == 0);
+        ut_assert(stats.report.duplicate == 0);
+        ut_assert(stats.report.corrupt == 0);
+        
+        // Perfectly regular arrivals have no jitter
+        ut_assert(stats.report.interval == (1000 << 4));
+        ut_assert(stats.report.jitter == 0);
+    }
+    
+    // Gaps in the sequence should be counted as lost, including across the
+    // wrap around of the sequence number.
+    {
+        init_telemetry_link_stats(&stats);
+        ut_assert(receive(65530, 0) == TELEMETRY_LINK_OK);
+        ut_assert(receive(65533, 3000) == TELEMETRY_LINK_OK);
+        ut_assert(receive(2, 8000) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.received == 3);
+        ut_assert(stats.report.lost == 6);
+        
+        // The interval is spread over the lost frames
+        ut_assert(stats.report.interval == (1000 << 4));
+        ut_assert(stats.report.jitter == 0);
+    }
+    
+    // Repeated frames should be counted as duplicates and a large jump
+    // backwards should be treated as the sender restarting.
+    {
+        init_telemetry_link_stats(&stats);
+        ut_assert(receive(500, 0) == TELEMETRY_LINK_OK);
+        ut_assert(receive(500, 10) == TELEMETRY_LINK_DUPLICATE);
+        ut_assert(receive(501, 1000) == TELEMETRY_LINK_OK);
+        ut_assert(receive(490, 1010) == TELEMETRY_LINK_DUPLICATE);
+        ut_assert(stats.report.duplicate == 2);
+        
+        ut_assert(receive(0, 2000) == TELEMETRY_LINK_OK);
+        ut_assert(receive(1, 3000) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.received == 4);
+        ut_assert(stats.report.lost == 0);
+    }
+    
+    // Frames which arrive late should be accepted once and no longer be
+    // counted as lost.
+    {
+        init_telemetry_link_stats(&stats);
+        ut_assert(receive(100, 0) == TELEMETRY_LINK_OK);
+        ut_assert(receive(103, 3000) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.lost == 2);
+        
+        ut_assert(receive(102, 3100) == TELEMETRY_LINK_OK);
+        ut_assert(receive(102, 3200) == TELEMETRY_LINK_DUPLICATE);
+        ut_assert(receive(103, 3300) == TELEMETRY_LINK_DUPLICATE);
+        ut_assert(stats.report.lost == 1);
+        ut_assert(stats.report.received == 3);
+        
+        // The late frames should not move the sequence backwards
+        ut_assert(receive(104, 4000) == TELEMETRY_LINK_OK);
+        ut_assert(receive(101, 4100) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.lost == 0);
+        ut_assert(stats.report.duplicate == 2);
+        
+        // Frames from before the first frame were never counted as lost
+        ut_assert(receive(99, 4200) == TELEMETRY_LINK_DUPLICATE);
+        
+        // After a gap as long as the window, frames in the window can still
+        // arrive late
+        ut_assert(receive(104 + TELEMETRY_LINK_REORDER_WINDOW, 5000) ==
+                  TELEMETRY_LINK_OK);
+        ut_assert(stats.report.lost == (TELEMETRY_LINK_REORDER_WINDOW - 1));
+        ut_assert(receive(105, 5100) == TELEMETRY_LINK_OK);
+        ut_assert(receive(105, 5200) == TELEMETRY_LINK_DUPLICATE);
+        ut_assert(stats.report.lost == (TELEMETRY_LINK_REORDER_WINDOW - 2));
+    }
+    
+    // Corrupted frames should be rejected without affecting the sequence.
+    {
+        uint8_t frame[32];
+        init_telemetry_link_stats(&stats);
+        ut_assert(receive(7, 0) == TELEMETRY_LINK_OK);
+        
+        for (uint8_t byte = 0; byte < (10 + TELEMETRY_LINK_OVERHEAD); byte++) {
+            uint8_t length = make_frame(frame, 8, 10);
+            frame[byte] ^= 0x10;
+            ut_assert(telemetry_link_receive(&stats, frame, length, 0, 100, 0,
+                                             -100) == TELEMETRY_LINK_CORRUPT);
+        }
+        
+        // Frames which forward error correction couldn't fix and frames which
+        // are too short are also corrupt
+        uint8_t length = make_frame(frame, 8, 10);
+        ut_assert(telemetry_link_receive(&stats, frame, length, -1, 100, 0,
+                                         -100) == TELEMETRY_LINK_CORRUPT);
+        ut_assert(telemetry_link_receive(&stats, frame, 3, 0, 100, 0,
+                                         -100) == TELEMETRY_LINK_CORRUPT);
+        
+        ut_assert(stats.report.corrupt == (10 + TELEMETRY_LINK_OVERHEAD + 2));
+        ut_assert(telemetry_link_receive(&stats, frame, length, 3, 1000, 0,
+                                         -100) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.lost == 0);
+        ut_assert(stats.report.corrected == 3);
+    }
+    
+    // Every frame should be counted in the histograms.
+    {
+        uint8_t frame[32];
+        init_telemetry_link_stats(&stats);
+        
+        static const int8_t snrs[] = { -128, -21, -20, -17, -16, 0, 7, 8,
+                                       127 };
+        static const uint8_t snr_buckets[] = { 0, 0, 0, 0, 1, 5, 6, 7, 7 };
+        for (unsigned i = 0; i < sizeof(snrs); i++) {
+            uint8_t length = make_frame(frame, (uint16_t)i, 4);
+            telemetry_link_receive(&stats, frame, length, 0, i, snrs[i],
+                                   INT8_MIN);
+        }
+        for (int b = 0; b < TELEMETRY_LINK_HISTOGRAM_BUCKETS; b++) {
+            uint16_t expected = 0;
+            for (unsigned i = 0; i < sizeof(snrs); i++) {
+                expected += (snr_buckets[i] == b);
+            }
+            ut_assert(stats.report.snr_histogram[b] == expected);
+            // Unknown RSSI is not counted
+            ut_assert(stats.report.rssi_histogram[b] == 0);
+        }
+        
+        static const int8_t rssis[] = { -127, -121, -120, -111, -60, -51,
+                                        -50, -1 };
+        static const uint8_t rssi_buckets[] = { 0, 0, 1, 1, 7, 7, 7, 7 };
+        for (unsigned i = 0; i < sizeof(rssis); i++) {
+            uint8_t length = make_frame(frame, (uint16_t)(100 + i), 4);
+            telemetry_link_receive(&stats, frame, length, 0, i, 0, rssis[i]);
+        }
+        for (int b = 0; b < TELEMETRY_LINK_HISTOGRAM_BUCKETS; b++) {
+            uint16_t expected = 0;
+            for (unsigned i = 0; i < sizeof(rssis); i++) {
+                expected += (rssi_buckets[i] == b);
+            }
+            ut_assert(stats.report.rssi_histogram[b] == expected);
+        }
+    }
+    
+    // Irregular arrivals should have jitter close to their average deviation.
+    {
+        init_telemetry_link_stats(&stats);
+        uint32_t time = 0;
+        for (uint16_t i = 0; i < 1000; i++) {
+            // Alternately 100 ms early and 100 ms late
+            time += (i & 1) ? 1100 : 900;
+            ut_assert(receive(i, time) == TELEMETRY_LINK_OK);
+        }
+        ut_assert(abs((int32_t)stats.report.interval - (1000 << 4)) <
+                  (20 << 4));
+        ut_assert(abs((int32_t)stats.report.jitter - (100 << 4)) < (20 << 4));
+    }
+    
+    // Intervals longer than four seconds, such as the 5 second period used
+    // on the pad, should be tracked without saturating.
+    {
+        init_telemetry_link_stats(&stats);
+        uint32_t time = 0;
+        for (uint16_t i = 0; i < 100; i++) {
+            ut_assert(receive(i, time) == TELEMETRY_LINK_OK);
+            time += 5000;
+        }
+        ut_assert(stats.report.interval == (5000 << 4));
+        ut_assert(stats.report.jitter == 0);
+        
+        // Alternately 500 ms early and 500 ms late
+        for (uint16_t i = 100; i < 1100; i++) {
+            time += (i & 1) ? 5500 : 4500;
+            ut_assert(receive(i, time) == TELEMETRY_LINK_OK);
+        }
+        ut_assert(abs((int32_t)stats.report.interval - (5000 << 4)) <
+                  (100 << 4));
+        ut_assert(abs((int32_t)stats.report.jitter - (500 << 4)) < (100 << 4));
+        
+        // A lost frame spreads the interval over both frames
+        init_telemetry_link_stats(&stats);
+        ut_assert(receive(0, 0) == TELEMETRY_LINK_OK);
+        ut_assert(receive(2, 10000) == TELEMETRY_LINK_OK);
+        ut_assert(stats.report.interval == (5000 << 4));
+    }
+    
+    return UT_PASS;
+}
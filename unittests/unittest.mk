@@ -49,7 +49,7 @@ LCOV_OPTS += --rc lcov_branch_coverage=1
 build: $(TEST_BINARIES)
 
 $(BINDIR)/% %.gcno: %.c $(COMMON) | $(BINDIR)
-	$(CC) $(CFLAGS) -Wall -fprofile-arcs -ftest-coverage "$(abspath $<)" -o ${BINDIR}/$(basename $(notdir $@))
+	$(CC) $(CFLAGS) -Wall -fprofile-arcs -ftest-coverage "$(abspath $<)" -o ${BINDIR}/$(basename $(notdir $@)) $(LDLIBS)
 
 %.gcda: $(BINDIR)/%
 	rm -f $@
@@ -0,0 +1,177 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+
+// Interrupts can not be disabled on the host
+#define __disable_irq()
+#define __enable_irq()
+
+// The USB interrupt is simulated by the stub peripheral, masking it defers
+// any in complete callbacks until it is unmasked
+static uint8_t usb_irq_masked;
+static void usb_irq_unmask (void);
+#define NVIC_DisableIRQ(irq)    (usb_irq_masked = 1)
+#define NVIC_EnableIRQ(irq)     usb_irq_unmask()
+#define __DSB()
+#define __ISB()
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+
+/* USB peripheral stubs */
+
+/** Maximum number of bytes which the stub host can receive */
+#define TEST_HOST_IN_LEN    4096
+
+/**
+ *  An in transaction which has been started on the stub USB peripheral.
+ */
+struct test_transaction_t {
+    const uint8_t *data;
+    uint16_t length;
+};
+
+/** In transactions which are waiting to be sent, one for each bank */
+static struct test_transaction_t in_banks[2];
+/** Number of transactions in in_banks */
+static uint8_t in_banks_used;
+
+/** Everything which the stub host has received */
+static uint8_t host_in[TEST_HOST_IN_LEN];
+/** Number of bytes in host_in */
+static uint16_t host_in_length;
+/** Number of in transactions which have been started */
+static uint32_t in_transactions;
+
+/** Callback for the data in endpoint */
+static void (*in_callback)(void);
+
+/** If set, the stub peripheral refuses to start in transactions */
+static uint8_t in_refuse;
+/** If set, the next in transaction is received by the host as soon as it is
+    started, as if the oldest transaction completed during the call */
+static uint8_t in_complete_on_start;
+/** Number of in complete interrupts waiting for the interrupt to be
+    unmasked */
+static uint8_t in_complete_pending;
+
+static uint8_t host_receive (void);
+
+void usb_enable_endpoint_in (uint8_t ep, enum usb_endpoint_size size,
+                             enum usb_endpoint_type type,
+                             void (*callback)(void))
+{
+}
+
+void usb_enable_endpoint_in_dual_bank (uint8_t ep, enum usb_endpoint_size size,
+                                       enum usb_endpoint_type type,
+                                       void (*callback)(void))
+{
+    in_callback = callback;
+}
+
+void usb_enable_endpoint_out (uint8_t ep, enum usb_endpoint_size size,
+                              enum usb_endpoint_type type,
+                              void (*callback)(uint16_t length))
+{
+}
+
+void usb_disable_endpoint_in (uint8_t ep)
+{
+}
+
+void usb_disable_endpoint_out (uint8_t ep)
+{
+}
+
+void usb_start_out (uint8_t ep, uint8_t *data, uint16_t length)
+{
+}
+
+uint8_t usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
+                      uint8_t zlp)
+{
+    // The USB can only read from aligned memory
+    ut_assert(((uintptr_t)data & 0x3) == 0);
+    ut_assert(length != 0);
+    // The in complete callback must not be able to run while transactions
+    // are being queued
+    ut_assert(usb_irq_masked);
+    
+    if (in_refuse || (in_banks_used == 2)) {
+        return 1;
+    }
+    in_banks[in_banks_used].data = data;
+    in_banks[in_banks_used].length = length;
+    in_banks_used++;
+    in_transactions++;
+    
+    if (in_complete_on_start) {
+        in_complete_on_start = 0;
+        if (usb_irq_masked) {
+            in_complete_pending++;
+        } else {
+            host_receive();
+        }
+    }
+    return 0;
+}
+
+static void usb_irq_unmask (void)
+{
+    usb_irq_masked = 0;
+    
+    while (in_complete_pending) {
+        in_complete_pending--;
+        host_receive();
+    }
+}
+
+/* Vendor interface stubs */
+
+void usb_vendor_enable_config_callback (void)
+{
+}
+
+void usb_vendor_disable_config_callback (void)
+{
+}
+
+/**
+ *  Have the stub host receive the oldest in transaction.
+ *
+ *  @return 0 if a transaction was received, 1 if there was none
+ */
+static uint8_t host_receive (void)
+{
+    if (in_banks_used == 0) {
+        return 1;
+    }
+    
+    ut_assert((host_in_length + in_banks[0].length) <= TEST_HOST_IN_LEN);
+    memcpy(host_in + host_in_length, in_banks[0].data, in_banks[0].length);
+    host_in_length += in_banks[0].length;
+    
+    in_banks[0] = in_banks[1];
+    in_banks_used--;
+    
+    in_callback();
+    return 0;
+}
+
+/**
+ *  Reset the stub USB peripheral and enable the CDC configuration.
+ */
+static void reset_usb (void)
+{
+    in_banks_used = 0;
+    host_in_length = 0;
+    in_transactions = 0;
+    in_refuse = 0;
+    in_complete_on_start = 0;
+    in_complete_pending = 0;
+    usb_cdc_enable_config_callback();
+}
@@ -0,0 +1,142 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  Data written to a CDC port is sent to the host in transactions which always
+ *  start from aligned memory. While transactions are in progress, data which
+ *  is written is collected so that it can be sent in as few transactions as
+ *  possible.
+ */
+
+#define TEST_PORT   0
+
+
+int main (int argc, char **argv)
+{
+    // Unaligned data should be sent in a single transaction.
+    {
+        reset_usb();
+        
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"abc", 3);
+        ut_assert(in_transactions == 1);
+        
+        // The next transaction starts after the aligned end of the first
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"defghijklm", 10);
+        ut_assert(in_transactions == 2);
+        ut_assert(in_banks[1].length == 10);
+        
+        while (!host_receive());
+        ut_assert(host_in_length == 13);
+        ut_assert(!memcmp(host_in, "abcdefghijklm", 13));
+        ut_assert(in_transactions == 2);
+        ut_assert(usb_cdc_out_buffer_empty(TEST_PORT));
+    }
+    
+    // Data written while both banks are busy should be sent together.
+    {
+        reset_usb();
+        
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"a", 1);
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"b", 1);
+        ut_assert(in_transactions == 2);
+        
+        for (int i = 0; i < 20; i++) {
+            usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"cde", 3);
+        }
+        ut_assert(in_transactions == 2);
+        
+        host_receive();
+        ut_assert(in_transactions == 3);
+        ut_assert(in_banks[1].length == 60);
+        
+        while (!host_receive());
+        ut_assert(host_in_length == 62);
+        ut_assert(in_transactions == 3);
+    }
+    
+    // A long stream of unaligned writes should arrive intact and use few
+    // transactions.
+    {
+        reset_usb();
+        
+        uint8_t expected[TEST_HOST_IN_LEN];
+        uint16_t written = 0;
+        uint8_t chunk[7];
+        
+        while (written < (TEST_HOST_IN_LEN - sizeof(chunk))) {
+            for (uint8_t i = 0; i < sizeof(chunk); i++) {
+                chunk[i] = (uint8_t)((written + i) * 13);
+            }
+            uint16_t sent = usb_cdc_put_bytes(TEST_PORT, chunk, sizeof(chunk));
+            memcpy(expected + written, chunk, sent);
+            written += sent;
+            
+            if (sent < sizeof(chunk)) {
+                // The buffer is full, wait for the host to receive some data
+                // and write the rest of the chunk
+                ut_assert(!host_receive());
+                uint16_t rest = usb_cdc_put_bytes(TEST_PORT, chunk + sent,
+                                                  sizeof(chunk) - sent);
+                ut_assert(rest == (sizeof(chunk) - sent));
+                memcpy(expected + written, chunk + sent, rest);
+                written += rest;
+            }
+        }
+        
+        while (!host_receive());
+        ut_assert(host_in_length == written);
+        ut_assert(!memcmp(host_in, expected, written));
+        ut_assert(usb_cdc_out_buffer_empty(TEST_PORT));
+        
+        // Every transaction but the first two, which are sent as soon as
+        // there is data, carries more than a full packet on average
+        ut_assert(((in_transactions - 2) * USB_CDC_DATA_EP_SIZE) < written);
+    }
+    
+    // An in transaction which completes while data is being written should
+    // not disturb the transactions which are being queued.
+    {
+        reset_usb();
+        
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"abcd", 4);
+        ut_assert(in_transactions == 1);
+        
+        // The first transaction completes as soon as the second is started
+        in_complete_on_start = 1;
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"efgh", 4);
+        ut_assert(!in_complete_on_start);
+        ut_assert(!usb_irq_masked);
+        ut_assert(in_transactions == 2);
+        ut_assert(host_in_length == 4);
+        ut_assert(in_banks_used == 1);
+        
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"ijk", 3);
+        ut_assert(in_transactions == 3);
+        
+        while (!host_receive());
+        ut_assert(host_in_length == 11);
+        ut_assert(!memcmp(host_in, "abcdefghijk", 11));
+        ut_assert(usb_cdc_out_buffer_empty(TEST_PORT));
+    }
+    
+    // Data should not be lost if an in transaction can not be started.
+    {
+        reset_usb();
+        
+        in_refuse = 1;
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"abc", 3);
+        ut_assert(in_transactions == 0);
+        
+        in_refuse = 0;
+        usb_cdc_put_bytes(TEST_PORT, (const uint8_t*)"de", 2);
+        ut_assert(in_transactions == 1);
+        ut_assert(in_banks[0].length == 5);
+        
+        while (!host_receive());
+        ut_assert(host_in_length == 5);
+        ut_assert(!memcmp(host_in, "abcde", 5));
+        ut_assert(usb_cdc_out_buffer_empty(TEST_PORT));
+    }
+    
+    return UT_PASS;
+}
@@ -0,0 +1,102 @@
+#include <samd21j18a.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include SOURCE_C
+
+
+/* USB peripheral stubs */
+
+/** Callback for the in endpoint */
+static void (*in_callback)(void);
+/** Callback for the out endpoint */
+static void (*out_callback)(uint16_t length);
+
+/** Data for the in transaction which has been started */
+static const uint8_t *in_data;
+/** Length of the in transaction which has been started */
+static uint16_t in_length;
+/** Buffer for the out transaction which has been started */
+static uint8_t *out_data;
+/** Length of the out transaction which has been started */
+static uint16_t out_length;
+
+void usb_enable_endpoint_in (uint8_t ep, enum usb_endpoint_size size,
+                             enum usb_endpoint_type type,
+                             void (*callback)(void))
+{
+    ut_assert(ep == USB_VENDOR_IN_ENDPOINT);
+    ut_assert(type == USB_ENDPOINT_TYPE_BULK);
+    in_callback = callback;
+}
+
+void usb_enable_endpoint_out (uint8_t ep, enum usb_endpoint_size size,
+                              enum usb_endpoint_type type,
+                              void (*callback)(uint16_t length))
+{
+    ut_assert(ep == USB_VENDOR_OUT_ENDPOINT);
+    ut_assert(type == USB_ENDPOINT_TYPE_BULK);
+    out_callback = callback;
+}
+
+void usb_disable_endpoint_in (uint8_t ep)
+{
+}
+
+void usb_disable_endpoint_out (uint8_t ep)
+{
+}
+
+void usb_start_out (uint8_t ep, uint8_t *data, uint16_t length)
+{
+    // The USB can only write to aligned memory
+    ut_assert(((uintptr_t)data & 0x3) == 0);
+    ut_assert(out_data == NULL);
+    out_data = data;
+    out_length = length;
+}
+
+uint8_t usb_start_in (uint8_t ep, const uint8_t *data, uint16_t length,
+                      uint8_t zlp)
+{
+    // The USB can only read from aligned memory
+    ut_assert(((uintptr_t)data & 0x3) == 0);
+    ut_assert(in_data == NULL);
+    in_data = data;
+    in_length = length;
+    return 0;
+}
+
+/**
+ *  Have the stub host receive the in transaction.
+ */
+static void host_receive (void)
+{
+    ut_assert(in_data != NULL);
+    in_data = NULL;
+    in_callback();
+}
+
+/**
+ *  Have the stub host send data for the out transaction.
+ */
+static void host_send (const uint8_t *data, uint16_t length)
+{
+    ut_assert(out_data != NULL);
+    ut_assert(length <= out_length);
+    memcpy(out_data, data, length);
+    out_data = NULL;
+    out_callback(length);
+}
+
+/**
+ *  Reset the stub USB peripheral and enable the vendor interface.
+ */
+static void reset_usb (void)
+{
+    in_data = NULL;
+    out_data = NULL;
+    usb_vendor_disable_config_callback();
+    usb_vendor_enable_config_callback();
+}
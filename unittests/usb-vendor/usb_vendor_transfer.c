@@ -0,0 +1,94 @@
+#include <unittest.h>
+#include "common.c"
+
+/*
+ *  The vendor interface sends and receives data directly from buffers provided
+ *  by the caller, one transaction at a time in each direction.
+ */
+
+static uint8_t sent;
+static uint8_t *received_buffer;
+static uint16_t received_length;
+
+static void in_complete (void *context)
+{
+    sent++;
+}
+
+static void out_complete (void *context, uint8_t *buffer, uint16_t length)
+{
+    received_buffer = buffer;
+    received_length = length;
+}
+
+
+int main (int argc, char **argv)
+{
+    static uint32_t buffer[1024];
+    uint8_t *data = (uint8_t*)buffer;
+    
+    usb_vendor_set_callbacks(&in_complete, &out_complete, NULL);
+    
+    // Nothing should be started before the host enables the interface.
+    {
+        usb_vendor_disable_config_callback();
+        ut_assert(!usb_vendor_is_ready());
+        ut_assert(usb_vendor_send(data, 64) == 1);
+        ut_assert(usb_vendor_receive(data, 64) == 1);
+        ut_assert(in_data == NULL);
+        ut_assert(out_data == NULL);
+    }
+    
+    // A long buffer should be sent in a single transaction.
+    {
+        reset_usb();
+        sent = 0;
+        ut_assert(usb_vendor_is_ready());
+        
+        ut_assert(usb_vendor_send(data, sizeof(buffer)) == 0);
+        ut_assert(in_data == data);
+        ut_assert(in_length == sizeof(buffer));
+        ut_assert(usb_vendor_send_busy());
+        
+        // Only one transaction can be in progress
+        ut_assert(usb_vendor_send(data, 4) == 1);
+        
+        host_receive();
+        ut_assert(sent == 1);
+        ut_assert(!usb_vendor_send_busy());
+        ut_assert(usb_vendor_send(data, 4) == 0);
+    }
+    
+    // Unaligned and oversized buffers should be rejected.
+    {
+        reset_usb();
+        
+        ut_assert(usb_vendor_send(data + 1, 4) == 1);
+        ut_assert(usb_vendor_send(data, USB_VENDOR_MAX_LENGTH + 1) == 1);
+        ut_assert(usb_vendor_receive(data + 2, 64) == 1);
+        ut_assert(usb_vendor_receive(data, 100) == 1);
+        ut_assert(usb_vendor_receive(data, 0) == 1);
+        ut_assert(in_data == NULL);
+        ut_assert(out_data == NULL);
+    }
+    
+    // Received data should be placed directly in the buffer.
+    {
+        reset_usb();
+        received_buffer = NULL;
+        
+        ut_assert(usb_vendor_receive(data, 128) == 0);
+        ut_assert(out_data == data);
+        ut_assert(out_length == 128);
+        ut_assert(usb_vendor_receive(data, 64) == 1);
+        
+        host_send((const uint8_t*)"abcdef", 6);
+        ut_assert(received_buffer == data);
+        ut_assert(received_length == 6);
+        ut_assert(!memcmp(data, "abcdef", 6));
+        
+        ut_assert(usb_vendor_receive(data, 64) == 0);
+    }
+    
+    return UT_PASS;
+}